@@ -0,0 +1,163 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/guid.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// Length of "2CB15D1D-5FC1-11D2-ABE1-00A0C911F518".
+const size_t kGuidStringLength = 36;
+
+const char kHexDigits[] = "0123456789ABCDEF";
+
+bool HexDigitValue(char c, unsigned int* value) {
+  DCHECK(value != NULL);
+  if (c >= '0' && c <= '9')
+    *value = c - '0';
+  else if (c >= 'A' && c <= 'F')
+    *value = c - 'A' + 10;
+  else if (c >= 'a' && c <= 'f')
+    *value = c - 'a' + 10;
+  else
+    return false;
+  return true;
+}
+
+// Parses |digits| hexadecimal digits of |str| starting at |*position| and
+// moves |*position| after them.
+bool ParseHex(const std::string& str, size_t digits, size_t* position,
+              uint32_t* value) {
+  DCHECK(position != NULL);
+  DCHECK(value != NULL);
+  uint32_t result = 0;
+  for (size_t i = 0; i < digits; ++i) {
+    unsigned int digit = 0;
+    if (!HexDigitValue(str[*position + i], &digit))
+      return false;
+    result = (result << 4) | digit;
+  }
+  *position += digits;
+  *value = result;
+  return true;
+}
+
+bool ParseDash(const std::string& str, size_t* position) {
+  DCHECK(position != NULL);
+  if (str[*position] != '-')
+    return false;
+  ++*position;
+  return true;
+}
+
+void AppendHex(uint32_t value, size_t digits, std::string* str) {
+  DCHECK(str != NULL);
+  for (size_t i = digits; i > 0; --i)
+    str->push_back(kHexDigits[(value >> (4 * (i - 1))) & 0xF]);
+}
+
+}  // namespace
+
+bool operator==(const Guid& left, const Guid& right) {
+  return left.data1 == right.data1 &&
+         left.data2 == right.data2 &&
+         left.data3 == right.data3 &&
+         memcmp(left.data4, right.data4, sizeof(left.data4)) == 0;
+}
+
+bool operator!=(const Guid& left, const Guid& right) {
+  return !(left == right);
+}
+
+bool operator<(const Guid& left, const Guid& right) {
+  if (left.data1 != right.data1)
+    return left.data1 < right.data1;
+  if (left.data2 != right.data2)
+    return left.data2 < right.data2;
+  if (left.data3 != right.data3)
+    return left.data3 < right.data3;
+  return memcmp(left.data4, right.data4, sizeof(left.data4)) < 0;
+}
+
+bool StringToGuid(const std::string& str, Guid* guid) {
+  DCHECK(guid != NULL);
+
+  if (str.size() != kGuidStringLength)
+    return false;
+
+  Guid result = {};
+  size_t position = 0;
+  uint32_t value = 0;
+
+  if (!ParseHex(str, 8, &position, &value))
+    return false;
+  result.data1 = value;
+
+  if (!ParseDash(str, &position) || !ParseHex(str, 4, &position, &value))
+    return false;
+  result.data2 = static_cast<uint16_t>(value);
+
+  if (!ParseDash(str, &position) || !ParseHex(str, 4, &position, &value))
+    return false;
+  result.data3 = static_cast<uint16_t>(value);
+
+  if (!ParseDash(str, &position))
+    return false;
+  for (size_t i = 0; i < sizeof(result.data4); ++i) {
+    // A dash separates the first two bytes from the last six.
+    if (i == 2 && !ParseDash(str, &position))
+      return false;
+    if (!ParseHex(str, 2, &position, &value))
+      return false;
+    result.data4[i] = static_cast<uint8_t>(value);
+  }
+
+  *guid = result;
+  return true;
+}
+
+std::string GuidToString(const Guid& guid) {
+  std::string str;
+  str.reserve(kGuidStringLength);
+  AppendHex(guid.data1, 8, &str);
+  str.push_back('-');
+  AppendHex(guid.data2, 4, &str);
+  str.push_back('-');
+  AppendHex(guid.data3, 4, &str);
+  str.push_back('-');
+  for (size_t i = 0; i < sizeof(guid.data4); ++i) {
+    if (i == 2)
+      str.push_back('-');
+    AppendHex(guid.data4[i], 2, &str);
+  }
+  return str;
+}
+
+}  // namespace base
@@ -0,0 +1,61 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BASE_GUID_H_
+#define BASE_GUID_H_
+
+#include <stdint.h>
+#include <string>
+
+namespace base {
+
+// Binary representation of a GUID. The layout is the same as the GUID
+// structure of Windows.
+struct Guid {
+  uint32_t data1;
+  uint16_t data2;
+  uint16_t data3;
+  uint8_t data4[8];
+};
+
+bool operator==(const Guid& left, const Guid& right);
+bool operator!=(const Guid& left, const Guid& right);
+bool operator<(const Guid& left, const Guid& right);
+
+// Parses a GUID of the form "2CB15D1D-5FC1-11D2-ABE1-00A0C911F518". Both
+// upper and lower case hexadecimal digits are accepted.
+// @param str the string to parse.
+// @param guid receives the parsed GUID.
+// @returns true if |str| is a valid GUID, false otherwise.
+bool StringToGuid(const std::string& str, Guid* guid);
+
+// Formats a GUID as "2CB15D1D-5FC1-11D2-ABE1-00A0C911F518".
+// @param guid the GUID to format.
+// @returns the string representation of |guid|, in upper case.
+std::string GuidToString(const Guid& guid);
+
+}  // namespace base
+
+#endif  // BASE_GUID_H_
@@ -0,0 +1,88 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/guid.h"
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(GuidTest, StringToGuid) {
+  Guid guid = {};
+  EXPECT_TRUE(StringToGuid("2CB15D1D-5FC1-11D2-ABE1-00A0C911F518", &guid));
+  EXPECT_EQ(0x2CB15D1DU, guid.data1);
+  EXPECT_EQ(0x5FC1U, guid.data2);
+  EXPECT_EQ(0x11D2U, guid.data3);
+  const uint8_t kExpectedData4[] =
+      { 0xAB, 0xE1, 0x00, 0xA0, 0xC9, 0x11, 0xF5, 0x18 };
+  for (size_t i = 0; i < sizeof(kExpectedData4); ++i)
+    EXPECT_EQ(kExpectedData4[i], guid.data4[i]);
+
+  Guid lower_case = {};
+  EXPECT_TRUE(
+      StringToGuid("2cb15d1d-5fc1-11d2-abe1-00a0c911f518", &lower_case));
+  EXPECT_TRUE(guid == lower_case);
+}
+
+TEST(GuidTest, StringToGuidInvalid) {
+  Guid guid = {};
+  EXPECT_FALSE(StringToGuid("", &guid));
+  EXPECT_FALSE(StringToGuid("2CB15D1D-5FC1-11D2-ABE1-00A0C911F51", &guid));
+  EXPECT_FALSE(StringToGuid("2CB15D1D-5FC1-11D2-ABE1-00A0C911F5188", &guid));
+  EXPECT_FALSE(StringToGuid("2CB15D1D-5FC1-11D2-ABE100-A0C911F518", &guid));
+  EXPECT_FALSE(StringToGuid("2CB15D1D_5FC1-11D2-ABE1-00A0C911F518", &guid));
+  EXPECT_FALSE(StringToGuid("2CB15D1G-5FC1-11D2-ABE1-00A0C911F518", &guid));
+}
+
+TEST(GuidTest, GuidToString) {
+  const char kGuid[] = "3D6FA8D0-FE05-11D0-9DDA-00C04FD7BA7C";
+  Guid guid = {};
+  ASSERT_TRUE(StringToGuid(kGuid, &guid));
+  EXPECT_EQ(kGuid, GuidToString(guid));
+
+  Guid lower_case = {};
+  ASSERT_TRUE(
+      StringToGuid("def2fe46-7bd6-4b80-bd94-f57fe20d0ce3", &lower_case));
+  EXPECT_EQ("DEF2FE46-7BD6-4B80-BD94-F57FE20D0CE3", GuidToString(lower_case));
+}
+
+TEST(GuidTest, Compare) {
+  Guid process = {};
+  Guid thread = {};
+  Guid disk = {};
+  ASSERT_TRUE(StringToGuid("3D6FA8D0-FE05-11D0-9DDA-00C04FD7BA7C", &process));
+  ASSERT_TRUE(StringToGuid("3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C", &thread));
+  ASSERT_TRUE(StringToGuid("3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7D", &disk));
+
+  EXPECT_TRUE(process == process);
+  EXPECT_FALSE(process != process);
+  EXPECT_TRUE(process != thread);
+  EXPECT_TRUE(process < thread);
+  EXPECT_FALSE(thread < process);
+  EXPECT_TRUE(thread < disk);
+  EXPECT_FALSE(thread < thread);
+}
+
+}  // namespace base
@@ -0,0 +1,148 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/memory_mapped_file.h"
+
+#if defined(_WIN32)
+// Restrict the import to the windows basic includes.
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  // NOLINT
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "base/logging.h"
+#include "base/string_utils.h"
+
+namespace base {
+
+#if defined(_WIN32)
+
+MemoryMappedFile::MemoryMappedFile()
+    : data_(nullptr),
+      size_(0),
+      file_(INVALID_HANDLE_VALUE),
+      mapping_(NULL) {
+}
+
+bool MemoryMappedFile::Open(const std::wstring& path) {
+  Close();
+
+  file_ = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file_ == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(file_, &size)) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  if (size_ == 0)
+    return true;
+
+  mapping_ = ::CreateFileMappingW(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping_ == NULL) {
+    Close();
+    return false;
+  }
+
+  data_ = static_cast<const char*>(
+      ::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (data_ == nullptr) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MemoryMappedFile::Close() {
+  if (data_ != nullptr)
+    ::UnmapViewOfFile(data_);
+  if (mapping_ != NULL)
+    ::CloseHandle(mapping_);
+  if (file_ != INVALID_HANDLE_VALUE)
+    ::CloseHandle(file_);
+  data_ = nullptr;
+  size_ = 0;
+  mapping_ = NULL;
+  file_ = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MemoryMappedFile::MemoryMappedFile()
+    : data_(nullptr),
+      size_(0) {
+}
+
+bool MemoryMappedFile::Open(const std::wstring& path) {
+  Close();
+
+  int fd = ::open(WStringToString(path).c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return true;
+  }
+
+  // The mapping stays valid after the file descriptor is closed.
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  data_ = static_cast<const char*>(data);
+  size_ = size;
+  return true;
+}
+
+void MemoryMappedFile::Close() {
+  if (data_ != nullptr)
+    ::munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
+
+MemoryMappedFile::~MemoryMappedFile() {
+  Close();
+}
+
+}  // namespace base
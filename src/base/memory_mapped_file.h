@@ -0,0 +1,80 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BASE_MEMORY_MAPPED_FILE_H_
+#define BASE_MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "base/base.h"
+
+namespace base {
+
+// A read-only view on the content of a file, mapped into memory. The pages of
+// the file are loaded by the operating system on first access, so a file can
+// be read without copying it into the memory of the process.
+//
+// Usage example:
+//   MemoryMappedFile file;
+//   if (!file.Open(L"trace.etl"))
+//     return false;
+//   Process(file.data(), file.size());
+class MemoryMappedFile {
+ public:
+  MemoryMappedFile();
+  ~MemoryMappedFile();
+
+  // Maps a file into memory. The previous file, if any, is unmapped.
+  // @param path the path of the file.
+  // @returns true on success, false otherwise.
+  bool Open(const std::wstring& path);
+
+  // Unmaps the file.
+  void Close();
+
+  // @returns the content of the file, or nullptr when no file is mapped or
+  //     the file is empty.
+  const char* data() const { return data_; }
+
+  // @returns the size of the file, in bytes.
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+
+#if defined(_WIN32)
+  // The handles of the file and of its mapping.
+  void* file_;
+  void* mapping_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_MAPPED_FILE_H_
@@ -0,0 +1,66 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/memory_mapped_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "base/string_utils.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(MemoryMappedFileTest, OpenMissingFile) {
+  MemoryMappedFile file;
+  EXPECT_FALSE(file.Open(L"do_not_exist"));
+  EXPECT_EQ(nullptr, file.data());
+  EXPECT_EQ(0U, file.size());
+}
+
+TEST(MemoryMappedFileTest, Open) {
+  const char kContent[] = "libtrace memory mapped file";
+  const std::string path("memory_mapped_file_unittest.tmp");
+  FILE* output = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(output != NULL);
+  fwrite(kContent, 1, sizeof(kContent), output);
+  fclose(output);
+
+  {
+    MemoryMappedFile file;
+    ASSERT_TRUE(file.Open(StringToWString(path)));
+    ASSERT_EQ(sizeof(kContent), file.size());
+    EXPECT_EQ(0, memcmp(kContent, file.data(), sizeof(kContent)));
+
+    file.Close();
+    EXPECT_EQ(nullptr, file.data());
+    EXPECT_EQ(0U, file.size());
+  }
+
+  remove(path.c_str());
+}
+
+}  // namespace base
@@ -0,0 +1,55 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/span.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(SpanTest, Empty) {
+  Span<int> span;
+  EXPECT_TRUE(span.empty());
+  EXPECT_EQ(0U, span.size());
+  EXPECT_TRUE(span.begin() == span.end());
+}
+
+TEST(SpanTest, Elements) {
+  std::vector<int> values = { 1, 2, 3 };
+  Span<const int> span(values.data(), values.size());
+  EXPECT_FALSE(span.empty());
+  EXPECT_EQ(3U, span.size());
+  EXPECT_EQ(values.data(), span.data());
+  EXPECT_EQ(2, span[1]);
+
+  int sum = 0;
+  for (int value : span)
+    sum += value;
+  EXPECT_EQ(6, sum);
+}
+
+}  // namespace base
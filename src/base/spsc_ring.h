@@ -0,0 +1,136 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BASE_SPSC_RING_H_
+#define BASE_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "base/base.h"
+#include "base/logging.h"
+
+namespace base {
+
+// A bounded lock-free queue with a single producer thread and a single
+// consumer thread. The elements are kept in a ring of slots; the producer only
+// writes the tail index and the consumer only writes the head index, so
+// neither side ever waits for the other. Callers decide what to do when the
+// ring is full or empty (e.g. spin, yield or sleep).
+//
+// Usage example:
+//   SpscRing<int> ring(1024);
+//   // Producer thread.
+//   while (!ring.TryPush(42))
+//     std::this_thread::yield();
+//   // Consumer thread.
+//   int value = 0;
+//   if (ring.TryPop(&value))
+//     ...
+template<typename T>
+class SpscRing {
+ public:
+  // @param capacity the minimum number of elements held by the ring. It is
+  //     rounded up to a power of two.
+  explicit SpscRing(size_t capacity)
+      : capacity_(RoundUpToPowerOfTwo(capacity)),
+        slots_(new T[capacity_]),
+        head_(0),
+        cached_tail_(0),
+        tail_(0),
+        cached_head_(0) {
+  }
+
+  // Returns the number of elements held by a full ring.
+  size_t capacity() const { return capacity_; }
+
+  // Appends an element. Must only be called by the producer thread.
+  // @param value the element to append. It is moved from only on success.
+  // @returns true if the element is appended, false if the ring is full.
+  bool TryPush(T&& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_)
+        return false;
+    }
+    slots_[tail & (capacity_ - 1)] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Removes the oldest element. Must only be called by the consumer thread.
+  // @param value receives the removed element.
+  // @returns true if an element is removed, false if the ring is empty.
+  bool TryPop(T* value) {
+    DCHECK(value != nullptr);
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return false;
+    }
+    *value = std::move(slots_[head & (capacity_ - 1)]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  // The size of a cache line. The members written by each side are kept on
+  // separate lines so that they are not invalidated by the other side.
+  static const size_t kCacheLineSize = 64;
+
+  const size_t capacity_;
+  std::unique_ptr<T[]> slots_;
+  char padding_[kCacheLineSize];
+
+  // Consumer side: the index of the next element to pop, and the last tail
+  // read by the consumer. The cached tail avoids reading the index of the
+  // producer on every call.
+  std::atomic<size_t> head_;
+  size_t cached_tail_;
+  char consumer_padding_[kCacheLineSize];
+
+  // Producer side: the index of the next element to push, and the last head
+  // read by the producer.
+  std::atomic<size_t> tail_;
+  size_t cached_head_;
+  char producer_padding_[kCacheLineSize];
+
+  DISALLOW_COPY_AND_ASSIGN(SpscRing);
+};
+
+}  // namespace base
+
+#endif  // BASE_SPSC_RING_H_
@@ -0,0 +1,108 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/spsc_ring.h"
+
+#include <memory>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(SpscRingTest, Capacity) {
+  SpscRing<int> ring(5);
+  EXPECT_EQ(8U, ring.capacity());
+
+  SpscRing<int> exact_ring(16);
+  EXPECT_EQ(16U, exact_ring.capacity());
+}
+
+TEST(SpscRingTest, PushAndPop) {
+  SpscRing<int> ring(4);
+  int value = 0;
+  EXPECT_FALSE(ring.TryPop(&value));
+
+  EXPECT_TRUE(ring.TryPush(1));
+  EXPECT_TRUE(ring.TryPush(2));
+  EXPECT_TRUE(ring.TryPush(3));
+  EXPECT_TRUE(ring.TryPush(4));
+  EXPECT_FALSE(ring.TryPush(5));
+
+  EXPECT_TRUE(ring.TryPop(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(ring.TryPush(5));
+
+  for (int expected = 2; expected <= 5; ++expected) {
+    EXPECT_TRUE(ring.TryPop(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(ring.TryPop(&value));
+}
+
+TEST(SpscRingTest, MoveOnlyElements) {
+  SpscRing<std::unique_ptr<int> > ring(1);
+
+  std::unique_ptr<int> first(new int(1));
+  EXPECT_TRUE(ring.TryPush(std::move(first)));
+  EXPECT_EQ(nullptr, first.get());
+
+  // A failed push leaves the element to the caller.
+  std::unique_ptr<int> second(new int(2));
+  EXPECT_FALSE(ring.TryPush(std::move(second)));
+  ASSERT_NE(nullptr, second.get());
+
+  std::unique_ptr<int> value;
+  EXPECT_TRUE(ring.TryPop(&value));
+  ASSERT_NE(nullptr, value.get());
+  EXPECT_EQ(1, *value);
+}
+
+TEST(SpscRingTest, ProducerAndConsumerThreads) {
+  const size_t kCount = 100000;
+  SpscRing<size_t> ring(16);
+
+  std::thread producer([&ring, kCount] {
+    for (size_t i = 0; i < kCount; ++i) {
+      while (!ring.TryPush(size_t(i)))
+        std::this_thread::yield();
+    }
+  });
+
+  size_t expected = 0;
+  while (expected < kCount) {
+    size_t value = 0;
+    if (!ring.TryPop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(expected, value);
+    ++expected;
+  }
+
+  producer.join();
+}
+
+}  // namespace base
@@ -0,0 +1,196 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/w16_string.h"
+
+#include <stdint.h>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BASE_W16_STRING_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define BASE_W16_STRING_AVX2
+#include <immintrin.h>
+#endif
+
+namespace base {
+
+namespace {
+
+// Returns the 16-bit character at index |index| of |data|.
+uint16_t ReadUnit(const char* data, size_t index) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return static_cast<uint16_t>(bytes[2 * index] | (bytes[2 * index + 1] << 8));
+}
+
+bool IsHighSurrogate(uint16_t unit) {
+  return (unit & 0xFC00) == 0xD800;
+}
+
+bool IsLowSurrogate(uint16_t unit) {
+  return (unit & 0xFC00) == 0xDC00;
+}
+
+#if defined(BASE_W16_STRING_SSE2) || defined(BASE_W16_STRING_AVX2)
+// Returns the index of the lowest bit set in |mask|, which must not be 0.
+size_t LowestBitSet(uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Decodes the characters of |data| one at a time, until |min_length|
+// characters are consumed or the end of the string is reached. A surrogate
+// pair is never split.
+// @param data the characters to decode.
+// @param min_length the number of characters to consume.
+// @param length the number of characters remaining in the string.
+// @param out receives the decoded characters.
+// @param written receives the number of wchar_t written into |out|.
+// @returns the number of characters consumed.
+size_t DecodeScalar(const char* data, size_t min_length, size_t length,
+                    wchar_t* out, size_t* written) {
+  size_t index = 0;
+  size_t count = 0;
+  while (index < length && index < min_length) {
+    uint16_t unit = ReadUnit(data, index);
+    if (sizeof(wchar_t) > 2 && IsHighSurrogate(unit) && index + 1 < length) {
+      uint16_t next = ReadUnit(data, index + 1);
+      if (IsLowSurrogate(next)) {
+        uint32_t code_point =
+            0x10000 + ((static_cast<uint32_t>(unit) - 0xD800) << 10) +
+            (static_cast<uint32_t>(next) - 0xDC00);
+        out[count++] = static_cast<wchar_t>(code_point);
+        index += 2;
+        continue;
+      }
+    }
+    out[count++] = static_cast<wchar_t>(unit);
+    ++index;
+  }
+  *written = count;
+  return index;
+}
+
+}  // namespace
+
+size_t W16StringLength(const char* data, size_t max_length) {
+  size_t index = 0;
+
+#if defined(BASE_W16_STRING_AVX2)
+  const __m256i zero256 = _mm256_setzero_si256();
+  for (; index + 16 <= max_length; index += 16) {
+    __m256i block = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + 2 * index));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi16(block, zero256)));
+    if (mask != 0)
+      return index + LowestBitSet(mask) / 2;
+  }
+#endif
+
+#if defined(BASE_W16_STRING_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; index + 8 <= max_length; index += 8) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 2 * index));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi16(block, zero)));
+    if (mask != 0)
+      return index + LowestBitSet(mask) / 2;
+  }
+#endif
+
+  for (; index < max_length; ++index) {
+    if (data[2 * index] == 0 && data[2 * index + 1] == 0)
+      return index;
+  }
+  return max_length;
+}
+
+void AppendW16String(const char* data, size_t length, std::wstring* value) {
+  size_t initial_size = value->size();
+
+  if (sizeof(wchar_t) == 2) {
+    // The code units are copied as-is. Like the rest of the decoders, this
+    // assumes a little-endian host.
+    value->resize(initial_size + length);
+    if (length != 0)
+      ::memcpy(&(*value)[initial_size], data, 2 * length);
+    return;
+  }
+
+  // Each 16-bit character produces at most one wchar_t.
+  value->resize(initial_size + length);
+  wchar_t* out = length != 0 ? &(*value)[initial_size] : nullptr;
+  size_t index = 0;
+  size_t count = 0;
+
+  while (index < length) {
+#if defined(BASE_W16_STRING_SSE2)
+    // Widen blocks of 8 characters without surrogates.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+    const __m128i surrogate_value = _mm_set1_epi16(static_cast<short>(0xD800));
+    while (index + 8 <= length) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 2 * index));
+      __m128i surrogates = _mm_cmpeq_epi16(
+          _mm_and_si128(block, surrogate_mask), surrogate_value);
+      if (_mm_movemask_epi8(surrogates) != 0)
+        break;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count),
+                       _mm_unpacklo_epi16(block, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count + 4),
+                       _mm_unpackhi_epi16(block, zero));
+      index += 8;
+      count += 8;
+    }
+#endif
+
+    // Decode the next block one character at a time.
+    size_t written = 0;
+    index += DecodeScalar(data + 2 * index, 8, length - index,
+                          out + count, &written);
+    count += written;
+  }
+
+  value->resize(initial_size + count);
+}
+
+}  // namespace base
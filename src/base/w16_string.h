@@ -0,0 +1,58 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Decoding of strings of little-endian 16-bit characters (UTF-16LE), as found
+// in trace payloads. The characters may be unaligned. The size of wchar_t
+// depends on the platform: with a 16-bit wchar_t the code units are copied
+// as-is, with a 32-bit wchar_t surrogate pairs are combined into a single
+// code point. Unpaired surrogates are kept as-is.
+//
+// Both functions process the string in blocks with SSE2 or AVX2, when enabled
+// by the compiler flags, and fall back to a scalar loop otherwise.
+
+#ifndef BASE_W16_STRING_H_
+#define BASE_W16_STRING_H_
+
+#include <cstddef>
+#include <string>
+
+namespace base {
+
+// Finds the null terminator of a string of 16-bit characters.
+// @param data the characters of the string.
+// @param max_length the maximal number of 16-bit characters to scan.
+// @returns the number of 16-bit characters before the first null character,
+//     or |max_length| if there is none.
+size_t W16StringLength(const char* data, size_t max_length);
+
+// Decodes a string of 16-bit characters and appends it to |value|.
+// @param data the characters of the string.
+// @param length the number of 16-bit characters to decode.
+// @param value the string receiving the decoded characters.
+void AppendW16String(const char* data, size_t length, std::wstring* value);
+
+}  // namespace base
+
+#endif  // BASE_W16_STRING_H_
@@ -0,0 +1,167 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/w16_string.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Encodes 16-bit characters in little-endian order, starting at |offset|
+// bytes in the returned buffer so that unaligned data can be tested.
+std::vector<char> Encode(const std::vector<unsigned int>& units,
+                         size_t offset) {
+  std::vector<char> bytes(offset, 'x');
+  for (unsigned int unit : units) {
+    bytes.push_back(static_cast<char>(unit & 0xFF));
+    bytes.push_back(static_cast<char>((unit >> 8) & 0xFF));
+  }
+  return bytes;
+}
+
+std::vector<unsigned int> AsciiUnits(const char* str) {
+  std::vector<unsigned int> units;
+  for (const char* c = str; *c != '\0'; ++c)
+    units.push_back(static_cast<unsigned int>(*c));
+  return units;
+}
+
+}  // namespace
+
+TEST(W16StringTest, LengthWithTerminator) {
+  std::vector<unsigned int> units = AsciiUnits("abc");
+  units.push_back(0);
+  units.push_back('d');
+  std::vector<char> bytes = Encode(units, 0);
+
+  EXPECT_EQ(3U, W16StringLength(&bytes[0], units.size()));
+  EXPECT_EQ(2U, W16StringLength(&bytes[0], 2));
+}
+
+TEST(W16StringTest, LengthWithoutTerminator) {
+  std::vector<unsigned int> units = AsciiUnits("abcdefghijklmnopqrstuvwxyz");
+  std::vector<char> bytes = Encode(units, 0);
+
+  EXPECT_EQ(units.size(), W16StringLength(&bytes[0], units.size()));
+  EXPECT_EQ(0U, W16StringLength(&bytes[0], 0));
+}
+
+TEST(W16StringTest, LengthLongUnaligned) {
+  // The terminator is found at every position, in and across blocks.
+  for (size_t offset = 0; offset < 4; ++offset) {
+    for (size_t terminator = 0; terminator < 40; ++terminator) {
+      std::vector<unsigned int> units(48, 0x4100);
+      units[terminator] = 0;
+      std::vector<char> bytes = Encode(units, offset);
+
+      EXPECT_EQ(terminator,
+                W16StringLength(&bytes[offset], units.size()));
+    }
+  }
+}
+
+TEST(W16StringTest, LengthIgnoresNullBytes) {
+  // Characters with a null low or high byte are not terminators.
+  std::vector<unsigned int> units(20, 0x0100);
+  units[9] = 0x0041;
+  units[17] = 0;
+  std::vector<char> bytes = Encode(units, 1);
+
+  EXPECT_EQ(17U, W16StringLength(&bytes[1], units.size()));
+}
+
+TEST(W16StringTest, AppendAscii) {
+  for (size_t offset = 0; offset < 3; ++offset) {
+    const char kStr[] = "The quick brown fox jumps over the lazy dog";
+    std::vector<unsigned int> units = AsciiUnits(kStr);
+    std::vector<char> bytes = Encode(units, offset);
+
+    std::wstring value(L">");
+    AppendW16String(&bytes[offset], units.size(), &value);
+    EXPECT_EQ(L">The quick brown fox jumps over the lazy dog", value);
+  }
+}
+
+TEST(W16StringTest, AppendNonAscii) {
+  // Characters with a byte >= 0x80 must not be sign-extended.
+  std::vector<unsigned int> units;
+  for (unsigned int i = 0; i < 20; ++i)
+    units.push_back(0x00E0 + i * 0x0101);
+  std::vector<char> bytes = Encode(units, 1);
+
+  std::wstring value;
+  AppendW16String(&bytes[1], units.size(), &value);
+  ASSERT_EQ(units.size(), value.size());
+  for (size_t i = 0; i < units.size(); ++i)
+    EXPECT_EQ(static_cast<wchar_t>(units[i]), value[i]);
+}
+
+TEST(W16StringTest, AppendEmpty) {
+  std::wstring value(L"abc");
+  AppendW16String(nullptr, 0, &value);
+  EXPECT_EQ(L"abc", value);
+}
+
+TEST(W16StringTest, AppendSurrogatePair) {
+  // U+1F600 at every position around the 8-character block boundaries.
+  for (size_t position = 0; position < 18; ++position) {
+    std::vector<unsigned int> units = AsciiUnits("abcdefghijklmnopqrst");
+    units.insert(units.begin() + position, 0xDE00);
+    units.insert(units.begin() + position, 0xD83D);
+    std::vector<char> bytes = Encode(units, 0);
+
+    std::wstring value;
+    AppendW16String(&bytes[0], units.size(), &value);
+
+    std::wstring expected(L"abcdefghijklmnopqrst");
+    if (sizeof(wchar_t) == 2) {
+      expected.insert(position, 1, static_cast<wchar_t>(0xDE00));
+      expected.insert(position, 1, static_cast<wchar_t>(0xD83D));
+    } else {
+      expected.insert(position, 1, static_cast<wchar_t>(0x1F600));
+    }
+    EXPECT_EQ(expected, value);
+  }
+}
+
+TEST(W16StringTest, AppendUnpairedSurrogates) {
+  std::vector<unsigned int> units = AsciiUnits("abcdefghijk");
+  units[2] = 0xD83D;  // High surrogate followed by a regular character.
+  units[6] = 0xDE00;  // Low surrogate without a high surrogate.
+  units.push_back(0xD83D);  // High surrogate at the end of the string.
+  std::vector<char> bytes = Encode(units, 0);
+
+  std::wstring value;
+  AppendW16String(&bytes[0], units.size(), &value);
+  ASSERT_EQ(units.size(), value.size());
+  for (size_t i = 0; i < units.size(); ++i)
+    EXPECT_EQ(static_cast<wchar_t>(units[i]), value[i]);
+}
+
+}  // namespace base
@@ -0,0 +1,137 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/atom.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "base/base.h"
+#include "base/logging.h"
+
+namespace event {
+
+namespace {
+
+// The interned strings are kept in fixed-size chunks which are never moved,
+// so that Atom::str() can read them without taking the lock.
+const size_t kChunkSize = 1024;
+const size_t kMaxChunks = 1024;
+
+class AtomTable {
+ public:
+  AtomTable() : size_(0) {
+    for (size_t i = 0; i < kMaxChunks; ++i)
+      chunks_[i].store(nullptr, std::memory_order_relaxed);
+    // The empty string is always the atom 0.
+    Insert(std::string());
+  }
+
+  ~AtomTable() {
+    for (size_t i = 0; i < kMaxChunks; ++i)
+      delete[] chunks_[i].load(std::memory_order_relaxed);
+  }
+
+  Atom::Id Intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(lock_);
+    Ids::const_iterator look = ids_.find(name);
+    if (look != ids_.end())
+      return look->second;
+    return Insert(name);
+  }
+
+  bool Lookup(const std::string& name, Atom::Id* id) {
+    std::lock_guard<std::mutex> lock(lock_);
+    Ids::const_iterator look = ids_.find(name);
+    if (look == ids_.end())
+      return false;
+    *id = look->second;
+    return true;
+  }
+
+  const std::string& Get(Atom::Id id) const {
+    DCHECK_LT(id, size_.load(std::memory_order_acquire));
+    const std::string* chunk =
+        chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    return chunk[id % kChunkSize];
+  }
+
+ private:
+  typedef std::unordered_map<std::string, Atom::Id> Ids;
+
+  // Must be called with |lock_| held.
+  Atom::Id Insert(const std::string& name) {
+    Atom::Id id = size_.load(std::memory_order_relaxed);
+    size_t chunk_index = id / kChunkSize;
+    if (chunk_index >= kMaxChunks)
+      LOG(FATAL) << "Too many atoms.";
+
+    std::string* chunk = chunks_[chunk_index].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      chunk = new std::string[kChunkSize];
+      chunks_[chunk_index].store(chunk, std::memory_order_release);
+    }
+    chunk[id % kChunkSize] = name;
+
+    ids_.insert(std::make_pair(name, id));
+    size_.store(id + 1, std::memory_order_release);
+    return id;
+  }
+
+  std::mutex lock_;
+  Ids ids_;
+  std::atomic<Atom::Id> size_;
+  std::atomic<std::string*> chunks_[kMaxChunks];
+
+  DISALLOW_COPY_AND_ASSIGN(AtomTable);
+};
+
+AtomTable* GetAtomTable() {
+  // The table is leaked to remain valid during static destruction.
+  static AtomTable* table = new AtomTable();
+  return table;
+}
+
+}  // namespace
+
+Atom Atom::Intern(const std::string& name) {
+  return Atom(GetAtomTable()->Intern(name));
+}
+
+bool Atom::Lookup(const std::string& name, Atom* atom) {
+  DCHECK(atom != nullptr);
+  Id id = 0;
+  if (!GetAtomTable()->Lookup(name, &id))
+    return false;
+  *atom = Atom(id);
+  return true;
+}
+
+const std::string& Atom::str() const {
+  return GetAtomTable()->Get(id_);
+}
+
+}  // namespace event
@@ -0,0 +1,96 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An Atom is a compact handle on an interned string. Field names are interned
+// once in a process-wide table; comparing two atoms is an integer compare.
+//
+// Interned strings are never released: they live until the end of the
+// process, and the table holds about a million of them before it aborts. Only
+// names which are known to be few (e.g. the field names of decoded events)
+// should be interned. Code which looks up a name, possibly coming from user
+// input, uses Lookup(), which never interns (e.g. Value::GetField() with a
+// string name).
+//
+// Usage example:
+//   const Atom kBaseAddress = Atom::Intern("BaseAddress");
+//   uint64_t base_address = 0;
+//   payload->GetFieldAsULong(kBaseAddress, &base_address);
+
+#ifndef EVENT_ATOM_H_
+#define EVENT_ATOM_H_
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+
+namespace event {
+
+class Atom {
+ public:
+  typedef uint32_t Id;
+
+  // Constructs the atom of the empty string.
+  Atom() : id_(0) {
+  }
+
+  // Returns the atom of |name|, interning |name| if needed. Interning is
+  // thread-safe. An interned string is never released.
+  // @param name the string to intern.
+  // @returns the atom of |name|.
+  static Atom Intern(const std::string& name);
+
+  // Finds the atom of |name| without interning it.
+  // @param name the string to look for.
+  // @param atom receives the atom of |name|, when found.
+  // @returns true if |name| has been interned, false otherwise.
+  static bool Lookup(const std::string& name, Atom* atom);
+
+  // Returns the interned string. The string lives until the end of the
+  // process.
+  const std::string& str() const;
+  const char* c_str() const { return str().c_str(); }
+
+  // Returns the numeric identifier of this atom. Identifiers are dense and
+  // start at 0 for the empty string.
+  Id id() const { return id_; }
+
+  bool operator==(const Atom& other) const { return id_ == other.id_; }
+  bool operator!=(const Atom& other) const { return id_ != other.id_; }
+  bool operator<(const Atom& other) const { return id_ < other.id_; }
+
+ private:
+  explicit Atom(Id id) : id_(id) {
+  }
+
+  Id id_;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Atom& atom) {
+  return out << atom.str();
+}
+
+}  // namespace event
+
+#endif  // EVENT_ATOM_H_
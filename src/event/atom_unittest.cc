@@ -0,0 +1,109 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/atom.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace event {
+
+TEST(AtomTest, Empty) {
+  Atom atom;
+  EXPECT_EQ(0U, atom.id());
+  EXPECT_STREQ("", atom.c_str());
+  EXPECT_EQ(atom, Atom::Intern(""));
+}
+
+TEST(AtomTest, Intern) {
+  Atom first = Atom::Intern("AtomTestIntern");
+  Atom second = Atom::Intern(std::string("AtomTestIntern"));
+  Atom other = Atom::Intern("AtomTestInternOther");
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first.id(), second.id());
+  EXPECT_NE(first, other);
+  EXPECT_STREQ("AtomTestIntern", first.c_str());
+  EXPECT_EQ("AtomTestInternOther", other.str());
+
+  // The interned string is shared.
+  EXPECT_EQ(first.c_str(), second.c_str());
+}
+
+TEST(AtomTest, Lookup) {
+  Atom atom;
+  EXPECT_FALSE(Atom::Lookup("AtomTestLookupNeverInterned", &atom));
+  EXPECT_EQ(Atom(), atom);
+
+  Atom interned = Atom::Intern("AtomTestLookup");
+  EXPECT_TRUE(Atom::Lookup("AtomTestLookup", &atom));
+  EXPECT_EQ(interned, atom);
+}
+
+TEST(AtomTest, Stream) {
+  std::stringstream ss;
+  ss << Atom::Intern("AtomTestStream");
+  EXPECT_EQ("AtomTestStream", ss.str());
+}
+
+TEST(AtomTest, ManyAtoms) {
+  // Fill more than one chunk of the table.
+  std::vector<Atom> atoms;
+  for (int i = 0; i < 3000; ++i)
+    atoms.push_back(Atom::Intern("AtomTestMany" + std::to_string(i)));
+
+  for (int i = 0; i < 3000; ++i) {
+    EXPECT_EQ("AtomTestMany" + std::to_string(i), atoms[i].str());
+    EXPECT_EQ(atoms[i], Atom::Intern("AtomTestMany" + std::to_string(i)));
+  }
+}
+
+TEST(AtomTest, ConcurrentIntern) {
+  const int kThreads = 4;
+  const int kAtoms = 500;
+  std::vector<std::vector<Atom> > atoms(kThreads);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.push_back(std::thread([&atoms, t]() {
+      for (int i = 0; i < kAtoms; ++i)
+        atoms[t].push_back(Atom::Intern("AtomTestThread" + std::to_string(i)));
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+
+  for (int i = 0; i < kAtoms; ++i) {
+    for (int t = 1; t < kThreads; ++t)
+      EXPECT_EQ(atoms[0][i], atoms[t][i]);
+    EXPECT_EQ("AtomTestThread" + std::to_string(i), atoms[0][i].str());
+  }
+}
+
+}  // namespace event
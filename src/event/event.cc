@@ -25,6 +25,7 @@
 
 #include "event/event.h"
 #include "event/value.h"
+#include "event/variant.h"
 
 namespace event {
 
@@ -38,8 +39,129 @@ Event::Event(Timestamp timestamp,
              std::unique_ptr<const Value> header,
              std::unique_ptr<const Value> payload)
     : timestamp_(timestamp),
-      header_(std::move(header)),
-      payload_(std::move(payload)) {
+      header_(header.get()),
+      payload_(payload.get()),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(nullptr),
+      has_event_header_(false),
+      typed_header_(false),
+      owned_header_(std::move(header)),
+      owned_payload_(std::move(payload)) {
+}
+
+Event::Event(Timestamp timestamp, const Value* header, const Value* payload)
+    : timestamp_(timestamp),
+      header_(header),
+      payload_(payload),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(nullptr),
+      has_event_header_(false),
+      typed_header_(false) {
+}
+
+Event::Event(Timestamp timestamp,
+             const VariantStruct* header,
+             const VariantStruct* payload)
+    : timestamp_(timestamp),
+      header_(nullptr),
+      payload_(nullptr),
+      variant_header_(header),
+      variant_payload_(payload),
+      lazy_payload_(nullptr),
+      has_event_header_(false),
+      typed_header_(false) {
+}
+
+Event::Event(Timestamp timestamp,
+             const Value* header,
+             const LazyPayload* payload)
+    : timestamp_(timestamp),
+      header_(header),
+      payload_(nullptr),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(payload),
+      has_event_header_(false),
+      typed_header_(false) {
+}
+
+Event::Event(Timestamp timestamp,
+             const EventHeader& header,
+             const Value* payload)
+    : timestamp_(timestamp),
+      header_(nullptr),
+      payload_(payload),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(nullptr),
+      event_header_(header),
+      has_event_header_(true),
+      typed_header_(true) {
+}
+
+Event::Event(Timestamp timestamp,
+             const EventHeader& header,
+             const LazyPayload* payload)
+    : timestamp_(timestamp),
+      header_(nullptr),
+      payload_(nullptr),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(payload),
+      event_header_(header),
+      has_event_header_(true),
+      typed_header_(true) {
+}
+
+Event::Event(Timestamp timestamp,
+             const EventHeader& header,
+             std::unique_ptr<const Value> payload)
+    : timestamp_(timestamp),
+      header_(nullptr),
+      payload_(payload.get()),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(nullptr),
+      event_header_(header),
+      has_event_header_(true),
+      typed_header_(true),
+      owned_payload_(std::move(payload)) {
+}
+
+Event::Event(Timestamp timestamp,
+             const Value* header,
+             const Value* payload,
+             std::shared_ptr<const ValueArena> arena)
+    : timestamp_(timestamp),
+      header_(header),
+      payload_(payload),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(nullptr),
+      has_event_header_(false),
+      typed_header_(false),
+      arena_(std::move(arena)) {
+}
+
+Event::Event(Timestamp timestamp,
+             const EventHeader& header,
+             const Value* payload,
+             std::shared_ptr<const ValueArena> arena)
+    : timestamp_(timestamp),
+      header_(nullptr),
+      payload_(payload),
+      variant_header_(nullptr),
+      variant_payload_(nullptr),
+      lazy_payload_(nullptr),
+      event_header_(header),
+      has_event_header_(true),
+      typed_header_(true),
+      arena_(std::move(arena)) {
+}
+
+Event::~Event() {
 }
 
 Timestamp Event::timestamp() const {
@@ -47,11 +169,63 @@ Timestamp Event::timestamp() const {
 }
 
 const Value* Event::header() const {
-  return header_.get();
+  if (header_ == nullptr && variant_header_ != nullptr) {
+    owned_header_ = variant_header_->ToValue();
+    header_ = owned_header_.get();
+  } else if (header_ == nullptr && has_event_header_) {
+    owned_header_ = EventHeaderToValue(event_header_);
+    header_ = owned_header_.get();
+  }
+  return header_;
+}
+
+const EventHeader& Event::event_header() const {
+  if (!has_event_header_) {
+    const Value* header = this->header();
+    if (header != nullptr)
+      EventHeaderFromValue(header, &event_header_);
+    has_event_header_ = true;
+  }
+  return event_header_;
 }
 
 const Value* Event::payload() const {
-  return payload_.get();
+  if (payload_ == nullptr && variant_payload_ != nullptr) {
+    owned_payload_ = variant_payload_->ToValue();
+    payload_ = owned_payload_.get();
+  }
+  if (lazy_payload_ != nullptr) {
+    payload_ = lazy_payload_->Decode();
+    lazy_payload_ = nullptr;
+  }
+  return payload_;
+}
+
+bool Event::GetHeaderField(Atom name, Variant* value) const {
+  DCHECK(value != nullptr);
+  if (variant_header_ != nullptr)
+    return variant_header_->GetField(name, value);
+  if (header_ == nullptr && has_event_header_)
+    return GetEventHeaderField(event_header_, name, value);
+
+  const Value* field = nullptr;
+  if (header_ == nullptr || !header_->GetField(name, &field))
+    return false;
+  *value = Variant::FromValue(field);
+  return true;
+}
+
+bool Event::GetPayloadField(Atom name, Variant* value) const {
+  DCHECK(value != nullptr);
+  if (variant_payload_ != nullptr)
+    return variant_payload_->GetField(name, value);
+
+  const Value* payload = this->payload();
+  const Value* field = nullptr;
+  if (payload == nullptr || !payload->GetField(name, &field))
+    return false;
+  *value = Variant::FromValue(field);
+  return true;
 }
 
 }  // namespace event
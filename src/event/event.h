@@ -30,11 +30,16 @@
 #include <stdint.h>
 
 #include "base/base.h"
+#include "event/atom.h"
+#include "event/event_header.h"
 
 namespace event {
 
-// Forward declaration (see value.h).
+// Forward declarations (see value.h and variant.h).
 class Value;
+class ValueArena;
+class Variant;
+class VariantStruct;
 
 typedef uint64_t Timestamp;
 
@@ -45,6 +50,19 @@ extern const char kProcessIdFieldName[];
 extern const char kThreadIdFieldName[];
 extern const char kProcessorNumberFieldName[];
 
+// Decodes the payload of an event the first time it is accessed. Consumers
+// which only look at the header of an event never pay for the decoding of its
+// payload.
+class LazyPayload {
+ public:
+  virtual ~LazyPayload() { }
+
+  // Decodes the payload. Called at most once per event.
+  // @returns the decoded payload, or nullptr if the payload can't be decoded.
+  //     The decoded payload must outlive the event.
+  virtual const Value* Decode() const = 0;
+};
+
 // This class contains a single event and its payload.
 class Event {
  public:
@@ -57,6 +75,77 @@ class Event {
         std::unique_ptr<const Value> header,
         std::unique_ptr<const Value> payload);
 
+  // Constructor for an event which does not own its header and payload (e.g.
+  // they are allocated into a ValueArena).
+  // @param timestamp the timestamp at which this event occurred.
+  // @param header the header of this event, must outlive the event.
+  // @param payload the payload of this event, must outlive the event.
+  Event(Timestamp timestamp, const Value* header, const Value* payload);
+
+  // Constructor for an event carrying its header and payload as variants. The
+  // event does not own them. The Value form returned by header() and
+  // payload() is created on first use.
+  // @param timestamp the timestamp at which this event occurred.
+  // @param header the header of this event, must outlive the event.
+  // @param payload the payload of this event, must outlive the event.
+  Event(Timestamp timestamp,
+        const VariantStruct* header,
+        const VariantStruct* payload);
+
+  // Constructor for an event whose payload is decoded on first use. The event
+  // does not own its header and its payload.
+  // @param timestamp the timestamp at which this event occurred.
+  // @param header the header of this event, must outlive the event.
+  // @param payload the decoder of the payload of this event, must outlive the
+  //     event.
+  Event(Timestamp timestamp, const Value* header, const LazyPayload* payload);
+
+  // Constructors for an event with a typed header, copied into the event. The
+  // Value form returned by header() is created on first use. The event does
+  // not own its payload.
+  // @param timestamp the timestamp at which this event occurred.
+  // @param header the header of this event.
+  // @param payload the payload of this event, or its decoder. Must outlive
+  //     the event.
+  // @{
+  Event(Timestamp timestamp,
+        const EventHeader& header,
+        const Value* payload);
+  Event(Timestamp timestamp,
+        const EventHeader& header,
+        const LazyPayload* payload);
+  // @}
+
+  // Constructor for an event with a typed header, owning its payload.
+  // @param timestamp the timestamp at which this event occurred.
+  // @param header the header of this event.
+  // @param payload the payload of this event.
+  Event(Timestamp timestamp,
+        const EventHeader& header,
+        std::unique_ptr<const Value> payload);
+
+  // Constructors for an event whose header and payload are allocated into an
+  // arena shared with other events. The event keeps a reference on the arena,
+  // which is released with the last event using it.
+  // @param timestamp the timestamp at which this event occurred.
+  // @param header the header of this event.
+  // @param payload the payload of this event, allocated into |arena|. May be
+  //     nullptr.
+  // @param arena the arena holding the header and the payload.
+  // @{
+  Event(Timestamp timestamp,
+        const Value* header,
+        const Value* payload,
+        std::shared_ptr<const ValueArena> arena);
+  Event(Timestamp timestamp,
+        const EventHeader& header,
+        const Value* payload,
+        std::shared_ptr<const ValueArena> arena);
+  // @}
+
+  // Destructor.
+  ~Event();
+
   // Accessors.
   // @{
 
@@ -67,15 +156,54 @@ class Event {
   // header.
   const Value* header() const;
 
-  // Returns the payload of this event. The event keeps ownership of the
-  // payload.
+  // Returns the typed header of this event. For an event created with a Value
+  // header, it is read from the Value on first use.
+  const EventHeader& event_header() const;
+
+  // Returns true if this event was created with a typed header.
+  bool has_typed_header() const { return typed_header_; }
+
+  // Returns the payload of this event, or nullptr if a lazy payload can't be
+  // decoded. The event keeps ownership of the payload.
   const Value* payload() const;
   // @}
 
+  // Retrieve a field of the header or of the payload as a variant, whichever
+  // form the event carries. Strings and aggregates referenced by the variant
+  // live as long as the event.
+  // @param name the name of the field to find.
+  // @param value receives the value of the field.
+  // @returns true if the field is found, false otherwise.
+  // @{
+  bool GetHeaderField(Atom name, Variant* value) const;
+  bool GetPayloadField(Atom name, Variant* value) const;
+  // @}
+
  private:
   Timestamp timestamp_;
-  const std::unique_ptr<const Value> header_;
-  const std::unique_ptr<const Value> payload_;
+  mutable const Value* header_;
+  mutable const Value* payload_;
+
+  // The header and the payload, when carried as variants.
+  const VariantStruct* variant_header_;
+  const VariantStruct* variant_payload_;
+
+  // The decoder of the payload, until the payload is first accessed.
+  mutable const LazyPayload* lazy_payload_;
+
+  // The typed header, valid when |has_event_header_| is true.
+  mutable EventHeader event_header_;
+  mutable bool has_event_header_;
+  bool typed_header_;
+
+  // The arena holding the header and the payload, when shared with other
+  // events.
+  std::shared_ptr<const ValueArena> arena_;
+
+  // The header and the payload, when owned by this event or created from
+  // their variant form.
+  mutable std::unique_ptr<const Value> owned_header_;
+  mutable std::unique_ptr<const Value> owned_payload_;
 
   DISALLOW_COPY_AND_ASSIGN(Event);
 };
@@ -0,0 +1,111 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/event_header.h"
+
+#include <string>
+
+#include "base/logging.h"
+#include "event/event.h"
+#include "event/value.h"
+#include "event/variant.h"
+
+namespace event {
+
+namespace {
+
+const Atom kOperationField = Atom::Intern(kOperationFieldName);
+const Atom kCategoryField = Atom::Intern(kCategoryFieldName);
+const Atom kProcessIdField = Atom::Intern(kProcessIdFieldName);
+const Atom kThreadIdField = Atom::Intern(kThreadIdFieldName);
+const Atom kProcessorNumberField = Atom::Intern(kProcessorNumberFieldName);
+
+}  // namespace
+
+EventHeader::EventHeader()
+    : process_id(0),
+      thread_id(0),
+      processor_number(0),
+      flags(0) {
+}
+
+std::unique_ptr<StructValue> EventHeaderToValue(const EventHeader& header) {
+  std::unique_ptr<StructValue> value(new StructValue());
+  value->AddField<StringValue>(kOperationField, header.type.operation().str());
+  value->AddField<StringValue>(kCategoryField, header.type.category().str());
+  value->AddField<ULongValue>(kProcessIdField, header.process_id);
+  value->AddField<ULongValue>(kThreadIdField, header.thread_id);
+  value->AddField<UCharValue>(kProcessorNumberField, header.processor_number);
+  return value;
+}
+
+void EventHeaderFromValue(const Value* value, EventHeader* header) {
+  DCHECK(value != nullptr);
+  DCHECK(header != nullptr);
+
+  std::string name;
+  Atom category = header->type.category();
+  Atom operation = header->type.operation();
+  if (value->GetFieldAsString(kOperationField, &name))
+    operation = Atom::Intern(name);
+  if (value->GetFieldAsString(kCategoryField, &name))
+    category = Atom::Intern(name);
+  header->type = EventType::Register(category, operation);
+
+  uint64_t id = 0;
+  if (value->GetFieldAsULong(kProcessIdField, &id))
+    header->process_id = id;
+  if (value->GetFieldAsULong(kThreadIdField, &id))
+    header->thread_id = id;
+
+  const Value* processor_number = nullptr;
+  if (value->GetField(kProcessorNumberField, &processor_number) &&
+      UCharValue::InstanceOf(processor_number)) {
+    header->processor_number = UCharValue::GetValue(processor_number);
+  }
+}
+
+bool GetEventHeaderField(const EventHeader& header,
+                         Atom name,
+                         Variant* value) {
+  DCHECK(value != nullptr);
+
+  if (name == kOperationField) {
+    *value = Variant::FromString(&header.type.operation().str());
+  } else if (name == kCategoryField) {
+    *value = Variant::FromString(&header.type.category().str());
+  } else if (name == kProcessIdField) {
+    *value = Variant::Make<ULongValue>(header.process_id);
+  } else if (name == kThreadIdField) {
+    *value = Variant::Make<ULongValue>(header.thread_id);
+  } else if (name == kProcessorNumberField) {
+    *value = Variant::Make<UCharValue>(header.processor_number);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace event
@@ -0,0 +1,88 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// EventHeader is the typed header of an event. It is stored inline in an
+// Event: reading a header field requires neither a lookup by name nor a string
+// comparison. The category and the operation are given by the type of the
+// event (see event_type.h), compared as an integer.
+//
+// The Value form of a header, still returned by Event::header(), is a
+// structure with the fields kOperationFieldName, kCategoryFieldName,
+// kProcessIdFieldName, kThreadIdFieldName and kProcessorNumberFieldName.
+
+#ifndef EVENT_EVENT_HEADER_H_
+#define EVENT_EVENT_HEADER_H_
+
+#include <stdint.h>
+#include <memory>
+
+#include "base/types.h"
+#include "event/atom.h"
+#include "event/event_type.h"
+
+namespace event {
+
+// Forward declarations (see value.h and variant.h).
+class StructValue;
+class Value;
+class Variant;
+
+struct EventHeader {
+  EventHeader();
+
+  // The category and the operation of the event.
+  EventType type;
+
+  base::Pid process_id;
+  base::Tid thread_id;
+  uint8_t processor_number;
+
+  // The flags of the raw header of the event, specific to the trace format
+  // (e.g. the EVENT_HEADER_FLAG_* values of ETW).
+  uint32_t flags;
+};
+
+// Creates the Value form of a header.
+// @param header the header to convert.
+// @returns the structure holding the fields of |header|.
+std::unique_ptr<StructValue> EventHeaderToValue(const EventHeader& header);
+
+// Reads a header from its Value form. Missing fields are left unchanged.
+// @param value the Value form of a header.
+// @param header receives the fields of |value|.
+void EventHeaderFromValue(const Value* value, EventHeader* header);
+
+// Retrieves a field of a header, by its name in the Value form of the header.
+// @param header the header holding the field.
+// @param name the name of the field.
+// @param value receives the value of the field.
+// @returns true if the field exists, false otherwise.
+bool GetEventHeaderField(const EventHeader& header,
+                         Atom name,
+                         Variant* value);
+
+}  // namespace event
+
+#endif  // EVENT_EVENT_HEADER_H_
@@ -0,0 +1,92 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/event_header.h"
+
+#include "event/event.h"
+#include "event/value.h"
+#include "event/variant.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+TEST(EventHeaderTest, Constructor) {
+  EventHeader header;
+  EXPECT_EQ(EventType(), header.type);
+  EXPECT_EQ(0U, header.process_id);
+  EXPECT_EQ(0U, header.thread_id);
+  EXPECT_EQ(0U, header.processor_number);
+  EXPECT_EQ(0U, header.flags);
+}
+
+TEST(EventHeaderTest, ToValueAndBack) {
+  EventHeader header;
+  header.type = EventType::Register(Atom::Intern("Thread"),
+                                    Atom::Intern("CSwitch"));
+  header.process_id = 4;
+  header.thread_id = 2252;
+  header.processor_number = 3;
+  header.flags = 0x40;
+
+  StructValue expected;
+  expected.AddField<StringValue>(kOperationFieldName, "CSwitch");
+  expected.AddField<StringValue>(kCategoryFieldName, "Thread");
+  expected.AddField<ULongValue>(kProcessIdFieldName, 4);
+  expected.AddField<ULongValue>(kThreadIdFieldName, 2252);
+  expected.AddField<UCharValue>(kProcessorNumberFieldName, 3);
+
+  std::unique_ptr<StructValue> value = EventHeaderToValue(header);
+  EXPECT_TRUE(expected.Equals(value.get()));
+
+  // The flags have no Value form.
+  EventHeader read;
+  EventHeaderFromValue(value.get(), &read);
+  EXPECT_EQ(header.type, read.type);
+  EXPECT_EQ(header.process_id, read.process_id);
+  EXPECT_EQ(header.thread_id, read.thread_id);
+  EXPECT_EQ(header.processor_number, read.processor_number);
+  EXPECT_EQ(0U, read.flags);
+}
+
+TEST(EventHeaderTest, GetField) {
+  EventHeader header;
+  header.type = EventType::Register(Atom::Intern("Thread"), Atom());
+  header.processor_number = 3;
+
+  Variant value;
+  std::string category;
+  uint32_t processor_number = 0;
+  EXPECT_TRUE(GetEventHeaderField(header, Atom::Intern(kCategoryFieldName),
+                                  &value));
+  EXPECT_TRUE(value.GetAsString(&category));
+  EXPECT_EQ("Thread", category);
+  EXPECT_TRUE(GetEventHeaderField(
+      header, Atom::Intern(kProcessorNumberFieldName), &value));
+  EXPECT_TRUE(value.GetAsUInteger(&processor_number));
+  EXPECT_EQ(3U, processor_number);
+  EXPECT_FALSE(GetEventHeaderField(header, Atom::Intern("flags"), &value));
+}
+
+}  // namespace event
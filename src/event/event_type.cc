@@ -0,0 +1,132 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/event_type.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "base/base.h"
+#include "base/logging.h"
+
+namespace event {
+
+namespace {
+
+// As in the atom table, the names are kept in fixed-size chunks which are
+// never moved, so that they can be read without taking the lock.
+const size_t kChunkSize = 256;
+const size_t kMaxChunks = 256;
+
+struct EventTypeNames {
+  Atom category;
+  Atom operation;
+};
+
+class EventTypeTable {
+ public:
+  EventTypeTable() : size_(0) {
+    for (size_t i = 0; i < kMaxChunks; ++i)
+      chunks_[i].store(nullptr, std::memory_order_relaxed);
+    // The unknown type is always the type 0.
+    Insert(Atom(), Atom());
+  }
+
+  ~EventTypeTable() {
+    for (size_t i = 0; i < kMaxChunks; ++i)
+      delete[] chunks_[i].load(std::memory_order_relaxed);
+  }
+
+  EventType::Id Register(Atom category, Atom operation) {
+    std::lock_guard<std::mutex> lock(lock_);
+    Ids::const_iterator look = ids_.find(Key(category, operation));
+    if (look != ids_.end())
+      return look->second;
+    return Insert(category, operation);
+  }
+
+  const EventTypeNames& Get(EventType::Id id) const {
+    DCHECK_LT(id, size_.load(std::memory_order_acquire));
+    const EventTypeNames* chunk =
+        chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    return chunk[id % kChunkSize];
+  }
+
+ private:
+  typedef std::pair<Atom, Atom> Key;
+  typedef std::map<Key, EventType::Id> Ids;
+
+  // Must be called with |lock_| held.
+  EventType::Id Insert(Atom category, Atom operation) {
+    EventType::Id id = size_.load(std::memory_order_relaxed);
+    size_t chunk_index = id / kChunkSize;
+    if (chunk_index >= kMaxChunks)
+      LOG(FATAL) << "Too many event types.";
+
+    EventTypeNames* chunk =
+        chunks_[chunk_index].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      chunk = new EventTypeNames[kChunkSize];
+      chunks_[chunk_index].store(chunk, std::memory_order_release);
+    }
+    chunk[id % kChunkSize].category = category;
+    chunk[id % kChunkSize].operation = operation;
+
+    ids_.insert(std::make_pair(Key(category, operation), id));
+    size_.store(id + 1, std::memory_order_release);
+    return id;
+  }
+
+  std::mutex lock_;
+  Ids ids_;
+  std::atomic<EventType::Id> size_;
+  std::atomic<EventTypeNames*> chunks_[kMaxChunks];
+
+  DISALLOW_COPY_AND_ASSIGN(EventTypeTable);
+};
+
+EventTypeTable* GetEventTypeTable() {
+  // The table is leaked to remain valid during static destruction.
+  static EventTypeTable* table = new EventTypeTable();
+  return table;
+}
+
+}  // namespace
+
+EventType EventType::Register(Atom category, Atom operation) {
+  return EventType(GetEventTypeTable()->Register(category, operation));
+}
+
+Atom EventType::category() const {
+  return GetEventTypeTable()->Get(id_).category;
+}
+
+Atom EventType::operation() const {
+  return GetEventTypeTable()->Get(id_).operation;
+}
+
+}  // namespace event
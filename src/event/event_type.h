@@ -0,0 +1,87 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An EventType identifies the kind of an event: a pair of a category and an
+// operation (e.g. "Thread" and "CSwitch"). Types are registered once in a
+// process-wide registry, typically when a decoder builds its tables, and
+// receive dense integer identifiers. Consumers dispatch on the identifier
+// instead of comparing names; the names remain available for display.
+//
+// Usage example:
+//   const EventType kCSwitch =
+//       EventType::Register(Atom::Intern("Thread"), Atom::Intern("CSwitch"));
+//   if (event.event_header().type == kCSwitch)
+//     ...
+
+#ifndef EVENT_EVENT_TYPE_H_
+#define EVENT_EVENT_TYPE_H_
+
+#include <stdint.h>
+
+#include "event/atom.h"
+
+namespace event {
+
+class EventType {
+ public:
+  typedef uint32_t Id;
+
+  // Constructs the unknown type, which has an empty category and an empty
+  // operation.
+  EventType() : id_(0) {
+  }
+
+  // Returns the type of a pair of category and operation, registering the
+  // pair if needed. Registration is thread-safe.
+  // @param category the name of the category.
+  // @param operation the name of the operation.
+  // @returns the type of the pair.
+  static EventType Register(Atom category, Atom operation);
+
+  // Returns the names of this type. Reading them does not take a lock.
+  // @{
+  Atom category() const;
+  Atom operation() const;
+  // @}
+
+  // Returns the numeric identifier of this type. Identifiers are dense and
+  // start at 0 for the unknown type; they are stable for the lifetime of the
+  // process.
+  Id id() const { return id_; }
+
+  bool operator==(const EventType& other) const { return id_ == other.id_; }
+  bool operator!=(const EventType& other) const { return id_ != other.id_; }
+  bool operator<(const EventType& other) const { return id_ < other.id_; }
+
+ private:
+  explicit EventType(Id id) : id_(id) {
+  }
+
+  Id id_;
+};
+
+}  // namespace event
+
+#endif  // EVENT_EVENT_TYPE_H_
@@ -0,0 +1,92 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/event_type.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace event {
+
+TEST(EventTypeTest, Unknown) {
+  EventType type;
+  EXPECT_EQ(0U, type.id());
+  EXPECT_EQ(Atom(), type.category());
+  EXPECT_EQ(Atom(), type.operation());
+  EXPECT_EQ(type, EventType::Register(Atom(), Atom()));
+}
+
+TEST(EventTypeTest, Register) {
+  const Atom kCategory = Atom::Intern("EventTypeTestCategory");
+  const Atom kOperation = Atom::Intern("EventTypeTestOperation");
+  const Atom kOther = Atom::Intern("EventTypeTestOther");
+
+  EventType first = EventType::Register(kCategory, kOperation);
+  EventType second = EventType::Register(kCategory, kOperation);
+  EventType other_operation = EventType::Register(kCategory, kOther);
+  EventType other_category = EventType::Register(kOther, kOperation);
+
+  EXPECT_EQ(first, second);
+  EXPECT_NE(EventType(), first);
+  EXPECT_NE(first, other_operation);
+  EXPECT_NE(first, other_category);
+  EXPECT_NE(other_operation, other_category);
+
+  EXPECT_EQ(kCategory, first.category());
+  EXPECT_EQ(kOperation, first.operation());
+  EXPECT_EQ(kOther, other_category.category());
+  EXPECT_EQ(kOperation, other_category.operation());
+}
+
+TEST(EventTypeTest, ConcurrentRegister) {
+  const int kThreads = 4;
+  const int kTypes = 300;
+
+  std::vector<std::vector<EventType> > types(kThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(std::thread([i, &types] {
+      for (int j = 0; j < kTypes; ++j) {
+        types[i].push_back(EventType::Register(
+            Atom::Intern("EventTypeTestConcurrent"),
+            Atom::Intern("Operation" + std::to_string(j))));
+      }
+    }));
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (int i = 1; i < kThreads; ++i)
+    EXPECT_EQ(types[0], types[i]);
+  for (int j = 0; j < kTypes; ++j) {
+    EXPECT_EQ("Operation" + std::to_string(j),
+              types[0][j].operation().str());
+  }
+}
+
+}  // namespace event
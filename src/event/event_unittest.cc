@@ -25,11 +25,35 @@
 
 #include "event/event.h"
 #include "event/value.h"
+#include "event/variant.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace event {
 
+namespace {
+
+// Returns a given payload and counts the calls to Decode().
+class CountingLazyPayload : public LazyPayload {
+ public:
+  explicit CountingLazyPayload(const Value* payload)
+      : payload_(payload), decode_count_(0) {
+  }
+
+  const Value* Decode() const override {
+    ++decode_count_;
+    return payload_;
+  }
+
+  int decode_count() const { return decode_count_; }
+
+ private:
+  const Value* payload_;
+  mutable int decode_count_;
+};
+
+}  // namespace
+
 TEST(EventTest, ConstructorAndAccessors) {
   std::unique_ptr<const Value> header(new IntValue(1337));
   std::unique_ptr<const Value> payload(new IntValue(42));
@@ -40,4 +64,145 @@ TEST(EventTest, ConstructorAndAccessors) {
   EXPECT_EQ(42, IntValue::Cast(event.payload())->GetValue());
 }
 
+TEST(EventTest, NonOwningConstructor) {
+  IntValue header(1337);
+  IntValue payload(42);
+  Event event(Timestamp(123456U), &header, &payload);
+
+  EXPECT_EQ(123456U, event.timestamp());
+  EXPECT_EQ(&header, event.header());
+  EXPECT_EQ(&payload, event.payload());
+}
+
+TEST(EventTest, VariantConstructor) {
+  const std::string kOperation = "CSwitch";
+  VariantStruct header;
+  header.AddField(Atom::Intern(kOperationFieldName),
+                  Variant::FromString(&kOperation));
+  header.AddField<ULongValue>(Atom::Intern(kProcessIdFieldName), 4);
+  VariantStruct payload;
+  payload.AddField<UIntValue>(Atom::Intern("NewThreadId"), 2252);
+  Event event(Timestamp(123456U), &header, &payload);
+
+  Variant field;
+  uint64_t process_id = 0;
+  EXPECT_TRUE(event.GetHeaderField(Atom::Intern(kProcessIdFieldName), &field));
+  EXPECT_TRUE(field.GetAsULong(&process_id));
+  EXPECT_EQ(4U, process_id);
+  EXPECT_FALSE(event.GetPayloadField(Atom::Intern("OldThreadId"), &field));
+
+  // The Value form is created on demand.
+  std::string operation;
+  uint32_t new_thread_id = 0;
+  ASSERT_TRUE(event.header() != nullptr);
+  EXPECT_EQ(event.header(), event.header());
+  EXPECT_TRUE(event.header()->GetFieldAsString(kOperationFieldName,
+                                               &operation));
+  EXPECT_EQ(kOperation, operation);
+  EXPECT_TRUE(event.payload()->GetFieldAsUInteger("NewThreadId",
+                                                  &new_thread_id));
+  EXPECT_EQ(2252U, new_thread_id);
+}
+
+TEST(EventTest, VariantAccessorsOnValues) {
+  std::unique_ptr<StructValue> header(new StructValue());
+  header->AddField<StringValue>(kOperationFieldName, "CSwitch");
+  std::unique_ptr<StructValue> payload(new StructValue());
+  payload->AddField<UIntValue>("NewThreadId", 2252);
+  Event event(Timestamp(123456U), std::move(header), std::move(payload));
+
+  Variant field;
+  std::string operation;
+  uint32_t new_thread_id = 0;
+  EXPECT_TRUE(event.GetHeaderField(Atom::Intern(kOperationFieldName), &field));
+  EXPECT_TRUE(field.GetAsString(&operation));
+  EXPECT_EQ("CSwitch", operation);
+  EXPECT_TRUE(event.GetPayloadField(Atom::Intern("NewThreadId"), &field));
+  EXPECT_TRUE(field.GetAsUInteger(&new_thread_id));
+  EXPECT_EQ(2252U, new_thread_id);
+  EXPECT_FALSE(event.GetPayloadField(Atom::Intern("OldThreadId"), &field));
+}
+
+TEST(EventTest, LazyPayload) {
+  IntValue header(1337);
+  StructValue payload;
+  payload.AddField<UIntValue>("NewThreadId", 2252);
+  CountingLazyPayload lazy_payload(&payload);
+  Event event(Timestamp(123456U), &header, &lazy_payload);
+
+  // Accessing the header does not decode the payload.
+  EXPECT_EQ(&header, event.header());
+  EXPECT_EQ(0, lazy_payload.decode_count());
+
+  Variant field;
+  uint32_t new_thread_id = 0;
+  EXPECT_TRUE(event.GetPayloadField(Atom::Intern("NewThreadId"), &field));
+  EXPECT_TRUE(field.GetAsUInteger(&new_thread_id));
+  EXPECT_EQ(2252U, new_thread_id);
+  EXPECT_EQ(1, lazy_payload.decode_count());
+
+  // The payload is decoded once.
+  EXPECT_EQ(&payload, event.payload());
+  EXPECT_EQ(&payload, event.payload());
+  EXPECT_EQ(1, lazy_payload.decode_count());
+}
+
+TEST(EventTest, LazyPayloadFailure) {
+  IntValue header(1337);
+  CountingLazyPayload lazy_payload(nullptr);
+  Event event(Timestamp(123456U), &header, &lazy_payload);
+
+  Variant field;
+  EXPECT_TRUE(event.payload() == nullptr);
+  EXPECT_FALSE(event.GetPayloadField(Atom::Intern("NewThreadId"), &field));
+  EXPECT_EQ(1, lazy_payload.decode_count());
+}
+
+TEST(EventTest, TypedHeader) {
+  EventHeader header;
+  header.type = EventType::Register(Atom::Intern("Thread"),
+                                    Atom::Intern("CSwitch"));
+  header.process_id = 4;
+  header.thread_id = 2252;
+  header.processor_number = 3;
+  IntValue payload(42);
+  Event event(Timestamp(123456U), header, &payload);
+
+  EXPECT_TRUE(event.has_typed_header());
+  EXPECT_EQ(Atom::Intern("CSwitch"), event.event_header().type.operation());
+  EXPECT_EQ(4U, event.event_header().process_id);
+  EXPECT_EQ(&payload, event.payload());
+
+  Variant field;
+  uint64_t thread_id = 0;
+  EXPECT_TRUE(event.GetHeaderField(Atom::Intern(kThreadIdFieldName), &field));
+  EXPECT_TRUE(field.GetAsULong(&thread_id));
+  EXPECT_EQ(2252U, thread_id);
+  EXPECT_FALSE(event.GetHeaderField(Atom::Intern("unknown"), &field));
+
+  // The Value form is created on demand.
+  std::string category;
+  ASSERT_TRUE(event.header() != nullptr);
+  EXPECT_EQ(event.header(), event.header());
+  EXPECT_TRUE(event.header()->GetFieldAsString(kCategoryFieldName,
+                                               &category));
+  EXPECT_EQ("Thread", category);
+}
+
+TEST(EventTest, TypedHeaderFromValue) {
+  std::unique_ptr<StructValue> header(new StructValue());
+  header->AddField<StringValue>(kOperationFieldName, "Load");
+  header->AddField<StringValue>(kCategoryFieldName, "Image");
+  header->AddField<ULongValue>(kProcessIdFieldName, 12);
+  std::unique_ptr<const Value> payload(new IntValue(42));
+  Event event(Timestamp(123456U), std::move(header), std::move(payload));
+
+  EXPECT_FALSE(event.has_typed_header());
+  const EventHeader& event_header = event.event_header();
+  EXPECT_EQ(EventType::Register(Atom::Intern("Image"), Atom::Intern("Load")),
+            event_header.type);
+  EXPECT_EQ(12U, event_header.process_id);
+  EXPECT_EQ(0U, event_header.thread_id);
+}
+
 }  // namespace event
@@ -0,0 +1,266 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/fast_event_formatter.h"
+
+#include <stdio.h>
+
+#include "base/logging.h"
+#include "base/w16_string.h"
+#include "event/value.h"
+#include "event/value_visitor.h"
+
+namespace event {
+
+namespace {
+
+// Appends the decimal representation of an unsigned integer.
+void AppendUnsigned(uint64_t value, std::string* buffer) {
+  char digits[20];
+  size_t length = 0;
+  do {
+    digits[length++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  while (length > 0)
+    buffer->push_back(digits[--length]);
+}
+
+// Appends the decimal representation of a signed integer.
+void AppendSigned(int64_t value, std::string* buffer) {
+  if (value < 0) {
+    buffer->push_back('-');
+    // Negate in unsigned arithmetic to support the minimal value.
+    AppendUnsigned(0 - static_cast<uint64_t>(value), buffer);
+    return;
+  }
+  AppendUnsigned(static_cast<uint64_t>(value), buffer);
+}
+
+// Appends a floating point number the way std::ostream does by default,
+// i.e. with 6 significant digits.
+void AppendFloating(double value, std::string* buffer) {
+  char digits[32];
+  int length = snprintf(digits, sizeof(digits), "%g", value);
+  DCHECK(length > 0 && length < static_cast<int>(sizeof(digits)));
+  buffer->append(digits, length);
+}
+
+// Appends the textual representation of the visited values to a buffer.
+class FormatterVisitor : public ValueVisitor {
+ public:
+  FormatterVisitor(std::string* buffer, std::wstring* scratch)
+      : buffer_(buffer), scratch_(scratch), indent_(0), succeeded_(true) {
+    DCHECK(buffer != nullptr);
+    DCHECK(scratch != nullptr);
+  }
+
+  // Returns false if a visited value has no textual representation.
+  bool succeeded() const { return succeeded_; }
+
+  // Overridden from ValueVisitor:
+  // @{
+  void Visit(const BoolValue& value) override {
+    succeeded_ = false;
+  }
+  void Visit(const CharValue& value) override {
+    AppendSigned(value.GetValue(), buffer_);
+  }
+  void Visit(const UCharValue& value) override {
+    AppendUnsigned(value.GetValue(), buffer_);
+  }
+  void Visit(const ShortValue& value) override {
+    AppendSigned(value.GetValue(), buffer_);
+  }
+  void Visit(const UShortValue& value) override {
+    AppendUnsigned(value.GetValue(), buffer_);
+  }
+  void Visit(const IntValue& value) override {
+    AppendSigned(value.GetValue(), buffer_);
+  }
+  void Visit(const UIntValue& value) override {
+    AppendUnsigned(value.GetValue(), buffer_);
+  }
+  void Visit(const LongValue& value) override {
+    AppendSigned(value.GetValue(), buffer_);
+  }
+  void Visit(const ULongValue& value) override {
+    AppendUnsigned(value.GetValue(), buffer_);
+  }
+  void Visit(const FloatValue& value) override {
+    AppendFloating(value.GetValue(), buffer_);
+  }
+  void Visit(const DoubleValue& value) override {
+    AppendFloating(value.GetValue(), buffer_);
+  }
+
+  void Visit(const StringValue& value) override {
+    buffer_->push_back('"');
+    buffer_->append(value.GetValue());
+    buffer_->push_back('"');
+  }
+
+  void Visit(const WStringValue& value) override {
+    AppendNarrowed(value.GetValue());
+  }
+
+  void Visit(const StringViewValue& value) override {
+    buffer_->push_back('"');
+    buffer_->append(value.GetValue().data(), value.GetValue().size());
+    buffer_->push_back('"');
+  }
+
+  void Visit(const W16StringViewValue& value) override {
+    scratch_->clear();
+    base::AppendW16String(value.GetValue().data(), value.length(), scratch_);
+    AppendNarrowed(*scratch_);
+  }
+
+  void Visit(const StructValue& value) override {
+    size_t indent = indent_;
+    buffer_->append("{\n");
+    indent_ += 4;
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end() && succeeded_; ++it) {
+      buffer_->append(indent_, ' ');
+      buffer_->append(it->first.str());
+      buffer_->append(" = ");
+      it->second->Accept(this);
+      buffer_->push_back('\n');
+    }
+    indent_ = indent;
+    buffer_->append(indent_, ' ');
+    buffer_->push_back('}');
+  }
+
+  void Visit(const ArrayValue& value) override {
+    size_t indent = indent_;
+    buffer_->append("[\n");
+    indent_ += 4;
+    ArrayValue::const_iterator it = value.begin();
+    for (; it != value.end() && succeeded_; ++it) {
+      buffer_->append(indent_, ' ');
+      (*it)->Accept(this);
+      buffer_->push_back('\n');
+    }
+    indent_ = indent;
+    buffer_->append(indent_, ' ');
+    buffer_->push_back(']');
+  }
+  // @}
+
+ private:
+  // Appends a quoted wide string, narrowed as base::WStringToString does.
+  void AppendNarrowed(const std::wstring& value) {
+    buffer_->push_back('"');
+    for (wchar_t c : value)
+      buffer_->push_back(static_cast<char>(c));
+    buffer_->push_back('"');
+  }
+
+  std::string* buffer_;
+  std::wstring* scratch_;
+  size_t indent_;
+  bool succeeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(FormatterVisitor);
+};
+
+// Appends a header the way its Value form (see event_header.h) is formatted.
+void AppendHeader(const EventHeader& header, std::string* buffer) {
+  buffer->append("{\n    ");
+  buffer->append(kOperationFieldName);
+  buffer->append(" = \"");
+  buffer->append(header.type.operation().str());
+  buffer->append("\"\n    ");
+  buffer->append(kCategoryFieldName);
+  buffer->append(" = \"");
+  buffer->append(header.type.category().str());
+  buffer->append("\"\n    ");
+  buffer->append(kProcessIdFieldName);
+  buffer->append(" = ");
+  AppendUnsigned(header.process_id, buffer);
+  buffer->append("\n    ");
+  buffer->append(kThreadIdFieldName);
+  buffer->append(" = ");
+  AppendUnsigned(header.thread_id, buffer);
+  buffer->append("\n    ");
+  buffer->append(kProcessorNumberFieldName);
+  buffer->append(" = ");
+  AppendUnsigned(header.processor_number, buffer);
+  buffer->append("\n}");
+}
+
+}  // namespace
+
+FastEventFormatter::FastEventFormatter() {
+}
+
+bool FastEventFormatter::AppendEvent(const Event& event,
+                                     std::string* buffer) const {
+  DCHECK(buffer != nullptr);
+  size_t initial_size = buffer->size();
+
+  buffer->push_back('[');
+  AppendUnsigned(event.timestamp(), buffer);
+  buffer->append("] event ");
+  // A typed header is formatted without creating its Value form.
+  if (event.has_typed_header()) {
+    AppendHeader(event.event_header(), buffer);
+  } else if (!AppendValue(event.header(), buffer)) {
+    buffer->resize(initial_size);
+    return false;
+  }
+  buffer->push_back(' ');
+  // A lazy payload which fails to decode is shown as an empty structure.
+  const Value* payload = event.payload();
+  if (payload == nullptr) {
+    buffer->append("{\n}");
+  } else if (!AppendValue(payload, buffer)) {
+    buffer->resize(initial_size);
+    return false;
+  }
+
+  return true;
+}
+
+bool FastEventFormatter::AppendValue(const Value* value,
+                                     std::string* buffer) const {
+  DCHECK(value != nullptr);
+  DCHECK(buffer != nullptr);
+  size_t initial_size = buffer->size();
+
+  FormatterVisitor visitor(buffer, &scratch_);
+  value->Accept(&visitor);
+  if (!visitor.succeeded()) {
+    buffer->resize(initial_size);
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace event
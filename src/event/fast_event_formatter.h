@@ -0,0 +1,78 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// FastEventFormatter produces the same textual representation as
+// event::ToString (see utils.h), appended into a buffer owned by the caller.
+// The buffer is meant to be reused across events: once its capacity has
+// grown, formatting an event does not allocate.
+//
+// Usage example:
+//   FastEventFormatter formatter;
+//   std::string buffer;
+//   for each event:
+//     formatter.AppendEvent(event, &buffer);
+//     buffer.push_back('\n');
+//     if (buffer.size() > kFlushThreshold) { write(buffer); buffer.clear(); }
+
+#ifndef EVENT_FAST_EVENT_FORMATTER_H_
+#define EVENT_FAST_EVENT_FORMATTER_H_
+
+#include <string>
+
+#include "base/base.h"
+#include "event/event.h"
+
+namespace event {
+
+class FastEventFormatter {
+ public:
+  FastEventFormatter();
+
+  // Appends the textual representation of an event to |buffer|. A payload
+  // which fails to decode (see LazyPayload) is formatted as an empty
+  // structure.
+  // @param event the event to format.
+  // @param buffer the buffer receiving the representation.
+  // @returns true if the conversion was successful, false otherwise and
+  //     |buffer| stays unchanged.
+  bool AppendEvent(const Event& event, std::string* buffer) const;
+
+  // Appends the textual representation of a Value to |buffer|.
+  // @param value the value to format.
+  // @param buffer the buffer receiving the representation.
+  // @returns true if the conversion was successful, false otherwise and
+  //     |buffer| stays unchanged.
+  bool AppendValue(const Value* value, std::string* buffer) const;
+
+ private:
+  // Reused storage for the decoding of 16-bit strings.
+  mutable std::wstring scratch_;
+
+  DISALLOW_COPY_AND_ASSIGN(FastEventFormatter);
+};
+
+}  // namespace event
+
+#endif  // EVENT_FAST_EVENT_FORMATTER_H_
@@ -0,0 +1,170 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/fast_event_formatter.h"
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event/string_view_value.h"
+#include "event/utils.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+// Expects |value| to be formatted like event::ToString does.
+void ExpectSameAsToString(const Value* value) {
+  std::string expected;
+  ASSERT_TRUE(ToString(value, &expected));
+
+  FastEventFormatter formatter;
+  std::string buffer;
+  EXPECT_TRUE(formatter.AppendValue(value, &buffer));
+  EXPECT_EQ(expected, buffer);
+}
+
+// A lazy payload which fails to decode.
+class FailingLazyPayload : public LazyPayload {
+ public:
+  const Value* Decode() const override { return nullptr; }
+};
+
+}  // namespace
+
+TEST(FastEventFormatterTest, Scalars) {
+  std::vector<std::unique_ptr<Value>> values;
+  values.emplace_back(new CharValue(std::numeric_limits<int8_t>::min()));
+  values.emplace_back(new UCharValue(std::numeric_limits<uint8_t>::max()));
+  values.emplace_back(new ShortValue(-1234));
+  values.emplace_back(new UShortValue(0));
+  values.emplace_back(new IntValue(std::numeric_limits<int32_t>::min()));
+  values.emplace_back(new UIntValue(std::numeric_limits<uint32_t>::max()));
+  values.emplace_back(new LongValue(std::numeric_limits<int64_t>::min()));
+  values.emplace_back(new LongValue(std::numeric_limits<int64_t>::max()));
+  values.emplace_back(new ULongValue(std::numeric_limits<uint64_t>::max()));
+  values.emplace_back(new ULongValue(10));
+  values.emplace_back(new FloatValue(.5f));
+  values.emplace_back(new FloatValue(1.0f / 3));
+  values.emplace_back(new DoubleValue(-.25));
+  values.emplace_back(new DoubleValue(1e100));
+  values.emplace_back(new DoubleValue(123456789.0));
+  values.emplace_back(new DoubleValue(0.000012345));
+  values.emplace_back(new StringValue("dummy"));
+  values.emplace_back(new WStringValue(L"dummy"));
+  values.emplace_back(new StringViewValue(base::Span<const char>("dummy", 5)));
+  values.emplace_back(
+      new W16StringViewValue(base::Span<const char>("d\0u\0m\0", 6)));
+
+  for (const auto& value : values)
+    ExpectSameAsToString(value.get());
+}
+
+TEST(FastEventFormatterTest, Aggregates) {
+  StructValue fields;
+  fields.AddField<IntValue>("field", 12);
+  StructValue* inner = fields.AddStructField("inner");
+  inner->AddField<StringValue>("name", "dummy");
+  ArrayValue* array = inner->AddArrayField("array");
+  array->Append<ULongValue>(1);
+  array->Append(std::unique_ptr<Value>(new StructValue()));
+  fields.AddArrayField("empty");
+
+  ExpectSameAsToString(&fields);
+}
+
+TEST(FastEventFormatterTest, Event) {
+  std::unique_ptr<StructValue> header(new StructValue());
+  header->AddField<IntValue>("field", 1337);
+  std::unique_ptr<StructValue> payload(new StructValue());
+  payload->AddField<IntValue>("field", 12);
+  Event event(42, std::move(header), std::move(payload));
+
+  std::string expected;
+  ASSERT_TRUE(ToString(event, &expected));
+
+  // Events are appended to the content of the buffer.
+  FastEventFormatter formatter;
+  std::string buffer = "previous\n";
+  EXPECT_TRUE(formatter.AppendEvent(event, &buffer));
+  EXPECT_EQ("previous\n" + expected, buffer);
+}
+
+TEST(FastEventFormatterTest, TypedHeaderEvent) {
+  EventHeader header;
+  header.type = EventType::Register(Atom::Intern("Thread"),
+                                    Atom::Intern("CSwitch"));
+  header.process_id = 4;
+  header.thread_id = 2252;
+  header.processor_number = 3;
+  StructValue payload;
+  payload.AddField<IntValue>("field", 12);
+  Event event(42, header, &payload);
+
+  // The typed header is formatted like its Value form.
+  FastEventFormatter formatter;
+  std::string buffer;
+  EXPECT_TRUE(formatter.AppendEvent(event, &buffer));
+
+  std::string expected;
+  ASSERT_TRUE(ToString(event, &expected));
+  EXPECT_EQ(expected, buffer);
+}
+
+TEST(FastEventFormatterTest, EventWithFailedLazyPayload) {
+  StructValue header;
+  header.AddField<IntValue>("field", 1337);
+  FailingLazyPayload lazy_payload;
+  Event event(42, &header, &lazy_payload);
+
+  FastEventFormatter formatter;
+  std::string buffer;
+  EXPECT_TRUE(formatter.AppendEvent(event, &buffer));
+  EXPECT_EQ("[42] event {\n    field = 1337\n} {\n}", buffer);
+}
+
+TEST(FastEventFormatterTest, Failure) {
+  std::unique_ptr<StructValue> header(new StructValue());
+  header->AddField<IntValue>("field", 1337);
+  std::unique_ptr<StructValue> payload(new StructValue());
+  payload->AddField<IntValue>("field", 12);
+  payload->AddField<BoolValue>("unsupported", true);
+  Event event(42, std::move(header), std::move(payload));
+
+  std::string dummy;
+  EXPECT_FALSE(ToString(event, &dummy));
+
+  // The buffer is left unchanged on failure.
+  FastEventFormatter formatter;
+  std::string buffer = "previous\n";
+  EXPECT_FALSE(formatter.AppendEvent(event, &buffer));
+  EXPECT_EQ("previous\n", buffer);
+}
+
+}  // namespace event
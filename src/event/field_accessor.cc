@@ -0,0 +1,143 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/field_accessor.h"
+
+#include "event/struct_schema.h"
+
+namespace event {
+
+FieldAccessor::FieldAccessor(Atom name)
+    : name_(name),
+      schema_(nullptr),
+      position_(0),
+      resolved_(false) {
+}
+
+FieldAccessor::FieldAccessor(const std::string& name)
+    : name_(Atom::Intern(name)),
+      schema_(nullptr),
+      position_(0),
+      resolved_(false) {
+}
+
+const Value* FieldAccessor::GetField(const Value* fields) const {
+  DCHECK(fields != nullptr);
+  if (!StructValue::InstanceOf(fields))
+    return fields->GetField(name_);
+
+  const StructValue* strct = StructValue::Cast(fields);
+  StructValue::const_iterator begin = strct->fields_begin();
+  size_t size = strct->fields_end() - begin;
+
+  // Fast path: the field is at the cached position. Fields of a structure
+  // with a schema are at the position given by the schema.
+  if (resolved_ && strct->schema() == schema_ && position_ < size &&
+      (schema_ != nullptr || begin[position_].first == name_)) {
+    return begin[position_].second;
+  }
+
+  return Resolve(strct);
+}
+
+const Value* FieldAccessor::Resolve(const StructValue* fields) const {
+  DCHECK(fields != nullptr);
+
+  const StructSchema* schema = fields->schema();
+  StructValue::const_iterator begin = fields->fields_begin();
+  size_t size = fields->fields_end() - begin;
+
+  if (schema != nullptr) {
+    size_t index = 0;
+    if (!schema->FindField(name_, &index))
+      return nullptr;
+    schema_ = schema;
+    position_ = index;
+    resolved_ = true;
+    return index < size ? begin[index].second : nullptr;
+  }
+
+  for (size_t index = 0; index < size; ++index) {
+    if (begin[index].first == name_) {
+      schema_ = nullptr;
+      position_ = index;
+      resolved_ = true;
+      return begin[index].second;
+    }
+  }
+
+  return nullptr;
+}
+
+bool FieldAccessor::GetFieldAsInteger(const Value* fields,
+                                      int32_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsInteger(value);
+}
+
+bool FieldAccessor::GetFieldAsUInteger(const Value* fields,
+                                       uint32_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsUInteger(value);
+}
+
+bool FieldAccessor::GetFieldAsLong(const Value* fields,
+                                   int64_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsLong(value);
+}
+
+bool FieldAccessor::GetFieldAsULong(const Value* fields,
+                                    uint64_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsULong(value);
+}
+
+bool FieldAccessor::GetFieldAsFloating(const Value* fields,
+                                       double* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsFloating(value);
+}
+
+bool FieldAccessor::GetFieldAsString(const Value* fields,
+                                     std::string* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsString(value);
+}
+
+bool FieldAccessor::GetFieldAsWString(const Value* fields,
+                                      std::wstring* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(fields);
+  return field != nullptr && field->GetAsWString(value);
+}
+
+}  // namespace event
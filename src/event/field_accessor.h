@@ -0,0 +1,120 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A FieldAccessor reads a named field of structures which usually share the
+// same layout, e.g. the payloads of a given kind of event. The position of
+// the field is resolved on the first structure and cached: following reads
+// check the cached position and only scan the structure when the layout
+// differs. Structures with a schema are resolved once per schema.
+//
+// An accessor holds a cache and must not be shared between threads.
+//
+// Usage example:
+//   FieldAccessor module_size("ModuleSize");
+//   ...
+//   uint32_t size = 0;
+//   if (module_size.GetFieldAsUInteger(event.payload(), &size))
+//     ...
+
+#ifndef EVENT_FIELD_ACCESSOR_H_
+#define EVENT_FIELD_ACCESSOR_H_
+
+#include <string>
+
+#include "base/logging.h"
+#include "event/atom.h"
+#include "event/value.h"
+
+namespace event {
+
+class FieldAccessor {
+ public:
+  // @param name the name of the field to read.
+  // @{
+  explicit FieldAccessor(Atom name);
+  explicit FieldAccessor(const std::string& name);
+  // @}
+
+  // Returns the name of the field read by this accessor.
+  Atom name() const { return name_; }
+
+  // Retrieve the field of |fields|.
+  // @param fields the structure holding the field.
+  // @returns the value of the field if the field is found, nullptr otherwise.
+  const Value* GetField(const Value* fields) const;
+
+  // Retrieve the field of |fields| with a given type.
+  // @tparam T the type to cast the field value.
+  // @param fields the structure holding the field.
+  // @param value receives the value of the field.
+  // @returns true if the field is found and of the specified type, false
+  //     otherwise.
+  template<class T>
+  bool GetFieldAs(const Value* fields, const T** value) const {
+    DCHECK(value != nullptr);
+    const Value* field = GetField(fields);
+    if (field == nullptr || !T::InstanceOf(field))
+      return false;
+    *value = T::Cast(field);
+    return true;
+  }
+
+  // These methods retrieve the field of |fields| with the same conversions as
+  // Value::GetFieldAs*.
+  // @param fields the structure holding the field.
+  // @param value receives the value holded by the field.
+  // @returns true when the conversion is valid, false otherwise and |value|
+  // stay unchanged.
+  // @{
+  bool GetFieldAsInteger(const Value* fields, int32_t* value) const;
+  bool GetFieldAsUInteger(const Value* fields, uint32_t* value) const;
+  bool GetFieldAsLong(const Value* fields, int64_t* value) const;
+  bool GetFieldAsULong(const Value* fields, uint64_t* value) const;
+  bool GetFieldAsFloating(const Value* fields, double* value) const;
+  bool GetFieldAsString(const Value* fields, std::string* value) const;
+  bool GetFieldAsWString(const Value* fields, std::wstring* value) const;
+  // @}
+
+ private:
+  // Finds the field in a structure and updates the cached position.
+  const Value* Resolve(const StructValue* fields) const;
+
+  // The name of the field.
+  Atom name_;
+
+  // The schema on which |position_| has been resolved, or nullptr when it has
+  // been resolved on a structure without a schema.
+  mutable const StructSchema* schema_;
+
+  // The cached position of the field.
+  mutable size_t position_;
+
+  // Whether |position_| holds a resolved position.
+  mutable bool resolved_;
+};
+
+}  // namespace event
+
+#endif  // EVENT_FIELD_ACCESSOR_H_
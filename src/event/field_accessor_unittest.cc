@@ -0,0 +1,158 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/field_accessor.h"
+
+#include <memory>
+#include <string>
+
+#include "event/struct_schema.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+TEST(FieldAccessorTest, DynamicStruct) {
+  FieldAccessor accessor("size");
+  EXPECT_EQ(Atom::Intern("size"), accessor.name());
+
+  StructValue first;
+  first.AddField<IntValue>("name", 1);
+  first.AddField<UIntValue>("size", 42);
+
+  uint32_t size = 0;
+  EXPECT_TRUE(accessor.GetFieldAsUInteger(&first, &size));
+  EXPECT_EQ(42U, size);
+
+  // Same layout.
+  StructValue second;
+  second.AddField<IntValue>("name", 2);
+  second.AddField<UIntValue>("size", 43);
+  EXPECT_TRUE(accessor.GetFieldAsUInteger(&second, &size));
+  EXPECT_EQ(43U, size);
+
+  // Different layout.
+  StructValue third;
+  third.AddField<UIntValue>("size", 44);
+  EXPECT_TRUE(accessor.GetFieldAsUInteger(&third, &size));
+  EXPECT_EQ(44U, size);
+
+  // Same position, different field.
+  StructValue fourth;
+  fourth.AddField<UIntValue>("other", 45);
+  EXPECT_EQ(nullptr, accessor.GetField(&fourth));
+
+  // Back to the first layout.
+  EXPECT_EQ(first.GetField("size"), accessor.GetField(&first));
+}
+
+TEST(FieldAccessorTest, SchemaStruct) {
+  StructSchema schema;
+  schema.AddField<UIntValue>("id");
+  schema.AddField<ULongValue>("address");
+  StructSchema other_schema;
+  other_schema.AddField<ULongValue>("address");
+
+  FieldAccessor accessor("address");
+
+  SchemaStructValue first(&schema);
+  first.Append<UIntValue>(1);
+  first.Append<ULongValue>(0x1000);
+  SchemaStructValue second(&schema);
+  second.Append<UIntValue>(2);
+  second.Append<ULongValue>(0x2000);
+  SchemaStructValue other(&other_schema);
+  other.Append<ULongValue>(0x3000);
+
+  uint64_t address = 0;
+  EXPECT_TRUE(accessor.GetFieldAsULong(&first, &address));
+  EXPECT_EQ(0x1000U, address);
+  EXPECT_TRUE(accessor.GetFieldAsULong(&second, &address));
+  EXPECT_EQ(0x2000U, address);
+  EXPECT_TRUE(accessor.GetFieldAsULong(&other, &address));
+  EXPECT_EQ(0x3000U, address);
+
+  // A dynamic structure after a structure with a schema.
+  StructValue dynamic;
+  dynamic.AddField<ULongValue>("id", 3);
+  dynamic.AddField<ULongValue>("address", 0x4000);
+  EXPECT_TRUE(accessor.GetFieldAsULong(&dynamic, &address));
+  EXPECT_EQ(0x4000U, address);
+
+  // An incomplete structure.
+  SchemaStructValue incomplete(&schema);
+  incomplete.Append<UIntValue>(4);
+  EXPECT_EQ(nullptr, accessor.GetField(&incomplete));
+
+  FieldAccessor missing("missing");
+  EXPECT_EQ(nullptr, missing.GetField(&first));
+}
+
+TEST(FieldAccessorTest, Conversions) {
+  StructValue fields;
+  fields.AddField<IntValue>("int", -1);
+  fields.AddField<DoubleValue>("double", .5);
+  fields.AddField<StringValue>("string", "dummy");
+  fields.AddField<WStringValue>("wstring", L"dummy");
+  fields.AddArrayField("array")->Append<IntValue>(1);
+
+  int32_t int_value = 0;
+  int64_t long_value = 0;
+  uint32_t uint_value = 0;
+  uint64_t ulong_value = 0;
+  double double_value = 0;
+  std::string string_value;
+  std::wstring wstring_value;
+
+  EXPECT_TRUE(FieldAccessor("int").GetFieldAsInteger(&fields, &int_value));
+  EXPECT_EQ(-1, int_value);
+  EXPECT_TRUE(FieldAccessor("int").GetFieldAsLong(&fields, &long_value));
+  EXPECT_EQ(-1, long_value);
+  EXPECT_FALSE(FieldAccessor("int").GetFieldAsUInteger(&fields, &uint_value));
+  EXPECT_FALSE(FieldAccessor("int").GetFieldAsULong(&fields, &ulong_value));
+  EXPECT_TRUE(
+      FieldAccessor("double").GetFieldAsFloating(&fields, &double_value));
+  EXPECT_EQ(.5, double_value);
+  EXPECT_TRUE(
+      FieldAccessor("string").GetFieldAsString(&fields, &string_value));
+  EXPECT_EQ("dummy", string_value);
+  EXPECT_TRUE(
+      FieldAccessor("wstring").GetFieldAsWString(&fields, &wstring_value));
+  EXPECT_EQ(L"dummy", wstring_value);
+  EXPECT_FALSE(
+      FieldAccessor("missing").GetFieldAsInteger(&fields, &int_value));
+
+  const ArrayValue* array = nullptr;
+  const IntValue* int_field = nullptr;
+  EXPECT_TRUE(FieldAccessor("array").GetFieldAs<ArrayValue>(&fields, &array));
+  EXPECT_EQ(1U, array->Length());
+  EXPECT_FALSE(
+      FieldAccessor("array").GetFieldAs<IntValue>(&fields, &int_field));
+
+  // Scalars have no fields.
+  IntValue scalar(42);
+  EXPECT_EQ(nullptr, FieldAccessor("int").GetField(&scalar));
+}
+
+}  // namespace event
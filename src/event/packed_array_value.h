@@ -0,0 +1,171 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A PackedArrayValue stores scalars of a single type contiguously, instead of
+// one heap allocated Value per element. The elements are accessed without
+// virtual calls through a typed span. The generic ArrayValue interface is
+// still supported: the Values of the elements are created on first use, so
+// it must not be used concurrently from several threads.
+//
+// Usage example:
+//   PackedArrayValue<ULongValue> stack;
+//   stack.Append(0x401000ULL);
+//   for (uint64_t address : stack.elements())
+//     ...
+
+#ifndef EVENT_PACKED_ARRAY_VALUE_H_
+#define EVENT_PACKED_ARRAY_VALUE_H_
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "base/base.h"
+#include "base/logging.h"
+#include "base/span.h"
+#include "event/value.h"
+#include "event/value_arena.h"
+
+namespace event {
+
+template<class T>
+class PackedArrayValue : public ArrayValue {
+ public:
+  typedef typename T::ScalarType ScalarType;
+  typedef std::vector<ScalarType, ArenaAllocator<ScalarType> > Elements;
+
+  static_assert(std::is_trivially_copyable<ScalarType>::value,
+                "Only trivially copyable scalars can be packed.");
+
+  PackedArrayValue()
+      : ArrayValue(nullptr, T::kType) {
+  }
+
+  // Constructor for an array allocated into |arena|.
+  // @param arena the arena holding the elements, must outlive the array.
+  explicit PackedArrayValue(ValueArena* arena)
+      : ArrayValue(arena, T::kType),
+        elements_(ArenaAllocator<ScalarType>(arena)) {
+    DCHECK(arena != nullptr);
+  }
+
+  // Reserves room for |size| elements.
+  // @param size the expected number of elements.
+  void Reserve(size_t size) {
+    elements_.reserve(size);
+  }
+
+  // Appends an element to the array.
+  // @param value the element to append.
+  void Append(const ScalarType& value) {
+    elements_.push_back(value);
+  }
+
+  // Appends |length| elements to the array.
+  // @param values the elements to append.
+  // @param length the number of elements to append.
+  void AppendAll(const ScalarType* values, size_t length) {
+    elements_.insert(elements_.end(), values, values + length);
+  }
+
+  // Appends |length| elements stored in raw memory, which may be unaligned.
+  // @param data the encoded elements.
+  // @param length the number of elements to append.
+  void AppendRaw(const void* data, size_t length) {
+    size_t offset = elements_.size();
+    elements_.resize(offset + length);
+    if (length != 0)
+      ::memcpy(&elements_[offset], data, length * sizeof(ScalarType));
+  }
+
+  // Returns the elements of the array.
+  base::Span<const ScalarType> elements() const {
+    return base::Span<const ScalarType>(elements_.data(), elements_.size());
+  }
+
+  // Overridden from ArrayValue:
+  // @{
+  size_t Length() const override {
+    return elements_.size();
+  }
+
+  const_iterator begin() const override {
+    Materialize();
+    return ArrayValue::begin();
+  }
+
+  const_iterator end() const override {
+    Materialize();
+    return ArrayValue::end();
+  }
+  // @}
+
+  // Overridden from Value:
+  // @{
+  bool Equals(const Value* value) const override {
+    if (InstanceOf(value)) {
+      const PackedArrayValue<T>* array = Cast(value);
+      return elements_ == array->elements_;
+    }
+    return ArrayValue::Equals(value);
+  }
+  // @}
+
+  // Determine if |value| is a packed array of |T|.
+  // @returns true is |value| has the appropriate type, false otherwise.
+  static bool InstanceOf(const Value* value) {
+    if (value == nullptr || !ArrayValue::InstanceOf(value))
+      return false;
+    const ArrayValue* array = ArrayValue::Cast(value);
+    return array->IsPacked() && array->packed_type() == T::kType;
+  }
+
+  // Cast |value| to a packed array of |T|.
+  // @param value the value to cast.
+  // @returns the casted value.
+  static const PackedArrayValue<T>* Cast(const Value* value) {
+    DCHECK(InstanceOf(value));
+    return static_cast<const PackedArrayValue<T>*>(ArrayValue::Cast(value));
+  }
+
+ private:
+  // Creates the Values of the elements which have no Value yet.
+  void Materialize() const {
+    for (size_t i = MaterializedLength(); i < elements_.size(); ++i) {
+      if (arena() != nullptr)
+        AppendMaterialized(arena()->New<T>(elements_[i]));
+      else
+        AppendMaterialized(new T(elements_[i]));
+    }
+  }
+
+  Elements elements_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackedArrayValue);
+};
+
+}  // namespace event
+
+#endif  // EVENT_PACKED_ARRAY_VALUE_H_
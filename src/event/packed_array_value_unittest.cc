@@ -0,0 +1,176 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/packed_array_value.h"
+
+#include <memory>
+#include <string>
+
+#include "event/utils.h"
+#include "event/value_arena.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+TEST(PackedArrayValueTest, Elements) {
+  PackedArrayValue<ULongValue> array;
+  EXPECT_TRUE(array.IsPacked());
+  EXPECT_EQ(VALUE_ULONG, array.packed_type());
+  EXPECT_TRUE(array.IsEmpty());
+  EXPECT_TRUE(array.elements().empty());
+
+  array.Append(1);
+  const uint64_t kValues[] = { 2, 3 };
+  array.AppendAll(kValues, 2);
+
+  EXPECT_EQ(3U, array.Length());
+  EXPECT_FALSE(array.IsEmpty());
+  ASSERT_EQ(3U, array.elements().size());
+  EXPECT_EQ(1U, array.elements()[0]);
+  EXPECT_EQ(2U, array.elements()[1]);
+  EXPECT_EQ(3U, array.elements()[2]);
+}
+
+TEST(PackedArrayValueTest, AppendRaw) {
+  // Unaligned little-endian encoded values.
+  const unsigned char kRaw[] = { 0xFF, 0x01, 0x00, 0x00, 0x00,
+                                 0x02, 0x00, 0x00, 0x00 };
+  PackedArrayValue<UIntValue> array;
+  array.AppendRaw(&kRaw[1], 2);
+  ASSERT_EQ(2U, array.Length());
+  EXPECT_EQ(1U, array.elements()[0]);
+  EXPECT_EQ(2U, array.elements()[1]);
+
+  array.AppendRaw(&kRaw[1], 0);
+  EXPECT_EQ(2U, array.Length());
+}
+
+TEST(PackedArrayValueTest, ValueInterface) {
+  PackedArrayValue<IntValue> array;
+  array.Append(42);
+  array.Append(-1);
+
+  // The generic interface creates Values on demand.
+  EXPECT_TRUE(IntValue::InstanceOf(array.at(0)));
+  EXPECT_EQ(42, IntValue::GetValue(array[0]));
+  EXPECT_EQ(-1, IntValue::GetValue(array.at(1)));
+
+  int32_t value = 0;
+  EXPECT_TRUE(array.GetElementAsInteger(1, &value));
+  EXPECT_EQ(-1, value);
+  EXPECT_FALSE(array.GetElementAsInteger(2, &value));
+
+  // Elements appended after a generic access are visible too.
+  array.Append(7);
+  size_t count = 0;
+  for (const Value* element : array) {
+    EXPECT_TRUE(IntValue::InstanceOf(element));
+    ++count;
+  }
+  EXPECT_EQ(3U, count);
+  EXPECT_EQ(7, IntValue::GetValue(array.at(2)));
+}
+
+TEST(PackedArrayValueTest, Equals) {
+  PackedArrayValue<UIntValue> packed;
+  packed.Append(1);
+  packed.Append(2);
+
+  ArrayValue array;
+  array.Append<UIntValue>(1);
+  array.Append<UIntValue>(2);
+
+  EXPECT_TRUE(packed.Equals(&array));
+  EXPECT_TRUE(array.Equals(&packed));
+
+  PackedArrayValue<UIntValue> other;
+  other.Append(1);
+  EXPECT_FALSE(packed.Equals(&other));
+  other.Append(2);
+  EXPECT_TRUE(packed.Equals(&other));
+
+  // Same values, different type.
+  PackedArrayValue<IntValue> signed_array;
+  signed_array.Append(1);
+  signed_array.Append(2);
+  EXPECT_FALSE(packed.Equals(&signed_array));
+
+  std::string packed_str;
+  std::string array_str;
+  EXPECT_TRUE(ToString(&packed, &packed_str));
+  EXPECT_TRUE(ToString(&array, &array_str));
+  EXPECT_EQ(array_str, packed_str);
+}
+
+TEST(PackedArrayValueTest, InstanceOf) {
+  PackedArrayValue<ULongValue> packed;
+  ArrayValue array;
+  IntValue scalar(42);
+
+  EXPECT_TRUE(ArrayValue::InstanceOf(&packed));
+  EXPECT_TRUE(PackedArrayValue<ULongValue>::InstanceOf(&packed));
+  EXPECT_FALSE(PackedArrayValue<UIntValue>::InstanceOf(&packed));
+  EXPECT_FALSE(PackedArrayValue<ULongValue>::InstanceOf(&array));
+  EXPECT_FALSE(PackedArrayValue<ULongValue>::InstanceOf(&scalar));
+  EXPECT_FALSE(array.IsPacked());
+
+  const Value* value = &packed;
+  EXPECT_EQ(&packed, PackedArrayValue<ULongValue>::Cast(value));
+}
+
+TEST(PackedArrayValueTest, StructField) {
+  StructValue fields;
+  PackedArrayValue<ULongValue>* stack =
+      fields.AddPackedArrayField<ULongValue>("Stack");
+  ASSERT_TRUE(stack != nullptr);
+  stack->Append(0x401000ULL);
+  EXPECT_EQ(nullptr, fields.AddPackedArrayField<ULongValue>("Stack"));
+
+  const PackedArrayValue<ULongValue>* retrieved = nullptr;
+  EXPECT_TRUE(fields.GetFieldAs<PackedArrayValue<ULongValue> >(
+      "Stack", &retrieved));
+  EXPECT_EQ(stack, retrieved);
+
+  const ArrayValue* array = nullptr;
+  EXPECT_TRUE(fields.GetFieldAs<ArrayValue>("Stack", &array));
+  EXPECT_EQ(1U, array->Length());
+}
+
+TEST(PackedArrayValueTest, Arena) {
+  ValueArena arena;
+  StructValue* fields = arena.New<StructValue>(&arena);
+  PackedArrayValue<ULongValue>* stack =
+      fields->AddPackedArrayField<ULongValue>("Stack");
+  ASSERT_TRUE(stack != nullptr);
+  EXPECT_EQ(&arena, stack->arena());
+
+  for (uint64_t i = 0; i < 64; ++i)
+    stack->Append(i);
+  EXPECT_EQ(63U, ULongValue::GetValue(stack->at(63)));
+
+  arena.Reset();
+}
+
+}  // namespace event
@@ -0,0 +1,104 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/string_view_value.h"
+
+#include <cstring>
+
+#include "base/w16_string.h"
+#include "event/value_visitor.h"
+
+namespace event {
+
+namespace {
+
+bool SameBytes(const base::Span<const char>& left,
+               const base::Span<const char>& right) {
+  if (left.size() != right.size())
+    return false;
+  return left.empty() ||
+         ::memcmp(left.data(), right.data(), left.size()) == 0;
+}
+
+}  // namespace
+
+const ValueType StringViewValue::kType;
+const ValueType W16StringViewValue::kType;
+
+bool StringViewValue::Equals(const Value* value) const {
+  if (value == nullptr || !InstanceOf(value))
+    return false;
+  return SameBytes(value_, Cast(value)->GetValue());
+}
+
+void StringViewValue::Accept(ValueVisitor* visitor) const {
+  DCHECK(visitor != nullptr);
+  visitor->Visit(*this);
+}
+
+std::string StringViewValue::str() const {
+  return std::string(value_.data(), value_.size());
+}
+
+bool StringViewValue::InstanceOf(const Value* value) {
+  DCHECK(value != nullptr);
+  return value->GetType() == kType;
+}
+
+const StringViewValue* StringViewValue::Cast(const Value* value) {
+  DCHECK(value != nullptr);
+  DCHECK(value->GetType() == kType);
+  return reinterpret_cast<const StringViewValue*>(value);
+}
+
+bool W16StringViewValue::Equals(const Value* value) const {
+  if (value == nullptr || !InstanceOf(value))
+    return false;
+  return SameBytes(value_, Cast(value)->GetValue());
+}
+
+void W16StringViewValue::Accept(ValueVisitor* visitor) const {
+  DCHECK(visitor != nullptr);
+  visitor->Visit(*this);
+}
+
+std::wstring W16StringViewValue::wstr() const {
+  std::wstring result;
+  base::AppendW16String(value_.data(), length(), &result);
+  return result;
+}
+
+bool W16StringViewValue::InstanceOf(const Value* value) {
+  DCHECK(value != nullptr);
+  return value->GetType() == kType;
+}
+
+const W16StringViewValue* W16StringViewValue::Cast(const Value* value) {
+  DCHECK(value != nullptr);
+  DCHECK(value->GetType() == kType);
+  return reinterpret_cast<const W16StringViewValue*>(value);
+}
+
+}  // namespace event
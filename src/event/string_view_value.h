@@ -0,0 +1,159 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// String values which do not own their characters. A view points into a
+// buffer owned by someone else, usually the payload of the event being
+// decoded, and is only valid as long as this buffer is alive. Parsers produce
+// views only when the lifetime of the payload is bounded, e.g. during the
+// callback of an event decoded into a ValueArena; consumers that keep a string
+// beyond that point must ask for an owned copy through GetAsString() or
+// GetAsWString().
+
+#ifndef EVENT_STRING_VIEW_VALUE_H_
+#define EVENT_STRING_VIEW_VALUE_H_
+
+#include <string>
+
+#include "base/base.h"
+#include "base/span.h"
+#include "event/value.h"
+#include "event/value_arena.h"
+
+namespace event {
+
+// A view on a narrow string, without the terminating null character.
+class StringViewValue : public Value {
+ public:
+  typedef base::Span<const char> ScalarType;
+
+  // The type of the values of this class.
+  static const ValueType kType = VALUE_STRING_VIEW;
+
+  // @param value the characters of the string, must outlive this value.
+  explicit StringViewValue(const ScalarType& value) : value_(value) {
+  }
+
+  // Overridden from Value:
+  // @{
+  virtual ValueType GetType() const override { return kType; }
+  virtual bool IsScalar() const override { return true; }
+  virtual bool IsAggregate() const override { return false; }
+  virtual bool IsInteger() const override { return false; }
+  virtual bool IsSigned() const override { return false; }
+  virtual bool IsFloating() const override { return false; }
+
+  virtual bool Equals(const Value* value) const override;
+  virtual void Accept(ValueVisitor* visitor) const override;
+  // @}
+
+  // Returns the characters of the string.
+  const ScalarType& GetValue() const { return value_; }
+
+  // Returns the number of characters of the string.
+  size_t length() const { return value_.size(); }
+
+  // Returns an owned copy of the string.
+  std::string str() const;
+
+  // Determine if |value| is of type VALUE_STRING_VIEW.
+  // @returns true is |value| has the appropriate type, false otherwise.
+  static bool InstanceOf(const Value* value);
+
+  // Cast |value| to type VALUE_STRING_VIEW.
+  // @param value the value to cast.
+  // @returns the casted value.
+  static const StringViewValue* Cast(const Value* value);
+
+ private:
+  ScalarType value_;
+
+  DISALLOW_COPY_AND_ASSIGN(StringViewValue);
+};
+
+// A view on a string of little-endian 16-bit characters, without the
+// terminating null character. The characters may be unaligned.
+class W16StringViewValue : public Value {
+ public:
+  // The raw bytes of the string; the size is always even.
+  typedef base::Span<const char> ScalarType;
+
+  // The type of the values of this class.
+  static const ValueType kType = VALUE_W16STRING_VIEW;
+
+  // @param value the bytes of the string, must outlive this value.
+  explicit W16StringViewValue(const ScalarType& value) : value_(value) {
+    DCHECK_EQ(0U, value.size() % 2);
+  }
+
+  // Overridden from Value:
+  // @{
+  virtual ValueType GetType() const override { return kType; }
+  virtual bool IsScalar() const override { return true; }
+  virtual bool IsAggregate() const override { return false; }
+  virtual bool IsInteger() const override { return false; }
+  virtual bool IsSigned() const override { return false; }
+  virtual bool IsFloating() const override { return false; }
+
+  virtual bool Equals(const Value* value) const override;
+  virtual void Accept(ValueVisitor* visitor) const override;
+  // @}
+
+  // Returns the raw bytes of the string.
+  const ScalarType& GetValue() const { return value_; }
+
+  // Returns the number of 16-bit characters of the string.
+  size_t length() const { return value_.size() / 2; }
+
+  // Returns an owned copy of the string.
+  std::wstring wstr() const;
+
+  // Determine if |value| is of type VALUE_W16STRING_VIEW.
+  // @returns true is |value| has the appropriate type, false otherwise.
+  static bool InstanceOf(const Value* value);
+
+  // Cast |value| to type VALUE_W16STRING_VIEW.
+  // @param value the value to cast.
+  // @returns the casted value.
+  static const W16StringViewValue* Cast(const Value* value);
+
+ private:
+  ScalarType value_;
+
+  DISALLOW_COPY_AND_ASSIGN(W16StringViewValue);
+};
+
+// Views do not own memory and never need their destructor to be run when
+// allocated into a ValueArena.
+template<>
+struct ArenaSkipsDestructor<StringViewValue> : std::true_type {
+};
+
+template<>
+struct ArenaSkipsDestructor<W16StringViewValue> : std::true_type {
+};
+
+}  // namespace event
+
+#endif  // EVENT_STRING_VIEW_VALUE_H_
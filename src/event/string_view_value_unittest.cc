@@ -0,0 +1,131 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/string_view_value.h"
+
+#include <string>
+
+#include "event/utils.h"
+#include "event/value_arena.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+const char kString[] = "dummy";
+const char kW16String[] = "d\0u\0m\0m\0y\0";
+
+base::Span<const char> MakeSpan(const char* data, size_t size) {
+  return base::Span<const char>(data, size);
+}
+
+}  // namespace
+
+TEST(StringViewValueTest, StringView) {
+  StringViewValue value(MakeSpan(kString, 5));
+  EXPECT_EQ(VALUE_STRING_VIEW, value.GetType());
+  EXPECT_TRUE(value.IsScalar());
+  EXPECT_FALSE(value.IsAggregate());
+  EXPECT_FALSE(value.IsInteger());
+  EXPECT_EQ(kString, value.GetValue().data());
+  EXPECT_EQ(5U, value.length());
+  EXPECT_EQ("dummy", value.str());
+
+  std::string str;
+  EXPECT_TRUE(value.GetAsString(&str));
+  EXPECT_EQ("dummy", str);
+  std::wstring wstr;
+  EXPECT_TRUE(value.GetAsWString(&wstr));
+  EXPECT_EQ(L"dummy", wstr);
+
+  int32_t integer = 0;
+  EXPECT_FALSE(value.GetAsInteger(&integer));
+}
+
+TEST(StringViewValueTest, W16StringView) {
+  W16StringViewValue value(MakeSpan(kW16String, 10));
+  EXPECT_EQ(VALUE_W16STRING_VIEW, value.GetType());
+  EXPECT_TRUE(value.IsScalar());
+  EXPECT_EQ(5U, value.length());
+  EXPECT_EQ(L"dummy", value.wstr());
+
+  std::wstring wstr;
+  EXPECT_TRUE(value.GetAsWString(&wstr));
+  EXPECT_EQ(L"dummy", wstr);
+  std::string str;
+  EXPECT_TRUE(value.GetAsString(&str));
+  EXPECT_EQ("dummy", str);
+}
+
+TEST(StringViewValueTest, W16StringViewNonAscii) {
+  const char kBytes[] = { '\xE9', '\x00', '\xAC', '\x20' };
+  W16StringViewValue value(MakeSpan(kBytes, sizeof(kBytes)));
+  std::wstring expected;
+  expected.push_back(static_cast<wchar_t>(0xE9));
+  expected.push_back(static_cast<wchar_t>(0x20AC));
+  EXPECT_EQ(expected, value.wstr());
+}
+
+TEST(StringViewValueTest, Empty) {
+  StringViewValue value(MakeSpan(nullptr, 0));
+  EXPECT_EQ("", value.str());
+  W16StringViewValue wvalue(MakeSpan(nullptr, 0));
+  EXPECT_EQ(L"", wvalue.wstr());
+  EXPECT_TRUE(value.Equals(&value));
+}
+
+TEST(StringViewValueTest, Equals) {
+  const char kOther[] = "dummy";
+  StringViewValue value(MakeSpan(kString, 5));
+  StringViewValue same(MakeSpan(kOther, 5));
+  StringViewValue prefix(MakeSpan(kString, 4));
+  StringValue owned("dummy");
+  W16StringViewValue wvalue(MakeSpan(kW16String, 10));
+
+  EXPECT_TRUE(value.Equals(&same));
+  EXPECT_FALSE(value.Equals(&prefix));
+  EXPECT_FALSE(value.Equals(&owned));
+  EXPECT_FALSE(value.Equals(&wvalue));
+  EXPECT_FALSE(value.Equals(nullptr));
+  EXPECT_TRUE(wvalue.Equals(&wvalue));
+}
+
+TEST(StringViewValueTest, StructField) {
+  ValueArena arena;
+  StructValue* fields = arena.New<StructValue>(&arena);
+  EXPECT_TRUE(fields->AddField<W16StringViewValue>(
+      "FileName", MakeSpan(kW16String, 10)));
+
+  std::wstring file_name;
+  EXPECT_TRUE(fields->GetFieldAsWString("FileName", &file_name));
+  EXPECT_EQ(L"dummy", file_name);
+
+  std::string str;
+  EXPECT_TRUE(ToString(fields, &str));
+  EXPECT_EQ("{\n    FileName = \"dummy\"\n}", str);
+}
+
+}  // namespace event
@@ -0,0 +1,112 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/struct_schema.h"
+
+namespace event {
+
+namespace {
+
+// Alignment of the values in the buffer of a SchemaStructValue.
+const size_t kValueAlignment = 8;
+
+size_t Align(size_t size) {
+  return (size + kValueAlignment - 1) & ~(kValueAlignment - 1);
+}
+
+// Size of the field table at the beginning of a SchemaStructValue buffer.
+size_t FieldTableSize(const StructSchema* schema) {
+  return Align(schema->FieldCount() * sizeof(StructValue::Field));
+}
+
+}  // namespace
+
+StructSchema::StructSchema()
+    : values_size_(0) {
+}
+
+bool StructSchema::FindField(Atom name, size_t* index) const {
+  DCHECK(index != nullptr);
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].name == name) {
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t StructSchema::AddField(Atom name, ValueType type, size_t size) {
+  size_t index = 0;
+  DCHECK(!FindField(name, &index));
+
+  FieldDescriptor field;
+  field.name = name;
+  field.type = type;
+  field.offset = values_size_;
+  fields_.push_back(field);
+
+  values_size_ += Align(size);
+  return fields_.size() - 1;
+}
+
+SchemaStructValue::SchemaStructValue(const StructSchema* schema)
+    : StructValue(schema, nullptr),
+      owns_buffer_(true) {
+  Initialize(new char[FieldTableSize(schema) + schema->ValuesSize()]);
+}
+
+SchemaStructValue::SchemaStructValue(const StructSchema* schema,
+                                     ValueArena* arena)
+    : StructValue(schema, arena),
+      owns_buffer_(false) {
+  DCHECK(arena != nullptr);
+  Initialize(static_cast<char*>(
+      arena->Allocate(FieldTableSize(schema) + schema->ValuesSize())));
+}
+
+SchemaStructValue::~SchemaStructValue() {
+  // The values hold trivially destructible scalars: releasing the buffer is
+  // enough.
+  if (owns_buffer_)
+    delete[] buffer_;
+}
+
+StructValue::const_iterator SchemaStructValue::fields_begin() const {
+  return fields_;
+}
+
+StructValue::const_iterator SchemaStructValue::fields_end() const {
+  return fields_ + size_;
+}
+
+void SchemaStructValue::Initialize(char* buffer) {
+  buffer_ = buffer;
+  fields_ = reinterpret_cast<Field*>(buffer);
+  values_ = buffer + FieldTableSize(schema());
+  size_ = 0;
+}
+
+}  // namespace event
@@ -0,0 +1,188 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A StructSchema describes a structure with a fixed layout: the names and the
+// types of its fields are stored once and shared by every SchemaStructValue
+// built from it. A SchemaStructValue keeps its values in a single inline
+// buffer, at offsets precomputed by the schema.
+//
+// Usage example:
+//   StructSchema schema;
+//   schema.AddField<UIntValue>("ThreadId");
+//   schema.AddField<UShortValue>("Count");
+//
+//   SchemaStructValue fields(&schema);
+//   fields.Append<UIntValue>(1234);
+//   fields.Append<UShortValue>(1);
+//   fields.GetFieldAsUInteger("ThreadId", &tid);  // Usual Value API.
+//   fields.GetFieldAt(1);  // Direct access to the field at index 1.
+
+#ifndef EVENT_STRUCT_SCHEMA_H_
+#define EVENT_STRUCT_SCHEMA_H_
+
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "base/base.h"
+#include "base/logging.h"
+#include "event/atom.h"
+#include "event/value.h"
+#include "event/value_arena.h"
+
+namespace event {
+
+class StructSchema {
+ public:
+  // Description of a field of the schema.
+  struct FieldDescriptor {
+    // The name of the field.
+    Atom name;
+    // The type of the value of the field.
+    ValueType type;
+    // The offset of the value in the buffer of a SchemaStructValue.
+    size_t offset;
+  };
+
+  StructSchema();
+
+  // Appends a field to the schema. Only types holding a trivially destructible
+  // scalar can be part of a schema.
+  // @tparam T the type of the value of the field.
+  // @param name the name of the field.
+  // @returns the index of the field.
+  template<class T>
+  size_t AddField(const std::string& name) {
+    static_assert(
+        std::is_trivially_destructible<typename T::ScalarType>::value,
+        "Only trivially destructible scalars can be part of a schema.");
+    return AddField(Atom::Intern(name), T::kType, sizeof(T));
+  }
+
+  // Returns the number of fields of the schema.
+  size_t FieldCount() const { return fields_.size(); }
+
+  // Returns the description of the field at index |index|.
+  const FieldDescriptor& field(size_t index) const {
+    DCHECK_LT(index, fields_.size());
+    return fields_[index];
+  }
+
+  // Finds the index of a field.
+  // @param name the name of the field.
+  // @param index receives the index of the field, when found.
+  // @returns true if the schema has a field named |name|, false otherwise.
+  bool FindField(Atom name, size_t* index) const;
+
+  // Returns the size of the buffer holding the values of a structure, in
+  // bytes.
+  size_t ValuesSize() const { return values_size_; }
+
+ private:
+  size_t AddField(Atom name, ValueType type, size_t size);
+
+  std::vector<FieldDescriptor> fields_;
+  size_t values_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(StructSchema);
+};
+
+// A StructValue whose layout is described by a StructSchema. The values of
+// the fields are appended in the order of the schema and are constructed in
+// place into a single buffer.
+class SchemaStructValue : public StructValue {
+ public:
+  // Constructor for a structure with heap storage.
+  // @param schema the layout of the structure, must outlive the struct.
+  explicit SchemaStructValue(const StructSchema* schema);
+
+  // Constructor for a structure stored into |arena|.
+  // @param schema the layout of the structure, must outlive the struct.
+  // @param arena the arena holding the values, must outlive the struct.
+  SchemaStructValue(const StructSchema* schema, ValueArena* arena);
+
+  virtual ~SchemaStructValue();
+
+  // Appends the value of the next field of the schema.
+  // @tparam T the type of the value, must match the type of the field.
+  // @param value the value of the field.
+  // @returns true if the value has been appended, false if the structure is
+  //     complete or if the type does not match.
+  template<class T>
+  bool Append(const typename T::ScalarType& value) {
+    if (size_ >= schema()->FieldCount())
+      return false;
+    const StructSchema::FieldDescriptor& field = schema()->field(size_);
+    if (field.type != T::kType)
+      return false;
+    T* field_value = new (values_ + field.offset) T(value);
+    new (&fields_[size_]) Field(field.name, field_value);
+    ++size_;
+    return true;
+  }
+
+  // Returns whether a value has been appended for every field of the schema.
+  bool IsComplete() const { return size_ == schema()->FieldCount(); }
+
+  // Retrieves the value of a field by its index in the schema.
+  // @param index the index of the field, must have been appended.
+  // @returns the value of the field.
+  const Value* GetFieldAt(size_t index) const {
+    DCHECK_LT(index, size_);
+    return reinterpret_cast<const Value*>(
+        values_ + schema()->field(index).offset);
+  }
+
+  // Overridden from StructValue:
+  // @{
+  const_iterator fields_begin() const override;
+  const_iterator fields_end() const override;
+  // @}
+
+ private:
+  void Initialize(char* buffer);
+
+  // The buffer holding the fields and their values.
+  char* buffer_;
+
+  // Whether |buffer_| is owned by this structure.
+  bool owns_buffer_;
+
+  // The name and the value of the appended fields, in schema order.
+  Field* fields_;
+
+  // The storage of the values, at the offsets of the schema.
+  char* values_;
+
+  // The number of appended fields.
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SchemaStructValue);
+};
+
+}  // namespace event
+
+#endif  // EVENT_STRUCT_SCHEMA_H_
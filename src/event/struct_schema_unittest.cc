@@ -0,0 +1,170 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/struct_schema.h"
+
+#include <memory>
+#include <string>
+
+#include "event/utils.h"
+#include "event/value_arena.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+void BuildSchema(StructSchema* schema) {
+  schema->AddField<UIntValue>("ThreadId");
+  schema->AddField<CharValue>("Priority");
+  schema->AddField<ULongValue>("Address");
+}
+
+}  // namespace
+
+TEST(StructSchemaTest, Fields) {
+  StructSchema schema;
+  EXPECT_EQ(0U, schema.FieldCount());
+  EXPECT_EQ(0U, schema.ValuesSize());
+
+  EXPECT_EQ(0U, schema.AddField<UIntValue>("ThreadId"));
+  EXPECT_EQ(1U, schema.AddField<CharValue>("Priority"));
+  EXPECT_EQ(2U, schema.FieldCount());
+
+  EXPECT_EQ(Atom::Intern("ThreadId"), schema.field(0).name);
+  EXPECT_EQ(VALUE_UINT, schema.field(0).type);
+  EXPECT_EQ(0U, schema.field(0).offset);
+  EXPECT_EQ(VALUE_CHAR, schema.field(1).type);
+  EXPECT_LE(sizeof(UIntValue), schema.field(1).offset);
+  EXPECT_LE(schema.field(1).offset + sizeof(CharValue), schema.ValuesSize());
+
+  size_t index = 0;
+  EXPECT_TRUE(schema.FindField(Atom::Intern("Priority"), &index));
+  EXPECT_EQ(1U, index);
+  EXPECT_FALSE(schema.FindField(Atom::Intern("Dummy"), &index));
+}
+
+TEST(SchemaStructValueTest, Append) {
+  StructSchema schema;
+  BuildSchema(&schema);
+
+  SchemaStructValue value(&schema);
+  EXPECT_EQ(&schema, value.schema());
+  EXPECT_TRUE(StructValue::InstanceOf(&value));
+  EXPECT_FALSE(value.IsComplete());
+  EXPECT_TRUE(value.fields_begin() == value.fields_end());
+
+  // The type must match the schema.
+  EXPECT_FALSE(value.Append<IntValue>(1));
+
+  EXPECT_TRUE(value.Append<UIntValue>(1234));
+  EXPECT_TRUE(value.Append<CharValue>(-2));
+  EXPECT_FALSE(value.IsComplete());
+  EXPECT_TRUE(value.Append<ULongValue>(0x401000ULL));
+  EXPECT_TRUE(value.IsComplete());
+
+  // The structure is complete.
+  EXPECT_FALSE(value.Append<ULongValue>(0));
+
+  // Fields cannot be added dynamically.
+  EXPECT_FALSE(value.AddField<IntValue>("Dummy", 42));
+  EXPECT_FALSE(value.HasField("Dummy"));
+}
+
+TEST(SchemaStructValueTest, GetField) {
+  StructSchema schema;
+  BuildSchema(&schema);
+
+  SchemaStructValue value(&schema);
+  value.Append<UIntValue>(1234);
+  value.Append<CharValue>(-2);
+  value.Append<ULongValue>(0x401000ULL);
+
+  uint32_t tid = 0;
+  EXPECT_TRUE(value.GetFieldAsUInteger("ThreadId", &tid));
+  EXPECT_EQ(1234U, tid);
+
+  int32_t priority = 0;
+  EXPECT_TRUE(value.GetFieldAsInteger(Atom::Intern("Priority"), &priority));
+  EXPECT_EQ(-2, priority);
+
+  uint64_t address = 0;
+  EXPECT_TRUE(value.GetFieldAsULong("Address", &address));
+  EXPECT_EQ(0x401000ULL, address);
+
+  EXPECT_EQ(value.GetField("Address"), value.GetFieldAt(2));
+  EXPECT_EQ(0x401000ULL, ULongValue::GetValue(value.GetFieldAt(2)));
+  EXPECT_FALSE(value.HasField("Dummy"));
+}
+
+TEST(SchemaStructValueTest, EqualsDynamicStruct) {
+  StructSchema schema;
+  BuildSchema(&schema);
+
+  SchemaStructValue value(&schema);
+  value.Append<UIntValue>(1234);
+  value.Append<CharValue>(-2);
+  value.Append<ULongValue>(0x401000ULL);
+
+  StructValue expected;
+  expected.AddField<UIntValue>("ThreadId", 1234);
+  expected.AddField<CharValue>("Priority", -2);
+  expected.AddField<ULongValue>("Address", 0x401000ULL);
+
+  EXPECT_TRUE(expected.Equals(&value));
+  EXPECT_TRUE(value.Equals(&expected));
+
+  std::string expected_str;
+  std::string value_str;
+  EXPECT_TRUE(ToString(&expected, &expected_str));
+  EXPECT_TRUE(ToString(&value, &value_str));
+  EXPECT_EQ(expected_str, value_str);
+
+  StructValue different;
+  different.AddField<UIntValue>("ThreadId", 1234);
+  different.AddField<CharValue>("Priority", -2);
+  EXPECT_FALSE(different.Equals(&value));
+  EXPECT_FALSE(value.Equals(&different));
+}
+
+TEST(SchemaStructValueTest, Arena) {
+  StructSchema schema;
+  BuildSchema(&schema);
+  ValueArena arena;
+
+  SchemaStructValue* value = arena.New<SchemaStructValue>(&schema, &arena);
+  EXPECT_EQ(&arena, value->arena());
+  EXPECT_TRUE(value->Append<UIntValue>(1234));
+  EXPECT_TRUE(value->Append<CharValue>(-2));
+  EXPECT_TRUE(value->Append<ULongValue>(0x401000ULL));
+
+  uint32_t tid = 0;
+  EXPECT_TRUE(value->GetFieldAsUInteger("ThreadId", &tid));
+  EXPECT_EQ(1234U, tid);
+
+  arena.Reset();
+}
+
+}  // namespace event
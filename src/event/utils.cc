@@ -25,103 +25,480 @@
 
 #include "event/utils.h"
 
+#include <cstring>
 #include <sstream>
 
 #include "base/logging.h"
+#include "event/packed_array_value.h"
+#include "event/string_view_value.h"
+#include "event/struct_schema.h"
 #include "event/value.h"
+#include "event/value_visitor.h"
 
 namespace event {
 
 namespace {
 
-bool ToString(const Value* value, size_t indent, std::stringstream* result) {
+// Writes the textual representation of the visited values into a stream.
+class ToStringVisitor : public ValueVisitor {
+ public:
+  explicit ToStringVisitor(std::stringstream* result)
+      : result_(result), indent_(0), succeeded_(true) {
+    DCHECK(result != NULL);
+  }
+
+  // Returns false if a visited value has no textual representation.
+  bool succeeded() const { return succeeded_; }
+
+  // Overridden from ValueVisitor:
+  // @{
+  void Visit(const BoolValue& value) override {
+    succeeded_ = false;
+  }
+  void Visit(const CharValue& value) override {
+    *result_ << static_cast<int>(value.GetValue());
+  }
+  void Visit(const UCharValue& value) override {
+    *result_ << static_cast<unsigned int>(value.GetValue());
+  }
+  void Visit(const ShortValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const UShortValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const IntValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const UIntValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const LongValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const ULongValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const FloatValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const DoubleValue& value) override {
+    *result_ << value.GetValue();
+  }
+  void Visit(const StringValue& value) override {
+    WriteString(value);
+  }
+  void Visit(const WStringValue& value) override {
+    WriteString(value);
+  }
+  void Visit(const StringViewValue& value) override {
+    WriteString(value);
+  }
+  void Visit(const W16StringViewValue& value) override {
+    WriteString(value);
+  }
+
+  void Visit(const StructValue& value) override {
+    std::string indent_string = std::string(indent_, ' ');
+    std::string indent_field = std::string(indent_ + 4, ' ');
+
+    *result_ << "{\n";
+    indent_ += 4;
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end() && succeeded_; ++it) {
+      *result_ << indent_field << it->first << " = ";
+      it->second->Accept(this);
+      *result_ << "\n";
+    }
+    indent_ -= 4;
+    *result_ << indent_string << "}";
+  }
+
+  void Visit(const ArrayValue& value) override {
+    std::string indent_string = std::string(indent_, ' ');
+    std::string indent_field = std::string(indent_ + 4, ' ');
+
+    *result_ << "[\n";
+    indent_ += 4;
+    ArrayValue::const_iterator it = value.begin();
+    for (; it != value.end() && succeeded_; ++it) {
+      *result_ << indent_field;
+      (*it)->Accept(this);
+      *result_ << "\n";
+    }
+    indent_ -= 4;
+    *result_ << indent_string << "]";
+  }
+  // @}
+
+ private:
+  void WriteString(const Value& value) {
+    std::string string_value;
+    if (!value.GetAsString(&string_value)) {
+      succeeded_ = false;
+      return;
+    }
+    *result_ << "\"" << string_value << "\"";  // TODO(etienneb): escaping.
+  }
+
+  std::stringstream* result_;
+  size_t indent_;
+  bool succeeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(ToStringVisitor);
+};
+
+bool ToString(const Value* value, std::stringstream* result) {
   DCHECK(value != NULL);
   DCHECK(result != NULL);
 
-  if (value->IsScalar()) {
-    int8_t char_value = 0;
-    uint8_t uchar_value = 0;
-    int16_t short_value = 0;
-    uint16_t ushort_value = 0;
-    int32_t int_value = 0;
-    uint32_t uint_value = 0;
-    int64_t long_value = 0;
-    uint64_t ulong_value = 0;
-    float float_value = 0;
-    double double_value = 0;
-    std::string string_value;
+  ToStringVisitor visitor(result);
+  value->Accept(&visitor);
+  return visitor.succeeded();
+}
 
-    if (CharValue::GetValue(value, &char_value)) {
-      *result << static_cast<int>(char_value);
-      return true;
-    } else if (UCharValue::GetValue(value, &uchar_value)) {
-      *result << static_cast<unsigned int>(uchar_value);
-      return true;
-    } else if (ShortValue::GetValue(value, &short_value)) {
-      *result << short_value;
-      return true;
-    } else if (UShortValue::GetValue(value, &ushort_value)) {
-      *result << ushort_value;
-      return true;
-    } else if (IntValue::GetValue(value, &int_value)) {
-      *result << int_value;
-      return true;
-    } else if (UIntValue::GetValue(value, &uint_value)) {
-      *result << uint_value;
-      return true;
-    } else if (LongValue::GetValue(value, &long_value)) {
-      *result << long_value;
-      return true;
-    } else if (ULongValue::GetValue(value, &ulong_value)) {
-      *result << ulong_value;
-      return true;
-    } else if (FloatValue::GetValue(value, &float_value)) {
-      *result << float_value;
-      return true;
-    } else if (DoubleValue::GetValue(value, &double_value)) {
-      *result << double_value;
-      return true;
-    } else if (value->GetAsString(&string_value)) {
-      *result << "\"" << string_value << "\"";  // TODO(etienneb): escaping.
-      return true;
-    }
-  } else if (value->IsAggregate()) {
-    if (ArrayValue::InstanceOf(value)) {
-      std::string indent_string = std::string(indent , ' ');
-      std::string indent_field = std::string(indent + 4, ' ');
-      const ArrayValue* array_value = ArrayValue::Cast(value);
-      DCHECK(array_value != NULL);
-
-      *result << "[\n";
-      ArrayValue::const_iterator it = array_value->begin();
-      for (; it != array_value->end(); ++it) {
-        *result << indent_field;
-        if (!ToString(*it, indent + 4, result))
-          return false;
-        *result << "\n";
-      }
-      *result << indent_string << "]";
-      return true;
-    } else if (StructValue::InstanceOf(value)) {
-      std::string indent_string = std::string(indent , ' ');
-      std::string indent_field = std::string(indent + 4, ' ');
-      const StructValue* struct_value = StructValue::Cast(value);
-      DCHECK(struct_value != NULL);
-
-      *result << "{\n";
-      StructValue::const_iterator it = struct_value->fields_begin();
-      for (; it != struct_value->fields_end(); ++it) {
-        *result << indent_field << it->first << " = ";
-        if (!ToString(it->second, indent + 4, result))
-          return false;
-        *result << "\n";
+// Copies a packed array, keeping its elements packed.
+template<class T>
+std::unique_ptr<Value> CopyPackedArray(const ArrayValue& value) {
+  const PackedArrayValue<T>* array = PackedArrayValue<T>::Cast(&value);
+  std::unique_ptr<PackedArrayValue<T> > copy(new PackedArrayValue<T>());
+  copy->AppendAll(array->elements().data(), array->elements().size());
+  return std::move(copy);
+}
+
+// Copies the visited value on the heap. Used with VisitValue().
+struct CopyValueVisitor {
+  typedef std::unique_ptr<Value> result_type;
+
+  template<class T>
+  std::unique_ptr<Value> operator()(const T& value) const {
+    return std::unique_ptr<Value>(new T(value.GetValue()));
+  }
+
+  std::unique_ptr<Value> operator()(const StringViewValue& value) const {
+    return std::unique_ptr<Value>(new StringValue(value.str()));
+  }
+
+  std::unique_ptr<Value> operator()(const W16StringViewValue& value) const {
+    return std::unique_ptr<Value>(new WStringValue(value.wstr()));
+  }
+
+  std::unique_ptr<Value> operator()(const StructValue& value) const {
+    std::unique_ptr<StructValue> copy(new StructValue());
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end(); ++it)
+      copy->AddField(it->first, CopyValue(it->second));
+    return std::move(copy);
+  }
+
+  std::unique_ptr<Value> operator()(const ArrayValue& value) const {
+    if (value.IsPacked()) {
+      switch (value.packed_type()) {
+        case VALUE_CHAR:
+          return CopyPackedArray<CharValue>(value);
+        case VALUE_UCHAR:
+          return CopyPackedArray<UCharValue>(value);
+        case VALUE_SHORT:
+          return CopyPackedArray<ShortValue>(value);
+        case VALUE_USHORT:
+          return CopyPackedArray<UShortValue>(value);
+        case VALUE_INT:
+          return CopyPackedArray<IntValue>(value);
+        case VALUE_UINT:
+          return CopyPackedArray<UIntValue>(value);
+        case VALUE_LONG:
+          return CopyPackedArray<LongValue>(value);
+        case VALUE_ULONG:
+          return CopyPackedArray<ULongValue>(value);
+        case VALUE_FLOAT:
+          return CopyPackedArray<FloatValue>(value);
+        case VALUE_DOUBLE:
+          return CopyPackedArray<DoubleValue>(value);
+        default:
+          break;
       }
-      *result << indent_string << "}";
-      return true;
     }
+
+    std::unique_ptr<ArrayValue> copy(new ArrayValue());
+    copy->Reserve(value.Length());
+    ArrayValue::const_iterator it = value.begin();
+    for (; it != value.end(); ++it)
+      copy->Append(CopyValue(*it));
+    return std::move(copy);
+  }
+};
+
+// Copies the characters of a string view into an arena.
+base::Span<const char> CopyChars(const base::Span<const char>& chars,
+                                 ValueArena* arena) {
+  if (chars.size() == 0)
+    return base::Span<const char>();
+  char* copy = static_cast<char*>(arena->Allocate(chars.size()));
+  ::memcpy(copy, chars.data(), chars.size());
+  return base::Span<const char>(copy, chars.size());
+}
+
+// Calls |function| with the type of the elements of a packed array.
+template<class Function>
+void VisitPackedType(ValueType type, Function function) {
+  switch (type) {
+    case VALUE_CHAR:
+      function.template operator()<CharValue>();
+      break;
+    case VALUE_UCHAR:
+      function.template operator()<UCharValue>();
+      break;
+    case VALUE_SHORT:
+      function.template operator()<ShortValue>();
+      break;
+    case VALUE_USHORT:
+      function.template operator()<UShortValue>();
+      break;
+    case VALUE_INT:
+      function.template operator()<IntValue>();
+      break;
+    case VALUE_UINT:
+      function.template operator()<UIntValue>();
+      break;
+    case VALUE_LONG:
+      function.template operator()<LongValue>();
+      break;
+    case VALUE_ULONG:
+      function.template operator()<ULongValue>();
+      break;
+    case VALUE_FLOAT:
+      function.template operator()<FloatValue>();
+      break;
+    case VALUE_DOUBLE:
+      function.template operator()<DoubleValue>();
+      break;
+    default:
+      LOG(FATAL) << "Unknown packed type.";
+      break;
+  }
+}
+
+void CopyFields(const StructValue& value, StructValue* copy);
+void CopyElements(const ArrayValue& value, ArrayValue* copy);
+
+// Copies the elements of a packed array into a packed array field of a
+// structure allocated into an arena.
+struct CopyPackedArrayToField {
+  template<class T>
+  void operator()() const {
+    const PackedArrayValue<T>* array = PackedArrayValue<T>::Cast(value);
+    PackedArrayValue<T>* copy = parent->AddPackedArrayField<T>(name);
+    copy->AppendAll(array->elements().data(), array->elements().size());
+  }
+
+  const ArrayValue* value;
+  StructValue* parent;
+  Atom name;
+};
+
+// Copies the elements of a packed array into a new packed array allocated
+// into an arena.
+struct CopyPackedArrayToArena {
+  template<class T>
+  void operator()() const {
+    const PackedArrayValue<T>* array = PackedArrayValue<T>::Cast(value);
+    PackedArrayValue<T>* copy = arena->New<PackedArrayValue<T> >(arena);
+    copy->AppendAll(array->elements().data(), array->elements().size());
+    *result = copy;
+  }
+
+  const ArrayValue* value;
+  ValueArena* arena;
+  Value** result;
+};
+
+// Copies the visited value into a field of a structure allocated into an
+// arena. Used with VisitValue().
+struct CopyFieldVisitor {
+  typedef void result_type;
+
+  CopyFieldVisitor(StructValue* parent, Atom name)
+      : parent_(parent), name_(name) {
+  }
+
+  template<class T>
+  void operator()(const T& value) const {
+    parent_->AddField<T>(name_, value.GetValue());
+  }
+
+  void operator()(const StringViewValue& value) const {
+    parent_->AddField<StringViewValue>(
+        name_, CopyChars(value.GetValue(), parent_->arena()));
+  }
+
+  void operator()(const W16StringViewValue& value) const {
+    parent_->AddField<W16StringViewValue>(
+        name_, CopyChars(value.GetValue(), parent_->arena()));
+  }
+
+  void operator()(const StructValue& value) const {
+    CopyFields(value, parent_->AddStructField(name_));
+  }
+
+  void operator()(const ArrayValue& value) const {
+    if (value.IsPacked()) {
+      CopyPackedArrayToField copy = { &value, parent_, name_ };
+      VisitPackedType(value.packed_type(), copy);
+      return;
+    }
+    CopyElements(value, parent_->AddArrayField(name_));
+  }
+
+  StructValue* parent_;
+  Atom name_;
+};
+
+// Appends a copy of the visited value to an array allocated into an arena.
+// Used with VisitValue().
+struct CopyElementVisitor {
+  typedef void result_type;
+
+  explicit CopyElementVisitor(ArrayValue* parent) : parent_(parent) {
+  }
+
+  template<class T>
+  void operator()(const T& value) const {
+    parent_->Append<T>(value.GetValue());
+  }
+
+  void operator()(const StringViewValue& value) const {
+    parent_->Append<StringViewValue>(
+        CopyChars(value.GetValue(), parent_->arena()));
+  }
+
+  void operator()(const W16StringViewValue& value) const {
+    parent_->Append<W16StringViewValue>(
+        CopyChars(value.GetValue(), parent_->arena()));
+  }
+
+  // Aggregates nested into arrays are rare: they are copied on the heap and
+  // adopted by the arena.
+  void operator()(const StructValue& value) const {
+    parent_->Append(CopyValue(&value));
+  }
+
+  void operator()(const ArrayValue& value) const {
+    parent_->Append(CopyValue(&value));
   }
 
-  return false;
+  ArrayValue* parent_;
+};
+
+// Appends the value of the next field of a structure with a schema.
+template<class T>
+void AppendSchemaField(SchemaStructValue* parent,
+                       const typename T::ScalarType& value) {
+  if (!parent->Append<T>(value))
+    LOG(ERROR) << "The copy of a structure does not match its schema.";
+}
+
+// Appends a copy of the visited value to a structure with a schema. Only
+// scalars are part of a schema. Used with VisitValue().
+struct CopySchemaFieldVisitor {
+  typedef void result_type;
+
+  explicit CopySchemaFieldVisitor(SchemaStructValue* parent)
+      : parent_(parent) {
+  }
+
+  template<class T>
+  void operator()(const T& value) const {
+    AppendSchemaField<T>(parent_, value.GetValue());
+  }
+
+  void operator()(const StringViewValue& value) const {
+    AppendSchemaField<StringViewValue>(
+        parent_, CopyChars(value.GetValue(), parent_->arena()));
+  }
+
+  void operator()(const W16StringViewValue& value) const {
+    AppendSchemaField<W16StringViewValue>(
+        parent_, CopyChars(value.GetValue(), parent_->arena()));
+  }
+
+  void operator()(const StructValue& value) const {
+    LOG(FATAL) << "A schema only holds scalars.";
+  }
+
+  void operator()(const ArrayValue& value) const {
+    LOG(FATAL) << "A schema only holds scalars.";
+  }
+
+  SchemaStructValue* parent_;
+};
+
+// Copies the visited value into an arena. Used with VisitValue().
+struct ArenaCopyValueVisitor {
+  typedef Value* result_type;
+
+  explicit ArenaCopyValueVisitor(ValueArena* arena) : arena_(arena) {
+  }
+
+  template<class T>
+  Value* operator()(const T& value) const {
+    return arena_->New<T>(value.GetValue());
+  }
+
+  Value* operator()(const StringViewValue& value) const {
+    return arena_->New<StringViewValue>(
+        CopyChars(value.GetValue(), arena_));
+  }
+
+  Value* operator()(const W16StringViewValue& value) const {
+    return arena_->New<W16StringViewValue>(
+        CopyChars(value.GetValue(), arena_));
+  }
+
+  Value* operator()(const StructValue& value) const {
+    // A structure with a schema keeps its compact layout.
+    if (value.schema() != nullptr) {
+      SchemaStructValue* copy =
+          arena_->New<SchemaStructValue>(value.schema(), arena_);
+      StructValue::const_iterator it = value.fields_begin();
+      for (; it != value.fields_end(); ++it)
+        VisitValue(it->second, CopySchemaFieldVisitor(copy));
+      return copy;
+    }
+
+    StructValue* copy = arena_->New<StructValue>(arena_);
+    CopyFields(value, copy);
+    return copy;
+  }
+
+  Value* operator()(const ArrayValue& value) const {
+    if (value.IsPacked()) {
+      Value* copy = nullptr;
+      CopyPackedArrayToArena copy_array = { &value, arena_, &copy };
+      VisitPackedType(value.packed_type(), copy_array);
+      return copy;
+    }
+
+    ArrayValue* copy = arena_->New<ArrayValue>(arena_);
+    CopyElements(value, copy);
+    return copy;
+  }
+
+  ValueArena* arena_;
+};
+
+void CopyFields(const StructValue& value, StructValue* copy) {
+  DCHECK(copy != nullptr);
+  StructValue::const_iterator it = value.fields_begin();
+  for (; it != value.fields_end(); ++it)
+    VisitValue(it->second, CopyFieldVisitor(copy, it->first));
+}
+
+void CopyElements(const ArrayValue& value, ArrayValue* copy) {
+  DCHECK(copy != nullptr);
+  copy->Reserve(value.Length());
+  ArrayValue::const_iterator it = value.begin();
+  for (; it != value.end(); ++it)
+    VisitValue(*it, CopyElementVisitor(copy));
 }
 
 }  // namespace
@@ -131,10 +508,14 @@ bool ToString(const Event& event, std::string* result) {
 
   std::stringstream ss;
   ss << "[" << event.timestamp() << "] event ";
-  if (!ToString(event.header(), 0, &ss))
+  if (!ToString(event.header(), &ss))
     return false;
   ss << " ";
-  if (!ToString(event.payload(), 0, &ss))
+  // A lazy payload which fails to decode is shown as an empty structure.
+  const Value* payload = event.payload();
+  if (payload == NULL)
+    ss << "{\n}";
+  else if (!ToString(payload, &ss))
     return false;
 
   *result = ss.str();
@@ -146,11 +527,58 @@ bool ToString(const Value* value, std::string* result) {
   DCHECK(result != NULL);
 
   std::stringstream ss;
-  if (!ToString(value, 0, &ss))
+  if (!ToString(value, &ss))
     return false;
 
   *result = ss.str();
   return true;
 }
 
+std::unique_ptr<Value> CopyValue(const Value* value) {
+  DCHECK(value != NULL);
+  return VisitValue(value, CopyValueVisitor());
+}
+
+Value* CopyValue(const Value* value, ValueArena* arena) {
+  DCHECK(value != NULL);
+  DCHECK(arena != NULL);
+  return VisitValue(value, ArenaCopyValueVisitor(arena));
+}
+
+std::unique_ptr<Event> CopyEvent(const Event& event) {
+  std::unique_ptr<const Value> payload;
+  if (event.payload() != NULL)
+    payload = CopyValue(event.payload());
+
+  if (event.has_typed_header()) {
+    return std::unique_ptr<Event>(new Event(
+        event.timestamp(), event.event_header(), std::move(payload)));
+  }
+
+  std::unique_ptr<const Value> header;
+  if (event.header() != NULL)
+    header = CopyValue(event.header());
+  return std::unique_ptr<Event>(new Event(
+      event.timestamp(), std::move(header), std::move(payload)));
+}
+
+std::unique_ptr<Event> CopyEvent(const Event& event,
+                                 const std::shared_ptr<ValueArena>& arena) {
+  DCHECK(arena.get() != nullptr);
+  const Value* payload = nullptr;
+  if (event.payload() != nullptr)
+    payload = CopyValue(event.payload(), arena.get());
+
+  if (event.has_typed_header()) {
+    return std::unique_ptr<Event>(new Event(
+        event.timestamp(), event.event_header(), payload, arena));
+  }
+
+  const Value* header = nullptr;
+  if (event.header() != nullptr)
+    header = CopyValue(event.header(), arena.get());
+  return std::unique_ptr<Event>(new Event(
+      event.timestamp(), header, payload, arena));
+}
+
 }  // namespace event
@@ -26,14 +26,17 @@
 #ifndef EVENT_UTILS_H_
 #define EVENT_UTILS_H_
 
+#include <memory>
 #include <string>
 
 #include "base/base.h"
 #include "event/event.h"
+#include "event/value_arena.h"
 
 namespace event {
 
-// Produce a textual representation of an event.
+// Produce a textual representation of an event. A payload which fails to
+// decode (see LazyPayload) is represented as an empty structure.
 // @param event the event to pretty-print.
 // @param result receives the textual representation.
 // @returns true if the conversion was successful, false otherwise.
@@ -45,6 +48,39 @@ bool ToString(const Event& event, std::string* result);
 // @returns true if the conversion was successful, false otherwise.
 bool ToString(const Value* value, std::string* result);
 
+// Produce a deep copy of a Value, allocated on the heap. The copy does not
+// depend on the memory of |value|: string views are copied into owned strings
+// and structures with a schema are copied into dynamic structures.
+// @param value the value to copy.
+// @returns the copy of |value|.
+std::unique_ptr<Value> CopyValue(const Value* value);
+
+// Produce a deep copy of a Value, allocated into an arena. The copy does not
+// depend on the memory of |value|, except for the StructSchema of a structure
+// with a schema, which is shared with the copy. String views are copied into
+// the arena and remain views.
+// @param value the value to copy.
+// @param arena the arena holding the copy.
+// @returns the copy of |value|, owned by |arena|.
+Value* CopyValue(const Value* value, ValueArena* arena);
+
+// Produce a copy of an event which owns its header and its payload. Events
+// received by a callback usually point into memory released when the callback
+// returns; a copy can be kept beyond that point. A lazy payload is decoded.
+// @param event the event to copy.
+// @returns the copy of |event|.
+std::unique_ptr<Event> CopyEvent(const Event& event);
+
+// Produce a copy of an event whose payload, and its header when it is not
+// typed, are allocated into a shared arena (see CopyValue()). Copying many
+// events into the same arena costs a few heap allocations per arena instead
+// of one per value. A lazy payload is decoded.
+// @param event the event to copy.
+// @param arena the arena holding the copy. The copy keeps a reference on it.
+// @returns the copy of |event|.
+std::unique_ptr<Event> CopyEvent(const Event& event,
+                                 const std::shared_ptr<ValueArena>& arena);
+
 }  // namespace event
 
 #endif  // EVENT_UTILS_H_
@@ -24,11 +24,28 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "event/utils.h"
+
+#include <string>
+
+#include "event/packed_array_value.h"
+#include "event/string_view_value.h"
+#include "event/struct_schema.h"
 #include "event/value.h"
+#include "event/value_arena.h"
 #include "gtest/gtest.h"
 
 namespace event {
 
+namespace {
+
+// A lazy payload which fails to decode.
+class FailingLazyPayload : public LazyPayload {
+ public:
+  const Value* Decode() const override { return nullptr; }
+};
+
+}  // namespace
+
 TEST(EventToStringTest, ScalarType) {
   IntValue int_value(-42);
   std::string int_str;
@@ -106,4 +123,171 @@ TEST(EventToStringTest, Event) {
   EXPECT_STREQ(expected, event_str.c_str());
 }
 
+TEST(EventToStringTest, EventWithFailedLazyPayload) {
+  StructValue header;
+  header.AddField<IntValue>("field", 1337);
+  FailingLazyPayload lazy_payload;
+  Event event(42, &header, &lazy_payload);
+
+  std::string event_str;
+  EXPECT_TRUE(ToString(event, &event_str));
+
+  const char* expected = "[42] event {\n    field = 1337\n} {\n}";
+  EXPECT_STREQ(expected, event_str.c_str());
+}
+
+TEST(EventCopyTest, CopyValue) {
+  const std::string kName("dummy");
+  std::unique_ptr<ValueArena> arena(new ValueArena());
+  StructValue* value = arena->New<StructValue>(arena.get());
+  value->AddField<IntValue>("int", 42);
+  value->AddField("name", std::unique_ptr<Value>(new StringViewValue(
+      StringViewValue::ScalarType(kName.data(), kName.size()))));
+  ArrayValue* array = value->AddArrayField("array");
+  array->Append<UIntValue>(1);
+  array->Append<UIntValue>(2);
+  PackedArrayValue<ULongValue>* stack =
+      value->AddPackedArrayField<ULongValue>("stack");
+  stack->Append(0x401000ULL);
+  stack->Append(0x402000ULL);
+
+  std::unique_ptr<Value> copy = CopyValue(value);
+
+  // The copy does not depend on the arena.
+  arena.reset();
+
+  int32_t int_value = 0;
+  std::string name;
+  const ArrayValue* array_copy = NULL;
+  const ArrayValue* stack_copy = NULL;
+  ASSERT_TRUE(StructValue::InstanceOf(copy.get()));
+  const StructValue* struct_copy = StructValue::Cast(copy.get());
+  EXPECT_TRUE(struct_copy->GetFieldAsInteger("int", &int_value));
+  EXPECT_EQ(42, int_value);
+  EXPECT_TRUE(struct_copy->GetFieldAsString("name", &name));
+  EXPECT_EQ(kName, name);
+  ASSERT_TRUE(struct_copy->GetFieldAs<ArrayValue>("array", &array_copy));
+  EXPECT_EQ(2U, array_copy->Length());
+  ASSERT_TRUE(struct_copy->GetFieldAs<ArrayValue>("stack", &stack_copy));
+  ASSERT_TRUE(PackedArrayValue<ULongValue>::InstanceOf(stack_copy));
+  base::Span<const uint64_t> frames =
+      PackedArrayValue<ULongValue>::Cast(stack_copy)->elements();
+  ASSERT_EQ(2U, frames.size());
+  EXPECT_EQ(0x401000ULL, frames[0]);
+  EXPECT_EQ(0x402000ULL, frames[1]);
+}
+
+TEST(EventCopyTest, CopyEvent) {
+  EventHeader header;
+  header.process_id = 42;
+  header.type = EventType::Register(Atom::Intern("Thread"),
+                                    Atom::Intern("CSwitch"));
+
+  std::unique_ptr<Event> copy;
+  {
+    StructValue payload;
+    payload.AddField<IntValue>("field", 12);
+    Event event(1337, header, &payload);
+    copy = CopyEvent(event);
+  }
+
+  int32_t field = 0;
+  EXPECT_EQ(1337U, copy->timestamp());
+  EXPECT_TRUE(copy->has_typed_header());
+  EXPECT_EQ(42U, copy->event_header().process_id);
+  EXPECT_EQ(header.type, copy->event_header().type);
+  ASSERT_TRUE(copy->payload() != NULL);
+  EXPECT_TRUE(copy->payload()->GetFieldAsInteger("field", &field));
+  EXPECT_EQ(12, field);
+}
+
+TEST(EventCopyTest, CopyValueToArena) {
+  std::string name("dummy");
+  std::unique_ptr<ValueArena> arena(new ValueArena());
+  StructValue* value = arena->New<StructValue>(arena.get());
+  value->AddField<IntValue>("int", 42);
+  value->AddField<StringViewValue>(
+      "name", StringViewValue::ScalarType(name.data(), name.size()));
+  ArrayValue* array = value->AddArrayField("array");
+  array->Append<UIntValue>(1);
+  array->Append<UIntValue>(2);
+  PackedArrayValue<ULongValue>* stack =
+      value->AddPackedArrayField<ULongValue>("stack");
+  stack->Append(0x401000ULL);
+
+  ValueArena copy_arena;
+  Value* copy = CopyValue(value, &copy_arena);
+
+  // The copy depends neither on the source arena nor on the viewed string.
+  arena.reset();
+  name = "other";
+
+  ASSERT_TRUE(StructValue::InstanceOf(copy));
+  const StructValue* struct_copy = StructValue::Cast(copy);
+  EXPECT_EQ(&copy_arena, struct_copy->arena());
+  int32_t int_value = 0;
+  EXPECT_TRUE(struct_copy->GetFieldAsInteger("int", &int_value));
+  EXPECT_EQ(42, int_value);
+
+  // String views remain views, into the arena of the copy.
+  const StringViewValue* name_copy = NULL;
+  ASSERT_TRUE(struct_copy->GetFieldAs<StringViewValue>("name", &name_copy));
+  EXPECT_EQ("dummy", name_copy->str());
+
+  const ArrayValue* array_copy = NULL;
+  const ArrayValue* stack_copy = NULL;
+  ASSERT_TRUE(struct_copy->GetFieldAs<ArrayValue>("array", &array_copy));
+  EXPECT_EQ(2U, array_copy->Length());
+  ASSERT_TRUE(struct_copy->GetFieldAs<ArrayValue>("stack", &stack_copy));
+  ASSERT_TRUE(PackedArrayValue<ULongValue>::InstanceOf(stack_copy));
+  ASSERT_EQ(1U, stack_copy->Length());
+  EXPECT_EQ(0x401000ULL,
+            PackedArrayValue<ULongValue>::Cast(stack_copy)->elements()[0]);
+}
+
+TEST(EventCopyTest, CopySchemaStructToArena) {
+  StructSchema schema;
+  schema.AddField<UIntValue>("ThreadId");
+  schema.AddField<UShortValue>("Count");
+  SchemaStructValue value(&schema);
+  value.Append<UIntValue>(1234);
+  value.Append<UShortValue>(1);
+
+  ValueArena arena;
+  Value* copy = CopyValue(&value, &arena);
+
+  // The copy keeps the layout of the schema.
+  ASSERT_TRUE(StructValue::InstanceOf(copy));
+  EXPECT_EQ(&schema, StructValue::Cast(copy)->schema());
+  EXPECT_TRUE(value.Equals(copy));
+}
+
+TEST(EventCopyTest, CopyEventToArena) {
+  EventHeader header;
+  header.process_id = 42;
+  header.type = EventType::Register(Atom::Intern("Thread"),
+                                    Atom::Intern("CSwitch"));
+
+  std::unique_ptr<Event> first;
+  std::unique_ptr<Event> second;
+  {
+    std::shared_ptr<ValueArena> arena = std::make_shared<ValueArena>();
+    StructValue payload;
+    payload.AddField<IntValue>("field", 12);
+    Event event(1337, header, &payload);
+    first = CopyEvent(event, arena);
+    second = CopyEvent(event, arena);
+  }
+
+  // The arena is shared by the copies and lives as long as any of them.
+  first.reset();
+  int32_t field = 0;
+  EXPECT_EQ(1337U, second->timestamp());
+  EXPECT_TRUE(second->has_typed_header());
+  EXPECT_EQ(42U, second->event_header().process_id);
+  ASSERT_TRUE(second->payload() != NULL);
+  EXPECT_TRUE(second->payload()->GetFieldAsInteger("field", &field));
+  EXPECT_EQ(12, field);
+}
+
 }  // namespace event
@@ -29,6 +29,8 @@
 
 #include "base/logging.h"
 #include "base/string_utils.h"
+#include "event/string_view_value.h"
+#include "event/value_visitor.h"
 
 namespace event {
 
@@ -284,6 +286,14 @@ bool Value::GetAsString(std::string* value) const {
       *value = base::WStringToString(WStringValue::GetValue(this));
       return true;
     }
+    case VALUE_STRING_VIEW: {
+      *value = StringViewValue::Cast(this)->str();
+      return true;
+    }
+    case VALUE_W16STRING_VIEW: {
+      *value = base::WStringToString(W16StringViewValue::Cast(this)->wstr());
+      return true;
+    }
     default:
       return false;
   }
@@ -301,6 +311,14 @@ bool Value::GetAsWString(std::wstring* value) const {
       *value = WStringValue::GetValue(this);
       return true;
     }
+    case VALUE_STRING_VIEW: {
+      *value = base::StringToWString(StringViewValue::Cast(this)->str());
+      return true;
+    }
+    case VALUE_W16STRING_VIEW: {
+      *value = W16StringViewValue::Cast(this)->wstr();
+      return true;
+    }
     default:
       return false;
   }
@@ -317,6 +335,18 @@ const Value* Value::GetField(const std::string& name) const {
 bool Value::GetField(const std::string& name, const Value** value) const {
   return false;
 }
+
+bool Value::HasField(Atom name) const {
+  return false;
+}
+
+const Value* Value::GetField(Atom name) const {
+  return nullptr;
+}
+
+bool Value::GetField(Atom name, const Value** value) const {
+  return false;
+}
 
 bool Value::GetFieldAsInteger(
     const std::string& name, int32_t* value) const {
@@ -380,6 +410,62 @@ bool Value::GetFieldAsWString(
   return field->GetAsWString(value);
 }
 
+bool Value::GetFieldAsInteger(Atom name, int32_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsInteger(value);
+}
+
+bool Value::GetFieldAsUInteger(Atom name, uint32_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsUInteger(value);
+}
+
+bool Value::GetFieldAsLong(Atom name, int64_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsLong(value);
+}
+
+bool Value::GetFieldAsULong(Atom name, uint64_t* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsULong(value);
+}
+
+bool Value::GetFieldAsFloating(Atom name, double* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsFloating(value);
+}
+
+bool Value::GetFieldAsString(Atom name, std::string* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsString(value);
+}
+
+bool Value::GetFieldAsWString(Atom name, std::wstring* value) const {
+  DCHECK(value != nullptr);
+  const Value* field = nullptr;
+  if (!GetField(name, &field))
+    return false;
+  return field->GetAsWString(value);
+}
+
 template<class T, int TYPE>
 ValueType ScalarValue<T, TYPE>::GetType() const {
   return static_cast<ValueType>(TYPE);
@@ -426,6 +512,12 @@ bool ScalarValue<T, TYPE>::Equals(const Value* value) const {
   return true;
 }
 
+template<class T, int TYPE>
+void ScalarValue<T, TYPE>::Accept(ValueVisitor* visitor) const {
+  DCHECK(visitor != nullptr);
+  visitor->Visit(*this);
+}
+
 template<class T, int TYPE>
 const T& ScalarValue<T, TYPE>::GetValue() const {
   return value_;
@@ -500,10 +592,31 @@ bool AggregateValue<TYPE>::IsFloating() const {
   return false;
 }
 
-ArrayValue::ArrayValue() {
+ArrayValue::ArrayValue()
+    : arena_(nullptr),
+      packed_(false),
+      packed_type_(VALUE_ARRAY) {
+}
+
+ArrayValue::ArrayValue(ValueArena* arena)
+    : arena_(arena),
+      packed_(false),
+      packed_type_(VALUE_ARRAY),
+      values_(ArenaAllocator<Value*>(arena)) {
+  DCHECK(arena != nullptr);
+}
+
+ArrayValue::ArrayValue(ValueArena* arena, ValueType packed_type)
+    : arena_(arena),
+      packed_(true),
+      packed_type_(packed_type),
+      values_(ArenaAllocator<Value*>(arena)) {
 }
 
 ArrayValue::~ArrayValue() {
+  // Elements allocated into an arena are released by the arena.
+  if (arena_ != nullptr)
+    return;
   for (Values::iterator it = values_.begin(); it != values_.end(); ++it)
     delete *it;
 }
@@ -516,72 +629,83 @@ size_t ArrayValue::Length() const {
   return values_.size();
 }
 
+void ArrayValue::Reserve(size_t size) {
+  values_.reserve(size);
+}
+
 void ArrayValue::Append(std::unique_ptr<Value> value) {
   DCHECK(value.get() != nullptr);
+  DCHECK(!packed_);
+  if (arena_ != nullptr) {
+    values_.push_back(arena_->Adopt(std::move(value)));
+    return;
+  }
   values_.push_back(value.release());
 }
 
 const Value* ArrayValue::operator[](size_t index) const {
-  return values_.at(index);
+  return at(index);
 }
 
 Value* ArrayValue::operator[](size_t index) {
-  return values_.at(index);
+  return at(index);
 }
 
 const Value* ArrayValue::at(size_t index) const {
-  return values_.at(index);
+  DCHECK_LT(index, Length());
+  return begin()[index];
 }
 
 Value* ArrayValue::at(size_t index) {
-  return values_.at(index);
+  DCHECK_LT(index, Length());
+  return begin()[index];
 }
 
 bool ArrayValue::GetElementAsInteger(size_t index, int32_t* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsInteger(value);
 }
 
 bool ArrayValue::GetElementAsUInteger(size_t index, uint32_t* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsUInteger(value);
 }
 
 bool ArrayValue::GetElementAsLong(size_t index, int64_t* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsLong(value);
 }
 
 bool ArrayValue::GetElementAsULong(size_t index, uint64_t* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsULong(value);
 }
 
 bool ArrayValue::GetElementAsFloating(size_t index, double* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsFloating(value);
 }
 
 bool ArrayValue::GetElementAsString(size_t index, std::string* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsString(value);
 }
 
 bool ArrayValue::GetElementAsWString(size_t index, std::wstring* value) const {
   DCHECK(value != nullptr);
-  if (index >= values_.size())
+  if (index >= Length())
     return false;
   return at(index)->GetAsWString(value);
 }
@@ -610,6 +734,24 @@ bool ArrayValue::Equals(const Value* value) const {
   return true;
 }
 
+ArrayValue::const_iterator ArrayValue::begin() const {
+  return values_.data();
+}
+
+ArrayValue::const_iterator ArrayValue::end() const {
+  return values_.data() + values_.size();
+}
+
+void ArrayValue::AppendMaterialized(Value* value) const {
+  DCHECK(packed_);
+  values_.push_back(value);
+}
+
+void ArrayValue::Accept(ValueVisitor* visitor) const {
+  DCHECK(visitor != nullptr);
+  visitor->Visit(*this);
+}
+
 bool ArrayValue::InstanceOf(const Value* value) {
   DCHECK(value != nullptr);
   return value->GetType() == VALUE_ARRAY;
@@ -621,45 +763,147 @@ const ArrayValue* ArrayValue::Cast(const Value* value) {
   return reinterpret_cast<const ArrayValue*>(value);
 }
 
-StructValue::StructValue() {
+StructValue::StructValue()
+    : schema_(nullptr),
+      arena_(nullptr) {
+}
+
+StructValue::StructValue(ValueArena* arena)
+    : schema_(nullptr),
+      arena_(arena),
+      fields_(ArenaAllocator<Field>(arena)) {
+  DCHECK(arena != nullptr);
+}
+
+StructValue::StructValue(const StructSchema* schema, ValueArena* arena)
+    : schema_(schema),
+      arena_(arena),
+      fields_(ArenaAllocator<Field>(arena)) {
+  DCHECK(schema != nullptr);
 }
 
 StructValue::~StructValue() {
-  for (ValueList::iterator it = fields_.begin(); it != fields_.end(); ++it)
+  // Fields allocated into an arena are released by the arena.
+  if (arena_ != nullptr)
+    return;
+  for (Fields::iterator it = fields_.begin(); it != fields_.end(); ++it)
     delete it->second;
 }
 
 bool StructValue::HasField(const std::string& name) const {
-  return fields_map_.find(name) != fields_map_.end();
+  return GetField(name) != nullptr;
 }
 
 const Value* StructValue::GetField(const std::string& name) const {
-  ValueMap::const_iterator look = fields_map_.find(name);
-  if (look == fields_map_.end())
+  // A name which was never interned can't be the name of a field. Reads don't
+  // intern names, so that unknown names don't fill the atom table.
+  Atom atom;
+  if (!Atom::Lookup(name, &atom))
     return nullptr;
-  return look->second;
+  return GetField(atom);
 }
 
 bool StructValue::GetField(const std::string& name,
                            const Value** value) const {
   DCHECK(value != nullptr);
-  ValueMap::const_iterator look = fields_map_.find(name);
-  if (look == fields_map_.end())
+  const Value* field = GetField(name);
+  if (field == nullptr)
     return false;
-  *value = look->second;
+  *value = field;
   return true;
 }
 
-bool StructValue::AddField(const std::string& name, std::unique_ptr<Value> value) {
+bool StructValue::HasField(Atom name) const {
+  return GetField(name) != nullptr;
+}
+
+const Value* StructValue::GetField(Atom name) const {
+  const_iterator end = fields_end();
+  for (const_iterator it = fields_begin(); it != end; ++it) {
+    if (it->first == name)
+      return it->second;
+  }
+  return nullptr;
+}
+
+bool StructValue::GetField(Atom name, const Value** value) const {
+  DCHECK(value != nullptr);
+  const Value* field = GetField(name);
+  if (field == nullptr)
+    return false;
+  *value = field;
+  return true;
+}
+
+bool StructValue::AddField(const std::string& name,
+                           std::unique_ptr<Value> value) {
+  return AddField(Atom::Intern(name), std::move(value));
+}
+
+bool StructValue::AddField(Atom name, std::unique_ptr<Value> value) {
   DCHECK(value.get() != nullptr);
-  if (HasField(name))
+  if (!CanAddField(name))
     return false;
-  Value* raw_value = value.release();
-  fields_.push_back(std::make_pair(name, raw_value));
-  fields_map_.insert(std::make_pair(name, raw_value));
+  if (arena_ != nullptr)
+    InsertField(name, arena_->Adopt(std::move(value)));
+  else
+    InsertField(name, value.release());
   return true;
 }
 
+ArrayValue* StructValue::AddArrayField(const std::string& name) {
+  return AddArrayField(Atom::Intern(name));
+}
+
+ArrayValue* StructValue::AddArrayField(Atom name) {
+  if (!CanAddField(name))
+    return nullptr;
+  ArrayValue* array = nullptr;
+  if (arena_ != nullptr)
+    array = arena_->New<ArrayValue>(arena_);
+  else
+    array = new ArrayValue();
+  InsertField(name, array);
+  return array;
+}
+
+StructValue* StructValue::AddStructField(const std::string& name) {
+  return AddStructField(Atom::Intern(name));
+}
+
+StructValue* StructValue::AddStructField(Atom name) {
+  if (!CanAddField(name))
+    return nullptr;
+  StructValue* strct = nullptr;
+  if (arena_ != nullptr)
+    strct = arena_->New<StructValue>(arena_);
+  else
+    strct = new StructValue();
+  InsertField(name, strct);
+  return strct;
+}
+
+void StructValue::Reserve(size_t size) {
+  DCHECK(schema_ == nullptr);
+  fields_.reserve(size);
+}
+
+StructValue::const_iterator StructValue::fields_begin() const {
+  return fields_.data();
+}
+
+StructValue::const_iterator StructValue::fields_end() const {
+  return fields_.data() + fields_.size();
+}
+
+bool StructValue::CanAddField(Atom name) const {
+  return schema_ == nullptr && !HasField(name);
+}
+
+void StructValue::InsertField(Atom name, Value* value) {
+  fields_.push_back(std::make_pair(name, value));
+}
+
 bool StructValue::Equals(const Value* value) const {
   if (value == nullptr)
     return false;
@@ -672,7 +916,7 @@ bool StructValue::Equals(const Value* value) const {
   const_iterator left = fields_begin();
   const_iterator right = strct->fields_begin();
   while (left != fields_end() && right != strct->fields_end()) {
-    if (left->first.compare(right->first) != 0)
+    if (left->first != right->first)
       return false;
     if (!left->second->Equals(right->second))
       return false;
@@ -687,6 +931,11 @@ bool StructValue::Equals(const Value* value) const {
   return true;
 }
 
+void StructValue::Accept(ValueVisitor* visitor) const {
+  DCHECK(visitor != nullptr);
+  visitor->Visit(*this);
+}
+
 bool StructValue::InstanceOf(const Value* value) {
   DCHECK(value != nullptr);
   return value->GetType() == VALUE_STRUCT;
@@ -39,6 +39,13 @@
 //   top_struct->AddField("name1", my_array.Pass());
 //   top_struct->AddField<LongValue>("name2", new LongValue(4U));
 //
+// - Creation into an arena (see value_arena.h)
+//   ValueArena arena;
+//   StructValue* fields = arena.New<StructValue>(&arena);
+//   fields->AddField<IntValue>("name1", 42);
+//   ArrayValue* stack = fields->AddArrayField("name2");
+//   stack->Append<ULongValue>(0x401000ULL);
+//
 // - Introspection and casting
 //   std::unique_ptr<IntValue> value(new IntValue(42));
 //   if (value->IsInteger())
@@ -62,17 +69,22 @@
 #define EVENT_VALUE_H_
 
 #include <cstdlib>
-#include <list>
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "base/base.h"
 #include "base/logging.h"
+#include "event/atom.h"
+#include "event/value_arena.h"
 
 namespace event {
 
+// Forward declarations (see struct_schema.h and packed_array_value.h).
+class StructSchema;
+class ValueVisitor;
+template<class T> class PackedArrayValue;
+
 enum ValueType {
   VALUE_BOOL,
   VALUE_CHAR,
@@ -87,6 +99,8 @@ enum ValueType {
   VALUE_DOUBLE,
   VALUE_STRING,
   VALUE_WSTRING,
+  VALUE_STRING_VIEW,
+  VALUE_W16STRING_VIEW,
   VALUE_STRUCT,
   VALUE_ARRAY
 };
@@ -144,6 +158,13 @@ class Value {
   // @returns true if the field is found, false otherwise.
   virtual bool GetField(const std::string& name, const Value** value) const;
 
+  // Same as above, for a field name interned as an atom.
+  // @{
+  virtual bool HasField(Atom name) const;
+  virtual const Value* GetField(Atom name) const;
+  virtual bool GetField(Atom name, const Value** value) const;
+  // @}
+
   // Retrieve the value of a given type for a given name.
   // @tparam T the type to cast the field value.
   // @param name the name of the field to find.
@@ -160,6 +181,17 @@ class Value {
     return true;
   }
 
+  // Same as above, for a field name interned as an atom.
+  template<class T>
+  bool GetFieldAs(Atom name, const T** value) const {
+    DCHECK(value != nullptr);
+    const Value* field = nullptr;
+    if (!GetField(name, &field) || !T::InstanceOf(field))
+      return false;
+    *value = T::Cast(field);
+    return true;
+  }
+
   // These methods allow the convenient retrieval of a field with a basic
   // value. If the current value can be converted into the given type,
   // the value is returned through the |value| parameter.
@@ -177,10 +209,26 @@ class Value {
   bool GetFieldAsWString(const std::string& name, std::wstring* value) const;
   // @}
 
+  // Same as above, for a field name interned as an atom.
+  // @{
+  bool GetFieldAsInteger(Atom name, int32_t* value) const;
+  bool GetFieldAsUInteger(Atom name, uint32_t* value) const;
+  bool GetFieldAsLong(Atom name, int64_t* value) const;
+  bool GetFieldAsULong(Atom name, uint64_t* value) const;
+  bool GetFieldAsFloating(Atom name, double* value) const;
+  bool GetFieldAsString(Atom name, std::string* value) const;
+  bool GetFieldAsWString(Atom name, std::wstring* value) const;
+  // @}
+
   // Compare this value with the given value |value|.
   // @param value the value to compare with.
   // @returns true when both values are equal, false otherwise.
   virtual bool Equals(const Value* value) const = 0;
+
+  // Calls the Visit() overload of |visitor| for the concrete type of this
+  // value (see value_visitor.h).
+  // @param visitor the visitor.
+  virtual void Accept(ValueVisitor* visitor) const = 0;
 };
 
 template<class T, int TYPE>
@@ -189,6 +237,9 @@ class ScalarValue : public Value {
   typedef ScalarValue<T, TYPE> SelfType;
   typedef T ScalarType;
 
+  // The type of the values of this class.
+  static const ValueType kType = static_cast<ValueType>(TYPE);
+
   explicit ScalarValue(const T& value)
       : value_(value) {
   }
@@ -203,6 +254,7 @@ class ScalarValue : public Value {
   virtual bool IsFloating() const override;
 
   virtual bool Equals(const Value* value) const override;
+  virtual void Accept(ValueVisitor* visitor) const override;
   // @}
 
   // Retrieve the value holded in this wrapper.
@@ -238,6 +290,9 @@ class ScalarValue : public Value {
   T value_;
 };
 
+template<class T, int TYPE>
+const ValueType ScalarValue<T, TYPE>::kType;
+
 typedef ScalarValue<bool, VALUE_BOOL> BoolValue;
 typedef ScalarValue<int8_t, VALUE_CHAR> CharValue;
 typedef ScalarValue<uint8_t, VALUE_UCHAR> UCharValue;
@@ -252,6 +307,13 @@ typedef ScalarValue<std::wstring, VALUE_WSTRING> WStringValue;
 typedef ScalarValue<float, VALUE_FLOAT> FloatValue;
 typedef ScalarValue<double, VALUE_DOUBLE> DoubleValue;
 
+// Scalars holding a trivially destructible value do not need their destructor
+// to be run when allocated into a ValueArena.
+template<class T, int TYPE>
+struct ArenaSkipsDestructor<ScalarValue<T, TYPE> >
+    : std::is_trivially_destructible<T> {
+};
+
 template<int TYPE>
 class AggregateValue : public Value {
  public:
@@ -266,22 +328,46 @@ class AggregateValue : public Value {
   // @}
 };
 
-// An ArrayValue holds a sequence of disparate values.
+// An ArrayValue holds a sequence of disparate values. Arrays of scalars of a
+// single type may be packed (see packed_array_value.h).
 class ArrayValue : public AggregateValue<VALUE_ARRAY> {
  public:
-  typedef std::vector<Value*> Values;
-  typedef Values::const_iterator const_iterator;
+  typedef std::vector<Value*, ArenaAllocator<Value*> > Values;
+  typedef Value* const* const_iterator;
 
   ArrayValue();
+
+  // Constructor for an array allocated into |arena|. The elements of the
+  // array are allocated into |arena| and are released by the arena.
+  // @param arena the arena holding the elements, must outlive the array.
+  explicit ArrayValue(ValueArena* arena);
+
   virtual ~ArrayValue();
-  
+
+  // Returns the arena holding the elements, or nullptr for heap elements.
+  ValueArena* arena() const { return arena_; }
+
+  // Returns whether the elements are packed scalars of a single type.
+  bool IsPacked() const { return packed_; }
+
+  // Returns the type of the packed elements. Only valid for packed arrays.
+  ValueType packed_type() const {
+    DCHECK(packed_);
+    return packed_type_;
+  }
+
   // Returns whether the array is empty.
   bool IsEmpty() const;
 
   // Returns the number of elements in the array.
-  size_t Length() const;
+  virtual size_t Length() const;
 
-  // Appends a Value to the end of the sequence.
+  // Reserves room for |size| elements.
+  // @param size the expected number of elements.
+  void Reserve(size_t size);
+
+  // Appends a Value to the end of the sequence. Values cannot be appended
+  // through this interface to a packed array.
   // Take the ownership of |value|.
   // @param value the value to add.
   void Append(std::unique_ptr<Value> value);
@@ -291,6 +377,11 @@ class ArrayValue : public AggregateValue<VALUE_ARRAY> {
   // @param value the value to add.
   template<class T>
   void Append(const typename T::ScalarType& value) {
+    DCHECK(!packed_);
+    if (arena_ != nullptr) {
+      values_.push_back(arena_->New<T>(value));
+      return;
+    }
     std::unique_ptr<Value> ptr(new T(value));
     Append(std::move(ptr));
   }
@@ -323,7 +414,7 @@ class ArrayValue : public AggregateValue<VALUE_ARRAY> {
   template<class T>
   bool GetElementAs(size_t index, const T** value) const {
     DCHECK(value != nullptr);
-    if (index >= values_.size())
+    if (index >= Length())
       return false;
     const Value* field = at(index);
     if (!T::InstanceOf(field))
@@ -352,12 +443,13 @@ class ArrayValue : public AggregateValue<VALUE_ARRAY> {
   // Overridden from Value:
   // @{
   virtual bool Equals(const Value* value) const override;
+  virtual void Accept(ValueVisitor* visitor) const override;
   // @}
 
   // Iteration.
   // @{
-  const_iterator begin() const { return values_.begin(); }
-  const_iterator end() const { return values_.end(); }
+  virtual const_iterator begin() const;
+  virtual const_iterator end() const;
   // @}
 
   // Determine if |value| is of type ArrayType.
@@ -370,34 +462,77 @@ class ArrayValue : public AggregateValue<VALUE_ARRAY> {
   // @returns the casted value.
   static const ArrayValue* Cast(const Value* value);
 
+ protected:
+  // Constructor for a packed array.
+  // @param arena the arena holding the elements, or nullptr for the heap.
+  // @param packed_type the type of the elements of the array.
+  ArrayValue(ValueArena* arena, ValueType packed_type);
+
+  // Appends a Value created to give access to a packed element. Packed arrays
+  // create these values lazily, on the first use of the Value interface.
+  // @param value the value to append, owned by this array.
+  void AppendMaterialized(Value* value) const;
+
+  // Returns the number of values appended with AppendMaterialized().
+  size_t MaterializedLength() const { return values_.size(); }
+
  private:
-  Values values_;
+  ValueArena* arena_;
+  bool packed_;
+  ValueType packed_type_;
+
+  // The elements of the array. Packed arrays fill it lazily.
+  mutable Values values_;
 
   DISALLOW_COPY_AND_ASSIGN(ArrayValue);
 };
 
 // StructValue provides a key-value dictionary and keeps fields in a sequence.
+// Field names are interned atoms; structures hold few fields, so lookups scan
+// the sequence and compare atom identifiers. Structures with a fixed layout
+// are described by a StructSchema (see struct_schema.h).
 class StructValue : public AggregateValue<VALUE_STRUCT> {
  public:
-  typedef std::map<std::string, Value*> ValueMap;
-  typedef std::list<std::pair<std::string, Value*> > ValueList;
-  typedef ValueList::const_iterator const_iterator;
+  typedef std::pair<Atom, Value*> Field;
+  typedef std::vector<Field, ArenaAllocator<Field> > Fields;
+  typedef const Field* const_iterator;
 
   StructValue();
+
+  // Constructor for a struct allocated into |arena|. The fields of the
+  // struct are allocated into |arena| and are released by the arena.
+  // @param arena the arena holding the fields, must outlive the struct.
+  explicit StructValue(ValueArena* arena);
+
   virtual ~StructValue();
 
+  // Returns the arena holding the fields, or nullptr for heap fields.
+  ValueArena* arena() const { return arena_; }
+
+  // Returns the schema describing the layout of this structure, or nullptr
+  // when fields are added dynamically.
+  const StructSchema* schema() const { return schema_; }
+
   // Overridden from Value:
   // @{
   bool HasField(const std::string& name) const override;
   const Value* GetField(const std::string& name) const override;
   bool GetField(const std::string& name, const Value** value) const override;
+  bool HasField(Atom name) const override;
+  const Value* GetField(Atom name) const override;
+  bool GetField(Atom name, const Value** value) const override;
   // @}
 
-  // Add a field with name |name| to this structure.
+  // Add a field with name |name| to this structure. Fields cannot be added to
+  // a structure with a schema. A name passed as a string is interned for the
+  // lifetime of the process (see atom.h).
   // @param name the name of the field.
   // @param value the value of the field.
   // @returns true if the field can be added, false otherwise.
+  // @{
   bool AddField(const std::string& name, std::unique_ptr<Value> value);
+  bool AddField(Atom name, std::unique_ptr<Value> value);
+  // @}
 
   // Add a field with name |name| to this structure.
   // @tparam T the type of the value of the field.
@@ -406,19 +541,77 @@ class StructValue : public AggregateValue<VALUE_STRUCT> {
   // @returns true if the field can be added, false otherwise.
   template<class T>
   bool AddField(const std::string& name, const typename T::ScalarType& value) {
+    return AddField<T>(Atom::Intern(name), value);
+  }
+
+  // Add a field with name |name| to this structure.
+  // @tparam T the type of the value of the field.
+  // @param name the name of the field.
+  // @param value the value of the field.
+  // @returns true if the field can be added, false otherwise.
+  template<class T>
+  bool AddField(Atom name, const typename T::ScalarType& value) {
+    if (arena_ != nullptr) {
+      if (!CanAddField(name))
+        return false;
+      InsertField(name, arena_->New<T>(value));
+      return true;
+    }
     std::unique_ptr<Value> ptr(new T(value));
     return AddField(name, std::move(ptr));
   }
 
+  // Reserves room for |size| fields. Fields cannot be added to a structure
+  // with a schema.
+  // @param size the expected number of fields.
+  void Reserve(size_t size);
+
+  // Add an empty aggregate field with name |name| to this structure. The new
+  // aggregate shares the arena of this structure.
+  // @param name the name of the field.
+  // @returns the new aggregate, owned by this structure, or nullptr if the
+  //     field cannot be added.
+  // @{
+  ArrayValue* AddArrayField(const std::string& name);
+  ArrayValue* AddArrayField(Atom name);
+  StructValue* AddStructField(const std::string& name);
+  StructValue* AddStructField(Atom name);
+  // @}
+
+  // Add an empty packed array field with name |name| to this structure. The
+  // caller must include packed_array_value.h.
+  // @tparam T the type of the elements of the array.
+  // @param name the name of the field.
+  // @returns the new array, owned by this structure, or nullptr if the field
+  //     cannot be added.
+  template<class T>
+  PackedArrayValue<T>* AddPackedArrayField(Atom name) {
+    if (!CanAddField(name))
+      return nullptr;
+    PackedArrayValue<T>* array = nullptr;
+    if (arena_ != nullptr)
+      array = arena_->New<PackedArrayValue<T> >(arena_);
+    else
+      array = new PackedArrayValue<T>();
+    InsertField(name, array);
+    return array;
+  }
+
+  template<class T>
+  PackedArrayValue<T>* AddPackedArrayField(const std::string& name) {
+    return AddPackedArrayField<T>(Atom::Intern(name));
+  }
+
   // Overridden from Value:
   // @{
   virtual bool Equals(const Value* value) const override;
+  virtual void Accept(ValueVisitor* visitor) const override;
   // @}
 
   // Iteration.
   // @{
-  const_iterator fields_begin() const { return fields_.begin(); }
-  const_iterator fields_end() const { return fields_.end(); }
+  virtual const_iterator fields_begin() const;
+  virtual const_iterator fields_end() const;
   // @}
 
   // Determine if |value| is of type StructType.
@@ -430,9 +623,22 @@ class StructValue : public AggregateValue<VALUE_STRUCT> {
   // @returns the casted value.
   static const StructValue* Cast(const Value* value);
 
+ protected:
+  // Constructor for a structure with a fixed layout.
+  // @param schema the layout of the structure, must outlive the struct.
+  // @param arena the arena holding the fields, or nullptr for the heap.
+  StructValue(const StructSchema* schema, ValueArena* arena);
+
  private:
-  ValueList fields_;
-  ValueMap fields_map_;
+  // Returns whether a field named |name| can be added to this structure.
+  bool CanAddField(Atom name) const;
+
+  // Appends a field which is known not to exist yet.
+  void InsertField(Atom name, Value* value);
+
+  const StructSchema* schema_;
+  ValueArena* arena_;
+  Fields fields_;
 
   DISALLOW_COPY_AND_ASSIGN(StructValue);
 };
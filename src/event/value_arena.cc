@@ -0,0 +1,90 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/value_arena.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace event {
+
+ValueArena::ValueArena(size_t block_size)
+    : block_size_(block_size),
+      current_block_(0),
+      current_offset_(0),
+      bytes_used_(0) {
+  DCHECK_GT(block_size, 0U);
+}
+
+ValueArena::~ValueArena() {
+  Reset();
+  for (size_t i = 0; i < blocks_.size(); ++i)
+    delete [] blocks_[i].data;
+}
+
+void* ValueArena::Allocate(size_t size) {
+  // Round up the size to keep the next allocation aligned.
+  size_t aligned_size = (size + kAlignment - 1) & ~(kAlignment - 1);
+
+  // Find a block with enough free space, reusing the blocks kept by Reset().
+  while (current_block_ < blocks_.size() &&
+         blocks_[current_block_].size - current_offset_ < aligned_size) {
+    ++current_block_;
+    current_offset_ = 0;
+  }
+
+  // Request a new block to the heap.
+  if (current_block_ == blocks_.size()) {
+    Block block;
+    block.size = std::max(block_size_, aligned_size);
+    block.data = new char[block.size];
+    blocks_.push_back(block);
+    current_offset_ = 0;
+  }
+
+  void* result = blocks_[current_block_].data + current_offset_;
+  current_offset_ += aligned_size;
+  bytes_used_ += aligned_size;
+  return result;
+}
+
+void ValueArena::Reset() {
+  // Destroy the objects in the reverse order of their construction.
+  for (size_t i = cleanups_.size(); i > 0; --i)
+    cleanups_[i - 1].function(cleanups_[i - 1].object);
+  cleanups_.clear();
+
+  current_block_ = 0;
+  current_offset_ = 0;
+  bytes_used_ = 0;
+}
+
+void ValueArena::AddCleanup(CleanupFunction function, void* object) {
+  Cleanup cleanup = { function, object };
+  cleanups_.push_back(cleanup);
+}
+
+}  // namespace event
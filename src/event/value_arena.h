@@ -0,0 +1,211 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A ValueArena is a bump allocator used to build the Value tree of an event
+// without paying a heap allocation per field. Values carved from an arena are
+// owned by the arena and released all at once by Reset(), typically after the
+// event callback returns.
+//
+// Usage example:
+//   ValueArena arena;
+//   StructValue* fields = arena.New<StructValue>(&arena);
+//   fields->AddField<IntValue>("answer", 42);  // Allocated in |arena|.
+//   ...
+//   arena.Reset();  // |fields| and its children are released.
+
+#ifndef EVENT_VALUE_ARENA_H_
+#define EVENT_VALUE_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/base.h"
+
+namespace event {
+
+// Types whose destructor only releases memory may skip the arena cleanup list
+// by specializing this trait.
+template<class T>
+struct ArenaSkipsDestructor : std::is_trivially_destructible<T> {
+};
+
+// A region allocator for Values.
+class ValueArena {
+ public:
+  // Default size of the memory blocks requested to the heap, in bytes.
+  static const size_t kDefaultBlockSize = 16 * 1024;
+
+  // Alignment of every allocation, in bytes.
+  static const size_t kAlignment = 8;
+
+  // Constructor.
+  // @param block_size the size of the memory blocks requested to the heap.
+  explicit ValueArena(size_t block_size = kDefaultBlockSize);
+
+  // Destructor. Releases every object allocated in the arena.
+  ~ValueArena();
+
+  // Allocates raw memory in the arena.
+  // @param size the number of bytes to allocate.
+  // @returns a pointer to |size| bytes aligned on |kAlignment|.
+  void* Allocate(size_t size);
+
+  // Constructs an object of type T in the arena. The destructor of the object
+  // is invoked by Reset() unless ArenaSkipsDestructor<T> is true.
+  // @param args the arguments forwarded to the constructor of T.
+  // @returns the constructed object, owned by the arena.
+  template<class T, class... Args>
+  T* New(Args&&... args) {
+    static_assert(std::alignment_of<T>::value <= kAlignment,
+                  "Type is over-aligned for ValueArena.");
+    void* memory = Allocate(sizeof(T));
+    T* object = new (memory) T(std::forward<Args>(args)...);
+    if (!ArenaSkipsDestructor<T>::value)
+      AddCleanup(&DestroyObject<T>, object);
+    return object;
+  }
+
+  // Transfers the ownership of a heap allocated object to the arena. The
+  // object is deleted by Reset().
+  // @param object the object to adopt.
+  // @returns the adopted object, owned by the arena.
+  template<class T>
+  T* Adopt(std::unique_ptr<T> object) {
+    T* raw_object = object.release();
+    if (raw_object != nullptr)
+      AddCleanup(&DeleteObject<T>, raw_object);
+    return raw_object;
+  }
+
+  // Releases every object allocated in the arena. The memory blocks are kept
+  // to serve the next allocations.
+  void Reset();
+
+  // Returns the number of bytes handed out since the last Reset().
+  size_t BytesUsed() const { return bytes_used_; }
+
+ private:
+  typedef void (*CleanupFunction)(void* object);
+
+  struct Block {
+    char* data;
+    size_t size;
+  };
+
+  struct Cleanup {
+    CleanupFunction function;
+    void* object;
+  };
+
+  template<class T>
+  static void DestroyObject(void* object) {
+    static_cast<T*>(object)->~T();
+  }
+
+  template<class T>
+  static void DeleteObject(void* object) {
+    delete static_cast<T*>(object);
+  }
+
+  void AddCleanup(CleanupFunction function, void* object);
+
+  // Size of the blocks requested to the heap.
+  size_t block_size_;
+
+  // Memory blocks owned by the arena.
+  std::vector<Block> blocks_;
+
+  // Index of the block serving the allocations and offset of the first free
+  // byte into this block.
+  size_t current_block_;
+  size_t current_offset_;
+
+  // Number of bytes handed out since the last Reset().
+  size_t bytes_used_;
+
+  // Destructors to run on Reset(), in allocation order.
+  std::vector<Cleanup> cleanups_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueArena);
+};
+
+// A standard allocator carving its memory from a ValueArena. A default
+// constructed allocator uses the heap.
+//
+// The arena doesn't reuse memory before Reset(): when a std::vector using this
+// allocator grows, its previous buffer stays in the arena until then. Growing
+// a vector one element at a time from 1 to N elements strands about N
+// elements; reserve the expected size when it is known (e.g.
+// StructValue::Reserve(), ArrayValue::Reserve()).
+template<class T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+
+  ArenaAllocator() : arena_(nullptr) {
+  }
+
+  explicit ArenaAllocator(ValueArena* arena) : arena_(arena) {
+  }
+
+  template<class U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {
+  }
+
+  T* allocate(size_t n) {
+    if (arena_ != nullptr)
+      return static_cast<T*>(arena_->Allocate(n * sizeof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, size_t /* n */) {
+    // Memory carved from an arena is released by ValueArena::Reset().
+    if (arena_ == nullptr)
+      ::operator delete(pointer);
+  }
+
+  ValueArena* arena() const { return arena_; }
+
+ private:
+  ValueArena* arena_;
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right) {
+  return left.arena() == right.arena();
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& left, const ArenaAllocator<U>& right) {
+  return left.arena() != right.arena();
+}
+
+}  // namespace event
+
+#endif  // EVENT_VALUE_ARENA_H_
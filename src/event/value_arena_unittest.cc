@@ -0,0 +1,182 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/value_arena.h"
+
+#include <cstdint>
+#include <string>
+
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+class IncrementOnDelete : public IntValue {
+ public:
+  IncrementOnDelete(int value, int* ptr)
+      : IntValue(value), ptr_(ptr) {
+  }
+  ~IncrementOnDelete() { *ptr_ += 1; }
+ private:
+  int* ptr_;
+};
+
+}  // namespace
+
+TEST(ValueArenaTest, Allocate) {
+  ValueArena arena(64);
+
+  void* first = arena.Allocate(3);
+  void* second = arena.Allocate(5);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(first) % ValueArena::kAlignment);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(second) % ValueArena::kAlignment);
+  EXPECT_NE(first, second);
+
+  // An allocation larger than the block size gets its own block.
+  void* large = arena.Allocate(256);
+  EXPECT_TRUE(large != nullptr);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(large) % ValueArena::kAlignment);
+}
+
+TEST(ValueArenaTest, ResetReusesMemory) {
+  ValueArena arena;
+
+  void* first = arena.Allocate(16);
+  EXPECT_LE(16U, arena.BytesUsed());
+
+  arena.Reset();
+  EXPECT_EQ(0U, arena.BytesUsed());
+
+  void* second = arena.Allocate(16);
+  EXPECT_EQ(first, second);
+}
+
+TEST(ValueArenaTest, ResetRunsDestructors) {
+  int deleted = 0;
+  ValueArena arena;
+
+  IncrementOnDelete* value = arena.New<IncrementOnDelete>(42, &deleted);
+  EXPECT_EQ(42, value->GetValue());
+  EXPECT_EQ(0, deleted);
+
+  arena.Reset();
+  EXPECT_EQ(1, deleted);
+
+  arena.Reset();
+  EXPECT_EQ(1, deleted);
+}
+
+TEST(ValueArenaTest, Adopt) {
+  int deleted = 0;
+  {
+    ValueArena arena;
+    IncrementOnDelete* value = new IncrementOnDelete(42, &deleted);
+    EXPECT_EQ(value,
+              arena.Adopt(std::unique_ptr<IncrementOnDelete>(value)));
+    EXPECT_EQ(0, deleted);
+  }
+  EXPECT_EQ(1, deleted);
+}
+
+TEST(ValueArenaTest, ArenaStruct) {
+  ValueArena arena;
+
+  StructValue* fields = arena.New<StructValue>(&arena);
+  EXPECT_EQ(&arena, fields->arena());
+  EXPECT_TRUE(fields->AddField<IntValue>("int", 42));
+  EXPECT_TRUE(fields->AddField<StringValue>("string", "dummy"));
+  EXPECT_FALSE(fields->AddField<IntValue>("int", 43));
+
+  ArrayValue* array = fields->AddArrayField("array");
+  ASSERT_TRUE(array != nullptr);
+  EXPECT_EQ(&arena, array->arena());
+  array->Append<UIntValue>(1);
+  array->Append<UIntValue>(2);
+  EXPECT_EQ(nullptr, fields->AddArrayField("array"));
+
+  StructValue* inner = fields->AddStructField("inner");
+  ASSERT_TRUE(inner != nullptr);
+  EXPECT_EQ(&arena, inner->arena());
+  inner->AddField<ULongValue>("ulong", 12);
+  EXPECT_EQ(nullptr, fields->AddStructField("inner"));
+
+  // Build the same value on the heap.
+  StructValue expected;
+  expected.AddField<IntValue>("int", 42);
+  expected.AddField<StringValue>("string", "dummy");
+  std::unique_ptr<ArrayValue> expected_array(new ArrayValue);
+  expected_array->Append<UIntValue>(1);
+  expected_array->Append<UIntValue>(2);
+  expected.AddField("array", std::move(expected_array));
+  std::unique_ptr<StructValue> expected_inner(new StructValue);
+  expected_inner->AddField<ULongValue>("ulong", 12);
+  expected.AddField("inner", std::move(expected_inner));
+
+  EXPECT_TRUE(expected.Equals(fields));
+  EXPECT_TRUE(fields->Equals(&expected));
+
+  arena.Reset();
+}
+
+TEST(ValueArenaTest, ArenaStructReserve) {
+  const char* kNames[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+  const size_t kCount = sizeof(kNames) / sizeof(kNames[0]);
+
+  // Growing the fields one at a time strands the previous buffers.
+  ValueArena growing_arena;
+  StructValue* growing = growing_arena.New<StructValue>(&growing_arena);
+  for (size_t i = 0; i < kCount; ++i)
+    growing->AddField<IntValue>(kNames[i], 42);
+
+  ValueArena reserved_arena;
+  StructValue* reserved = reserved_arena.New<StructValue>(&reserved_arena);
+  reserved->Reserve(kCount);
+  for (size_t i = 0; i < kCount; ++i)
+    reserved->AddField<IntValue>(kNames[i], 42);
+
+  EXPECT_TRUE(growing->Equals(reserved));
+  EXPECT_LT(reserved_arena.BytesUsed(), growing_arena.BytesUsed());
+}
+
+TEST(ValueArenaTest, ArenaStructAdoptsHeapValues) {
+  int deleted = 0;
+  ValueArena arena;
+
+  StructValue* fields = arena.New<StructValue>(&arena);
+  std::unique_ptr<Value> value(new IncrementOnDelete(42, &deleted));
+  EXPECT_TRUE(fields->AddField("value", std::move(value)));
+
+  ArrayValue* array = fields->AddArrayField("array");
+  std::unique_ptr<Value> element(new IncrementOnDelete(43, &deleted));
+  array->Append(std::move(element));
+  EXPECT_EQ(0, deleted);
+
+  arena.Reset();
+  EXPECT_EQ(2, deleted);
+}
+
+}  // namespace event
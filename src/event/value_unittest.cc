@@ -1028,6 +1028,72 @@ TEST(StructValueTest, GetFieldAs) {
   EXPECT_FALSE(struct_value.GetFieldAsWString("no_field", &wstring_value));
 }
 
+TEST(StructValueTest, AtomOperations) {
+  const Atom kField = Atom::Intern("field");
+  const Atom kOther = Atom::Intern("other");
+  StructValue value;
+
+  EXPECT_FALSE(value.HasField(kField));
+  EXPECT_TRUE(value.AddField<IntValue>(kField, 42));
+  EXPECT_FALSE(value.AddField<IntValue>(kField, 43));
+  EXPECT_FALSE(value.AddField<IntValue>("field", 43));
+  EXPECT_TRUE(value.HasField(kField));
+  EXPECT_TRUE(value.HasField("field"));
+  EXPECT_FALSE(value.HasField(kOther));
+
+  std::unique_ptr<Value> other(new StringValue("dummy"));
+  Value* raw_other = other.get();
+  EXPECT_TRUE(value.AddField(kOther, std::move(other)));
+  EXPECT_EQ(raw_other, value.GetField(kOther));
+  EXPECT_EQ(raw_other, value.GetField("other"));
+
+  const Value* retrieved = NULL;
+  EXPECT_FALSE(value.GetField(Atom::Intern("dummy"), &retrieved));
+  EXPECT_EQ(NULL, retrieved);
+  EXPECT_TRUE(value.GetField(kOther, &retrieved));
+  EXPECT_EQ(raw_other, retrieved);
+
+  int32_t int_value = 0;
+  EXPECT_TRUE(value.GetFieldAsInteger(kField, &int_value));
+  EXPECT_EQ(42, int_value);
+  std::string string_value;
+  EXPECT_TRUE(value.GetFieldAsString(kOther, &string_value));
+  EXPECT_EQ("dummy", string_value);
+  EXPECT_FALSE(value.GetFieldAsString(kField, &string_value));
+
+  const StringValue* raw_value = NULL;
+  EXPECT_TRUE(value.GetFieldAs<StringValue>(kOther, &raw_value));
+  EXPECT_FALSE(value.GetFieldAs<StringValue>(kField, &raw_value));
+
+  // Fields added by name or by atom are the same.
+  StructValue expected;
+  expected.AddField<IntValue>("field", 42);
+  expected.AddField<StringValue>("other", "dummy");
+  EXPECT_TRUE(expected.Equals(&value));
+
+  // Scalars have no fields.
+  IntValue scalar(42);
+  EXPECT_FALSE(scalar.HasField(kField));
+  EXPECT_EQ(NULL, scalar.GetField(kField));
+}
+
+TEST(StructValueTest, GetUnknownFieldByName) {
+  StructValue value;
+  value.AddField<IntValue>("field", 42);
+
+  // Looking up a name which was never interned doesn't intern it.
+  const char kUnknown[] = "StructValueTestNeverInternedField";
+  EXPECT_FALSE(value.HasField(kUnknown));
+  EXPECT_EQ(NULL, value.GetField(kUnknown));
+  int32_t int_value = 0;
+  EXPECT_FALSE(value.GetFieldAsInteger(kUnknown, &int_value));
+  Atom atom;
+  EXPECT_FALSE(Atom::Lookup(kUnknown, &atom));
+
+  EXPECT_TRUE(value.GetFieldAsInteger("field", &int_value));
+  EXPECT_EQ(42, int_value);
+}
+
 TEST(StructValueTest, Destructor) {
   int count = 0;
   {
@@ -0,0 +1,136 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Visitors walk a tree of Values with one dispatch per node instead of
+// probing each node with InstanceOf() for every possible type.
+//
+// ValueVisitor is the dynamic form: Value::Accept() calls the Visit()
+// overload of the concrete type of the value.
+//
+//   class CountVisitor : public ValueVisitor { ... };
+//   CountVisitor visitor;
+//   payload->Accept(&visitor);
+//
+// VisitValue() is the static form: it switches on the type of the value and
+// calls the function operator of a visitor class with the concrete type. The
+// calls are resolved at compile time and can be inlined.
+//
+//   struct IsZero {
+//     typedef bool result_type;
+//     template<class T> bool operator()(const T& value) const { ... }
+//   };
+//   bool is_zero = VisitValue(value, IsZero());
+
+#ifndef EVENT_VALUE_VISITOR_H_
+#define EVENT_VALUE_VISITOR_H_
+
+#include "base/logging.h"
+#include "event/string_view_value.h"
+#include "event/value.h"
+
+namespace event {
+
+class ValueVisitor {
+ public:
+  virtual ~ValueVisitor() { }
+
+  // Called by Value::Accept() with the concrete type of the value. Aggregates
+  // are not walked recursively: a visitor calls Accept() on the elements it
+  // wants to visit.
+  // @param value the visited value.
+  // @{
+  virtual void Visit(const BoolValue& value) = 0;
+  virtual void Visit(const CharValue& value) = 0;
+  virtual void Visit(const UCharValue& value) = 0;
+  virtual void Visit(const ShortValue& value) = 0;
+  virtual void Visit(const UShortValue& value) = 0;
+  virtual void Visit(const IntValue& value) = 0;
+  virtual void Visit(const UIntValue& value) = 0;
+  virtual void Visit(const LongValue& value) = 0;
+  virtual void Visit(const ULongValue& value) = 0;
+  virtual void Visit(const FloatValue& value) = 0;
+  virtual void Visit(const DoubleValue& value) = 0;
+  virtual void Visit(const StringValue& value) = 0;
+  virtual void Visit(const WStringValue& value) = 0;
+  virtual void Visit(const StringViewValue& value) = 0;
+  virtual void Visit(const W16StringViewValue& value) = 0;
+  virtual void Visit(const StructValue& value) = 0;
+  virtual void Visit(const ArrayValue& value) = 0;
+  // @}
+};
+
+// Calls the function operator of |visitor| with the concrete type of |value|.
+// @tparam Visitor a class with a |result_type| typedef and a function operator
+//     accepting every concrete Value type.
+// @param value the visited value.
+// @param visitor the visitor.
+// @returns the result of the function operator.
+template<class Visitor>
+typename Visitor::result_type VisitValue(const Value* value,
+                                         Visitor visitor) {
+  DCHECK(value != nullptr);
+  switch (value->GetType()) {
+    case VALUE_BOOL:
+      return visitor(*BoolValue::Cast(value));
+    case VALUE_CHAR:
+      return visitor(*CharValue::Cast(value));
+    case VALUE_UCHAR:
+      return visitor(*UCharValue::Cast(value));
+    case VALUE_SHORT:
+      return visitor(*ShortValue::Cast(value));
+    case VALUE_USHORT:
+      return visitor(*UShortValue::Cast(value));
+    case VALUE_INT:
+      return visitor(*IntValue::Cast(value));
+    case VALUE_UINT:
+      return visitor(*UIntValue::Cast(value));
+    case VALUE_LONG:
+      return visitor(*LongValue::Cast(value));
+    case VALUE_ULONG:
+      return visitor(*ULongValue::Cast(value));
+    case VALUE_FLOAT:
+      return visitor(*FloatValue::Cast(value));
+    case VALUE_DOUBLE:
+      return visitor(*DoubleValue::Cast(value));
+    case VALUE_STRING:
+      return visitor(*StringValue::Cast(value));
+    case VALUE_WSTRING:
+      return visitor(*WStringValue::Cast(value));
+    case VALUE_STRING_VIEW:
+      return visitor(*StringViewValue::Cast(value));
+    case VALUE_W16STRING_VIEW:
+      return visitor(*W16StringViewValue::Cast(value));
+    case VALUE_STRUCT:
+      return visitor(*StructValue::Cast(value));
+    case VALUE_ARRAY:
+      break;
+  }
+
+  return visitor(*ArrayValue::Cast(value));
+}
+
+}  // namespace event
+
+#endif  // EVENT_VALUE_VISITOR_H_
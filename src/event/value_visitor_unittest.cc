@@ -0,0 +1,190 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/value_visitor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event/packed_array_value.h"
+#include "event/struct_schema.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+// Records the type of every visited value, walking aggregates recursively.
+class RecordingVisitor : public ValueVisitor {
+ public:
+  const std::vector<ValueType>& types() const { return types_; }
+
+  void Visit(const BoolValue& value) override { Record(value); }
+  void Visit(const CharValue& value) override { Record(value); }
+  void Visit(const UCharValue& value) override { Record(value); }
+  void Visit(const ShortValue& value) override { Record(value); }
+  void Visit(const UShortValue& value) override { Record(value); }
+  void Visit(const IntValue& value) override { Record(value); }
+  void Visit(const UIntValue& value) override { Record(value); }
+  void Visit(const LongValue& value) override { Record(value); }
+  void Visit(const ULongValue& value) override { Record(value); }
+  void Visit(const FloatValue& value) override { Record(value); }
+  void Visit(const DoubleValue& value) override { Record(value); }
+  void Visit(const StringValue& value) override { Record(value); }
+  void Visit(const WStringValue& value) override { Record(value); }
+  void Visit(const StringViewValue& value) override { Record(value); }
+  void Visit(const W16StringViewValue& value) override { Record(value); }
+
+  void Visit(const StructValue& value) override {
+    Record(value);
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end(); ++it)
+      it->second->Accept(this);
+  }
+
+  void Visit(const ArrayValue& value) override {
+    Record(value);
+    for (const Value* element : value)
+      element->Accept(this);
+  }
+
+ private:
+  void Record(const Value& value) { types_.push_back(value.GetType()); }
+
+  std::vector<ValueType> types_;
+};
+
+// Returns the type of a value, as known at compile time.
+struct StaticType {
+  typedef ValueType result_type;
+
+  template<class T>
+  ValueType operator()(const T& value) const {
+    return T::kType;
+  }
+
+  ValueType operator()(const StructValue& value) const {
+    return VALUE_STRUCT;
+  }
+
+  ValueType operator()(const ArrayValue& value) const {
+    return VALUE_ARRAY;
+  }
+};
+
+// Returns whether a value is a scalar equal to zero.
+struct IsZero {
+  typedef bool result_type;
+
+  template<class T>
+  bool operator()(const T& value) const {
+    return value.GetValue() == 0;
+  }
+
+  bool operator()(const StringValue& value) const { return false; }
+  bool operator()(const WStringValue& value) const { return false; }
+  bool operator()(const StringViewValue& value) const { return false; }
+  bool operator()(const W16StringViewValue& value) const { return false; }
+  bool operator()(const StructValue& value) const { return false; }
+  bool operator()(const ArrayValue& value) const { return false; }
+};
+
+}  // namespace
+
+TEST(ValueVisitorTest, Accept) {
+  StructValue fields;
+  fields.AddField<BoolValue>("bool", true);
+  fields.AddField<CharValue>("char", 1);
+  fields.AddField<UCharValue>("uchar", 1);
+  fields.AddField<ShortValue>("short", 1);
+  fields.AddField<UShortValue>("ushort", 1);
+  fields.AddField<IntValue>("int", 1);
+  fields.AddField<UIntValue>("uint", 1);
+  fields.AddField<LongValue>("long", 1);
+  fields.AddField<ULongValue>("ulong", 1);
+  fields.AddField<FloatValue>("float", 1);
+  fields.AddField<DoubleValue>("double", 1);
+  fields.AddField<StringValue>("string", "1");
+  fields.AddField<WStringValue>("wstring", L"1");
+  fields.AddField<StringViewValue>(
+      "string_view", base::Span<const char>("1", 1));
+  fields.AddField<W16StringViewValue>(
+      "w16string_view", base::Span<const char>("1\0", 2));
+  ArrayValue* array = fields.AddArrayField("array");
+  array->Append<IntValue>(1);
+  fields.AddPackedArrayField<ULongValue>("packed")->Append(1);
+
+  RecordingVisitor visitor;
+  fields.Accept(&visitor);
+
+  const ValueType kExpected[] = {
+      VALUE_STRUCT, VALUE_BOOL, VALUE_CHAR, VALUE_UCHAR, VALUE_SHORT,
+      VALUE_USHORT, VALUE_INT, VALUE_UINT, VALUE_LONG, VALUE_ULONG,
+      VALUE_FLOAT, VALUE_DOUBLE, VALUE_STRING, VALUE_WSTRING,
+      VALUE_STRING_VIEW, VALUE_W16STRING_VIEW, VALUE_ARRAY, VALUE_INT,
+      VALUE_ARRAY, VALUE_ULONG };
+  std::vector<ValueType> expected(
+      kExpected, kExpected + sizeof(kExpected) / sizeof(kExpected[0]));
+  EXPECT_EQ(expected, visitor.types());
+}
+
+TEST(ValueVisitorTest, AcceptSchemaStruct) {
+  StructSchema schema;
+  schema.AddField<UIntValue>("id");
+  SchemaStructValue fields(&schema);
+  fields.Append<UIntValue>(42);
+
+  RecordingVisitor visitor;
+  fields.Accept(&visitor);
+
+  ASSERT_EQ(2U, visitor.types().size());
+  EXPECT_EQ(VALUE_STRUCT, visitor.types()[0]);
+  EXPECT_EQ(VALUE_UINT, visitor.types()[1]);
+}
+
+TEST(ValueVisitorTest, VisitValue) {
+  std::vector<std::unique_ptr<Value>> values;
+  values.emplace_back(new BoolValue(false));
+  values.emplace_back(new CharValue(1));
+  values.emplace_back(new UShortValue(0));
+  values.emplace_back(new ULongValue(0));
+  values.emplace_back(new DoubleValue(.5));
+  values.emplace_back(new StringValue("0"));
+  values.emplace_back(new W16StringViewValue(base::Span<const char>()));
+  values.emplace_back(new StructValue());
+  values.emplace_back(new PackedArrayValue<IntValue>());
+
+  const bool kIsZero[] = {
+      true, false, true, true, false, false, false, false, false };
+  ASSERT_EQ(sizeof(kIsZero) / sizeof(kIsZero[0]), values.size());
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i]->GetType(), VisitValue(values[i].get(), StaticType()));
+    EXPECT_EQ(kIsZero[i], VisitValue(values[i].get(), IsZero()));
+  }
+}
+
+}  // namespace event
@@ -0,0 +1,399 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/variant.h"
+
+#include <cstring>
+#include <limits>
+
+#include "base/string_utils.h"
+#include "event/string_view_value.h"
+
+namespace event {
+
+const uint8_t Variant::kNullType;
+
+Variant Variant::FromString(const std::string* value) {
+  DCHECK(value != nullptr);
+  Variant variant(VALUE_STRING);
+  variant.string_ = value;
+  return variant;
+}
+
+Variant Variant::FromWString(const std::wstring* value) {
+  DCHECK(value != nullptr);
+  Variant variant(VALUE_WSTRING);
+  variant.wstring_ = value;
+  return variant;
+}
+
+Variant Variant::FromStringView(const base::Span<const char>& value) {
+  DCHECK_LE(value.size(), std::numeric_limits<uint32_t>::max());
+  Variant variant(VALUE_STRING_VIEW);
+  variant.data_ = value.data();
+  variant.size_ = static_cast<uint32_t>(value.size());
+  return variant;
+}
+
+Variant Variant::FromW16StringView(const base::Span<const char>& value) {
+  DCHECK_LE(value.size(), std::numeric_limits<uint32_t>::max());
+  DCHECK_EQ(0U, value.size() % 2);
+  Variant variant(VALUE_W16STRING_VIEW);
+  variant.data_ = value.data();
+  variant.size_ = static_cast<uint32_t>(value.size());
+  return variant;
+}
+
+Variant Variant::FromAggregate(const Value* value) {
+  DCHECK(value != nullptr);
+  DCHECK(value->IsAggregate());
+  Variant variant(value->GetType());
+  variant.aggregate_ = value;
+  return variant;
+}
+
+Variant Variant::FromValue(const Value* value) {
+  DCHECK(value != nullptr);
+
+  switch (value->GetType()) {
+    case VALUE_BOOL:
+      return Make<BoolValue>(BoolValue::GetValue(value));
+    case VALUE_CHAR:
+      return Make<CharValue>(CharValue::GetValue(value));
+    case VALUE_UCHAR:
+      return Make<UCharValue>(UCharValue::GetValue(value));
+    case VALUE_SHORT:
+      return Make<ShortValue>(ShortValue::GetValue(value));
+    case VALUE_USHORT:
+      return Make<UShortValue>(UShortValue::GetValue(value));
+    case VALUE_INT:
+      return Make<IntValue>(IntValue::GetValue(value));
+    case VALUE_UINT:
+      return Make<UIntValue>(UIntValue::GetValue(value));
+    case VALUE_LONG:
+      return Make<LongValue>(LongValue::GetValue(value));
+    case VALUE_ULONG:
+      return Make<ULongValue>(ULongValue::GetValue(value));
+    case VALUE_FLOAT:
+      return Make<FloatValue>(FloatValue::GetValue(value));
+    case VALUE_DOUBLE:
+      return Make<DoubleValue>(DoubleValue::GetValue(value));
+    case VALUE_STRING:
+      return FromString(&StringValue::GetValue(value));
+    case VALUE_WSTRING:
+      return FromWString(&WStringValue::GetValue(value));
+    case VALUE_STRING_VIEW:
+      return FromStringView(StringViewValue::Cast(value)->GetValue());
+    case VALUE_W16STRING_VIEW:
+      return FromW16StringView(W16StringViewValue::Cast(value)->GetValue());
+    case VALUE_STRUCT:
+    case VALUE_ARRAY:
+      return FromAggregate(value);
+  }
+
+  LOG(FATAL) << "Unknown value type.";
+  return Variant();
+}
+
+std::unique_ptr<Value> Variant::ToValue() const {
+  std::unique_ptr<Value> value;
+  if (IsNull())
+    return value;
+
+  switch (GetType()) {
+    case VALUE_BOOL:
+      value.reset(new BoolValue(GetValue<BoolValue>()));
+      break;
+    case VALUE_CHAR:
+      value.reset(new CharValue(GetValue<CharValue>()));
+      break;
+    case VALUE_UCHAR:
+      value.reset(new UCharValue(GetValue<UCharValue>()));
+      break;
+    case VALUE_SHORT:
+      value.reset(new ShortValue(GetValue<ShortValue>()));
+      break;
+    case VALUE_USHORT:
+      value.reset(new UShortValue(GetValue<UShortValue>()));
+      break;
+    case VALUE_INT:
+      value.reset(new IntValue(GetValue<IntValue>()));
+      break;
+    case VALUE_UINT:
+      value.reset(new UIntValue(GetValue<UIntValue>()));
+      break;
+    case VALUE_LONG:
+      value.reset(new LongValue(GetValue<LongValue>()));
+      break;
+    case VALUE_ULONG:
+      value.reset(new ULongValue(GetValue<ULongValue>()));
+      break;
+    case VALUE_FLOAT:
+      value.reset(new FloatValue(GetValue<FloatValue>()));
+      break;
+    case VALUE_DOUBLE:
+      value.reset(new DoubleValue(GetValue<DoubleValue>()));
+      break;
+    case VALUE_STRING:
+      value.reset(new StringValue(*string_));
+      break;
+    case VALUE_WSTRING:
+      value.reset(new WStringValue(*wstring_));
+      break;
+    case VALUE_STRING_VIEW:
+      value.reset(new StringViewValue(view()));
+      break;
+    case VALUE_W16STRING_VIEW:
+      value.reset(new W16StringViewValue(view()));
+      break;
+    case VALUE_STRUCT:
+    case VALUE_ARRAY:
+      break;
+  }
+
+  return value;
+}
+
+bool Variant::IsScalar() const {
+  return !IsNull() && !IsAggregate();
+}
+
+bool Variant::IsAggregate() const {
+  return type_ == VALUE_STRUCT || type_ == VALUE_ARRAY;
+}
+
+bool Variant::IsInteger() const {
+  return type_ <= VALUE_ULONG;
+}
+
+bool Variant::IsSigned() const {
+  switch (type_) {
+    case VALUE_CHAR:
+    case VALUE_SHORT:
+    case VALUE_INT:
+    case VALUE_LONG:
+    case VALUE_FLOAT:
+    case VALUE_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Variant::IsFloating() const {
+  return type_ == VALUE_FLOAT || type_ == VALUE_DOUBLE;
+}
+
+bool Variant::HoldsSignedInteger() const {
+  return type_ == VALUE_CHAR || type_ == VALUE_SHORT ||
+         type_ == VALUE_INT || type_ == VALUE_LONG;
+}
+
+bool Variant::GetAsInteger(int32_t* value) const {
+  DCHECK(value != nullptr);
+  if (!IsInteger())
+    return false;
+
+  if (HoldsSignedInteger()) {
+    if (long_ > std::numeric_limits<int32_t>::max() ||
+        long_ < std::numeric_limits<int32_t>::min()) {
+      return false;
+    }
+    *value = static_cast<int32_t>(long_);
+    return true;
+  }
+
+  if (ulong_ > static_cast<uint64_t>(std::numeric_limits<int32_t>::max()))
+    return false;
+  *value = static_cast<int32_t>(ulong_);
+  return true;
+}
+
+bool Variant::GetAsUInteger(uint32_t* value) const {
+  DCHECK(value != nullptr);
+  if (!IsInteger())
+    return false;
+
+  if (HoldsSignedInteger()) {
+    if (long_ < 0 || long_ > std::numeric_limits<uint32_t>::max())
+      return false;
+    *value = static_cast<uint32_t>(long_);
+    return true;
+  }
+
+  if (ulong_ > std::numeric_limits<uint32_t>::max())
+    return false;
+  *value = static_cast<uint32_t>(ulong_);
+  return true;
+}
+
+bool Variant::GetAsLong(int64_t* value) const {
+  DCHECK(value != nullptr);
+  if (!IsInteger())
+    return false;
+
+  if (HoldsSignedInteger()) {
+    *value = long_;
+    return true;
+  }
+
+  if (ulong_ > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+    return false;
+  *value = static_cast<int64_t>(ulong_);
+  return true;
+}
+
+bool Variant::GetAsULong(uint64_t* value) const {
+  DCHECK(value != nullptr);
+  if (!IsInteger())
+    return false;
+
+  if (HoldsSignedInteger()) {
+    if (long_ < 0)
+      return false;
+    *value = static_cast<uint64_t>(long_);
+    return true;
+  }
+
+  *value = ulong_;
+  return true;
+}
+
+bool Variant::GetAsFloating(double* value) const {
+  DCHECK(value != nullptr);
+  if (!IsFloating())
+    return false;
+  *value = double_;
+  return true;
+}
+
+bool Variant::GetAsString(std::string* value) const {
+  DCHECK(value != nullptr);
+
+  switch (type_) {
+    case VALUE_STRING:
+      *value = *string_;
+      return true;
+    case VALUE_WSTRING:
+      *value = base::WStringToString(*wstring_);
+      return true;
+    case VALUE_STRING_VIEW:
+      value->assign(data_, size_);
+      return true;
+    case VALUE_W16STRING_VIEW:
+      *value = base::WStringToString(W16StringViewValue(view()).wstr());
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Variant::GetAsWString(std::wstring* value) const {
+  DCHECK(value != nullptr);
+
+  switch (type_) {
+    case VALUE_STRING:
+      *value = base::StringToWString(*string_);
+      return true;
+    case VALUE_WSTRING:
+      *value = *wstring_;
+      return true;
+    case VALUE_STRING_VIEW:
+      *value = base::StringToWString(std::string(data_, size_));
+      return true;
+    case VALUE_W16STRING_VIEW:
+      *value = W16StringViewValue(view()).wstr();
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Variant::Equals(const Variant& other) const {
+  if (type_ != other.type_)
+    return false;
+
+  switch (type_) {
+    case kNullType:
+      return true;
+    case VALUE_FLOAT:
+    case VALUE_DOUBLE:
+      return double_ == other.double_;
+    case VALUE_STRING:
+      return *string_ == *other.string_;
+    case VALUE_WSTRING:
+      return *wstring_ == *other.wstring_;
+    case VALUE_STRING_VIEW:
+    case VALUE_W16STRING_VIEW:
+      return size_ == other.size_ &&
+             (size_ == 0 || ::memcmp(data_, other.data_, size_) == 0);
+    case VALUE_STRUCT:
+    case VALUE_ARRAY:
+      return aggregate_->Equals(other.aggregate_);
+    default:
+      // Integers of both signedness share the same bits.
+      return ulong_ == other.ulong_;
+  }
+}
+
+VariantStruct::VariantStruct() {
+}
+
+bool VariantStruct::AddField(Atom name, const Variant& value) {
+  if (!value.IsScalar())
+    return false;
+  Variant existing;
+  if (GetField(name, &existing))
+    return false;
+  fields_.push_back(std::make_pair(name, value));
+  return true;
+}
+
+bool VariantStruct::AddField(const std::string& name, const Variant& value) {
+  return AddField(Atom::Intern(name), value);
+}
+
+bool VariantStruct::GetField(Atom name, Variant* value) const {
+  DCHECK(value != nullptr);
+  for (const_iterator it = fields_.begin(); it != fields_.end(); ++it) {
+    if (it->first == name) {
+      *value = it->second;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<StructValue> VariantStruct::ToValue() const {
+  std::unique_ptr<StructValue> value(new StructValue());
+  for (const_iterator it = fields_.begin(); it != fields_.end(); ++it) {
+    std::unique_ptr<Value> field = it->second.ToValue();
+    DCHECK(field.get() != nullptr);
+    value->AddField(it->first, std::move(field));
+  }
+  return value;
+}
+
+}  // namespace event
@@ -0,0 +1,269 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A Variant is a compact alternative to the Value hierarchy. It is a 16-byte
+// tagged union holding a scalar inline; strings and aggregates are referenced
+// out-of-line. Queries on a Variant are plain switches on the tag instead of
+// virtual calls, and a Variant can be copied by value without any allocation.
+//
+// A Variant never owns the data it references: strings and aggregates must
+// outlive the Variant. Conversions from and to the Value hierarchy are
+// provided by FromValue() and ToValue().
+//
+// Usage example:
+//   VariantStruct header;
+//   header.AddField<ULongValue>(kProcessIdField, 4);
+//   header.AddField(kOperationField, Variant::FromString(&operation));
+//
+//   Variant pid;
+//   uint64_t process_id = 0;
+//   if (header.GetField(kProcessIdField, &pid) && pid.GetAsULong(&process_id))
+//     ...
+
+#ifndef EVENT_VARIANT_H_
+#define EVENT_VARIANT_H_
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/base.h"
+#include "base/logging.h"
+#include "base/span.h"
+#include "event/atom.h"
+#include "event/value.h"
+
+namespace event {
+
+class Variant {
+ public:
+  // Constructs a null variant.
+  Variant() : ulong_(0), size_(0), type_(kNullType) {
+  }
+
+  // Constructs a variant holding a scalar of an arithmetic type.
+  // @tparam T the type of the value, e.g. IntValue.
+  // @param value the value to hold.
+  // @returns the variant.
+  template<class T>
+  static Variant Make(const typename T::ScalarType& value) {
+    typedef typename T::ScalarType ScalarType;
+    static_assert(std::is_arithmetic<ScalarType>::value,
+                  "Only arithmetic scalars are held inline.");
+    Variant variant(T::kType);
+    if (std::is_floating_point<ScalarType>::value)
+      variant.double_ = static_cast<double>(value);
+    else if (std::is_signed<ScalarType>::value)
+      variant.long_ = static_cast<int64_t>(value);
+    else
+      variant.ulong_ = static_cast<uint64_t>(value);
+    return variant;
+  }
+
+  // Constructs variants referencing a string. The string must outlive the
+  // variant.
+  // @{
+  static Variant FromString(const std::string* value);
+  static Variant FromWString(const std::wstring* value);
+  static Variant FromStringView(const base::Span<const char>& value);
+  static Variant FromW16StringView(const base::Span<const char>& value);
+  // @}
+
+  // Constructs a variant referencing an aggregate Value. The aggregate must
+  // outlive the variant.
+  // @param value the aggregate to reference.
+  // @returns the variant.
+  static Variant FromAggregate(const Value* value);
+
+  // Constructs a variant equivalent to |value|. Scalars are copied; strings
+  // and aggregates are referenced and must outlive the variant.
+  // @param value the value to convert.
+  // @returns the variant.
+  static Variant FromValue(const Value* value);
+
+  // Creates an owned Value holding the same scalar as this variant. Strings
+  // are copied, except string views which keep referencing their characters.
+  // @returns the new value, or nullptr for a null or aggregate variant.
+  std::unique_ptr<Value> ToValue() const;
+
+  // Returns whether this variant holds nothing.
+  bool IsNull() const { return type_ == kNullType; }
+
+  // Returns the type of the value held by this variant. The variant must not
+  // be null.
+  ValueType GetType() const {
+    DCHECK(!IsNull());
+    return static_cast<ValueType>(type_);
+  }
+
+  // These methods return some properties of the value type, with the same
+  // semantic as their Value counterpart.
+  // @{
+  bool IsScalar() const;
+  bool IsAggregate() const;
+  bool IsInteger() const;
+  bool IsSigned() const;
+  bool IsFloating() const;
+  // @}
+
+  // Retrieves the arithmetic scalar held by this variant.
+  // @tparam T the type of the value, must match the type of the variant.
+  // @returns the value held by this variant.
+  template<class T>
+  typename T::ScalarType GetValue() const {
+    typedef typename T::ScalarType ScalarType;
+    static_assert(std::is_arithmetic<ScalarType>::value,
+                  "Only arithmetic scalars are held inline.");
+    DCHECK_EQ(static_cast<int>(T::kType), static_cast<int>(type_));
+    if (std::is_floating_point<ScalarType>::value)
+      return static_cast<ScalarType>(double_);
+    if (std::is_signed<ScalarType>::value)
+      return static_cast<ScalarType>(long_);
+    return static_cast<ScalarType>(ulong_);
+  }
+
+  // Returns the referenced aggregate, or nullptr if this variant does not
+  // hold an aggregate.
+  const Value* aggregate() const {
+    return IsAggregate() ? aggregate_ : nullptr;
+  }
+
+  // These methods allow the convenient retrieval of a basic value, with the
+  // same conversion rules as Value::GetAs*.
+  // @param value receives the value holded in this variant.
+  // @returns true when the conversion is valid, false otherwise and |value|
+  // stays unchanged.
+  // @{
+  bool GetAsInteger(int32_t* value) const;
+  bool GetAsUInteger(uint32_t* value) const;
+  bool GetAsLong(int64_t* value) const;
+  bool GetAsULong(uint64_t* value) const;
+  bool GetAsFloating(double* value) const;
+  bool GetAsString(std::string* value) const;
+  bool GetAsWString(std::wstring* value) const;
+  // @}
+
+  // Compare this variant with the given variant |other|. Strings are compared
+  // by content and aggregates with Value::Equals.
+  // @param other the variant to compare with.
+  // @returns true when both variants are equal, false otherwise.
+  bool Equals(const Variant& other) const;
+
+ private:
+  // Tag of a null variant.
+  static const uint8_t kNullType = 0xFF;
+
+  explicit Variant(ValueType type)
+      : ulong_(0), size_(0), type_(static_cast<uint8_t>(type)) {
+  }
+
+  // Returns the characters referenced by a string view variant.
+  base::Span<const char> view() const {
+    return base::Span<const char>(data_, size_);
+  }
+
+  // Returns whether the integer held by this variant is stored in |long_|.
+  bool HoldsSignedInteger() const;
+
+  union {
+    int64_t long_;
+    uint64_t ulong_;
+    double double_;
+    const char* data_;
+    const std::string* string_;
+    const std::wstring* wstring_;
+    const Value* aggregate_;
+  };
+
+  // The size of a string view, in bytes.
+  uint32_t size_;
+
+  // The ValueType of the held value, or kNullType.
+  uint8_t type_;
+};
+
+static_assert(sizeof(Variant) == 16, "Variant must stay compact.");
+
+// A structure of scalar variants, the Variant counterpart of StructValue.
+// Fields are kept in insertion order.
+class VariantStruct {
+ public:
+  typedef std::pair<Atom, Variant> Field;
+  typedef std::vector<Field> Fields;
+  typedef Fields::const_iterator const_iterator;
+
+  VariantStruct();
+
+  // Add a field with name |name| to this structure. Only scalar variants can
+  // be added.
+  // @param name the name of the field.
+  // @param value the value of the field.
+  // @returns true if the field can be added, false otherwise.
+  // @{
+  bool AddField(Atom name, const Variant& value);
+  bool AddField(const std::string& name, const Variant& value);
+  // @}
+
+  // Add a field holding an arithmetic scalar to this structure.
+  // @tparam T the type of the value of the field.
+  // @param name the name of the field.
+  // @param value the value of the field.
+  // @returns true if the field can be added, false otherwise.
+  template<class T>
+  bool AddField(Atom name, const typename T::ScalarType& value) {
+    return AddField(name, Variant::Make<T>(value));
+  }
+
+  // Retrieve the value of a field.
+  // @param name the name of the field to find.
+  // @param value receives the value of the field with name |name|.
+  // @returns true if the field is found, false otherwise.
+  bool GetField(Atom name, Variant* value) const;
+
+  // Returns the number of fields of this structure.
+  size_t size() const { return fields_.size(); }
+
+  // Iteration.
+  // @{
+  const_iterator begin() const { return fields_.begin(); }
+  const_iterator end() const { return fields_.end(); }
+  // @}
+
+  // Creates an owned StructValue holding the same fields.
+  // @returns the new structure.
+  std::unique_ptr<StructValue> ToValue() const;
+
+ private:
+  Fields fields_;
+
+  DISALLOW_COPY_AND_ASSIGN(VariantStruct);
+};
+
+}  // namespace event
+
+#endif  // EVENT_VARIANT_H_
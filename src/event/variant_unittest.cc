@@ -0,0 +1,335 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/variant.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event/string_view_value.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+// Returns a sample of values covering every scalar type and the boundaries
+// of the integer conversions.
+std::vector<std::unique_ptr<Value>> MakeScalarValues() {
+  std::vector<std::unique_ptr<Value>> values;
+  values.emplace_back(new BoolValue(true));
+  values.emplace_back(new CharValue(-1));
+  values.emplace_back(new CharValue(CharValue::MaxValue()));
+  values.emplace_back(new UCharValue(UCharValue::MaxValue()));
+  values.emplace_back(new ShortValue(ShortValue::MinValue()));
+  values.emplace_back(new UShortValue(UShortValue::MaxValue()));
+  values.emplace_back(new IntValue(IntValue::MinValue()));
+  values.emplace_back(new IntValue(42));
+  values.emplace_back(new UIntValue(UIntValue::MaxValue()));
+  values.emplace_back(new LongValue(LongValue::MinValue()));
+  values.emplace_back(new LongValue(-1));
+  values.emplace_back(new LongValue(UIntValue::MaxValue()));
+  values.emplace_back(new ULongValue(ULongValue::MaxValue()));
+  values.emplace_back(new ULongValue(1024));
+  values.emplace_back(new FloatValue(.5f));
+  values.emplace_back(new DoubleValue(-3.25));
+  values.emplace_back(new StringValue("dummy"));
+  values.emplace_back(new WStringValue(L"dummy"));
+  return values;
+}
+
+// Checks that a conversion of |variant| gives the same result as the
+// conversion of |value|.
+template<class T>
+void ExpectSameConversion(const Value* value,
+                          const Variant& variant,
+                          bool (Value::*value_getter)(T*) const,
+                          bool (Variant::*variant_getter)(T*) const) {
+  T expected = T();
+  T actual = T();
+  bool expected_result = (value->*value_getter)(&expected);
+  EXPECT_EQ(expected_result, (variant.*variant_getter)(&actual));
+  EXPECT_EQ(expected, actual);
+}
+
+}  // namespace
+
+TEST(VariantTest, Null) {
+  Variant variant;
+  EXPECT_TRUE(variant.IsNull());
+  EXPECT_FALSE(variant.IsScalar());
+  EXPECT_FALSE(variant.IsAggregate());
+  EXPECT_FALSE(variant.IsInteger());
+
+  uint64_t value = 0;
+  EXPECT_FALSE(variant.GetAsULong(&value));
+  EXPECT_EQ(nullptr, variant.ToValue().get());
+  EXPECT_TRUE(variant.Equals(Variant()));
+}
+
+TEST(VariantTest, Make) {
+  Variant variant = Variant::Make<IntValue>(-42);
+  EXPECT_FALSE(variant.IsNull());
+  EXPECT_EQ(VALUE_INT, variant.GetType());
+  EXPECT_TRUE(variant.IsScalar());
+  EXPECT_TRUE(variant.IsInteger());
+  EXPECT_TRUE(variant.IsSigned());
+  EXPECT_FALSE(variant.IsFloating());
+  EXPECT_EQ(-42, variant.GetValue<IntValue>());
+
+  Variant floating = Variant::Make<FloatValue>(.5f);
+  EXPECT_TRUE(floating.IsFloating());
+  EXPECT_EQ(.5f, floating.GetValue<FloatValue>());
+
+  Variant boolean = Variant::Make<BoolValue>(true);
+  EXPECT_TRUE(boolean.IsInteger());
+  EXPECT_FALSE(boolean.IsSigned());
+  EXPECT_TRUE(boolean.GetValue<BoolValue>());
+}
+
+TEST(VariantTest, SameConversionsAsValue) {
+  std::vector<std::unique_ptr<Value>> values = MakeScalarValues();
+  for (const auto& value : values) {
+    Variant variant = Variant::FromValue(value.get());
+    EXPECT_EQ(value->GetType(), variant.GetType());
+    EXPECT_EQ(value->IsScalar(), variant.IsScalar());
+    EXPECT_EQ(value->IsAggregate(), variant.IsAggregate());
+    EXPECT_EQ(value->IsInteger(), variant.IsInteger());
+    EXPECT_EQ(value->IsSigned(), variant.IsSigned());
+    EXPECT_EQ(value->IsFloating(), variant.IsFloating());
+
+    ExpectSameConversion<int32_t>(value.get(), variant,
+        &Value::GetAsInteger, &Variant::GetAsInteger);
+    ExpectSameConversion<uint32_t>(value.get(), variant,
+        &Value::GetAsUInteger, &Variant::GetAsUInteger);
+    ExpectSameConversion<int64_t>(value.get(), variant,
+        &Value::GetAsLong, &Variant::GetAsLong);
+    ExpectSameConversion<uint64_t>(value.get(), variant,
+        &Value::GetAsULong, &Variant::GetAsULong);
+    ExpectSameConversion<double>(value.get(), variant,
+        &Value::GetAsFloating, &Variant::GetAsFloating);
+    ExpectSameConversion<std::string>(value.get(), variant,
+        &Value::GetAsString, &Variant::GetAsString);
+    ExpectSameConversion<std::wstring>(value.get(), variant,
+        &Value::GetAsWString, &Variant::GetAsWString);
+
+    // The round trip gives back an equal value.
+    std::unique_ptr<Value> round_trip = variant.ToValue();
+    ASSERT_TRUE(round_trip.get() != nullptr);
+    EXPECT_TRUE(value->Equals(round_trip.get()));
+  }
+}
+
+TEST(VariantTest, Strings) {
+  const std::string kString("dummy");
+  const char kW16String[] = "d\0u\0m\0m\0y\0";
+
+  Variant string = Variant::FromString(&kString);
+  Variant view = Variant::FromStringView(
+      base::Span<const char>(kString.data(), kString.size()));
+  Variant w16_view = Variant::FromW16StringView(
+      base::Span<const char>(kW16String, 10));
+
+  std::string str;
+  std::wstring wstr;
+  EXPECT_TRUE(string.GetAsString(&str));
+  EXPECT_EQ(kString, str);
+  EXPECT_TRUE(view.GetAsWString(&wstr));
+  EXPECT_EQ(L"dummy", wstr);
+  EXPECT_TRUE(w16_view.GetAsString(&str));
+  EXPECT_EQ(kString, str);
+
+  // Views keep referencing their characters once converted to Values.
+  std::unique_ptr<Value> value = w16_view.ToValue();
+  ASSERT_TRUE(W16StringViewValue::InstanceOf(value.get()));
+  EXPECT_EQ(kW16String,
+            W16StringViewValue::Cast(value.get())->GetValue().data());
+  EXPECT_TRUE(w16_view.Equals(Variant::FromValue(value.get())));
+
+  const std::string kOther("dummy");
+  EXPECT_TRUE(string.Equals(Variant::FromString(&kOther)));
+  EXPECT_FALSE(string.Equals(view));
+
+  int32_t integer = 0;
+  EXPECT_FALSE(string.GetAsInteger(&integer));
+}
+
+TEST(VariantTest, Aggregate) {
+  StructValue fields;
+  fields.AddField<IntValue>("dummy", 42);
+  Variant variant = Variant::FromValue(&fields);
+  EXPECT_EQ(VALUE_STRUCT, variant.GetType());
+  EXPECT_TRUE(variant.IsAggregate());
+  EXPECT_FALSE(variant.IsScalar());
+  EXPECT_EQ(&fields, variant.aggregate());
+  EXPECT_EQ(nullptr, variant.ToValue().get());
+
+  int32_t integer = 0;
+  EXPECT_FALSE(variant.GetAsInteger(&integer));
+  EXPECT_EQ(nullptr, Variant::Make<IntValue>(42).aggregate());
+}
+
+TEST(VariantTest, VariantStruct) {
+  const Atom kName = Atom::Intern("name");
+  const Atom kValue = Atom::Intern("value");
+  const std::string kString("dummy");
+  StructValue aggregate;
+
+  VariantStruct fields;
+  EXPECT_TRUE(fields.AddField(kName, Variant::FromString(&kString)));
+  EXPECT_TRUE(fields.AddField<ULongValue>(kValue, 42));
+  EXPECT_FALSE(fields.AddField<ULongValue>(kValue, 43));
+  EXPECT_FALSE(fields.AddField("null", Variant()));
+  EXPECT_FALSE(fields.AddField("aggregate", Variant::FromValue(&aggregate)));
+  EXPECT_EQ(2U, fields.size());
+
+  Variant value;
+  uint64_t ulong_value = 0;
+  EXPECT_TRUE(fields.GetField(kValue, &value));
+  EXPECT_TRUE(value.GetAsULong(&ulong_value));
+  EXPECT_EQ(42U, ulong_value);
+  EXPECT_FALSE(fields.GetField(Atom::Intern("unknown"), &value));
+
+  std::unique_ptr<StructValue> expected(new StructValue());
+  expected->AddField<StringValue>("name", kString);
+  expected->AddField<ULongValue>("value", 42);
+  EXPECT_TRUE(expected->Equals(fields.ToValue().get()));
+}
+
+// Compares field accesses on Values and on Variants. Run with
+// --gtest_also_run_disabled_tests.
+TEST(VariantTest, DISABLED_Benchmark) {
+  const size_t kIterations = 10 * 1000 * 1000;
+  const char* kNames[] = { "ProcessId", "ThreadId", "BaseAddress", "Size",
+                           "Flags" };
+  const size_t kFieldCount = sizeof(kNames) / sizeof(kNames[0]);
+
+  StructValue value_fields;
+  VariantStruct variant_fields;
+  std::vector<Atom> atoms;
+  for (size_t i = 0; i < kFieldCount; ++i) {
+    atoms.push_back(Atom::Intern(kNames[i]));
+    value_fields.AddField<ULongValue>(atoms.back(), i);
+    variant_fields.AddField<ULongValue>(atoms.back(), i);
+  }
+
+  typedef std::chrono::steady_clock Clock;
+
+  uint64_t value_sum = 0;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    uint64_t field = 0;
+    if (value_fields.GetFieldAsULong(atoms[i % kFieldCount], &field))
+      value_sum += field;
+  }
+  Clock::duration value_time = Clock::now() - start;
+
+  uint64_t variant_sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    Variant field;
+    uint64_t field_value = 0;
+    if (variant_fields.GetField(atoms[i % kFieldCount], &field) &&
+        field.GetAsULong(&field_value)) {
+      variant_sum += field_value;
+    }
+  }
+  Clock::duration variant_time = Clock::now() - start;
+
+  EXPECT_EQ(value_sum, variant_sum);
+
+  // Conversion of every element of an array of scalars.
+  const size_t kArraySize = 1000;
+  ArrayValue value_array;
+  std::vector<Variant> variant_array;
+  for (uint32_t i = 0; i < kArraySize; ++i) {
+    value_array.Append<UIntValue>(i);
+    variant_array.push_back(Variant::Make<UIntValue>(i));
+  }
+
+  value_sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < kIterations / kArraySize; ++i) {
+    for (const Value* element : value_array) {
+      uint64_t element_value = 0;
+      if (element->GetAsULong(&element_value))
+        value_sum += element_value;
+    }
+  }
+  Clock::duration value_array_time = Clock::now() - start;
+
+  variant_sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < kIterations / kArraySize; ++i) {
+    for (const Variant& element : variant_array) {
+      uint64_t element_value = 0;
+      if (element.GetAsULong(&element_value))
+        variant_sum += element_value;
+    }
+  }
+  Clock::duration variant_array_time = Clock::now() - start;
+
+  EXPECT_EQ(value_sum, variant_sum);
+
+  // Creation of a structure of scalars.
+  start = Clock::now();
+  for (size_t i = 0; i < kIterations / 10; ++i) {
+    StructValue fields;
+    for (size_t j = 0; j < kFieldCount; ++j)
+      fields.AddField<ULongValue>(atoms[j], j);
+  }
+  Clock::duration value_creation_time = Clock::now() - start;
+
+  start = Clock::now();
+  for (size_t i = 0; i < kIterations / 10; ++i) {
+    VariantStruct fields;
+    for (size_t j = 0; j < kFieldCount; ++j)
+      fields.AddField<ULongValue>(atoms[j], j);
+  }
+  Clock::duration variant_creation_time = Clock::now() - start;
+
+  typedef std::chrono::milliseconds ms;
+  std::cout << "Field access: Value "
+            << std::chrono::duration_cast<ms>(value_time).count()
+            << " ms, Variant "
+            << std::chrono::duration_cast<ms>(variant_time).count()
+            << " ms" << std::endl;
+  std::cout << "Array conversion: Value "
+            << std::chrono::duration_cast<ms>(value_array_time).count()
+            << " ms, Variant "
+            << std::chrono::duration_cast<ms>(variant_array_time).count()
+            << " ms" << std::endl;
+  std::cout << "Struct creation: Value "
+            << std::chrono::duration_cast<ms>(value_creation_time).count()
+            << " ms, Variant "
+            << std::chrono::duration_cast<ms>(variant_creation_time).count()
+            << " ms" << std::endl;
+}
+
+}  // namespace event
@@ -25,10 +25,11 @@
 
 #include "parser/decoder.h"
 
-#include <sstream>
+#include <cstring>
 #include <string>
 
 #include "base/string_utils.h"
+#include "base/w16_string.h"
 
 namespace parser {
 
@@ -40,92 +41,153 @@ using event::WStringValue;
 
 }  // namespace
 
-std::unique_ptr<StringValue> Decoder::DecodeString() {
-  std::unique_ptr<StringValue> result;
+bool Decoder::DecodeString(std::string* value) {
+  DCHECK(value != NULL);
   size_t start = position_;
   while (RemainingBytes() >= sizeof(char)) {
     char c = buffer_[position_];
     ++position_;
 
     if (c == 0) {
-      std::string string(&buffer_[start], position_ - start - 1);
-      result.reset(new StringValue(string));
-      break;
+      value->assign(&buffer_[start], position_ - start - 1);
+      return true;
     }
   }
 
-  return std::move(result);
+  return false;
 }
 
-std::unique_ptr<WStringValue> Decoder::DecodeWString() {
-  std::unique_ptr<WStringValue> result;
+std::unique_ptr<StringValue> Decoder::DecodeString() {
+  std::unique_ptr<StringValue> result;
+  std::string string;
+  if (DecodeString(&string))
+    result.reset(new StringValue(string));
+  return result;
+}
+
+bool Decoder::DecodeWString(std::wstring* value) {
+  DCHECK(value != NULL);
   size_t start = position_;
   while (RemainingBytes() >= sizeof(wchar_t)) {
     wchar_t c = *reinterpret_cast<const wchar_t*>(&buffer_[position_]);
     position_ += sizeof(wchar_t);
 
     if (c == 0) {
-      std::wstring wstring(reinterpret_cast<const wchar_t*>(&buffer_[start]),
-                           (position_ - start - 1) / sizeof(wchar_t));
-      result.reset(new WStringValue(wstring));
-      break;
+      value->assign(reinterpret_cast<const wchar_t*>(&buffer_[start]),
+                    (position_ - start - 1) / sizeof(wchar_t));
+      return true;
     }
   }
 
-  return std::move(result);
+  return false;
 }
 
-std::unique_ptr<WStringValue> Decoder::DecodeW16String() {
-  // The decoding cannot use native wchar_t because it can be 2 bytes or
-  // 4 bytes.
+std::unique_ptr<WStringValue> Decoder::DecodeWString() {
   std::unique_ptr<WStringValue> result;
-  std::wstringstream ss;
-  while (RemainingBytes() >= 2) {
-    wchar_t c = buffer_[position_] | (buffer_[position_ + 1]  << 8);
-    position_ += 2;
+  std::wstring wstring;
+  if (DecodeWString(&wstring))
+    result.reset(new WStringValue(wstring));
+  return result;
+}
 
-    if (c == 0) {
-      result.reset(new WStringValue(ss.str()));
-      break;
-    }
+bool Decoder::DecodeW16String(std::wstring* value) {
+  // The decoding cannot use native wchar_t because it can be 2 bytes or
+  // 4 bytes.
+  DCHECK(value != NULL);
+  size_t max_length = RemainingBytes() / 2;
+  size_t length = base::W16StringLength(&buffer_[position_], max_length);
+  if (length == max_length)
+    return false;
 
-    ss << c;
-  }
+  value->clear();
+  base::AppendW16String(&buffer_[position_], length, value);
+  position_ += 2 * (length + 1);
+  return true;
+}
 
-  return std::move(result);
+std::unique_ptr<WStringValue> Decoder::DecodeW16String() {
+  std::unique_ptr<WStringValue> result;
+  std::wstring wstring;
+  if (DecodeW16String(&wstring))
+    result.reset(new WStringValue(wstring));
+  return result;
 }
 
-std::unique_ptr<WStringValue> Decoder::DecodeFixedW16String(size_t length) {
+bool Decoder::DecodeFixedW16String(size_t length, std::wstring* value) {
   // The decoding cannot use native wchar_t because it can be 2 bytes or
   // 4 bytes.
-  std::unique_ptr<WStringValue> result;
-  std::wstringstream ss;
+  DCHECK(value != NULL);
 
   // Check whether there is enough characters.
   if (RemainingBytes() < 2 * length)
-    return std::move(result);
+    return false;
 
-  // Compute the position after consuming the array.
-  size_t next_position = position_ + 2 * length;
+  // The string stops at the first null character, if any.
+  size_t string_length = base::W16StringLength(&buffer_[position_], length);
+  value->clear();
+  base::AppendW16String(&buffer_[position_], string_length, value);
 
-  // Consume the array.
-  for (size_t i = 0; i < length; ++i) {
-    wchar_t c = buffer_[position_] | (buffer_[position_ + 1]  << 8);
-    position_ += 2;
+  // Move the decoder forward after the fixed length array.
+  position_ += 2 * length;
+  return true;
+}
 
-    if (c == 0)
-      break;
+std::unique_ptr<WStringValue> Decoder::DecodeFixedW16String(size_t length) {
+  std::unique_ptr<WStringValue> result;
+  std::wstring wstring;
+  if (DecodeFixedW16String(length, &wstring))
+    result.reset(new WStringValue(wstring));
+  return result;
+}
 
-    ss << c;
-  }
+bool Decoder::DecodeStringView(base::Span<const char>* value) {
+  DCHECK(value != NULL);
+  const void* end = ::memchr(&buffer_[position_], 0, RemainingBytes());
+  if (end == NULL)
+    return false;
 
-  // Move the decoder forward after the fixed length array.
-  position_ = next_position;
+  size_t length = static_cast<const char*>(end) - &buffer_[position_];
+  *value = base::Span<const char>(&buffer_[position_], length);
+  position_ += length + 1;
+  return true;
+}
+
+bool Decoder::DecodeW16StringView(base::Span<const char>* value) {
+  DCHECK(value != NULL);
+  size_t max_length = RemainingBytes() / 2;
+  size_t length = base::W16StringLength(&buffer_[position_], max_length);
+  if (length == max_length)
+    return false;
+
+  *value = base::Span<const char>(&buffer_[position_], 2 * length);
+  position_ += 2 * (length + 1);
+  return true;
+}
+
+bool Decoder::DecodeFixedW16StringView(size_t length,
+                                       base::Span<const char>* value) {
+  DCHECK(value != NULL);
+
+  // Check whether there is enough characters.
+  if (RemainingBytes() < 2 * length)
+    return false;
 
-  // Create and return the resulting value.
-  result.reset(new WStringValue(ss.str()));
+  // The string stops at the first null character, if any.
+  size_t string_length = base::W16StringLength(&buffer_[position_], length);
+  *value = base::Span<const char>(&buffer_[position_], 2 * string_length);
 
-  return std::move(result);
+  // Move the decoder forward after the fixed length array.
+  position_ += 2 * length;
+  return true;
+}
+
+bool Decoder::DecodeBytes(size_t size, const char** bytes) {
+  DCHECK(bytes != NULL);
+  if (RemainingBytes() < size)
+    return false;
+  *bytes = &buffer_[position_];
+  position_ += size;
+  return true;
 }
 
 bool Decoder::Skip(size_t size) {
@@ -40,12 +40,15 @@
 #ifndef PARSER_DECODER_H_
 #define PARSER_DECODER_H_
 
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <memory>
 #include <set>
 
 #include "base/logging.h"
+#include "base/span.h"
+#include "event/packed_array_value.h"
 #include "event/value.h"
 
 namespace parser {
@@ -64,7 +67,8 @@ class Decoder {
   Decoder(const char* buffer, size_t buffer_size)
       : buffer_(buffer),
         buffer_size_(buffer_size),
-        position_(0) {
+        position_(0),
+        use_string_views_(false) {
   }
 
   // @returns the remaining number of bytes to decode.
@@ -72,67 +76,172 @@ class Decoder {
     return buffer_size_ - position_;
   }
 
-  // Decode a scalar Value.
+  // Decode a scalar without allocating a Value.
   // @tparam T the type of Value to decode.
-  // @returns the decoded value if successful, NULL otherwise.
+  // @param value receives the decoded scalar.
+  // @returns true if successful, false otherwise.
   template <typename T>
-  std::unique_ptr<T> Decode() {
+  bool DecodeScalar(typename T::ScalarType* value) {
     typedef typename T::ScalarType ScalarType;
-    std::unique_ptr<T> result;
+    DCHECK(value != NULL);
 
     // There is not enough bytes, returns no value.
     if (RemainingBytes() < sizeof(ScalarType))
-      return std::move(result);
+      return false;
 
     // Consume the bytes.
-    size_t offset = position_;
+    ::memcpy(value, &buffer_[position_], sizeof(ScalarType));
     position_ += sizeof(ScalarType);
-    result.reset(
-        new T(*reinterpret_cast<const ScalarType*>(&buffer_[offset])));
-    return std::move(result);
+    return true;
   }
 
-  // Decode an array of scalar Value.
+  // Decode a scalar Value.
   // @tparam T the type of Value to decode.
-  // @returns the decoded array if successful, NULL otherwise.
+  // @returns the decoded value if successful, NULL otherwise.
   template <typename T>
-  std::unique_ptr<ArrayValue> DecodeArray(size_t size) {
-    std::unique_ptr<event::ArrayValue> array(new event::ArrayValue());
+  std::unique_ptr<T> Decode() {
+    typename T::ScalarType value = typename T::ScalarType();
+    if (!DecodeScalar<T>(&value))
+      return std::unique_ptr<T>();
+    return std::unique_ptr<T>(new T(value));
+  }
+
+  // Decode an array of scalar Value and append its elements to |array|.
+  // Elements are allocated into the arena of |array|, if any.
+  // @tparam T the type of Value to decode.
+  // @param size the number of elements to decode.
+  // @param array receives the decoded elements.
+  // @returns true if successful, false otherwise.
+  template <typename T>
+  bool DecodeArray(size_t size, ArrayValue* array) {
+    DCHECK(array != NULL);
+    array->Reserve(array->Length() + size);
 
     // Decode |size| elements from the sequence of bytes.
     for (size_t i = 0; i < size; ++i) {
-      std::unique_ptr<Value> element(Decode<T>());
+      typename T::ScalarType element = typename T::ScalarType();
+      if (!DecodeScalar<T>(&element))
+        return false;
+      array->Append<T>(element);
+    }
 
-      // If an error occurred, clears the array and returns no value.
-      if (element.get() == NULL) {
-        array.reset(NULL);
-        return std::move(array);
-      }
+    return true;
+  }
 
-      // Append the new element to the array.
-      array->Append(std::move(element));
-    }
+  // Decode an array of scalars and append them to |array|. The elements are
+  // copied in bulk.
+  // @tparam T the type of Value to decode.
+  // @param size the number of elements to decode.
+  // @param array receives the decoded elements.
+  // @returns true if successful, false otherwise.
+  template <typename T>
+  bool DecodeArray(size_t size, event::PackedArrayValue<T>* array) {
+    typedef typename T::ScalarType ScalarType;
+    DCHECK(array != NULL);
+
+    // There is not enough bytes, returns no value.
+    if (RemainingBytes() / sizeof(ScalarType) < size)
+      return false;
+
+    array->AppendRaw(&buffer_[position_], size);
+    position_ += size * sizeof(ScalarType);
+    return true;
+  }
+
+  // Decode an array of scalar Value.
+  // @tparam T the type of Value to decode.
+  // @returns the decoded array if successful, NULL otherwise.
+  template <typename T>
+  std::unique_ptr<ArrayValue> DecodeArray(size_t size) {
+    std::unique_ptr<event::PackedArrayValue<T> > array(
+        new event::PackedArrayValue<T>());
+
+    // If an error occurred, clears the array and returns no value.
+    if (!DecodeArray<T>(size, array.get()))
+      return std::unique_ptr<ArrayValue>();
 
-    return std::move(array);
+    return std::unique_ptr<ArrayValue>(std::move(array));
   }
 
+  // Decode a string.
+  // @param value receives the decoded string.
+  // @returns true if successful, false otherwise.
+  bool DecodeString(std::string* value);
+
   // Decode a string.
   // @returns the decoded string.
   std::unique_ptr<StringValue> DecodeString();
 
+  // Decode a std::wstring.
+  // @param value receives the decoded string.
+  // @returns true if successful, false otherwise.
+  bool DecodeWString(std::wstring* value);
+
   // Decode a std::wstring.
   // @returns the decoded string.
   std::unique_ptr<WStringValue> DecodeWString();
 
+  // Decode a string of 16-bit chars.
+  // @param value receives the decoded string.
+  // @returns true if successful, false otherwise.
+  bool DecodeW16String(std::wstring* value);
+
   // Decode a string of 16-bit chars.
   // @returns the decoded string.
   std::unique_ptr<WStringValue> DecodeW16String();
 
+  // Decode a string of 16-bit chars with a fixed length.
+  // @param length the length of the fixed array holding the string.
+  // @param value receives the decoded string.
+  // @returns true if successful, false otherwise.
+  bool DecodeFixedW16String(size_t length, std::wstring* value);
+
   // Decode a string of 16-bit chars with a fixed length.
   // @param length the length of the fixed array holding the string.
   // @returns the decoded string.
   std::unique_ptr<WStringValue> DecodeFixedW16String(size_t length);
 
+  // Decode a string without copying its characters. The view points into the
+  // decoded buffer and is only valid as long as this buffer is alive.
+  // @param value receives the characters of the string, without the
+  //     terminating null character.
+  // @returns true if successful, false otherwise.
+  bool DecodeStringView(base::Span<const char>* value);
+
+  // Decode a string of 16-bit chars without copying its characters. The view
+  // points into the decoded buffer and is only valid as long as this buffer is
+  // alive.
+  // @param value receives the bytes of the string, without the terminating
+  //     null character.
+  // @returns true if successful, false otherwise.
+  bool DecodeW16StringView(base::Span<const char>* value);
+
+  // Decode a string of 16-bit chars with a fixed length without copying its
+  // characters. The view stops at the first null character.
+  // @param length the length of the fixed array holding the string.
+  // @param value receives the bytes of the string.
+  // @returns true if successful, false otherwise.
+  bool DecodeFixedW16StringView(size_t length, base::Span<const char>* value);
+
+  // Returns whether the strings of the payload may be decoded as views into
+  // the decoded buffer instead of owned copies.
+  bool use_string_views() const { return use_string_views_; }
+
+  // Enables decoding the strings as views. The caller guarantees that the
+  // decoded buffer outlives the decoded values.
+  void set_use_string_views(bool use_string_views) {
+    use_string_views_ = use_string_views;
+  }
+
+  // Consumes a block of bytes, to decode several fields with a single bounds
+  // check.
+  // @param size the number of bytes to consume.
+  // @param bytes receives a pointer to the consumed bytes, into the decoded
+  //     buffer.
+  // @returns true if successful, false if there is not enough remaining
+  //     bytes in the buffer.
+  bool DecodeBytes(size_t size, const char** bytes);
+
   // Advances the current read position by the specified number of bytes.
   // @param size number of bytes to skip.
   // @returns true if the bytes have been skipped, false if there is not
@@ -153,16 +262,19 @@ class Decoder {
 
   // The actual position into the sequence of bytes.
   size_t position_;
+
+  // Indicates whether strings may be decoded as views into |buffer_|.
+  bool use_string_views_;
 };
 
 template<>
-inline std::unique_ptr<event::StringValue> Decoder::Decode<event::StringValue>() {
-  return DecodeString();
+inline bool Decoder::DecodeScalar<event::StringValue>(std::string* value) {
+  return DecodeString(value);
 }
 
 template<>
-inline std::unique_ptr<event::WStringValue> Decoder::Decode<event::WStringValue>() {
-  return DecodeWString();
+inline bool Decoder::DecodeScalar<event::WStringValue>(std::wstring* value) {
+  return DecodeWString(value);
 }
 
 }  // namespace parser
@@ -26,6 +26,7 @@
 #include "parser/decoder.h"
 
 #include "gtest/gtest.h"
+#include "event/string_view_value.h"
 #include "event/value.h"
 
 namespace parser {
@@ -167,4 +168,104 @@ TEST(DecoderTest, DecodeFixedW16String) {
   EXPECT_EQ(0, WStringValue::GetValue(value.get()).compare(expected));
 }
 
+TEST(DecoderTest, DecodeW16StringNonAscii) {
+  // "\u00e9t\u00e9 \U0001f600" followed by a terminator.
+  const char original[] = "\xE9\0t\0\xE9\0 \0\x3D\xD8\x00\xDE\0";
+  Decoder decoder(&original[0], sizeof(original) / sizeof(char));
+  std::unique_ptr<WStringValue> value(decoder.DecodeW16String());
+  ASSERT_TRUE(value.get() != nullptr);
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  std::wstring expected;
+  expected.push_back(static_cast<wchar_t>(0xE9));
+  expected.push_back(L't');
+  expected.push_back(static_cast<wchar_t>(0xE9));
+  expected.push_back(L' ');
+  if (sizeof(wchar_t) == 2) {
+    expected.push_back(static_cast<wchar_t>(0xD83D));
+    expected.push_back(static_cast<wchar_t>(0xDE00));
+  } else {
+    expected.push_back(static_cast<wchar_t>(0x1F600));
+  }
+  EXPECT_EQ(expected, WStringValue::GetValue(value.get()));
+
+  // The view decodes to the same string.
+  Decoder view_decoder(&original[0], sizeof(original) / sizeof(char));
+  base::Span<const char> view;
+  EXPECT_TRUE(view_decoder.DecodeW16StringView(&view));
+  EXPECT_EQ(expected, event::W16StringViewValue(view).wstr());
+}
+
+TEST(DecoderTest, DecodeW16StringMissingTerminator) {
+  const char original[] = "a\0b\0c\0";
+  Decoder decoder(&original[0], sizeof(original) - 1);
+  std::unique_ptr<WStringValue> value(decoder.DecodeW16String());
+  EXPECT_TRUE(value.get() == nullptr);
+  EXPECT_EQ(sizeof(original) - 1, decoder.RemainingBytes());
+}
+
+TEST(DecoderTest, DecodeBytes) {
+  const char original[] = { 1, 2, 3, 4, 5, 6 };
+  Decoder decoder(&original[0], sizeof(original));
+  const char* bytes = NULL;
+  EXPECT_TRUE(decoder.DecodeBytes(4, &bytes));
+  EXPECT_EQ(&original[0], bytes);
+  EXPECT_EQ(2U, decoder.RemainingBytes());
+
+  // There is not enough bytes; the position is unchanged.
+  EXPECT_FALSE(decoder.DecodeBytes(3, &bytes));
+  EXPECT_EQ(2U, decoder.RemainingBytes());
+
+  EXPECT_TRUE(decoder.DecodeBytes(2, &bytes));
+  EXPECT_EQ(&original[4], bytes);
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+}
+
+TEST(DecoderTest, DecodeStringView) {
+  const char original[] = "This is a test.";
+  Decoder decoder(&original[0], sizeof(original) / sizeof(char));
+  base::Span<const char> value;
+  EXPECT_TRUE(decoder.DecodeStringView(&value));
+  EXPECT_EQ(&original[0], value.data());
+  EXPECT_EQ(sizeof(original) - 1, value.size());
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  // The terminating null character is missing.
+  Decoder truncated(&original[0], sizeof(original) - 1);
+  EXPECT_FALSE(truncated.DecodeStringView(&value));
+}
+
+TEST(DecoderTest, DecodeW16StringView) {
+  const char original[] = "T\0h\0i\0s\0 \0i\0s\0 \0a\0 \0t\0e\0s\0t\0.\0\0";
+  const wchar_t expected[] = L"This is a test.";
+  Decoder decoder(&original[0], sizeof(original) / sizeof(char));
+  base::Span<const char> value;
+  EXPECT_TRUE(decoder.DecodeW16StringView(&value));
+  EXPECT_EQ(&original[0], value.data());
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  event::W16StringViewValue view(value);
+  EXPECT_EQ(15U, view.length());
+  EXPECT_EQ(0, view.wstr().compare(expected));
+
+  // The terminating null character is missing.
+  Decoder truncated(&original[0], sizeof(original) - 3);
+  EXPECT_FALSE(truncated.DecodeW16StringView(&value));
+}
+
+TEST(DecoderTest, DecodeFixedW16StringView) {
+  const char original[] = "T\0e\0s\0t\0.\0\0\0\0\0\0";
+  const wchar_t expected[] = L"Test.";
+  Decoder decoder(&original[0], sizeof(original) / sizeof(char));
+  base::Span<const char> value;
+  EXPECT_TRUE(decoder.DecodeFixedW16StringView(8, &value));
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  event::W16StringViewValue view(value);
+  EXPECT_EQ(0, view.wstr().compare(expected));
+
+  Decoder too_short(&original[0], sizeof(original) / sizeof(char));
+  EXPECT_FALSE(too_short.DecodeFixedW16StringView(9, &value));
+}
+
 }  // namespace parser
@@ -0,0 +1,674 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etl_file_parser.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/string_utils.h"
+#include "event/event.h"
+#include "event/value.h"
+#include "parser/etw/etl_format.h"
+#include "parser/etw/etl_index.h"
+#include "parser/etw/etw_raw_kernel_payload_decoder.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+using event::Event;
+using event::Value;
+
+// The buffers filled by a processor, in file order, and the position of the
+// next event to read.
+class ProcessorStream {
+ public:
+  ProcessorStream() : buffer_index_(0), offset_(0) {
+  }
+
+  void AddBuffer(const EtlBuffer& buffer) {
+    buffers_.push_back(buffer);
+  }
+
+  // Moves to the next event of the processor.
+  // @returns true if an event is read, false at the end of the buffers.
+  bool Next() {
+    while (buffer_index_ < buffers_.size()) {
+      const EtlBuffer& buffer = buffers_[buffer_index_];
+      if (offset_ == 0)
+        offset_ = kEtlBufferHeaderSize;
+      if (ReadEtlEventRecord(buffer.data, buffer.header.end_offset, &offset_,
+                             &record_)) {
+        return true;
+      }
+      ++buffer_index_;
+      offset_ = 0;
+    }
+    return false;
+  }
+
+  // @returns the event read by the last call to Next().
+  const EtlEventRecord& record() const { return record_; }
+
+  // @returns the processor which logged the event read by Next().
+  uint8_t processor_number() const {
+    return buffers_[buffer_index_].header.processor_number;
+  }
+
+ private:
+  std::vector<EtlBuffer> buffers_;
+  size_t buffer_index_;
+  size_t offset_;
+  EtlEventRecord record_;
+};
+
+// Orders a heap of streams by the timestamp of their next event, the oldest
+// first.
+struct StreamGreater {
+  explicit StreamGreater(const std::vector<ProcessorStream>* streams)
+      : streams_(streams) {
+  }
+
+  bool operator()(size_t left, size_t right) const {
+    uint64_t left_ts = (*streams_)[left].record().raw_timestamp;
+    uint64_t right_ts = (*streams_)[right].record().raw_timestamp;
+    if (left_ts != right_ts)
+      return left_ts > right_ts;
+    return left > right;
+  }
+
+  const std::vector<ProcessorStream>* streams_;
+};
+
+// Reads the header of an event record, before its payload is decoded.
+// @param record the event record.
+// @param processor_number the processor which logged the event.
+// @param clock the clock of the trace.
+// @param filter the filter of the parser, may be NULL.
+// @param timestamp receives the timestamp of the event, in system time.
+// @param header receives the header of the event.
+// @param projection receives the fields of the payload to decode, or NULL to
+//     decode every field.
+// @returns true if the event is a known kernel event accepted by the filter,
+//     false if it must be skipped.
+bool ReadRecordHeader(const EtlEventRecord& record,
+                      uint8_t processor_number,
+                      const EtlClock& clock,
+                      const EventFilter* filter,
+                      uint64_t* timestamp,
+                      event::EventHeader* header,
+                      const FieldProjection** projection) {
+  *timestamp = clock.ToSystemTime(record.raw_timestamp);
+  *projection = NULL;
+  if (filter != NULL) {
+    if (!filter->Accepts(record.provider_id, record.opcode,
+                         record.process_id, record.thread_id, *timestamp)) {
+      return false;
+    }
+    *projection = filter->GetProjection(record.provider_id, record.opcode);
+  }
+
+  if (!LookupRawETWKernelEvent(record.provider_id, record.version,
+                               record.opcode, record.is_64_bit,
+                               &header->type)) {
+    return false;
+  }
+  header->process_id = record.process_id;
+  header->thread_id = record.thread_id;
+  header->processor_number = processor_number;
+  header->flags = record.flags;
+  return true;
+}
+
+// An event decoded by a worker thread. Its payload is allocated in the arena
+// of its batch.
+struct DecodedEvent {
+  uint64_t timestamp;
+  event::EventHeader header;
+  const Value* payload;
+};
+
+// The events decoded from a buffer, in timestamp order.
+struct EventBatch {
+  event::ValueArena arena;
+  std::vector<DecodedEvent> events;
+};
+
+// Decodes the buffers of a trace on a pool of worker threads. The workers
+// take the buffers in file order and decode each of them into its own batch;
+// the consumer takes the batches back in the order of its choice. A buffer
+// requested beyond the buffers the workers may decode is decoded by the
+// consumer itself.
+class ParallelDecoder {
+ public:
+  // Maximum number of buffers decoded by the workers ahead of the oldest
+  // buffer which has not been taken by the consumer. It bounds the memory
+  // held by batches.
+  static const size_t kMaxPendingBuffers = 64;
+
+  // @param buffers the buffers of the trace, in file order. Must outlive the
+  //     decoder.
+  // @param clock the clock of the trace.
+  // @param filter the filter of the parser, may be NULL.
+  ParallelDecoder(const std::vector<EtlBuffer>* buffers,
+                  const EtlClock& clock,
+                  const EventFilter* filter)
+      : buffers_(buffers),
+        clock_(clock),
+        filter_(filter),
+        batches_(buffers->size()),
+        started_(buffers->size(), false),
+        taken_(buffers->size(), false),
+        next_buffer_(0),
+        first_pending_buffer_(0),
+        stopped_(false) {
+  }
+
+  // Stops the workers and waits for them.
+  ~ParallelDecoder() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stopped_ = true;
+    }
+    work_available_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i)
+      workers_[i].join();
+  }
+
+  // Starts the worker threads.
+  // @param num_threads the number of worker threads.
+  void Start(size_t num_threads) {
+    DCHECK(workers_.empty());
+    for (size_t i = 0; i < num_threads; ++i)
+      workers_.push_back(std::thread(&ParallelDecoder::Run, this));
+  }
+
+  // Waits for the batch of a buffer. Each batch is taken once.
+  // @param index the index of the buffer.
+  // @returns the events decoded from the buffer.
+  std::unique_ptr<EventBatch> TakeBatch(size_t index) {
+    DCHECK_LT(index, batches_.size());
+    std::unique_lock<std::mutex> lock(lock_);
+    DCHECK(!taken_[index]);
+
+    // The workers won't reach a buffer beyond their window before the older
+    // buffers are taken: decode it here, so that the consumer progresses
+    // without letting the workers hold more batches.
+    std::unique_ptr<EventBatch> batch;
+    if (!started_[index] && !IsInWindow(index)) {
+      started_[index] = true;
+      batch = NewBatch();
+      lock.unlock();
+      DecodeBuffer((*buffers_)[index], batch.get());
+      lock.lock();
+    } else {
+      while (batches_[index].get() == NULL)
+        batch_ready_.wait(lock);
+      batch = std::move(batches_[index]);
+    }
+
+    taken_[index] = true;
+    while (first_pending_buffer_ < taken_.size() &&
+           taken_[first_pending_buffer_]) {
+      ++first_pending_buffer_;
+    }
+    work_available_.notify_all();
+    return batch;
+  }
+
+  // Gives back a batch once its events are sent, so that its memory serves
+  // the next buffers.
+  // @param batch the batch to recycle.
+  void RecycleBatch(std::unique_ptr<EventBatch> batch) {
+    batch->events.clear();
+    batch->arena.Reset();
+    std::lock_guard<std::mutex> lock(lock_);
+    free_batches_.push_back(std::move(batch));
+  }
+
+ private:
+  // Indicates whether the workers may decode a buffer.
+  // Must be called with |lock_| held.
+  bool IsInWindow(size_t index) const {
+    return index < first_pending_buffer_ + kMaxPendingBuffers;
+  }
+
+  // Returns a recycled batch, or a new one.
+  // Must be called with |lock_| held.
+  std::unique_ptr<EventBatch> NewBatch() {
+    if (free_batches_.empty())
+      return std::unique_ptr<EventBatch>(new EventBatch());
+    std::unique_ptr<EventBatch> batch(std::move(free_batches_.back()));
+    free_batches_.pop_back();
+    return batch;
+  }
+
+  // Decodes buffers until all of them are decoded or the decoder is stopped.
+  void Run() {
+    std::unique_lock<std::mutex> lock(lock_);
+    while (true) {
+      // Skip the buffers decoded by the consumer.
+      while (next_buffer_ < buffers_->size() && started_[next_buffer_])
+        ++next_buffer_;
+      if (!stopped_ && next_buffer_ < buffers_->size() &&
+          !IsInWindow(next_buffer_)) {
+        work_available_.wait(lock);
+        continue;
+      }
+      if (stopped_ || next_buffer_ >= buffers_->size())
+        return;
+
+      size_t index = next_buffer_++;
+      started_[index] = true;
+      std::unique_ptr<EventBatch> batch = NewBatch();
+
+      lock.unlock();
+      DecodeBuffer((*buffers_)[index], batch.get());
+      lock.lock();
+
+      batches_[index] = std::move(batch);
+      batch_ready_.notify_all();
+    }
+  }
+
+  // Decodes the events of a buffer into a batch.
+  void DecodeBuffer(const EtlBuffer& buffer, EventBatch* batch) const {
+    size_t offset = kEtlBufferHeaderSize;
+    EtlEventRecord record;
+    while (ReadEtlEventRecord(buffer.data, buffer.header.end_offset, &offset,
+                              &record)) {
+      DecodedEvent decoded;
+      const FieldProjection* projection = NULL;
+      if (!ReadRecordHeader(record, buffer.header.processor_number, clock_,
+                            filter_, &decoded.timestamp, &decoded.header,
+                            &projection)) {
+        continue;
+      }
+      if (DecodeRawETWKernelPayload(
+              record.provider_id, record.version, record.opcode,
+              record.is_64_bit, record.payload, record.payload_size,
+              &batch->arena, projection, NULL, NULL, &decoded.payload)) {
+        batch->events.push_back(decoded);
+      }
+    }
+  }
+
+  const std::vector<EtlBuffer>* buffers_;
+  EtlClock clock_;
+  const EventFilter* filter_;
+
+  std::vector<std::thread> workers_;
+
+  // Protects the fields below.
+  std::mutex lock_;
+
+  // Signaled when a worker may decode the next buffer.
+  std::condition_variable work_available_;
+
+  // Signaled when a batch is decoded.
+  std::condition_variable batch_ready_;
+
+  // The decoded batches not taken yet, by buffer index.
+  std::vector<std::unique_ptr<EventBatch>> batches_;
+
+  // Indicates whether the decoding of each buffer has started, by a worker or
+  // by the consumer.
+  std::vector<bool> started_;
+
+  // Indicates whether the batch of each buffer has been taken.
+  std::vector<bool> taken_;
+
+  // Batches recycled by the consumer.
+  std::vector<std::unique_ptr<EventBatch>> free_batches_;
+
+  // The next buffer to decode by the workers.
+  size_t next_buffer_;
+
+  // The oldest buffer whose batch has not been taken. The workers decode the
+  // buffers up to kMaxPendingBuffers after it.
+  size_t first_pending_buffer_;
+
+  bool stopped_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelDecoder);
+};
+
+// The batches of the buffers filled by a processor, taken in file order from
+// a ParallelDecoder, and the position of the next event to send.
+class BatchStream {
+ public:
+  // @param decoder the decoder of the buffers.
+  // @param buffers the indexes of the buffers of the processor.
+  BatchStream(ParallelDecoder* decoder, const std::vector<size_t>* buffers)
+      : decoder_(decoder), buffers_(buffers), buffer_index_(0), position_(0) {
+  }
+
+  // Moves to the next event of the processor.
+  // @returns true if an event is available, false at the end of the buffers.
+  bool Next() {
+    if (batch_.get() != NULL && ++position_ < batch_->events.size())
+      return true;
+    while (buffer_index_ < buffers_->size()) {
+      if (batch_.get() != NULL)
+        decoder_->RecycleBatch(std::move(batch_));
+      batch_ = decoder_->TakeBatch((*buffers_)[buffer_index_++]);
+      position_ = 0;
+      if (!batch_->events.empty())
+        return true;
+    }
+    if (batch_.get() != NULL)
+      decoder_->RecycleBatch(std::move(batch_));
+    return false;
+  }
+
+  // @returns the event read by the last call to Next().
+  const DecodedEvent& event() const { return batch_->events[position_]; }
+
+ private:
+  ParallelDecoder* decoder_;
+  const std::vector<size_t>* buffers_;
+  size_t buffer_index_;
+  std::unique_ptr<EventBatch> batch_;
+  size_t position_;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchStream);
+};
+
+// Orders a heap of batch streams by the timestamp of their next event, the
+// oldest first.
+struct BatchStreamGreater {
+  explicit BatchStreamGreater(
+      const std::vector<std::unique_ptr<BatchStream>>* streams)
+      : streams_(streams) {
+  }
+
+  bool operator()(size_t left, size_t right) const {
+    uint64_t left_ts = (*streams_)[left]->event().timestamp;
+    uint64_t right_ts = (*streams_)[right]->event().timestamp;
+    if (left_ts != right_ts)
+      return left_ts > right_ts;
+    return left > right;
+  }
+
+  const std::vector<std::unique_ptr<BatchStream>>* streams_;
+};
+
+// Reads the clock of a trace from its first event, the EventTrace Header.
+bool ReadClock(const EtlBuffer& first_buffer,
+               event::ValueArena* arena,
+               EtlClock* clock) {
+  size_t offset = kEtlBufferHeaderSize;
+  EtlEventRecord record;
+  if (!ReadEtlEventRecord(first_buffer.data, first_buffer.header.end_offset,
+                          &offset, &record)) {
+    return false;
+  }
+
+  std::string operation;
+  std::string category;
+  const Value* header = NULL;
+  bool valid = DecodeRawETWKernelPayload(
+      record.provider_id, record.version, record.opcode, record.is_64_bit,
+      record.payload, record.payload_size, arena, NULL, &operation, &category,
+      &header) &&
+      category == "EventTraceEvent" && operation == "Header" &&
+      clock->Init(header, record.raw_timestamp);
+  arena->Reset();
+  return valid;
+}
+
+}  // namespace
+
+EtlFileParser::EtlFileParser()
+    : lazy_payloads_(false),
+      decode_threads_(0),
+      use_index_(false) {
+}
+
+bool EtlFileParser::AddTraceFile(const std::wstring& path) {
+  if (!path_.empty())
+    return false;
+  if (!base::WStringEndsWith(path, L".etl"))
+    return false;
+  path_ = path;
+  return true;
+}
+
+std::unique_ptr<parser::ParserImpl> EtlFileParser::NewInstance() const {
+  std::unique_ptr<EtlFileParser> instance(new EtlFileParser());
+  instance->set_lazy_payloads(lazy_payloads_);
+  instance->set_decode_threads(decode_threads_);
+  instance->set_use_index(use_index_);
+  return std::move(instance);
+}
+
+void EtlFileParser::Parse(const EventCallback& callback) {
+  if (path_.empty())
+    return;
+
+  base::MemoryMappedFile file;
+  if (!file.Open(path_)) {
+    LOG(ERROR) << "Cannot open the trace file "
+               << base::WStringToString(path_) << ".";
+    return;
+  }
+
+  // All the buffers have the size of the first one.
+  EtlBuffer first_buffer = { file.data(), EtlBufferHeader() };
+  if (file.data() == NULL ||
+      !ReadEtlBufferHeader(file.data(), file.size(), &first_buffer.header) ||
+      first_buffer.header.buffer_size > file.size()) {
+    LOG(ERROR) << "Invalid ETL trace file.";
+    return;
+  }
+  uint32_t buffer_size = first_buffer.header.buffer_size;
+
+  EtlClock clock;
+  if (!ReadClock(first_buffer, &arena_, &clock)) {
+    LOG(ERROR) << "Invalid ETL trace header.";
+    return;
+  }
+
+  // Without a time range, every buffer of the trace is read.
+  const EventFilter* filter = this->filter();
+  std::vector<EtlBuffer> buffers;
+  if (use_index_ && filter != NULL &&
+      (filter->begin_time() != 0 ||
+       filter->end_time() != std::numeric_limits<event::Timestamp>::max())) {
+    FindIndexedBuffers(file, buffer_size, clock, &buffers);
+  } else {
+    ReadEtlBuffers(file.data(), file.size(), buffer_size, &buffers);
+  }
+
+  // Group the buffers by processor. The events of a processor are in
+  // timestamp order.
+  std::vector<std::vector<size_t>> processor_buffers;
+  std::map<uint8_t, size_t> stream_by_processor;
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    std::map<uint8_t, size_t>::iterator stream =
+        stream_by_processor.find(buffers[i].header.processor_number);
+    if (stream == stream_by_processor.end()) {
+      stream = stream_by_processor.insert(std::make_pair(
+          buffers[i].header.processor_number,
+          processor_buffers.size())).first;
+      processor_buffers.push_back(std::vector<size_t>());
+    }
+    processor_buffers[stream->second].push_back(i);
+  }
+
+  if (decode_threads_ != 0)
+    ParseInParallel(buffers, processor_buffers, clock, callback);
+  else
+    ParseSequentially(buffers, processor_buffers, clock, callback);
+}
+
+void EtlFileParser::FindIndexedBuffers(const base::MemoryMappedFile& file,
+                                       uint32_t buffer_size,
+                                       const EtlClock& clock,
+                                       std::vector<EtlBuffer>* buffers) {
+  EtlIndex index;
+  std::wstring index_path = EtlIndex::GetIndexPath(path_);
+  EtlTraceId trace_id =
+      EtlIndex::GetTraceId(file.size(), buffer_size, clock);
+  if (!index.Load(index_path, trace_id)) {
+    std::vector<EtlBuffer> all_buffers;
+    ReadEtlBuffers(file.data(), file.size(), buffer_size, &all_buffers);
+    index.Build(file.data(), all_buffers, trace_id, clock);
+    if (!index.Save(index_path)) {
+      LOG(WARNING) << "Cannot save the index file "
+                   << base::WStringToString(index_path) << ".";
+    }
+  }
+
+  const EventFilter* filter = this->filter();
+  std::vector<size_t> entries;
+  index.FindBuffers(filter->begin_time(), filter->end_time(), &entries);
+
+  // Only the buffers in the time range are touched.
+  std::vector<size_t>::const_iterator entry = entries.begin();
+  for (; entry != entries.end(); ++entry) {
+    EtlBuffer buffer = {
+        file.data() + index.entries()[*entry].offset, EtlBufferHeader() };
+    if (!ReadEtlBufferHeader(buffer.data, buffer_size, &buffer.header) ||
+        buffer.header.buffer_size != buffer_size) {
+      LOG(WARNING) << "Invalid ETL buffer at offset "
+                   << index.entries()[*entry].offset << ".";
+      continue;
+    }
+    buffers->push_back(buffer);
+  }
+}
+
+void EtlFileParser::ParseSequentially(
+    const std::vector<EtlBuffer>& buffers,
+    const std::vector<std::vector<size_t>>& processor_buffers,
+    const EtlClock& clock,
+    const EventCallback& callback) {
+  std::vector<ProcessorStream> streams(processor_buffers.size());
+  for (size_t i = 0; i < processor_buffers.size(); ++i) {
+    for (size_t j = 0; j < processor_buffers[i].size(); ++j)
+      streams[i].AddBuffer(buffers[processor_buffers[i][j]]);
+  }
+
+  // Merge the events of the processors.
+  StreamGreater greater(&streams);
+  std::vector<size_t> heap;
+  for (size_t i = 0; i < streams.size(); ++i) {
+    if (streams[i].Next())
+      heap.push_back(i);
+  }
+  std::make_heap(heap.begin(), heap.end(), greater);
+
+  const EventFilter* filter = this->filter();
+  while (!heap.empty() && !cancelled()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+    ProcessorStream* stream = &streams[heap.back()];
+    const EtlEventRecord& record = stream->record();
+
+    // Skip the events rejected by the filter and the unknown events, before
+    // decoding their payload.
+    uint64_t timestamp = 0;
+    event::EventHeader header;
+    const FieldProjection* projection = NULL;
+    if (ReadRecordHeader(record, stream->processor_number(), clock, filter,
+                         &timestamp, &header, &projection)) {
+      // The decoded values are allocated in the arena of the parser and their
+      // strings point into the mapped file.
+      if (lazy_payloads_) {
+        LazyRawETWKernelPayload lazy_payload(
+            record.provider_id, record.version, record.opcode,
+            record.is_64_bit, record.payload, record.payload_size, &arena_,
+            projection);
+        Event event(timestamp, header, &lazy_payload);
+        callback(event);
+      } else {
+        const Value* payload = NULL;
+        if (DecodeRawETWKernelPayload(
+                record.provider_id, record.version, record.opcode,
+                record.is_64_bit, record.payload, record.payload_size,
+                &arena_, projection, NULL, NULL, &payload)) {
+          Event event(timestamp, header, payload);
+          callback(event);
+        }
+      }
+      arena_.Reset();
+    }
+
+    if (stream->Next())
+      std::push_heap(heap.begin(), heap.end(), greater);
+    else
+      heap.pop_back();
+  }
+}
+
+void EtlFileParser::ParseInParallel(
+    const std::vector<EtlBuffer>& buffers,
+    const std::vector<std::vector<size_t>>& processor_buffers,
+    const EtlClock& clock,
+    const EventCallback& callback) {
+  // The streams are destroyed before the decoder, which waits for its
+  // workers.
+  ParallelDecoder decoder(&buffers, clock, filter());
+  decoder.Start(decode_threads_);
+
+  std::vector<std::unique_ptr<BatchStream>> streams;
+  for (size_t i = 0; i < processor_buffers.size(); ++i) {
+    streams.push_back(std::unique_ptr<BatchStream>(
+        new BatchStream(&decoder, &processor_buffers[i])));
+  }
+
+  // Merge the decoded events of the processors.
+  BatchStreamGreater greater(&streams);
+  std::vector<size_t> heap;
+  for (size_t i = 0; i < streams.size(); ++i) {
+    if (streams[i]->Next())
+      heap.push_back(i);
+  }
+  std::make_heap(heap.begin(), heap.end(), greater);
+
+  while (!heap.empty() && !cancelled()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+    BatchStream* stream = streams[heap.back()].get();
+    const DecodedEvent& decoded = stream->event();
+    Event event(decoded.timestamp, decoded.header, decoded.payload);
+    callback(event);
+
+    if (stream->Next())
+      std::push_heap(heap.begin(), heap.end(), greater);
+    else
+      heap.pop_back();
+  }
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,159 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A portable parser of ETW trace files. Unlike ETWParser, it does not use the
+// ETW API of Windows: the trace file is mapped into memory and its buffers are
+// read directly (see etl_format.h). The payloads of the kernel events are
+// decoded by DecodeRawETWKernelPayload(); the other events are skipped.
+//
+// The buffers of each processor are read in sequence and the events of all
+// processors are merged in timestamp order, as ProcessTrace() does. The
+// buffers can also be decoded by a pool of worker threads, each buffer into
+// its own batch of events; the batches are then merged in timestamp order.
+//
+// When the filter restricts the time range of the events, the parser can use
+// an index of the buffers of the trace (see etl_index.h) to read only the
+// buffers in this range.
+
+#ifndef PARSER_ETW_ETL_FILE_PARSER_H_
+#define PARSER_ETW_ETL_FILE_PARSER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/memory_mapped_file.h"
+#include "event/value_arena.h"
+#include "parser/etw/etl_format.h"
+#include "parser/parser.h"
+
+namespace parser {
+namespace etw {
+
+// Generate Event objects from ETW trace files, on any platform.
+class EtlFileParser : public parser::ParserImpl {
+ public:
+  typedef parser::ParserImpl::EventCallback EventCallback;
+
+  EtlFileParser();
+
+  // Adds a trace file to parse. Each instance parses a single trace file.
+  // @param path path to the trace file.
+  // @returns true if the trace is an .etl file, false otherwise.
+  bool AddTraceFile(const std::wstring& path) override;
+
+  // Parses the trace file added with AddTraceFile() and sends the resulting
+  // events to the provided callback.
+  // @param callback a callback that will receive the decoded events.
+  void Parse(const EventCallback& callback) override;
+
+  // Each trace file is parsed by its own instance.
+  bool ParsesEachFileSeparately() const override { return true; }
+
+  // Creates a new parser with the same options.
+  std::unique_ptr<parser::ParserImpl> NewInstance() const override;
+
+  // Enables the lazy decoding of payloads (see ETWParser).
+  // @param lazy_payloads whether payloads are decoded on first access.
+  void set_lazy_payloads(bool lazy_payloads) {
+    lazy_payloads_ = lazy_payloads;
+  }
+
+  // Sets the number of worker threads decoding the buffers of the trace.
+  // Payloads decoded by workers are decoded eagerly, whatever the lazy
+  // payloads option.
+  // @param decode_threads the number of workers, or 0 to decode the events
+  //     on the thread calling Parse().
+  void set_decode_threads(size_t decode_threads) {
+    decode_threads_ = decode_threads;
+  }
+
+  // Enables the index of the buffers of the trace. When the filter restricts
+  // the time range of the events, the index is loaded from the sidecar file
+  // of the trace, or built and saved there on first use, and only the
+  // buffers in the time range are read.
+  // @param use_index whether the index of the trace is used.
+  void set_use_index(bool use_index) {
+    use_index_ = use_index;
+  }
+
+ private:
+  // Finds the buffers of the trace which may hold events of the time range
+  // of the filter, with the index of the trace.
+  // @param file the mapped trace file.
+  // @param buffer_size the size of the buffers of the trace.
+  // @param clock the clock of the trace.
+  // @param buffers receives the buffers in the time range, in file order.
+  void FindIndexedBuffers(const base::MemoryMappedFile& file,
+                          uint32_t buffer_size,
+                          const EtlClock& clock,
+                          std::vector<EtlBuffer>* buffers);
+
+  // Decodes the events of the buffers on the calling thread and sends them in
+  // timestamp order.
+  // @param buffers the buffers of the trace, in file order.
+  // @param processor_buffers the indexes of the buffers of each processor.
+  // @param clock the clock of the trace.
+  // @param callback a callback that will receive the decoded events.
+  void ParseSequentially(
+      const std::vector<EtlBuffer>& buffers,
+      const std::vector<std::vector<size_t>>& processor_buffers,
+      const EtlClock& clock,
+      const EventCallback& callback);
+
+  // Decodes the buffers on |decode_threads_| worker threads and sends their
+  // events in timestamp order. The parameters are those of
+  // ParseSequentially().
+  void ParseInParallel(
+      const std::vector<EtlBuffer>& buffers,
+      const std::vector<std::vector<size_t>>& processor_buffers,
+      const EtlClock& clock,
+      const EventCallback& callback);
+
+  // The trace file to parse.
+  std::wstring path_;
+
+  // Arena holding the values of the event being processed. It is reset after
+  // each event is sent to the callback.
+  event::ValueArena arena_;
+
+  // Indicates whether payloads are decoded on first access.
+  bool lazy_payloads_;
+
+  // The number of threads decoding the buffers, 0 to decode on the thread
+  // calling Parse().
+  size_t decode_threads_;
+
+  // Indicates whether the index of the trace is used.
+  bool use_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(EtlFileParser);
+};
+
+}  // namespace etw
+}  // namespace parser
+
+#endif  // PARSER_ETW_ETL_FILE_PARSER_H_
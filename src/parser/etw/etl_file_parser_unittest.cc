@@ -0,0 +1,409 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etl_file_parser.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory_mapped_file.h"
+#include "base/string_utils.h"
+#include "event/event.h"
+#include "event/utils.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/event_cursor.h"
+#include "parser/event_filter.h"
+#include "parser/etw/etl_index.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+// Thread provider: 3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C.
+const base::Guid kThreadProviderId = {
+    0x3D6FA8D1, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+const unsigned char kCSwitchOpcode = 36;
+
+// The start time of the sample trace, in its header.
+const uint64_t kStartTime = 130000000000000000ULL;
+// The raw timestamp of the first event of the sample trace.
+const uint64_t kFirstRawTimestamp = 1000;
+
+// The sample traces are generated by test/data/etw/generate_samples.py.
+const char kSampleTrace[] = "kernel_sample.etl";
+const char kManyBuffersTrace[] = "kernel_many_buffers.etl";
+
+std::wstring GetSamplePath(const char* name) {
+  return base::StringToWString(
+      std::string(LIBTRACE_TEST_DATA_DIR) + "/etw/" + name);
+}
+
+// Keeps a copy of the events received from a parser.
+class EventRecorder {
+ public:
+  void Receive(const event::Event& event) {
+    events_.push_back(event::CopyEvent(event));
+  }
+
+  const std::vector<std::unique_ptr<event::Event>>& events() const {
+    return events_;
+  }
+
+ private:
+  std::vector<std::unique_ptr<event::Event>> events_;
+};
+
+// Parses a sample trace with the provided options.
+void ParseSample(const char* name,
+                 bool lazy_payloads,
+                 size_t decode_threads,
+                 const EventFilter* filter,
+                 EventRecorder* recorder) {
+  std::unique_ptr<EtlFileParser> impl(new EtlFileParser());
+  impl->set_lazy_payloads(lazy_payloads);
+  impl->set_decode_threads(decode_threads);
+
+  parser::Parser parser;
+  parser.RegisterParser(std::move(impl));
+  if (filter != NULL)
+    parser.SetFilter(*filter);
+  ASSERT_TRUE(parser.AddTraceFile(GetSamplePath(name)));
+  parser.Parse([recorder](const event::Event& event) {
+    recorder->Receive(event);
+  });
+}
+
+// Copies a sample trace in the current folder, so that its index file is not
+// written among the test data.
+bool CopySample(const char* name, const std::string& path) {
+  base::MemoryMappedFile sample;
+  if (!sample.Open(GetSamplePath(name)))
+    return false;
+  FILE* output = fopen(path.c_str(), "wb");
+  if (output == NULL)
+    return false;
+  bool written = fwrite(sample.data(), 1, sample.size(), output) ==
+      sample.size();
+  fclose(output);
+  return written;
+}
+
+// Copies a sample trace with another start time in its header. The copy has
+// the same size as the sample.
+bool CopySampleWithStartTime(const char* name,
+                             const std::string& path,
+                             uint64_t start_time) {
+  base::MemoryMappedFile sample;
+  if (!sample.Open(GetSamplePath(name)))
+    return false;
+  std::string data(sample.data(), sample.size());
+  size_t offset = data.find(
+      std::string(reinterpret_cast<const char*>(&kStartTime),
+                  sizeof(kStartTime)));
+  if (offset == std::string::npos)
+    return false;
+  data.replace(offset, sizeof(start_time),
+               reinterpret_cast<const char*>(&start_time),
+               sizeof(start_time));
+
+  FILE* output = fopen(path.c_str(), "wb");
+  if (output == NULL)
+    return false;
+  bool written = fwrite(data.data(), 1, data.size(), output) == data.size();
+  fclose(output);
+  return written;
+}
+
+// Parses the events of a time range of a trace file.
+void ParseTimeRange(const std::wstring& path,
+                    bool use_index,
+                    event::Timestamp begin,
+                    event::Timestamp end,
+                    EventRecorder* recorder) {
+  std::unique_ptr<EtlFileParser> impl(new EtlFileParser());
+  impl->set_use_index(use_index);
+
+  parser::Parser parser;
+  parser.RegisterParser(std::move(impl));
+  parser.SetTimeRange(begin, end);
+  ASSERT_TRUE(parser.AddTraceFile(path));
+  parser.Parse([recorder](const event::Event& event) {
+    recorder->Receive(event);
+  });
+}
+
+uint32_t GetUInteger(const event::Event& event, const char* name) {
+  uint32_t value = 0;
+  EXPECT_TRUE(event.payload()->GetFieldAsUInteger(name, &value));
+  return value;
+}
+
+void ExpectSampleEvents(const EventRecorder& recorder) {
+  const std::vector<std::unique_ptr<event::Event>>& events = recorder.events();
+  ASSERT_EQ(6U, events.size());
+
+  const uint64_t kRawTimestamps[] = { 1000, 1050, 1100, 1200, 1300, 1400 };
+  const uint8_t kProcessors[] = { 0, 1, 0, 1, 0, 0 };
+  const char* kOperations[] = {
+      "Header", "CSwitch", "CSwitch", "CSwitch", "SampleProf", "CSwitch" };
+  for (size_t i = 0; i < events.size(); ++i) {
+    const event::Event& event = *events[i];
+    // The trace uses a 10MHz clock: a tick is 100ns.
+    EXPECT_EQ(kStartTime + kRawTimestamps[i] - kFirstRawTimestamp,
+              event.timestamp());
+    EXPECT_EQ(kProcessors[i], event.event_header().processor_number);
+    EXPECT_EQ(kOperations[i],
+              event.event_header().type.operation().str());
+    ASSERT_TRUE(event.payload() != NULL);
+  }
+
+  EXPECT_EQ("EventTraceEvent",
+            events[0]->event_header().type.category().str());
+  EXPECT_EQ("Thread", events[1]->event_header().type.category().str());
+  EXPECT_EQ("PerfInfo", events[4]->event_header().type.category().str());
+
+  EXPECT_EQ(200U, GetUInteger(*events[1], "NewThreadId"));
+  EXPECT_EQ(100U, GetUInteger(*events[2], "NewThreadId"));
+  EXPECT_EQ(200U, GetUInteger(*events[3], "OldThreadId"));
+  EXPECT_EQ(100U, GetUInteger(*events[4], "ThreadId"));
+  EXPECT_EQ(100U, GetUInteger(*events[5], "OldThreadId"));
+
+  uint64_t instruction_pointer = 0;
+  EXPECT_TRUE(events[4]->payload()->GetFieldAsULong(
+      "InstructionPointer", &instruction_pointer));
+  EXPECT_EQ(0x7FF612340000ULL, instruction_pointer);
+}
+
+}  // namespace
+
+TEST(EtlFileParserTest, AddTraceFile) {
+  EtlFileParser parser;
+  EXPECT_FALSE(parser.AddTraceFile(L"dummy.log"));
+  EXPECT_TRUE(parser.AddTraceFile(L"dummy.etl"));
+  // An instance parses a single trace file.
+  EXPECT_FALSE(parser.AddTraceFile(L"other.etl"));
+}
+
+TEST(EtlFileParserTest, ParseMissingFile) {
+  EventRecorder recorder;
+  EtlFileParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(L"do_not_exist.etl"));
+  parser.Parse([&recorder](const event::Event& event) {
+    recorder.Receive(event);
+  });
+  EXPECT_TRUE(recorder.events().empty());
+}
+
+TEST(EtlFileParserTest, Parse) {
+  EventRecorder recorder;
+  ParseSample(kSampleTrace, false, 0, NULL, &recorder);
+  ExpectSampleEvents(recorder);
+}
+
+TEST(EtlFileParserTest, ParseWithLazyPayloads) {
+  EventRecorder recorder;
+  ParseSample(kSampleTrace, true, 0, NULL, &recorder);
+  ExpectSampleEvents(recorder);
+}
+
+TEST(EtlFileParserTest, ParseInParallel) {
+  EventRecorder recorder;
+  ParseSample(kSampleTrace, false, 2, NULL, &recorder);
+  ExpectSampleEvents(recorder);
+}
+
+void ExpectFilteredSampleEvents(const EventRecorder& recorder) {
+  const std::vector<std::unique_ptr<event::Event>>& events = recorder.events();
+  ASSERT_EQ(2U, events.size());
+  EXPECT_EQ(kStartTime + 100, events[0]->timestamp());
+  EXPECT_EQ(kStartTime + 200, events[1]->timestamp());
+  EXPECT_EQ(100U, GetUInteger(*events[0], "NewThreadId"));
+  EXPECT_EQ(0U, GetUInteger(*events[1], "NewThreadId"));
+
+  uint32_t old_thread_id = 0;
+  EXPECT_FALSE(events[0]->payload()->GetFieldAsUInteger("OldThreadId",
+                                                        &old_thread_id));
+}
+
+TEST(EtlFileParserTest, ParseWithFilter) {
+  EventFilter filter;
+  filter.AllowOpcode(kThreadProviderId, kCSwitchOpcode);
+  filter.SetTimeRange(kStartTime + 100, kStartTime + 300);
+  filter.ProjectFields(kThreadProviderId, kCSwitchOpcode, { "NewThreadId" });
+
+  EventRecorder sequential_recorder;
+  ParseSample(kSampleTrace, false, 0, &filter, &sequential_recorder);
+  ExpectFilteredSampleEvents(sequential_recorder);
+
+  EventRecorder parallel_recorder;
+  ParseSample(kSampleTrace, false, 3, &filter, &parallel_recorder);
+  ExpectFilteredSampleEvents(parallel_recorder);
+}
+
+TEST(EtlFileParserTest, ParseManyBuffersInParallel) {
+  EventRecorder expected;
+  ParseSample(kManyBuffersTrace, false, 0, NULL, &expected);
+  // The header event, then 8 events in each of the 40 buffers of the 4
+  // processors.
+  ASSERT_EQ(1U + 4 * 40 * 8, expected.events().size());
+  for (size_t i = 1; i < expected.events().size(); ++i) {
+    EXPECT_LT(expected.events()[i - 1]->timestamp(),
+              expected.events()[i]->timestamp());
+  }
+
+  const size_t kDecodeThreads[] = { 1, 2, 4 };
+  for (size_t i = 0; i < sizeof(kDecodeThreads) / sizeof(kDecodeThreads[0]);
+       ++i) {
+    EventRecorder recorder;
+    ParseSample(kManyBuffersTrace, false, kDecodeThreads[i], NULL, &recorder);
+    ASSERT_EQ(expected.events().size(), recorder.events().size());
+    for (size_t j = 0; j < recorder.events().size(); ++j) {
+      const event::Event& expected_event = *expected.events()[j];
+      const event::Event& event = *recorder.events()[j];
+      EXPECT_EQ(expected_event.timestamp(), event.timestamp());
+      EXPECT_EQ(expected_event.event_header().processor_number,
+                event.event_header().processor_number);
+      EXPECT_TRUE(expected_event.payload()->Equals(event.payload()));
+    }
+  }
+}
+
+TEST(EtlFileParserTest, ParseTimeRangeWithIndex) {
+  const std::string kTracePath("etl_file_parser_unittest.etl");
+  const std::wstring trace_path = base::StringToWString(kTracePath);
+  const std::wstring index_path = EtlIndex::GetIndexPath(trace_path);
+  const std::string kIndexPath = base::WStringToString(index_path);
+  ASSERT_TRUE(CopySample(kManyBuffersTrace, kTracePath));
+  remove(kIndexPath.c_str());
+
+  // The events of buffers 9 and 10 of each processor.
+  const event::Timestamp kBegin = kStartTime + 10000;
+  const event::Timestamp kEnd = kStartTime + 12000;
+  EventRecorder expected;
+  ParseTimeRange(trace_path, false, kBegin, kEnd, &expected);
+  ASSERT_EQ(4U * 2 * 8, expected.events().size());
+  EXPECT_EQ(kBegin, expected.events().front()->timestamp());
+  EXPECT_GT(kEnd, expected.events().back()->timestamp());
+
+  // The first parsing builds the index, the second one loads it.
+  for (size_t i = 0; i < 2; ++i) {
+    EventRecorder recorder;
+    ParseTimeRange(trace_path, true, kBegin, kEnd, &recorder);
+    ASSERT_EQ(expected.events().size(), recorder.events().size());
+    for (size_t j = 0; j < recorder.events().size(); ++j) {
+      EXPECT_EQ(expected.events()[j]->timestamp(),
+                recorder.events()[j]->timestamp());
+      EXPECT_TRUE(expected.events()[j]->payload()->Equals(
+          recorder.events()[j]->payload()));
+    }
+
+    // One entry per buffer holding events.
+    base::MemoryMappedFile trace;
+    ASSERT_TRUE(trace.Open(trace_path));
+    EtlIndex index;
+    EtlTraceId trace_id = { trace.size(), 512, kStartTime,
+                            kFirstRawTimestamp };
+    ASSERT_TRUE(index.Load(index_path, trace_id));
+    EXPECT_EQ(1U + 4 * 40, index.entries().size());
+  }
+
+  remove(kIndexPath.c_str());
+  remove(kTracePath.c_str());
+}
+
+TEST(EtlFileParserTest, RejectIndexOfOtherTrace) {
+  const std::string kTracePath("etl_file_parser_unittest.etl");
+  const std::wstring trace_path = base::StringToWString(kTracePath);
+  const std::wstring index_path = EtlIndex::GetIndexPath(trace_path);
+  const std::string kIndexPath = base::WStringToString(index_path);
+  ASSERT_TRUE(CopySample(kManyBuffersTrace, kTracePath));
+  remove(kIndexPath.c_str());
+
+  // Index the trace: the range holds buffers 9 and 10 of each processor.
+  const event::Timestamp kBegin = kStartTime + 10000;
+  const event::Timestamp kEnd = kStartTime + 12000;
+  EventRecorder indexed;
+  ParseTimeRange(trace_path, true, kBegin, kEnd, &indexed);
+  ASSERT_EQ(4U * 2 * 8, indexed.events().size());
+
+  // A new trace of the same size, which started 20000 units earlier, is
+  // written at the same path: the range now holds buffers 29 and 30 of each
+  // processor. The index of the old trace would only find buffers 9 and 10.
+  const uint64_t kNewStartTime = kStartTime - 20000;
+  ASSERT_TRUE(CopySampleWithStartTime(kManyBuffersTrace, kTracePath,
+                                      kNewStartTime));
+  EventRecorder expected;
+  ParseTimeRange(trace_path, false, kBegin, kEnd, &expected);
+  ASSERT_EQ(4U * 2 * 8, expected.events().size());
+
+  EventRecorder recorder;
+  ParseTimeRange(trace_path, true, kBegin, kEnd, &recorder);
+  ASSERT_EQ(expected.events().size(), recorder.events().size());
+  for (size_t i = 0; i < recorder.events().size(); ++i) {
+    EXPECT_EQ(expected.events()[i]->timestamp(),
+              recorder.events()[i]->timestamp());
+    EXPECT_TRUE(expected.events()[i]->payload()->Equals(
+        recorder.events()[i]->payload()));
+    EXPECT_FALSE(indexed.events()[i]->payload()->Equals(
+        recorder.events()[i]->payload()));
+  }
+
+  // The index was rebuilt for the new trace.
+  base::MemoryMappedFile trace;
+  ASSERT_TRUE(trace.Open(trace_path));
+  EtlTraceId old_trace_id = { trace.size(), 512, kStartTime,
+                              kFirstRawTimestamp };
+  EtlTraceId new_trace_id = { trace.size(), 512, kNewStartTime,
+                              kFirstRawTimestamp };
+  EtlIndex index;
+  EXPECT_FALSE(index.Load(index_path, old_trace_id));
+  EXPECT_TRUE(index.Load(index_path, new_trace_id));
+
+  remove(kIndexPath.c_str());
+  remove(kTracePath.c_str());
+}
+
+TEST(EtlFileParserTest, StopParsingInParallel) {
+  std::unique_ptr<EtlFileParser> impl(new EtlFileParser());
+  impl->set_decode_threads(2);
+
+  parser::Parser parser;
+  parser.RegisterParser(std::move(impl));
+  ASSERT_TRUE(parser.AddTraceFile(GetSamplePath(kManyBuffersTrace)));
+
+  // Destroying the cursor cancels the parser and stops the workers.
+  std::unique_ptr<EventCursor> cursor = parser.CreateCursor();
+  for (size_t i = 0; i < 10; ++i)
+    ASSERT_TRUE(cursor->Next() != NULL);
+  cursor.reset();
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,369 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etl_format.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+// Types of trace headers, found in the third byte of a record.
+enum EtlHeaderType {
+  kSystem32HeaderType = 1,
+  kSystem64HeaderType = 2,
+  kCompact32HeaderType = 3,
+  kCompact64HeaderType = 4,
+  kFull32HeaderType = 10,
+  kInstance32HeaderType = 11,
+  kPerfInfo32HeaderType = 16,
+  kPerfInfo64HeaderType = 17,
+  kEvent32HeaderType = 18,
+  kEvent64HeaderType = 19,
+  kFull64HeaderType = 20,
+  kInstance64HeaderType = 21
+};
+
+// Sizes of the trace headers.
+const size_t kSystemHeaderSize = 32;
+const size_t kCompactHeaderSize = 24;
+const size_t kPerfInfoHeaderSize = 16;
+const size_t kFullHeaderSize = 48;
+const size_t kEventHeaderSize = 80;
+
+// Records are aligned on 8 bytes.
+const size_t kRecordAlignment = 8;
+
+// Fills the unused end of a buffer.
+const uint32_t kPaddingMarker = 0xFFFFFFFF;
+
+// Process and thread ids of the events which are logged without them.
+const uint32_t kUnknownId = 0xFFFFFFFF;
+
+// Clock types of a trace, as found in the ReservedFlags field of its header.
+const uint32_t kQueryPerformanceCounterClock = 1;
+const uint32_t kSystemTimeClock = 2;
+const uint32_t kCpuCycleCounterClock = 3;
+
+// Timestamps are converted to 100ns units, as the ETWParser does.
+const double kPerfPeriodMultiplier = 10000000.0;
+
+// Offsets of the fields of the buffer header.
+const size_t kBufferSizeOffset = 0x00;
+const size_t kSavedOffsetOffset = 0x04;
+const size_t kProcessorNumberOffset = 0x28;
+const size_t kOffsetOffset = 0x30;
+
+// Kernel providers, by group of events. The group is the high byte of the
+// hook id of a system header (see the EVENT_TRACE_GROUP_* values).
+struct GroupProvider {
+  uint8_t group;
+  base::Guid provider_id;
+};
+
+const GroupProvider kGroupProviders[] = {
+  // EventTraceEvent.
+  { 0x00, { 0x68FDD900, 0x4A3E, 0x11D1,
+            { 0x84, 0xF4, 0x00, 0x00, 0xF8, 0x04, 0x64, 0xE3 } } },
+  // DiskIO.
+  { 0x01, { 0x3D6FA8D4, 0xFE05, 0x11D0,
+            { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } } },
+  // PageFault.
+  { 0x02, { 0x3D6FA8D3, 0xFE05, 0x11D0,
+            { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } } },
+  // Process.
+  { 0x03, { 0x3D6FA8D0, 0xFE05, 0x11D0,
+            { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } } },
+  // FileIO.
+  { 0x04, { 0x90CBDC39, 0x4A3E, 0x11D1,
+            { 0x84, 0xF4, 0x00, 0x00, 0xF8, 0x04, 0x64, 0xE3 } } },
+  // Thread.
+  { 0x05, { 0x3D6FA8D1, 0xFE05, 0x11D0,
+            { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } } },
+  // Tcplp.
+  { 0x06, { 0x9A280AC0, 0xC8E0, 0x11D1,
+            { 0x84, 0xE2, 0x00, 0xC0, 0x4F, 0xB9, 0x98, 0xA2 } } },
+  // Registry.
+  { 0x09, { 0xAE53722E, 0xC863, 0x11D2,
+            { 0x86, 0x59, 0x00, 0xC0, 0x4F, 0xA3, 0x21, 0xA1 } } },
+  // PerfInfo.
+  { 0x0F, { 0xCE1DBFB4, 0x137E, 0x4DA6,
+            { 0x87, 0xB0, 0x3F, 0x59, 0xAA, 0x10, 0x2C, 0xBC } } },
+  // Image.
+  { 0x14, { 0x2CB15D1D, 0x5FC1, 0x11D2,
+            { 0xAB, 0xE1, 0x00, 0xA0, 0xC9, 0x11, 0xF5, 0x18 } } },
+  // StackWalk.
+  { 0x18, { 0xDEF2FE46, 0x7BD6, 0x4B80,
+            { 0xBD, 0x94, 0xF5, 0x7F, 0xE2, 0x0D, 0x0C, 0xE3 } } },
+};
+
+// Reads a little-endian value which may be unaligned.
+template<typename T>
+T ReadAt(const char* data, size_t offset) {
+  T value;
+  ::memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+// Finds the provider of a group of kernel events.
+// @param group the group of the events.
+// @param provider_id receives the GUID of the provider.
+// @returns true if the group is known, false otherwise.
+bool FindGroupProvider(uint8_t group, base::Guid* provider_id) {
+  for (size_t i = 0; i < sizeof(kGroupProviders) / sizeof(kGroupProviders[0]);
+       ++i) {
+    if (kGroupProviders[i].group == group) {
+      *provider_id = kGroupProviders[i].provider_id;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Reads a system header: SYSTEM_TRACE_HEADER, its compact form or
+// PERFINFO_TRACE_HEADER. They share a marker holding the version of the event
+// and a packet holding its size, opcode and group.
+void ReadSystemHeader(const char* record,
+                      size_t header_size,
+                      EtlEventRecord* result) {
+  result->version = static_cast<uint8_t>(ReadAt<uint16_t>(record, 0));
+  result->opcode = ReadAt<uint8_t>(record, 6);
+  if (!FindGroupProvider(ReadAt<uint8_t>(record, 7), &result->provider_id))
+    ::memset(&result->provider_id, 0, sizeof(result->provider_id));
+  result->flags = kEtlEventHeaderFlagClassicHeader |
+      (result->is_64_bit ? kEtlEventHeaderFlag64BitHeader :
+                           kEtlEventHeaderFlag32BitHeader);
+
+  if (header_size == kPerfInfoHeaderSize) {
+    result->process_id = kUnknownId;
+    result->thread_id = kUnknownId;
+    result->raw_timestamp = ReadAt<uint64_t>(record, 8);
+  } else {
+    result->thread_id = ReadAt<uint32_t>(record, 8);
+    result->process_id = ReadAt<uint32_t>(record, 12);
+    result->raw_timestamp = ReadAt<uint64_t>(record, 16);
+  }
+}
+
+// Reads a full header: EVENT_TRACE_HEADER.
+void ReadFullHeader(const char* record, EtlEventRecord* result) {
+  result->opcode = ReadAt<uint8_t>(record, 4);
+  result->version = static_cast<uint8_t>(ReadAt<uint16_t>(record, 6));
+  result->thread_id = ReadAt<uint32_t>(record, 8);
+  result->process_id = ReadAt<uint32_t>(record, 12);
+  result->raw_timestamp = ReadAt<uint64_t>(record, 16);
+  result->provider_id = ReadAt<base::Guid>(record, 24);
+  result->flags = kEtlEventHeaderFlagClassicHeader |
+      (result->is_64_bit ? kEtlEventHeaderFlag64BitHeader :
+                           kEtlEventHeaderFlag32BitHeader);
+}
+
+// Reads an event header: EVENT_HEADER.
+void ReadEventHeader(const char* record, EtlEventRecord* result) {
+  result->flags = ReadAt<uint16_t>(record, 4);
+  result->thread_id = ReadAt<uint32_t>(record, 8);
+  result->process_id = ReadAt<uint32_t>(record, 12);
+  result->raw_timestamp = ReadAt<uint64_t>(record, 16);
+  result->provider_id = ReadAt<base::Guid>(record, 24);
+  // The EVENT_DESCRIPTOR starts at offset 40.
+  result->version = ReadAt<uint8_t>(record, 42);
+  result->opcode = ReadAt<uint8_t>(record, 45);
+}
+
+}  // namespace
+
+bool ReadEtlBufferHeader(const char* buffer,
+                         size_t size,
+                         EtlBufferHeader* header) {
+  DCHECK(buffer != NULL);
+  DCHECK(header != NULL);
+
+  if (size < kEtlBufferHeaderSize)
+    return false;
+
+  header->buffer_size = ReadAt<uint32_t>(buffer, kBufferSizeOffset);
+  if (header->buffer_size < kEtlBufferHeaderSize)
+    return false;
+  header->processor_number = ReadAt<uint8_t>(buffer, kProcessorNumberOffset);
+
+  // The saved offset is the end of the events once the buffer is flushed to
+  // the file. Fall back on the current offset of the buffer.
+  uint32_t end_offset = ReadAt<uint32_t>(buffer, kSavedOffsetOffset);
+  if (end_offset < kEtlBufferHeaderSize || end_offset > header->buffer_size)
+    end_offset = ReadAt<uint32_t>(buffer, kOffsetOffset);
+  if (end_offset < kEtlBufferHeaderSize || end_offset > header->buffer_size)
+    end_offset = kEtlBufferHeaderSize;
+  header->end_offset = end_offset;
+  return true;
+}
+
+void ReadEtlBuffers(const char* data,
+                    size_t size,
+                    size_t buffer_size,
+                    std::vector<EtlBuffer>* buffers) {
+  DCHECK(data != NULL);
+  DCHECK(buffers != NULL);
+  DCHECK_NE(0U, buffer_size);
+
+  for (size_t offset = 0; offset + buffer_size <= size;
+       offset += buffer_size) {
+    EtlBuffer buffer = { data + offset, EtlBufferHeader() };
+    if (!ReadEtlBufferHeader(buffer.data, buffer_size, &buffer.header) ||
+        buffer.header.buffer_size != buffer_size) {
+      LOG(WARNING) << "Invalid ETL buffer at offset " << offset << ".";
+      continue;
+    }
+    buffers->push_back(buffer);
+  }
+}
+
+bool ReadEtlEventRecord(const char* buffer,
+                        size_t end_offset,
+                        size_t* offset,
+                        EtlEventRecord* record) {
+  DCHECK(buffer != NULL);
+  DCHECK(offset != NULL);
+  DCHECK(record != NULL);
+
+  while (*offset + sizeof(uint32_t) <= end_offset) {
+    const char* data = buffer + *offset;
+    size_t available = end_offset - *offset;
+    if (ReadAt<uint32_t>(data, 0) == kPaddingMarker)
+      return false;
+
+    // Find the size of the record and the size of its header.
+    uint8_t header_type = ReadAt<uint8_t>(data, 2);
+    size_t header_size = 0;
+    size_t record_size = 0;
+    bool has_event = true;
+    switch (header_type) {
+      case kSystem32HeaderType:
+      case kSystem64HeaderType:
+        header_size = kSystemHeaderSize;
+        break;
+      case kCompact32HeaderType:
+      case kCompact64HeaderType:
+        header_size = kCompactHeaderSize;
+        break;
+      case kPerfInfo32HeaderType:
+      case kPerfInfo64HeaderType:
+        header_size = kPerfInfoHeaderSize;
+        break;
+      case kFull32HeaderType:
+      case kFull64HeaderType:
+        header_size = kFullHeaderSize;
+        break;
+      case kEvent32HeaderType:
+      case kEvent64HeaderType:
+        header_size = kEventHeaderSize;
+        break;
+      case kInstance32HeaderType:
+      case kInstance64HeaderType:
+        has_event = false;
+        break;
+      default:
+        LOG(WARNING) << "Unknown ETL header type "
+                     << static_cast<int>(header_type) << ".";
+        return false;
+    }
+
+    // System headers keep the size of the record in their packet, at offset
+    // 4. The other headers start with it.
+    if (available < sizeof(uint32_t) * 2)
+      return false;
+    if (header_size == kSystemHeaderSize ||
+        header_size == kCompactHeaderSize ||
+        header_size == kPerfInfoHeaderSize) {
+      record_size = ReadAt<uint16_t>(data, 4);
+    } else {
+      record_size = ReadAt<uint16_t>(data, 0);
+    }
+    if (record_size < header_size || record_size < sizeof(uint32_t) ||
+        record_size > available) {
+      LOG(WARNING) << "Corrupted ETL event record.";
+      return false;
+    }
+
+    *offset += (record_size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+    if (!has_event)
+      continue;
+
+    record->is_64_bit = header_type == kSystem64HeaderType ||
+                        header_type == kCompact64HeaderType ||
+                        header_type == kPerfInfo64HeaderType ||
+                        header_type == kFull64HeaderType ||
+                        header_type == kEvent64HeaderType;
+    if (header_size == kFullHeaderSize)
+      ReadFullHeader(data, record);
+    else if (header_size == kEventHeaderSize)
+      ReadEventHeader(data, record);
+    else
+      ReadSystemHeader(data, header_size, record);
+    record->payload = data + header_size;
+    record->payload_size = record_size - header_size;
+    return true;
+  }
+
+  return false;
+}
+
+EtlClock::EtlClock() : start_time_(0), first_raw_timestamp_(0), period_(0) {
+}
+
+bool EtlClock::Init(const event::Value* header, uint64_t raw_timestamp) {
+  uint64_t perf_freq = 0;
+  uint32_t clock_type = 0;
+  uint32_t cpu_speed = 0;
+  if (header == NULL ||
+      !header->GetFieldAsULong("StartTime", &start_time_) ||
+      !header->GetFieldAsULong("PerfFreq", &perf_freq) ||
+      !header->GetFieldAsUInteger("ReservedFlags", &clock_type) ||
+      !header->GetFieldAsUInteger("CPUSpeed", &cpu_speed)) {
+    return false;
+  }
+
+  // The header comes from the trace file: an unknown clock type, or a clock
+  // without its frequency, rejects the trace.
+  first_raw_timestamp_ = raw_timestamp;
+  if (clock_type == kSystemTimeClock) {
+    period_ = 1.0;
+  } else if (clock_type == kCpuCycleCounterClock && cpu_speed != 0) {
+    // The speed of the processor is in MHz.
+    period_ = kPerfPeriodMultiplier / (cpu_speed * 1000000.0);
+  } else if ((clock_type == kQueryPerformanceCounterClock || clock_type == 0) &&
+             perf_freq != 0) {
+    period_ = kPerfPeriodMultiplier / perf_freq;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace etw
+}  // namespace parser
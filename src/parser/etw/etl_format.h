@@ -0,0 +1,169 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Portable readers for the on-disk format of ETW trace files (.etl). They do
+// not depend on the Windows API, so traces can be read on any platform.
+//
+// An .etl file is a sequence of buffers of a fixed size. Each buffer starts
+// with a WMI_BUFFER_HEADER and was filled by a single processor; it holds a
+// sequence of event records, in timestamp order, aligned on 8 bytes. Each
+// record starts with a trace header, whose type is given by the third byte of
+// the record:
+//
+//   - system headers (kernel events): SYSTEM_TRACE_HEADER, its compact form
+//     and PERFINFO_TRACE_HEADER. The provider is implied by the group of the
+//     event (e.g. EVENT_TRACE_GROUP_THREAD).
+//   - full headers (classic providers): EVENT_TRACE_HEADER.
+//   - event headers (manifest providers): EVENT_HEADER.
+//
+// The first record of a trace is the EventTrace Header event, whose payload
+// is the TRACE_LOGFILE_HEADER of the trace. Compressed traces are not
+// supported.
+
+#ifndef PARSER_ETW_ETL_FORMAT_H_
+#define PARSER_ETW_ETL_FORMAT_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "base/guid.h"
+#include "event/value.h"
+
+namespace parser {
+namespace etw {
+
+// Size of the header of a buffer.
+const size_t kEtlBufferHeaderSize = 72;
+
+// Flags of the header of an event, as found in EVENT_HEADER.
+const uint16_t kEtlEventHeaderFlag32BitHeader = 0x0020;
+const uint16_t kEtlEventHeaderFlag64BitHeader = 0x0040;
+const uint16_t kEtlEventHeaderFlagClassicHeader = 0x0100;
+
+// The fields of a WMI_BUFFER_HEADER used to read the events of a buffer.
+struct EtlBufferHeader {
+  // The size of the buffer, in bytes.
+  uint32_t buffer_size;
+  // The offset of the end of the events in the buffer.
+  uint32_t end_offset;
+  // The processor which filled the buffer.
+  uint8_t processor_number;
+};
+
+// A buffer of a trace file.
+struct EtlBuffer {
+  // The beginning of the buffer.
+  const char* data;
+  EtlBufferHeader header;
+};
+
+// The fields of an event record, read from its trace header.
+struct EtlEventRecord {
+  base::Guid provider_id;
+  uint8_t version;
+  uint8_t opcode;
+  bool is_64_bit;
+  // The EVENT_HEADER_FLAG_* flags of the event.
+  uint16_t flags;
+  uint32_t process_id;
+  uint32_t thread_id;
+  // The timestamp of the event, in the clock of the trace.
+  uint64_t raw_timestamp;
+  const char* payload;
+  size_t payload_size;
+};
+
+// Reads the header of a buffer.
+// @param buffer the beginning of the buffer.
+// @param size the number of bytes available from |buffer|.
+// @param header receives the header of the buffer.
+// @returns true if the header is valid, false otherwise.
+bool ReadEtlBufferHeader(const char* buffer,
+                         size_t size,
+                         EtlBufferHeader* header);
+
+// Reads the headers of the buffers of a trace file. Invalid buffers are
+// skipped.
+// @param data the content of the trace file.
+// @param size the size of the trace file.
+// @param buffer_size the size of the buffers of the trace.
+// @param buffers receives the valid buffers, in file order.
+void ReadEtlBuffers(const char* data,
+                    size_t size,
+                    size_t buffer_size,
+                    std::vector<EtlBuffer>* buffers);
+
+// Reads an event record of a buffer. Records which carry no event (e.g.
+// padding or instance headers) are skipped.
+// @param buffer the beginning of the buffer.
+// @param end_offset the offset of the end of the events in the buffer.
+// @param offset the offset of the record to read. Receives the offset of the
+//     next record.
+// @param record receives the event record. Its payload points into |buffer|.
+// @returns true if a record is read, false at the end of the buffer or when
+//     the record is corrupted.
+bool ReadEtlEventRecord(const char* buffer,
+                        size_t end_offset,
+                        size_t* offset,
+                        EtlEventRecord* record);
+
+// Converts the raw timestamps of a trace to system time.
+class EtlClock {
+ public:
+  EtlClock();
+
+  // Reads the clock of a trace from the payload of its header event.
+  // @param header the decoded payload of the EventTrace Header event.
+  // @param raw_timestamp the timestamp of the header event.
+  // @returns true if the clock is known, false otherwise.
+  bool Init(const event::Value* header, uint64_t raw_timestamp);
+
+  // @param raw_timestamp a timestamp in the clock of the trace.
+  // @returns the timestamp in system time, in 100ns units.
+  uint64_t ToSystemTime(uint64_t raw_timestamp) const {
+    int64_t delta = static_cast<int64_t>(raw_timestamp - first_raw_timestamp_);
+    return start_time_ + static_cast<int64_t>(delta * period_);
+  }
+
+  // @returns the system time of the header event, in 100ns units.
+  uint64_t start_time() const { return start_time_; }
+
+  // @returns the raw timestamp of the header event.
+  uint64_t first_raw_timestamp() const { return first_raw_timestamp_; }
+
+ private:
+  // The system time and the raw timestamp of the header event.
+  uint64_t start_time_;
+  uint64_t first_raw_timestamp_;
+
+  // The duration of a tick of the clock, in 100ns units.
+  double period_;
+};
+
+}  // namespace etw
+}  // namespace parser
+
+#endif  // PARSER_ETW_ETL_FORMAT_H_
@@ -0,0 +1,312 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etl_format.h"
+
+#include <cstring>
+#include <vector>
+
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+// Thread provider: 3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C.
+const base::Guid kThreadProviderId = {
+    0x3D6FA8D1, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+
+// PerfInfo provider: CE1DBFB4-137E-4DA6-87B0-3F59AA102CBC.
+const base::Guid kPerfInfoProviderId = {
+    0xCE1DBFB4, 0x137E, 0x4DA6,
+    { 0x87, 0xB0, 0x3F, 0x59, 0xAA, 0x10, 0x2C, 0xBC } };
+
+// A manifest provider: 22FB2CD6-0E7B-422B-A0C7-2FAD1FD0E716.
+const base::Guid kManifestProviderId = {
+    0x22FB2CD6, 0x0E7B, 0x422B,
+    { 0xA0, 0xC7, 0x2F, 0xAD, 0x1F, 0xD0, 0xE7, 0x16 } };
+
+// Writes the records of a buffer.
+class BufferWriter {
+ public:
+  BufferWriter() : data_(kEtlBufferHeaderSize, 0) {
+  }
+
+  template<typename T>
+  void Write(size_t offset, T value) {
+    if (data_.size() < offset + sizeof(value))
+      data_.resize(offset + sizeof(value));
+    memcpy(&data_[offset], &value, sizeof(value));
+  }
+
+  // Appends a record with a header of |header_size| bytes, followed by a
+  // payload of |payload_size| bytes, and aligns the end of the buffer.
+  // @returns the offset of the record.
+  size_t AddRecord(size_t header_size, size_t payload_size) {
+    size_t offset = data_.size();
+    data_.resize(offset + header_size + payload_size, 0);
+    for (size_t i = 0; i < payload_size; ++i)
+      data_[offset + header_size + i] = static_cast<char>(i);
+    while (data_.size() % 8 != 0)
+      data_.push_back(0);
+    return offset;
+  }
+
+  const char* data() const { return &data_[0]; }
+  size_t size() const { return data_.size(); }
+
+ private:
+  std::vector<char> data_;
+};
+
+// Creates the fields of an EventTrace Header used by EtlClock.
+std::unique_ptr<event::StructValue> CreateTraceHeader(uint64_t perf_freq,
+                                                      uint32_t clock_type,
+                                                      uint32_t cpu_speed) {
+  std::unique_ptr<event::StructValue> header(new event::StructValue());
+  header->AddField<event::ULongValue>("StartTime", 1000000ULL);
+  header->AddField<event::ULongValue>("PerfFreq", perf_freq);
+  header->AddField<event::UIntValue>("ReservedFlags", clock_type);
+  header->AddField<event::UIntValue>("CPUSpeed", cpu_speed);
+  return header;
+}
+
+}  // namespace
+
+TEST(EtlFormatTest, ReadBufferHeader) {
+  BufferWriter writer;
+  writer.Write<uint32_t>(0x00, 4096);
+  writer.Write<uint32_t>(0x04, 200);
+  writer.Write<uint8_t>(0x28, 3);
+
+  EtlBufferHeader header;
+  ASSERT_TRUE(ReadEtlBufferHeader(writer.data(), writer.size(), &header));
+  EXPECT_EQ(4096U, header.buffer_size);
+  EXPECT_EQ(200U, header.end_offset);
+  EXPECT_EQ(3U, header.processor_number);
+
+  // Fall back on the current offset when there is no saved offset.
+  writer.Write<uint32_t>(0x04, 0);
+  writer.Write<uint32_t>(0x30, 300);
+  ASSERT_TRUE(ReadEtlBufferHeader(writer.data(), writer.size(), &header));
+  EXPECT_EQ(300U, header.end_offset);
+
+  // An invalid offset means that the buffer has no event.
+  writer.Write<uint32_t>(0x30, 5000);
+  ASSERT_TRUE(ReadEtlBufferHeader(writer.data(), writer.size(), &header));
+  EXPECT_EQ(kEtlBufferHeaderSize, header.end_offset);
+}
+
+TEST(EtlFormatTest, ReadInvalidBufferHeader) {
+  BufferWriter writer;
+  EtlBufferHeader header;
+  EXPECT_FALSE(ReadEtlBufferHeader(writer.data(), 10, &header));
+
+  writer.Write<uint32_t>(0x00, 16);
+  EXPECT_FALSE(ReadEtlBufferHeader(writer.data(), writer.size(), &header));
+}
+
+TEST(EtlFormatTest, ReadSystemRecords) {
+  BufferWriter writer;
+
+  // A 32-bit SYSTEM_TRACE_HEADER: Thread CSwitch.
+  size_t offset = writer.AddRecord(32, 12);
+  writer.Write<uint16_t>(offset + 0, 2);
+  writer.Write<uint8_t>(offset + 2, 1);
+  writer.Write<uint16_t>(offset + 4, 32 + 12);
+  writer.Write<uint8_t>(offset + 6, 36);
+  writer.Write<uint8_t>(offset + 7, 0x05);
+  writer.Write<uint32_t>(offset + 8, 1234);
+  writer.Write<uint32_t>(offset + 12, 5678);
+  writer.Write<uint64_t>(offset + 16, 1000);
+
+  // A 64-bit PERFINFO_TRACE_HEADER: PerfInfo SampleProf.
+  offset = writer.AddRecord(16, 16);
+  writer.Write<uint16_t>(offset + 0, 2);
+  writer.Write<uint8_t>(offset + 2, 17);
+  writer.Write<uint16_t>(offset + 4, 16 + 16);
+  writer.Write<uint8_t>(offset + 6, 46);
+  writer.Write<uint8_t>(offset + 7, 0x0F);
+  writer.Write<uint64_t>(offset + 8, 2000);
+
+  size_t end_offset = writer.size();
+  offset = kEtlBufferHeaderSize;
+  EtlEventRecord record;
+
+  ASSERT_TRUE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                 &record));
+  EXPECT_EQ(kThreadProviderId, record.provider_id);
+  EXPECT_EQ(2U, record.version);
+  EXPECT_EQ(36U, record.opcode);
+  EXPECT_FALSE(record.is_64_bit);
+  EXPECT_EQ(kEtlEventHeaderFlagClassicHeader |
+                kEtlEventHeaderFlag32BitHeader,
+            record.flags);
+  EXPECT_EQ(1234U, record.thread_id);
+  EXPECT_EQ(5678U, record.process_id);
+  EXPECT_EQ(1000U, record.raw_timestamp);
+  EXPECT_EQ(writer.data() + kEtlBufferHeaderSize + 32, record.payload);
+  EXPECT_EQ(12U, record.payload_size);
+  EXPECT_EQ(kEtlBufferHeaderSize + 48, offset);
+
+  ASSERT_TRUE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                 &record));
+  EXPECT_EQ(kPerfInfoProviderId, record.provider_id);
+  EXPECT_EQ(46U, record.opcode);
+  EXPECT_TRUE(record.is_64_bit);
+  EXPECT_EQ(0xFFFFFFFFU, record.thread_id);
+  EXPECT_EQ(0xFFFFFFFFU, record.process_id);
+  EXPECT_EQ(2000U, record.raw_timestamp);
+  EXPECT_EQ(16U, record.payload_size);
+  EXPECT_EQ(end_offset, offset);
+
+  EXPECT_FALSE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                  &record));
+}
+
+TEST(EtlFormatTest, ReadEventHeaderRecord) {
+  BufferWriter writer;
+
+  // An instance header carries no event.
+  size_t offset = writer.AddRecord(24, 0);
+  writer.Write<uint16_t>(offset + 0, 24);
+  writer.Write<uint8_t>(offset + 2, 21);
+
+  // A 64-bit EVENT_HEADER.
+  offset = writer.AddRecord(80, 6);
+  writer.Write<uint16_t>(offset + 0, 80 + 6);
+  writer.Write<uint8_t>(offset + 2, 19);
+  writer.Write<uint16_t>(offset + 4, kEtlEventHeaderFlag64BitHeader);
+  writer.Write<uint32_t>(offset + 8, 42);
+  writer.Write<uint32_t>(offset + 12, 43);
+  writer.Write<uint64_t>(offset + 16, 3000);
+  writer.Write<base::Guid>(offset + 24, kManifestProviderId);
+  writer.Write<uint8_t>(offset + 42, 1);
+  writer.Write<uint8_t>(offset + 45, 12);
+
+  size_t end_offset = writer.size();
+  offset = kEtlBufferHeaderSize;
+  EtlEventRecord record;
+  ASSERT_TRUE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                 &record));
+  EXPECT_EQ(kManifestProviderId, record.provider_id);
+  EXPECT_EQ(1U, record.version);
+  EXPECT_EQ(12U, record.opcode);
+  EXPECT_TRUE(record.is_64_bit);
+  EXPECT_EQ(kEtlEventHeaderFlag64BitHeader, record.flags);
+  EXPECT_EQ(42U, record.thread_id);
+  EXPECT_EQ(43U, record.process_id);
+  EXPECT_EQ(3000U, record.raw_timestamp);
+  EXPECT_EQ(6U, record.payload_size);
+  EXPECT_EQ(end_offset, offset);
+}
+
+TEST(EtlFormatTest, StopAtPadding) {
+  BufferWriter writer;
+  size_t offset = writer.AddRecord(24, 8);
+  writer.Write<uint16_t>(offset + 0, 2);
+  writer.Write<uint8_t>(offset + 2, 4);
+  writer.Write<uint16_t>(offset + 4, 24 + 8);
+  writer.Write<uint8_t>(offset + 7, 0x05);
+  offset = writer.AddRecord(8, 0);
+  writer.Write<uint32_t>(offset, 0xFFFFFFFF);
+  writer.Write<uint32_t>(offset + 4, 0xFFFFFFFF);
+
+  size_t end_offset = writer.size();
+  offset = kEtlBufferHeaderSize;
+  EtlEventRecord record;
+  ASSERT_TRUE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                 &record));
+  EXPECT_EQ(8U, record.payload_size);
+  EXPECT_FALSE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                  &record));
+}
+
+TEST(EtlFormatTest, StopAtCorruptedRecord) {
+  BufferWriter writer;
+  size_t offset = writer.AddRecord(24, 8);
+  writer.Write<uint16_t>(offset + 0, 2);
+  writer.Write<uint8_t>(offset + 2, 4);
+  writer.Write<uint16_t>(offset + 4, 1000);
+
+  size_t end_offset = writer.size();
+  offset = kEtlBufferHeaderSize;
+  EtlEventRecord record;
+  EXPECT_FALSE(ReadEtlEventRecord(writer.data(), end_offset, &offset,
+                                  &record));
+}
+
+TEST(EtlFormatTest, ClockWithPerformanceCounter) {
+  // A 1MHz counter: a tick is 10 units of 100ns.
+  std::unique_ptr<event::StructValue> header = CreateTraceHeader(1000000, 1, 0);
+  EtlClock clock;
+  ASSERT_TRUE(clock.Init(header.get(), 500));
+  EXPECT_EQ(1000000U, clock.ToSystemTime(500));
+  EXPECT_EQ(1000100U, clock.ToSystemTime(510));
+  // Events may be logged slightly before the header.
+  EXPECT_EQ(999990U, clock.ToSystemTime(499));
+}
+
+TEST(EtlFormatTest, ClockWithSystemTime) {
+  std::unique_ptr<event::StructValue> header = CreateTraceHeader(0, 2, 0);
+  EtlClock clock;
+  ASSERT_TRUE(clock.Init(header.get(), 500));
+  EXPECT_EQ(1000010U, clock.ToSystemTime(510));
+}
+
+TEST(EtlFormatTest, ClockWithCycleCounter) {
+  // A 2000MHz processor: 200 cycles per 100ns.
+  std::unique_ptr<event::StructValue> header = CreateTraceHeader(0, 3, 2000);
+  EtlClock clock;
+  ASSERT_TRUE(clock.Init(header.get(), 0));
+  EXPECT_EQ(1000005U, clock.ToSystemTime(1000));
+}
+
+TEST(EtlFormatTest, InvalidClock) {
+  EtlClock clock;
+  EXPECT_FALSE(clock.Init(NULL, 0));
+
+  std::unique_ptr<event::StructValue> header = CreateTraceHeader(0, 1, 0);
+  EXPECT_FALSE(clock.Init(header.get(), 0));
+}
+
+TEST(EtlFormatTest, UnsupportedClock) {
+  EtlClock clock;
+
+  // An unknown clock type is rejected, even with a frequency.
+  std::unique_ptr<event::StructValue> header =
+      CreateTraceHeader(10000000, 4, 2000);
+  EXPECT_FALSE(clock.Init(header.get(), 0));
+
+  // A cycle counter without the speed of the processor is rejected.
+  header = CreateTraceHeader(10000000, 3, 0);
+  EXPECT_FALSE(clock.Init(header.get(), 0));
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,258 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etl_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+#include "base/string_utils.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+// Identifies an index file.
+const char kMagic[] = { 'L', 'T', 'E', 'T', 'L', 'I', 'D', 'X' };
+
+// Sizes of the header of an index file and of its entries, in bytes.
+const size_t kHeaderSize = sizeof(kMagic) + 4 + 4 + 8 + 8 + 8 + 8;
+const size_t kEntrySize = 8 + 8 + 8 + 4 + 4;
+
+// Appends a little-endian value to a buffer.
+template<typename T>
+void Append(T value, std::string* output) {
+  output->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads a little-endian value and moves past it.
+template<typename T>
+T Consume(const char** data) {
+  T value;
+  ::memcpy(&value, *data, sizeof(value));
+  *data += sizeof(value);
+  return value;
+}
+
+// Compares the last timestamp of an entry to a timestamp.
+struct LastTimestampLess {
+  explicit LastTimestampLess(const std::vector<EtlIndexEntry>* entries)
+      : entries_(entries) {
+  }
+
+  bool operator()(size_t entry, uint64_t timestamp) const {
+    return (*entries_)[entry].last_timestamp < timestamp;
+  }
+
+  const std::vector<EtlIndexEntry>* entries_;
+};
+
+bool IsSameTrace(const EtlTraceId& left, const EtlTraceId& right) {
+  return left.trace_size == right.trace_size &&
+         left.buffer_size == right.buffer_size &&
+         left.start_time == right.start_time &&
+         left.start_raw_timestamp == right.start_raw_timestamp;
+}
+
+FILE* OpenFileForWriting(const std::wstring& path) {
+#if defined(_WIN32)
+  return ::_wfopen(path.c_str(), L"wb");
+#else
+  return ::fopen(base::WStringToString(path).c_str(), "wb");
+#endif
+}
+
+}  // namespace
+
+EtlIndex::EtlIndex() : trace_id_() {
+}
+
+std::wstring EtlIndex::GetIndexPath(const std::wstring& trace_path) {
+  return trace_path + L".idx";
+}
+
+EtlTraceId EtlIndex::GetTraceId(uint64_t trace_size,
+                                uint32_t buffer_size,
+                                const EtlClock& clock) {
+  EtlTraceId trace_id = {};
+  trace_id.trace_size = trace_size;
+  trace_id.buffer_size = buffer_size;
+  trace_id.start_time = clock.start_time();
+  trace_id.start_raw_timestamp = clock.first_raw_timestamp();
+  return trace_id;
+}
+
+void EtlIndex::Build(const char* data,
+                     const std::vector<EtlBuffer>& buffers,
+                     const EtlTraceId& trace_id,
+                     const EtlClock& clock) {
+  DCHECK(data != NULL);
+
+  Reset(trace_id);
+
+  std::vector<EtlBuffer>::const_iterator buffer = buffers.begin();
+  for (; buffer != buffers.end(); ++buffer) {
+    EtlIndexEntry entry = {};
+    entry.offset = buffer->data - data;
+    entry.processor_number = buffer->header.processor_number;
+
+    // Only the headers of the events are read.
+    size_t offset = kEtlBufferHeaderSize;
+    EtlEventRecord record;
+    while (ReadEtlEventRecord(buffer->data, buffer->header.end_offset,
+                              &offset, &record)) {
+      uint64_t timestamp = clock.ToSystemTime(record.raw_timestamp);
+      if (entry.num_events == 0)
+        entry.first_timestamp = timestamp;
+      entry.last_timestamp = timestamp;
+      ++entry.num_events;
+    }
+
+    if (entry.num_events != 0)
+      AddEntry(entry);
+  }
+}
+
+void EtlIndex::Reset(const EtlTraceId& trace_id) {
+  trace_id_ = trace_id;
+  entries_.clear();
+  processor_entries_.clear();
+}
+
+void EtlIndex::AddEntry(const EtlIndexEntry& entry) {
+  if (processor_entries_.size() <= entry.processor_number)
+    processor_entries_.resize(entry.processor_number + 1);
+  processor_entries_[entry.processor_number].push_back(entries_.size());
+  entries_.push_back(entry);
+}
+
+bool EtlIndex::Load(const std::wstring& path, const EtlTraceId& trace_id) {
+  Reset(EtlTraceId());
+
+  base::MemoryMappedFile file;
+  if (!file.Open(path) || file.size() < kHeaderSize)
+    return false;
+
+  const char* data = file.data();
+  if (::memcmp(data, kMagic, sizeof(kMagic)) != 0)
+    return false;
+  data += sizeof(kMagic);
+
+  uint32_t version = Consume<uint32_t>(&data);
+  EtlTraceId indexed_trace_id = {};
+  indexed_trace_id.buffer_size = Consume<uint32_t>(&data);
+  indexed_trace_id.trace_size = Consume<uint64_t>(&data);
+  indexed_trace_id.start_time = Consume<uint64_t>(&data);
+  indexed_trace_id.start_raw_timestamp = Consume<uint64_t>(&data);
+  uint64_t num_entries = Consume<uint64_t>(&data);
+  if (version != kVersion ||
+      !IsSameTrace(indexed_trace_id, trace_id) ||
+      num_entries != (file.size() - kHeaderSize) / kEntrySize ||
+      (file.size() - kHeaderSize) % kEntrySize != 0) {
+    return false;
+  }
+
+  Reset(trace_id);
+  entries_.reserve(static_cast<size_t>(num_entries));
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    EtlIndexEntry entry = {};
+    entry.offset = Consume<uint64_t>(&data);
+    entry.first_timestamp = Consume<uint64_t>(&data);
+    entry.last_timestamp = Consume<uint64_t>(&data);
+    entry.num_events = Consume<uint32_t>(&data);
+    entry.processor_number = Consume<uint8_t>(&data);
+    data += 3;
+
+    if (entry.offset + trace_id.buffer_size > trace_id.trace_size) {
+      Reset(EtlTraceId());
+      return false;
+    }
+    AddEntry(entry);
+  }
+  return true;
+}
+
+bool EtlIndex::Save(const std::wstring& path) const {
+  std::string output;
+  output.reserve(kHeaderSize + entries_.size() * kEntrySize);
+  output.append(kMagic, sizeof(kMagic));
+  Append<uint32_t>(kVersion, &output);
+  Append<uint32_t>(trace_id_.buffer_size, &output);
+  Append<uint64_t>(trace_id_.trace_size, &output);
+  Append<uint64_t>(trace_id_.start_time, &output);
+  Append<uint64_t>(trace_id_.start_raw_timestamp, &output);
+  Append<uint64_t>(entries_.size(), &output);
+
+  std::vector<EtlIndexEntry>::const_iterator entry = entries_.begin();
+  for (; entry != entries_.end(); ++entry) {
+    Append<uint64_t>(entry->offset, &output);
+    Append<uint64_t>(entry->first_timestamp, &output);
+    Append<uint64_t>(entry->last_timestamp, &output);
+    Append<uint32_t>(entry->num_events, &output);
+    Append<uint8_t>(entry->processor_number, &output);
+    output.append(3, '\0');
+  }
+  DCHECK_EQ(kHeaderSize + entries_.size() * kEntrySize, output.size());
+
+  FILE* file = OpenFileForWriting(path);
+  if (file == NULL)
+    return false;
+  // A truncated index file is rejected by Load().
+  bool written = ::fwrite(output.data(), 1, output.size(), file) ==
+      output.size();
+  if (::fclose(file) != 0)
+    written = false;
+  return written;
+}
+
+void EtlIndex::FindBuffers(uint64_t begin,
+                           uint64_t end,
+                           std::vector<size_t>* entries) const {
+  DCHECK(entries != NULL);
+
+  // The buffers of a processor are in timestamp order: the first buffer in
+  // the range is found by a binary search.
+  LastTimestampLess less(&entries_);
+  std::vector<std::vector<size_t>>::const_iterator processor =
+      processor_entries_.begin();
+  for (; processor != processor_entries_.end(); ++processor) {
+    std::vector<size_t>::const_iterator entry = std::lower_bound(
+        processor->begin(), processor->end(), begin, less);
+    for (; entry != processor->end() &&
+           entries_[*entry].first_timestamp <= end;
+         ++entry) {
+      entries->push_back(*entry);
+    }
+  }
+
+  std::sort(entries->begin(), entries->end());
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,166 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An index of the buffers of an ETW trace file, used to read only the
+// buffers which hold the events of a time range. For each buffer holding
+// events, the index records its offset in the trace file, its processor and
+// the timestamps of its first and last events, in system time.
+//
+// Building the index reads the headers of every event of the trace without
+// decoding their payloads. The index is saved in a sidecar file next to the
+// trace (trace.etl.idx), so that the next parsing of the trace can use it
+// without reading the whole trace. The index records the identity of its
+// trace: the index of an older trace written at the same path is rejected.
+//
+// Example:
+//   EtlIndex index;
+//   EtlTraceId trace_id =
+//       EtlIndex::GetTraceId(trace_size, buffer_size, clock);
+//   if (!index.Load(EtlIndex::GetIndexPath(path), trace_id)) {
+//     index.Build(data, buffers, trace_id, clock);
+//     index.Save(EtlIndex::GetIndexPath(path));
+//   }
+//   std::vector<size_t> entries;
+//   index.FindBuffers(begin, end, &entries);
+
+#ifndef PARSER_ETW_ETL_INDEX_H_
+#define PARSER_ETW_ETL_INDEX_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "parser/etw/etl_format.h"
+
+namespace parser {
+namespace etw {
+
+// The index entry of a buffer holding events.
+struct EtlIndexEntry {
+  // The offset of the buffer in the trace file.
+  uint64_t offset;
+  // The timestamps of the first and last events of the buffer, in system
+  // time.
+  uint64_t first_timestamp;
+  uint64_t last_timestamp;
+  // The number of events in the buffer.
+  uint32_t num_events;
+  // The processor which filled the buffer.
+  uint8_t processor_number;
+};
+
+// Identifies the trace file indexed by an index.
+struct EtlTraceId {
+  uint64_t trace_size;
+  uint32_t buffer_size;
+  // The system time and the raw timestamp of the header event of the trace.
+  // A new trace written at the same path may have the same size, but not the
+  // same start time.
+  uint64_t start_time;
+  uint64_t start_raw_timestamp;
+};
+
+// The index of the buffers of a trace file.
+class EtlIndex {
+ public:
+  // Version of the format of the index files.
+  static const uint32_t kVersion = 2;
+
+  EtlIndex();
+
+  // @param trace_path the path of a trace file.
+  // @returns the path of the index file of the trace.
+  static std::wstring GetIndexPath(const std::wstring& trace_path);
+
+  // @param trace_size the size of a trace file.
+  // @param buffer_size the size of the buffers of the trace.
+  // @param clock the clock of the trace.
+  // @returns the identity of the trace.
+  static EtlTraceId GetTraceId(uint64_t trace_size,
+                               uint32_t buffer_size,
+                               const EtlClock& clock);
+
+  // Builds the index of the buffers of a trace file.
+  // @param data the content of the trace file.
+  // @param buffers the buffers of the trace, in file order.
+  // @param trace_id the identity of the trace.
+  // @param clock the clock of the trace.
+  void Build(const char* data,
+             const std::vector<EtlBuffer>& buffers,
+             const EtlTraceId& trace_id,
+             const EtlClock& clock);
+
+  // Clears the index and sets the trace it indexes.
+  // @param trace_id the identity of the trace.
+  void Reset(const EtlTraceId& trace_id);
+
+  // Adds the entry of a buffer. The buffers of a processor must be added in
+  // file order.
+  // @param entry the entry to add.
+  void AddEntry(const EtlIndexEntry& entry);
+
+  // Loads an index file. The index is rejected if it was not built for a
+  // trace with the same identity.
+  // @param path the path of the index file.
+  // @param trace_id the identity of the indexed trace.
+  // @returns true if the index is loaded, false otherwise.
+  bool Load(const std::wstring& path, const EtlTraceId& trace_id);
+
+  // Saves the index in a file.
+  // @param path the path of the index file.
+  // @returns true if the index is saved, false otherwise.
+  bool Save(const std::wstring& path) const;
+
+  // Finds the buffers which may hold events in a time range.
+  // @param begin the first timestamp of the range.
+  // @param end the last timestamp of the range.
+  // @param entries receives the indexes of the entries of the buffers, in
+  //     file order.
+  void FindBuffers(uint64_t begin,
+                   uint64_t end,
+                   std::vector<size_t>* entries) const;
+
+  // @returns the entries of the index, in the order they were added.
+  const std::vector<EtlIndexEntry>& entries() const { return entries_; }
+
+  // @returns the identity of the indexed trace.
+  const EtlTraceId& trace_id() const { return trace_id_; }
+
+ private:
+  EtlTraceId trace_id_;
+
+  std::vector<EtlIndexEntry> entries_;
+
+  // The indexes of the entries of each processor, in file order.
+  std::vector<std::vector<size_t>> processor_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(EtlIndex);
+};
+
+}  // namespace etw
+}  // namespace parser
+
+#endif  // PARSER_ETW_ETL_INDEX_H_
@@ -0,0 +1,159 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etl_index.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "base/string_utils.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+const char kIndexPath[] = "etl_index_unittest.idx";
+
+EtlIndexEntry CreateEntry(uint64_t offset,
+                          uint8_t processor_number,
+                          uint64_t first_timestamp,
+                          uint64_t last_timestamp) {
+  EtlIndexEntry entry = {};
+  entry.offset = offset;
+  entry.processor_number = processor_number;
+  entry.first_timestamp = first_timestamp;
+  entry.last_timestamp = last_timestamp;
+  entry.num_events = 1;
+  return entry;
+}
+
+// Adds the buffers of 2 processors: processor 0 holds [0, 99], [100, 199],
+// ... and processor 1 holds [50, 149], [150, 249], ...
+void AddEntries(EtlIndex* index) {
+  for (uint64_t i = 0; i < 5; ++i) {
+    index->AddEntry(CreateEntry(2 * i * 64, 0, i * 100, i * 100 + 99));
+    index->AddEntry(CreateEntry((2 * i + 1) * 64, 1, i * 100 + 50,
+                                i * 100 + 149));
+  }
+}
+
+}  // namespace
+
+TEST(EtlIndexTest, GetIndexPath) {
+  EXPECT_EQ(L"trace.etl.idx", EtlIndex::GetIndexPath(L"trace.etl"));
+}
+
+TEST(EtlIndexTest, FindBuffers) {
+  EtlIndex index;
+  AddEntries(&index);
+
+  std::vector<size_t> entries;
+  index.FindBuffers(120, 160, &entries);
+  EXPECT_EQ(std::vector<size_t>({ 1, 2, 3 }), entries);
+
+  entries.clear();
+  index.FindBuffers(0, 10, &entries);
+  EXPECT_EQ(std::vector<size_t>({ 0 }), entries);
+
+  entries.clear();
+  index.FindBuffers(440, 1000, &entries);
+  EXPECT_EQ(std::vector<size_t>({ 7, 8, 9 }), entries);
+
+  entries.clear();
+  index.FindBuffers(1000, 2000, &entries);
+  EXPECT_TRUE(entries.empty());
+}
+
+TEST(EtlIndexTest, SaveAndLoad) {
+  const std::wstring path = base::StringToWString(kIndexPath);
+  const uint64_t kTraceSize = 10 * 64;
+  const uint32_t kBufferSize = 64;
+  const EtlTraceId kTraceId = { kTraceSize, kBufferSize, 5000, 1000 };
+
+  {
+    EtlIndex index;
+    index.Reset(kTraceId);
+    AddEntries(&index);
+    ASSERT_TRUE(index.Save(path));
+  }
+
+  EtlIndex index;
+  ASSERT_TRUE(index.Load(path, kTraceId));
+  EXPECT_EQ(kTraceSize, index.trace_id().trace_size);
+  EXPECT_EQ(kBufferSize, index.trace_id().buffer_size);
+  EXPECT_EQ(5000U, index.trace_id().start_time);
+  EXPECT_EQ(1000U, index.trace_id().start_raw_timestamp);
+  ASSERT_EQ(10U, index.entries().size());
+  EXPECT_EQ(64U * 3, index.entries()[3].offset);
+  EXPECT_EQ(1U, index.entries()[3].processor_number);
+  EXPECT_EQ(150U, index.entries()[3].first_timestamp);
+  EXPECT_EQ(249U, index.entries()[3].last_timestamp);
+  EXPECT_EQ(1U, index.entries()[3].num_events);
+
+  std::vector<size_t> entries;
+  index.FindBuffers(120, 160, &entries);
+  EXPECT_EQ(std::vector<size_t>({ 1, 2, 3 }), entries);
+
+  // The index of another trace is rejected.
+  const EtlTraceId kLargerTraceId = { kTraceSize + 64, kBufferSize, 5000,
+                                      1000 };
+  EXPECT_FALSE(index.Load(path, kLargerTraceId));
+  const EtlTraceId kLargerBuffersTraceId = { kTraceSize, kBufferSize * 2,
+                                             5000, 1000 };
+  EXPECT_FALSE(index.Load(path, kLargerBuffersTraceId));
+  EXPECT_TRUE(index.entries().empty());
+
+  // So is the index of a trace of the same size which started at another
+  // time.
+  const EtlTraceId kLaterTraceId = { kTraceSize, kBufferSize, 6000, 1000 };
+  EXPECT_FALSE(index.Load(path, kLaterTraceId));
+  const EtlTraceId kOtherClockTraceId = { kTraceSize, kBufferSize, 5000,
+                                          2000 };
+  EXPECT_FALSE(index.Load(path, kOtherClockTraceId));
+  EXPECT_TRUE(index.entries().empty());
+
+  remove(kIndexPath);
+}
+
+TEST(EtlIndexTest, LoadInvalidFile) {
+  EtlIndex index;
+  const EtlTraceId kTraceId = { 64, 64, 0, 0 };
+  EXPECT_FALSE(index.Load(L"do_not_exist.idx", kTraceId));
+
+  FILE* output = fopen(kIndexPath, "wb");
+  ASSERT_TRUE(output != NULL);
+  const char kContent[] = "not an index file, not an index file";
+  fwrite(kContent, 1, sizeof(kContent), output);
+  fclose(output);
+
+  EXPECT_FALSE(index.Load(base::StringToWString(kIndexPath), kTraceId));
+  remove(kIndexPath);
+}
+
+}  // namespace etw
+}  // namespace parser
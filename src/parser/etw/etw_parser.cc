@@ -25,12 +25,18 @@
 
 #include "parser/etw/etw_parser.h"
 
+#include <cstring>
+
+#include "base/guid.h"
 #include "base/logging.h"
 #include "base/string_utils.h"
 #include "base/win/error_string.h"
+#include "event/atom.h"
 #include "event/event.h"
+#include "event/event_header.h"
 #include "event/value.h"
 #include "parser/etw/etw_raw_kernel_payload_decoder.h"
+#include "parser/event_filter.h"
 
 namespace parser {
 namespace etw {
@@ -39,49 +45,35 @@ namespace {
 
 using event::Event;
 using event::IntValue;
-using event::StringValue;
-using event::StructValue;
 using event::Timestamp;
-using event::UCharValue;
-using event::ULongValue;
 using event::Value;
 
 // Constant used to convert the frequency of the high-resolution performance
 // counter to a period, in ns.
 const double kPerfPeriodMultiplier = 10000000.0;
 
-//  Convert a GUID to a string representation.
-std::string GuidToString(const GUID& guid) {
-  const int kMaxGuidStringLength = 38;
-  char buffer[kMaxGuidStringLength];
-  sprintf_s(buffer, kMaxGuidStringLength,
-      "%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X",
-      guid.Data1,
-      guid.Data2,
-      guid.Data3,
-      guid.Data4[0],
-      guid.Data4[1],
-      guid.Data4[2],
-      guid.Data4[3],
-      guid.Data4[4],
-      guid.Data4[5],
-      guid.Data4[6],
-      guid.Data4[7]);
-  return std::string(buffer);
+// Converts a Windows GUID to its portable binary representation.
+base::Guid ToGuid(const GUID& guid) {
+  static_assert(sizeof(base::Guid) == sizeof(GUID),
+                "base::Guid must have the layout of GUID.");
+  base::Guid result;
+  memcpy(&result, &guid, sizeof(result));
+  return result;
 }
 
-bool DecodeRawETWPayload(const std::string& provider_id,
+bool DecodeRawETWPayload(const base::Guid& provider_id,
                          unsigned char version,
                          unsigned char opcode,
                          bool is_64_bit,
                          const char* payload,
                          size_t payload_size,
-                         std::string* operation,
-                         std::string* category,
-                         std::unique_ptr<event::Value>* decoded_payload) {
+                         event::ValueArena* arena,
+                         const FieldProjection* projection,
+                         const event::Value** decoded_payload) {
+  // The names of the event are not needed: its type is already known.
   if (DecodeRawETWKernelPayload(
           provider_id, version, opcode, is_64_bit, payload, payload_size,
-          operation, category, decoded_payload)) {
+          arena, projection, NULL, NULL, decoded_payload)) {
     return true;
   }
   return false;
@@ -93,70 +85,66 @@ ETWParser::ETWParser()
     : event_callback_(nullptr),
       first_event_system_ts_(0),
       first_event_raw_ts_(0),
-      perf_period_(0) {
+      perf_period_(0),
+      lazy_payloads_(false) {
 }
 
 bool ETWParser::AddTraceFile(const std::wstring& path) {
-  if (!traces_.empty()) {
+  if (!trace_.empty()) {
     LOG(ERROR) << "ETW Parser can only read one trace at a time.";
     return false;
   }
   if (!base::WStringEndsWith(path, L".etl")) {
     return false;
   }
-  traces_.push_back(path);
+  trace_ = path;
   return true;
 }
 
+std::unique_ptr<parser::ParserImpl> ETWParser::NewInstance() const {
+  std::unique_ptr<ETWParser> instance(new ETWParser());
+  instance->set_lazy_payloads(lazy_payloads_);
+  return std::move(instance);
+}
+
 void ETWParser::Parse(const EventCallback& callback) {
   DCHECK(event_callback_ == nullptr);
   DCHECK_EQ(first_event_system_ts_, 0);
   DCHECK_EQ(first_event_raw_ts_, 0);
   DCHECK_EQ(perf_period_, 0);
-  DCHECK_LE(traces_.size(), 1);
+
+  if (trace_.empty())
+    return;
 
   // Initialize the parser.
   event_callback_ = &callback;
 
-  // Open all trace files, and keep handles in a vector.
-  bool error = false;
-  std::vector<TRACEHANDLE> handles;
-  for (size_t i = 0; i < traces_.size(); ++i) {
-    EVENT_TRACE_LOGFILE trace;
-    ::memset(&trace, 0, sizeof(trace));
-    trace.LogFileName = const_cast<LPWSTR>(traces_[i].c_str());
-    trace.ProcessTraceMode = PROCESS_TRACE_MODE_EVENT_RECORD |
-        PROCESS_TRACE_MODE_RAW_TIMESTAMP;
-    trace.EventRecordCallback = &ETWParser::ProcessEvent;
-    trace.Context = this;
-
-    TRACEHANDLE th = ::OpenTrace(&trace);
-    if (th == INVALID_PROCESSTRACE_HANDLE) {
-      LOG(WARNING) << "OpenTrace failed with error "
-                   << base::GetLastWindowsErrorString();
-      error = true;
-      break;
-    }
-
+  // Open the trace file.
+  EVENT_TRACE_LOGFILE trace;
+  ::memset(&trace, 0, sizeof(trace));
+  trace.LogFileName = const_cast<LPWSTR>(trace_.c_str());
+  trace.ProcessTraceMode = PROCESS_TRACE_MODE_EVENT_RECORD |
+      PROCESS_TRACE_MODE_RAW_TIMESTAMP;
+  trace.EventRecordCallback = &ETWParser::ProcessEvent;
+  trace.BufferCallback = &ETWParser::ProcessBuffer;
+  trace.Context = this;
+
+  TRACEHANDLE th = ::OpenTrace(&trace);
+  if (th == INVALID_PROCESSTRACE_HANDLE) {
+    LOG(WARNING) << "OpenTrace failed with error "
+                 << base::GetLastWindowsErrorString();
+  } else {
     first_event_system_ts_ = trace.LogfileHeader.StartTime.QuadPart;
     perf_period_ =
         kPerfPeriodMultiplier / trace.LogfileHeader.PerfFreq.QuadPart;
 
-    handles.push_back(th);
-  }
-
-  if (!error && !handles.empty()) {
-    // Ask the ETW API to consume all traces and call the registered callbacks.
-    ULONG status = ::ProcessTrace(&handles[0], traces_.size(), NULL, NULL);
+    // Ask the ETW API to consume the trace and call the registered callbacks.
+    ULONG status = ::ProcessTrace(&th, 1, NULL, NULL);
     if (status != ERROR_SUCCESS) {
       LOG(ERROR) << "ProcessTrace failed with error " << status << ".";
     }
-  }
 
-  // Close all trace files.
-  for (size_t i = 0; i < handles.size(); ++i) {
-    DCHECK(handles[i] != NULL);
-    ::CloseTrace(handles[i]);
+    ::CloseTrace(th);
   }
 
   // Reset the parser.
@@ -166,55 +154,96 @@ void ETWParser::Parse(const EventCallback& callback) {
   perf_period_ = 0;
 }
 
+ULONG WINAPI ETWParser::ProcessBuffer(PEVENT_TRACE_LOGFILE logfile) {
+  DCHECK(logfile != NULL);
+  ETWParser* event_parser = reinterpret_cast<ETWParser*>(logfile->Context);
+
+  // Returning FALSE stops ProcessTrace().
+  return event_parser->cancelled() ? FALSE : TRUE;
+}
+
 void WINAPI ETWParser::ProcessEvent(PEVENT_RECORD pevent) {
   DCHECK(pevent != NULL);
   ETWParser* event_parser = reinterpret_cast<ETWParser*>(pevent->UserContext);
   DCHECK(event_parser->event_callback_ != nullptr);
 
+  // The remaining events of the buffer are ignored after a cancellation.
+  if (event_parser->cancelled())
+    return;
+
   // Record the timestamp of the first event. It will be used to convert raw
   // timestamps to system time.
   if (event_parser->first_event_raw_ts_ == 0)
     event_parser->first_event_raw_ts_ = pevent->EventHeader.TimeStamp.QuadPart;
 
-  // Decode the payload of the event.
-  std::string operation;
-  std::string category;
-
-  std::string provider_guid = GuidToString(pevent->EventHeader.ProviderId);
-  std::unique_ptr<Value> payload;
-  if (!DecodeRawETWPayload(
-      provider_guid,
-      pevent->EventHeader.EventDescriptor.Version,
-      pevent->EventHeader.EventDescriptor.Opcode,
-      (pevent->EventHeader.Flags & EVENT_HEADER_FLAG_64_BIT_HEADER) != 0,
-      reinterpret_cast<const char*>(pevent->UserData),
-      pevent->UserDataLength,
-      &operation,
-      &category,
-      &payload)) {
-      return;
-  }
-
-  // Generate the event header fields.
-  std::unique_ptr<StructValue> header(new StructValue());
-  header->AddField<StringValue>(event::kOperationFieldName, operation);
-  header->AddField<StringValue>(event::kCategoryFieldName, category);
-  header->AddField<ULongValue>(event::kProcessIdFieldName, pevent->EventHeader.ProcessId);
-  header->AddField<ULongValue>(event::kThreadIdFieldName, pevent->EventHeader.ThreadId);
-  header->AddField<UCharValue>(event::kProcessorNumberFieldName,
-      pevent->BufferContext.ProcessorNumber);
-
   // Compute the timestamp.
   uint64_t raw_ts = pevent->EventHeader.TimeStamp.QuadPart;
   uint64_t system_ts = event_parser->first_event_system_ts_ +
       static_cast<uint64_t>((raw_ts - event_parser->first_event_raw_ts_) *
           event_parser->perf_period_);
 
-  // Create the event with decoded fields.
-  Event event(Timestamp(system_ts), std::move(header), std::move(payload));
+  // Check the filter against the raw header, before decoding anything.
+  base::Guid provider_guid = ToGuid(pevent->EventHeader.ProviderId);
+  unsigned char opcode = pevent->EventHeader.EventDescriptor.Opcode;
+  const EventFilter* filter = event_parser->filter();
+  const FieldProjection* projection = NULL;
+  if (filter != NULL) {
+    if (!filter->Accepts(provider_guid, opcode, pevent->EventHeader.ProcessId,
+                         pevent->EventHeader.ThreadId, system_ts)) {
+      return;
+    }
+    projection = filter->GetProjection(provider_guid, opcode);
+  }
+
+  // Fill the typed header of the event. The type is found without decoding
+  // the payload.
+  event::EventHeader header;
+  unsigned char version = pevent->EventHeader.EventDescriptor.Version;
+  bool is_64_bit =
+      (pevent->EventHeader.Flags & EVENT_HEADER_FLAG_64_BIT_HEADER) != 0;
+  if (!LookupRawETWKernelEvent(provider_guid, version, opcode, is_64_bit,
+                               &header.type)) {
+    return;
+  }
+  header.process_id = pevent->EventHeader.ProcessId;
+  header.thread_id = pevent->EventHeader.ThreadId;
+  header.processor_number = pevent->BufferContext.ProcessorNumber;
+  header.flags = pevent->EventHeader.Flags;
+
+  // The decoded values are allocated in the arena of the parser and their
+  // strings point into the event record. They only live until the callback
+  // returns.
+  event::ValueArena* arena = &event_parser->arena_;
+  const char* raw_payload = reinterpret_cast<const char*>(pevent->UserData);
+  const Value* payload = NULL;
+  if (!event_parser->lazy_payloads_ && !DecodeRawETWPayload(
+      provider_guid,
+      version,
+      opcode,
+      is_64_bit,
+      raw_payload,
+      pevent->UserDataLength,
+      arena,
+      projection,
+      &payload)) {
+      arena->Reset();
+      return;
+  }
 
   // Send the event to the callback.
-  (*event_parser->event_callback_)(event);
+  if (event_parser->lazy_payloads_) {
+    LazyRawETWKernelPayload lazy_payload(
+        provider_guid, version, opcode, is_64_bit, raw_payload,
+        pevent->UserDataLength, arena, projection);
+    Event event(Timestamp(system_ts), header, &lazy_payload);
+    (*event_parser->event_callback_)(event);
+  } else {
+    Event event(Timestamp(system_ts), header, payload);
+    (*event_parser->event_callback_)(event);
+  }
+
+  // Release the values of this event.
+  arena->Reset();
 }
 
 }  // namespace etw
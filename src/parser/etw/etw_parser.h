@@ -32,17 +32,20 @@
 #include <evntcons.h>  // NOLINT
 
 #include <functional>
+#include <memory>
 #include <string>
-#include <vector>
 
 #include "base/base.h"
 #include "event/event.h"
+#include "event/value_arena.h"
 #include "parser/parser.h"
 
 namespace parser {
 namespace etw {
 
-// Generate Event objects from ETW trace files.
+// Generate Event objects from ETW trace files. Each trace file is parsed by
+// its own instance, with the clock of this trace. Parser merges the events of
+// the instances on their system timestamps (see event_merger.h).
 class ETWParser : public parser::ParserImpl {
  public:
   typedef parser::ParserImpl::EventCallback EventCallback;
@@ -50,22 +53,43 @@ class ETWParser : public parser::ParserImpl {
   // Constuctor.
   ETWParser();
 
-  // Adds a trace file to the list of traces to parse.
+  // Adds a trace file to parse. Each instance parses a single trace file.
   // @param path absolute path to the trace file.
+  // @returns true if the trace is an .etl file and no trace file was added
+  //     yet, false otherwise.
   bool AddTraceFile(const std::wstring& path) override;
 
-  // Parses the trace files added with AddTraceFile() and sends the resulting
+  // Parses the trace file added with AddTraceFile() and sends the resulting
   // events to the provided callback.
   // @param callback a callback that will receive the decoded events.
   void Parse(const EventCallback& callback) override;
 
+  // Each trace file is parsed by its own instance.
+  bool ParsesEachFileSeparately() const override { return true; }
+
+  // Creates a new ETW parser with the same options.
+  std::unique_ptr<parser::ParserImpl> NewInstance() const override;
+
+  // Enables the lazy decoding of payloads: the payload of an event is only
+  // decoded when the callback calls Event::payload(). Events whose payload
+  // fails to decode then reach the callback, with a NULL payload.
+  // @param lazy_payloads whether payloads are decoded on first access.
+  void set_lazy_payloads(bool lazy_payloads) {
+    lazy_payloads_ = lazy_payloads;
+  }
+
  private:
   // Called by the ETW API when an event is read.
   // @param pevent the read event.
   static void WINAPI ProcessEvent(PEVENT_RECORD pevent);
 
-  // Trace files to consume.
-  std::vector<std::wstring> traces_;
+  // Called by the ETW API after each buffer of events is processed.
+  // @param logfile the trace being processed.
+  // @returns TRUE to continue processing the trace, FALSE to stop.
+  static ULONG WINAPI ProcessBuffer(PEVENT_TRACE_LOGFILE logfile);
+
+  // Trace file to consume.
+  std::wstring trace_;
 
   // Active event callback.
   const EventCallback* event_callback_;
@@ -80,6 +104,13 @@ class ETWParser : public parser::ParserImpl {
   // timestamp conversion.
   double perf_period_;
 
+  // Arena holding the values of the event being processed. It is reset after
+  // each event is sent to the callback.
+  event::ValueArena arena_;
+
+  // Indicates whether payloads are decoded on first access.
+  bool lazy_payloads_;
+
   DISALLOW_COPY_AND_ASSIGN(ETWParser);
 };
 
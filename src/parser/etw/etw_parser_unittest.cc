@@ -58,6 +58,20 @@ TEST(EtwParserTest, AddTraceFile) {
   EXPECT_TRUE(parser.AddTraceFile(L"dummy.etl"));
 }
 
+TEST(EtwParserTest, AddTraceFiles) {
+  // An instance parses a single trace file.
+  parser::etw::ETWParser etw_parser;
+  EXPECT_TRUE(etw_parser.AddTraceFile(L"kernel.etl"));
+  EXPECT_FALSE(etw_parser.AddTraceFile(L"user.etl"));
+
+  // The parser creates an instance for each trace file.
+  parser::Parser parser;
+  parser.RegisterParser(std::unique_ptr<parser::ParserImpl>(
+      new parser::etw::ETWParser()));
+  EXPECT_TRUE(parser.AddTraceFile(L"kernel.etl"));
+  EXPECT_TRUE(parser.AddTraceFile(L"user.etl"));
+}
+
 TEST(EtwParserTest, ParseWithoutTrace) {
   std::unique_ptr<parser::ParserImpl> impl(new parser::etw::ETWParser());
   MockObserver observer;
@@ -0,0 +1,542 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_payload_layout.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/logging.h"
+#include "event/packed_array_value.h"
+#include "event/string_view_value.h"
+#include "parser/etw/etw_raw_payload_decoder_utils.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+using event::Atom;
+using event::SchemaStructValue;
+using event::StructSchema;
+using event::StructValue;
+
+bool AppliesTo(VersionRange versions, unsigned char version) {
+  return version >= versions.min_version && version <= versions.max_version;
+}
+
+bool AppliesTo(PointerSize pointer_size, bool is_64_bit) {
+  if (pointer_size == k32BitOnly)
+    return !is_64_bit;
+  if (pointer_size == k64BitOnly)
+    return is_64_bit;
+  return true;
+}
+
+// Returns the size of a field in bytes, or 0 if it has a variable size.
+size_t FieldSize(FieldType type, size_t count) {
+  switch (type) {
+    case kFieldChar:
+    case kFieldUChar:
+      return 1;
+    case kFieldShort:
+    case kFieldUShort:
+      return 2;
+    case kFieldInt:
+    case kFieldUInt:
+      return 4;
+    case kFieldLong:
+    case kFieldULong:
+      return 8;
+    case kFieldPadding:
+    case kFieldUCharArray:
+      return count;
+    default:
+      return 0;
+  }
+}
+
+// The scalar types come first in FieldType.
+bool IsScalar(FieldType type) {
+  return type <= kFieldULong;
+}
+
+// Adds a scalar read from |bytes| to a dynamic structure.
+template<class T>
+bool AddScalar(Atom name, const char* bytes, StructValue* fields) {
+  typename T::ScalarType value;
+  ::memcpy(&value, bytes, sizeof(value));
+  return fields->AddField<T>(name, value);
+}
+
+// Appends a scalar read from |bytes| to a structure with a schema.
+template<class T>
+bool AddScalar(Atom /* name */, const char* bytes, SchemaStructValue* fields) {
+  typename T::ScalarType value;
+  ::memcpy(&value, bytes, sizeof(value));
+  return fields->Append<T>(value);
+}
+
+template<class Fields>
+bool AddScalarField(FieldType type,
+                    Atom name,
+                    const char* bytes,
+                    Fields* fields) {
+  switch (type) {
+    case kFieldChar:
+      return AddScalar<event::CharValue>(name, bytes, fields);
+    case kFieldUChar:
+      return AddScalar<event::UCharValue>(name, bytes, fields);
+    case kFieldShort:
+      return AddScalar<event::ShortValue>(name, bytes, fields);
+    case kFieldUShort:
+      return AddScalar<event::UShortValue>(name, bytes, fields);
+    case kFieldInt:
+      return AddScalar<event::IntValue>(name, bytes, fields);
+    case kFieldUInt:
+      return AddScalar<event::UIntValue>(name, bytes, fields);
+    case kFieldLong:
+      return AddScalar<event::LongValue>(name, bytes, fields);
+    case kFieldULong:
+      return AddScalar<event::ULongValue>(name, bytes, fields);
+    default:
+      LOG(ERROR) << "Unexpected scalar field type.";
+      return false;
+  }
+}
+
+void AddSchemaField(FieldType type, const char* name, StructSchema* schema) {
+  switch (type) {
+    case kFieldChar:
+      schema->AddField<event::CharValue>(name);
+      break;
+    case kFieldUChar:
+      schema->AddField<event::UCharValue>(name);
+      break;
+    case kFieldShort:
+      schema->AddField<event::ShortValue>(name);
+      break;
+    case kFieldUShort:
+      schema->AddField<event::UShortValue>(name);
+      break;
+    case kFieldInt:
+      schema->AddField<event::IntValue>(name);
+      break;
+    case kFieldUInt:
+      schema->AddField<event::UIntValue>(name);
+      break;
+    case kFieldLong:
+      schema->AddField<event::LongValue>(name);
+      break;
+    case kFieldULong:
+      schema->AddField<event::ULongValue>(name);
+      break;
+    default:
+      LOG(ERROR) << "Unexpected scalar field type.";
+  }
+}
+
+}  // namespace
+
+PayloadDecoder::PayloadDecoder(const std::vector<FieldLayout>& fields,
+                               unsigned char version,
+                               bool is_64_bit)
+    : value_count_(0),
+      prefix_count_(0),
+      prefix_size_(0),
+      is_64_bit_(is_64_bit) {
+  bool in_prefix = true;
+  bool fixed_layout = true;
+  for (const FieldLayout& layout : fields) {
+    if (!AppliesTo(layout.versions, version) ||
+        !AppliesTo(layout.pointer_size, is_64_bit)) {
+      continue;
+    }
+
+    Field field = {};
+    field.type = layout.type;
+    if (field.type == kFieldPointer)
+      field.type = is_64_bit ? kFieldULong : kFieldUInt;
+    field.count = layout.count;
+    field.size = FieldSize(field.type, field.count);
+    field.label = layout.name;
+    if (field.type != kFieldPadding) {
+      DCHECK(layout.name != NULL);
+      field.name = Atom::Intern(layout.name);
+      ++value_count_;
+    }
+
+    if (field.size == 0 ||
+        (field.type != kFieldPadding && !IsScalar(field.type))) {
+      fixed_layout = false;
+    }
+    if (field.size == 0)
+      in_prefix = false;
+    if (in_prefix) {
+      ++prefix_count_;
+      prefix_size_ += field.size;
+    }
+
+    fields_.push_back(field);
+  }
+
+  if (fixed_layout) {
+    schema_.reset(new StructSchema());
+    for (const Field& field : fields_) {
+      if (field.type != kFieldPadding)
+        AddSchemaField(field.type, field.label, schema_.get());
+    }
+  }
+}
+
+StructValue* PayloadDecoder::CreateFields(
+    event::ValueArena* arena, const FieldProjection* projection) const {
+  // A projected payload lacks fields of the schema.
+  if (schema_.get() != NULL && projection == NULL) {
+    if (arena != NULL)
+      return arena->New<SchemaStructValue>(schema_.get(), arena);
+    return new SchemaStructValue(schema_.get());
+  }
+  StructValue* fields = NULL;
+  if (arena != NULL)
+    fields = arena->New<StructValue>(arena);
+  else
+    fields = new StructValue();
+
+  // Reserve the fields, so that growing them doesn't strand buffers in the
+  // arena.
+  size_t count = value_count_;
+  if (projection != NULL)
+    count = std::min(count, projection->size());
+  fields->Reserve(count);
+  return fields;
+}
+
+bool PayloadDecoder::Decode(Decoder* decoder,
+                            const FieldProjection* projection,
+                            StructValue* fields) const {
+  DCHECK(decoder != NULL);
+  DCHECK(fields != NULL);
+  DCHECK(fields->schema() == NULL || fields->schema() == schema_.get());
+  DCHECK(fields->schema() == NULL || projection == NULL);
+
+  if (is_64_bit_)
+    return DecodeFields<event::ULongValue>(decoder, projection, fields);
+  return DecodeFields<event::UIntValue>(decoder, projection, fields);
+}
+
+template <class PointerType>
+bool PayloadDecoder::DecodeFields(Decoder* decoder,
+                                  const FieldProjection* projection,
+                                  StructValue* fields) const {
+  // Decode the fixed-size prefix with a single bounds check.
+  const char* bytes = NULL;
+  if (prefix_size_ != 0 && !decoder->DecodeBytes(prefix_size_, &bytes))
+    return false;
+
+  bool decoded = false;
+  if (fields->schema() != NULL) {
+    decoded = DecodePrefix(bytes, projection,
+                           static_cast<SchemaStructValue*>(fields));
+  } else {
+    decoded = DecodePrefix(bytes, projection, fields);
+  }
+  if (!decoded)
+    return false;
+
+  // The remaining fields follow a variable-size field.
+  for (size_t i = prefix_count_; i < fields_.size(); ++i) {
+    const Field& field = fields_[i];
+    bool decoded = false;
+    if (projection != NULL && field.type != kFieldPadding &&
+        !projection->Contains(field.name)) {
+      decoded = SkipVariableField<PointerType>(field, decoder);
+    } else {
+      decoded = DecodeVariableField<PointerType>(field, decoder, fields);
+    }
+    if (!decoded)
+      return false;
+  }
+
+  return true;
+}
+
+template <class StructType>
+bool PayloadDecoder::DecodePrefix(const char* bytes,
+                                  const FieldProjection* projection,
+                                  StructType* fields) const {
+  size_t offset = 0;
+  for (size_t i = 0; i < prefix_count_; ++i) {
+    const Field& field = fields_[i];
+    const char* field_bytes = bytes + offset;
+    offset += field.size;
+
+    if (field.type == kFieldPadding)
+      continue;
+    if (projection != NULL && !projection->Contains(field.name))
+      continue;
+
+    if (field.type == kFieldUCharArray) {
+      event::PackedArrayValue<event::UCharValue>* array =
+          fields->template AddPackedArrayField<event::UCharValue>(field.name);
+      if (array == NULL)
+        return false;
+      array->AppendRaw(field_bytes, field.count);
+      continue;
+    }
+
+    if (!AddScalarField(field.type, field.name, field_bytes, fields))
+      return false;
+  }
+
+  return true;
+}
+
+template <class PointerType>
+bool PayloadDecoder::DecodeVariableField(const Field& field,
+                                         Decoder* decoder,
+                                         StructValue* fields) const {
+  DCHECK(decoder != NULL);
+  DCHECK(fields != NULL);
+
+  switch (field.type) {
+    case kFieldPadding:
+      return decoder->Skip(field.count);
+
+    case kFieldUCharArray: {
+      event::PackedArrayValue<event::UCharValue>* array =
+          fields->AddPackedArrayField<event::UCharValue>(field.name);
+      return array != NULL &&
+             decoder->DecodeArray<event::UCharValue>(field.count, array);
+    }
+
+    case kFieldULongTrailingArray: {
+      size_t length = decoder->RemainingBytes() / sizeof(uint64_t);
+      event::PackedArrayValue<event::ULongValue>* array =
+          fields->AddPackedArrayField<event::ULongValue>(field.name);
+      return array != NULL &&
+             decoder->DecodeArray<event::ULongValue>(length, array);
+    }
+
+    case kFieldString: {
+      if (decoder->use_string_views()) {
+        base::Span<const char> view;
+        return decoder->DecodeStringView(&view) &&
+               fields->AddField<event::StringViewValue>(field.name, view);
+      }
+      std::string decoded;
+      return decoder->DecodeString(&decoded) &&
+             fields->AddField<event::StringValue>(field.name, decoded);
+    }
+
+    case kFieldW16String: {
+      if (decoder->use_string_views()) {
+        base::Span<const char> view;
+        return decoder->DecodeW16StringView(&view) &&
+               fields->AddField<event::W16StringViewValue>(field.name, view);
+      }
+      std::wstring decoded;
+      return decoder->DecodeW16String(&decoded) &&
+             fields->AddField<event::WStringValue>(field.name, decoded);
+    }
+
+    case kFieldSID:
+      return DecodeSID<PointerType>(field.label, decoder, fields);
+
+    case kFieldTimeZoneInformation:
+      return DecodeTimeZoneInformation(field.label, decoder, fields);
+
+    default: {
+      const char* bytes = NULL;
+      return decoder->DecodeBytes(field.size, &bytes) &&
+             AddScalarField(field.type, field.name, bytes, fields);
+    }
+  }
+}
+
+template <class PointerType>
+bool PayloadDecoder::SkipVariableField(const Field& field,
+                                       Decoder* decoder) const {
+  DCHECK(decoder != NULL);
+
+  switch (field.type) {
+    case kFieldUCharArray:
+      return decoder->Skip(field.count);
+
+    case kFieldULongTrailingArray: {
+      size_t length = decoder->RemainingBytes() / sizeof(uint64_t);
+      return decoder->Skip(length * sizeof(uint64_t));
+    }
+
+    case kFieldString: {
+      base::Span<const char> view;
+      return decoder->DecodeStringView(&view);
+    }
+
+    case kFieldW16String: {
+      base::Span<const char> view;
+      return decoder->DecodeW16StringView(&view);
+    }
+
+    case kFieldSID:
+    case kFieldTimeZoneInformation: {
+      // These structures are rare: decode them into a discarded structure.
+      StructValue discarded;
+      return DecodeVariableField<PointerType>(field, decoder, &discarded);
+    }
+
+    default:
+      return decoder->Skip(field.size);
+  }
+}
+
+bool PayloadDecoder::HasSameFields(const PayloadDecoder& other) const {
+  if (fields_.size() != other.fields_.size())
+    return false;
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const Field& left = fields_[i];
+    const Field& right = other.fields_[i];
+    if (left.name != right.name ||
+        left.type != right.type ||
+        left.count != right.count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+PayloadLayoutTable::PayloadLayoutTable() {
+}
+
+PayloadLayoutTable::PayloadLayoutTable(event::Atom category)
+    : category_(category) {
+}
+
+PayloadLayoutTable::~PayloadLayoutTable() {
+}
+
+void PayloadLayoutTable::AddLayout(
+    VersionRange versions,
+    PointerSize pointer_size,
+    const std::vector<OperationLayout>& operations,
+    const std::vector<FieldLayout>& fields) {
+  DCHECK_LE(versions.min_version, versions.max_version);
+
+  const bool kPointerSizes[] = { false, true };
+  for (bool is_64_bit : kPointerSizes) {
+    if (!AppliesTo(pointer_size, is_64_bit))
+      continue;
+
+    // Compile the layout for each version. Consecutive versions decoding the
+    // same fields share their decoder.
+    size_t first_decoder = decoders_by_version_.size();
+    const PayloadDecoder* previous = NULL;
+    for (unsigned int version = versions.min_version;
+         version <= versions.max_version; ++version) {
+      std::unique_ptr<PayloadDecoder> decoder(new PayloadDecoder(
+          fields, static_cast<unsigned char>(version), is_64_bit));
+      if (previous == NULL || !previous->HasSameFields(*decoder)) {
+        previous = decoder.get();
+        decoders_.push_back(std::move(decoder));
+      }
+      decoders_by_version_.push_back(previous);
+    }
+
+    for (const OperationLayout& operation : operations) {
+      // Event types are registered once, when the table is built.
+      event::Atom name;
+      if (operation.name != NULL)
+        name = event::Atom::Intern(operation.name);
+      Entry entry = { operation.opcode, is_64_bit, versions,
+                      event::EventType::Register(category_, name),
+                      first_decoder };
+      std::vector<Entry>::iterator position =
+          std::upper_bound(entries_.begin(), entries_.end(), entry,
+                           &EntryLess);
+#ifndef NDEBUG
+      for (std::vector<Entry>::iterator it = entries_.begin();
+           it != position; ++it) {
+        DCHECK(EntryLess(*it, entry) ||
+               it->versions.max_version < versions.min_version ||
+               it->versions.min_version > versions.max_version);
+      }
+#endif
+      entries_.insert(position, entry);
+    }
+  }
+}
+
+const PayloadDecoder* PayloadLayoutTable::Find(unsigned char opcode,
+                                               unsigned char version,
+                                               bool is_64_bit,
+                                               std::string* operation) const {
+  DCHECK(operation != NULL);
+
+  const Entry* entry = FindEntry(opcode, version, is_64_bit);
+  if (entry == NULL)
+    return NULL;
+  event::Atom name = entry->type.operation();
+  if (name != event::Atom())
+    *operation = name.str();
+  return decoders_by_version_[
+      entry->first_decoder + version - entry->versions.min_version];
+}
+
+const PayloadDecoder* PayloadLayoutTable::Find(unsigned char opcode,
+                                               unsigned char version,
+                                               bool is_64_bit,
+                                               event::EventType* type) const {
+  DCHECK(type != NULL);
+
+  const Entry* entry = FindEntry(opcode, version, is_64_bit);
+  if (entry == NULL)
+    return NULL;
+  *type = entry->type;
+  return decoders_by_version_[
+      entry->first_decoder + version - entry->versions.min_version];
+}
+
+const PayloadLayoutTable::Entry* PayloadLayoutTable::FindEntry(
+    unsigned char opcode, unsigned char version, bool is_64_bit) const {
+  Entry key = { opcode, is_64_bit, AllVersions(), event::EventType(), 0 };
+  std::pair<std::vector<Entry>::const_iterator,
+            std::vector<Entry>::const_iterator> range =
+      std::equal_range(entries_.begin(), entries_.end(), key, &EntryLess);
+  for (std::vector<Entry>::const_iterator it = range.first;
+       it != range.second; ++it) {
+    if (AppliesTo(it->versions, version))
+      return &*it;
+  }
+  return NULL;
+}
+
+bool PayloadLayoutTable::EntryLess(const Entry& left, const Entry& right) {
+  if (left.opcode != right.opcode)
+    return left.opcode < right.opcode;
+  return left.is_64_bit < right.is_64_bit;
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,340 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Declarative description of the layout of event payloads. The fields of the
+// payloads are described by tables, which are decoded by a single generic
+// interpreter:
+//
+//   PayloadLayoutTable table;
+//   table.AddLayout(Versions(2, 3), kAnyPointerSize,
+//       { { kReadOpcode, "Read" }, { kWriteOpcode, "Write" } },
+//       { { "Offset", kFieldULong },
+//         { "IrpPtr", kFieldPointer },
+//         { "TTID", kFieldPointer, Version(2) },
+//         { "TTID", kFieldUInt, Version(3) },
+//         { "FileName", kFieldW16String } });
+//
+//   std::string operation;
+//   const PayloadDecoder* payload =
+//       table.Find(opcode, version, is_64_bit, &operation);
+//   if (payload != NULL) {
+//     std::unique_ptr<StructValue> fields(payload->CreateFields(NULL));
+//     payload->Decode(&decoder, fields.get());
+//   }
+//
+// A layout is compiled once for every version and pointer size it applies
+// to: the conditions of the fields are evaluated, pointer-sized fields are
+// resolved and field names are interned. The fixed-size fields at the start
+// of the payload are decoded from a single block of bytes, with one bounds
+// check. Payloads made only of fixed-size scalars are decoded into a
+// SchemaStructValue.
+
+#ifndef PARSER_ETW_ETW_PAYLOAD_LAYOUT_H_
+#define PARSER_ETW_ETW_PAYLOAD_LAYOUT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "event/atom.h"
+#include "event/event_type.h"
+#include "event/struct_schema.h"
+#include "event/value.h"
+#include "event/value_arena.h"
+#include "parser/decoder.h"
+#include "parser/event_filter.h"
+
+namespace parser {
+namespace etw {
+
+// The types of the fields of a payload.
+enum FieldType {
+  kFieldChar,
+  kFieldUChar,
+  kFieldShort,
+  kFieldUShort,
+  kFieldInt,
+  kFieldUInt,
+  kFieldLong,
+  kFieldULong,
+  // An unsigned integer of the size of a pointer of the traced system.
+  kFieldPointer,
+  // Bytes skipped without producing a field. Requires a count.
+  kFieldPadding,
+  // An array of unsigned chars. Requires a count.
+  kFieldUCharArray,
+  // An array of unsigned 64-bit integers filling the end of the payload.
+  kFieldULongTrailingArray,
+  // A null-terminated string of 8-bit characters.
+  kFieldString,
+  // A null-terminated string of 16-bit characters.
+  kFieldW16String,
+  // A TOKEN_USER structure followed by a SID.
+  kFieldSID,
+  // A TIME_ZONE_INFORMATION structure.
+  kFieldTimeZoneInformation,
+};
+
+// The pointer sizes of the traced systems to which a layout or a field
+// applies.
+enum PointerSize {
+  kAnyPointerSize,
+  k32BitOnly,
+  k64BitOnly,
+};
+
+// The versions of an event definition to which a layout or a field applies,
+// inclusively.
+struct VersionRange {
+  unsigned char min_version;
+  unsigned char max_version;
+};
+
+inline VersionRange Versions(unsigned char min_version,
+                             unsigned char max_version) {
+  VersionRange versions = { min_version, max_version };
+  return versions;
+}
+
+inline VersionRange Version(unsigned char version) {
+  return Versions(version, version);
+}
+
+inline VersionRange SinceVersion(unsigned char min_version) {
+  return Versions(min_version, 0xFF);
+}
+
+inline VersionRange AllVersions() {
+  return Versions(0, 0xFF);
+}
+
+// Description of a field of a payload.
+struct FieldLayout {
+  FieldLayout(const char* name,
+              FieldType type,
+              VersionRange versions = AllVersions(),
+              PointerSize pointer_size = kAnyPointerSize)
+      : name(name), type(type), count(0), versions(versions),
+        pointer_size(pointer_size) {
+  }
+
+  FieldLayout(const char* name,
+              FieldType type,
+              size_t count,
+              VersionRange versions = AllVersions(),
+              PointerSize pointer_size = kAnyPointerSize)
+      : name(name), type(type), count(count), versions(versions),
+        pointer_size(pointer_size) {
+  }
+
+  // The name of the field, or NULL for padding.
+  const char* name;
+  FieldType type;
+  // The number of elements of an array, or of bytes of a padding.
+  size_t count;
+  // The field is only present in these versions...
+  VersionRange versions;
+  // ... and for these pointer sizes.
+  PointerSize pointer_size;
+};
+
+// Associates an opcode with the name of its operation.
+struct OperationLayout {
+  unsigned char opcode;
+  // The name of the operation, or NULL to leave the operation unnamed.
+  const char* name;
+};
+
+// A payload layout compiled for one version and one pointer size.
+class PayloadDecoder {
+ public:
+  // @param fields the fields of the layout.
+  // @param version the version of the event definition.
+  // @param is_64_bit indicates whether the traced system uses 64-bit
+  //     pointers.
+  PayloadDecoder(const std::vector<FieldLayout>& fields,
+                 unsigned char version,
+                 bool is_64_bit);
+
+  // Creates an empty structure to receive the decoded fields.
+  // @param arena the arena holding the structure, or NULL for the heap.
+  // @param projection the fields to decode, or NULL to decode all of them.
+  // @returns the new structure, owned by |arena| when it is not NULL.
+  event::StructValue* CreateFields(event::ValueArena* arena,
+                                   const FieldProjection* projection) const;
+
+  // Decodes the fields of a payload.
+  // @param decoder the decoder processing the payload.
+  // @param projection the fields to decode, or NULL to decode all of them.
+  //     The other fields are skipped.
+  // @param fields the structure to receive the fields, from CreateFields().
+  // @returns true on success, false otherwise.
+  bool Decode(Decoder* decoder,
+              const FieldProjection* projection,
+              event::StructValue* fields) const;
+
+  // @returns the schema of the decoded structures, or NULL if the payload
+  //     holds variable-size fields.
+  const event::StructSchema* schema() const { return schema_.get(); }
+
+  // @returns the size of the fixed-size fields at the start of the payload,
+  //     in bytes.
+  size_t prefix_size() const { return prefix_size_; }
+
+  // @returns whether |other| decodes the same fields as this decoder.
+  bool HasSameFields(const PayloadDecoder& other) const;
+
+ private:
+  // A field resolved for the version and the pointer size of the decoder.
+  struct Field {
+    event::Atom name;
+    const char* label;
+    // The type of the field; never kFieldPointer.
+    FieldType type;
+    size_t count;
+    // The size of the field in bytes, or 0 if it has a variable size.
+    size_t size;
+  };
+
+  // Decodes the fields of a payload. Decode() selects the instantiation
+  // matching the pointer size once per payload, so that the pointer size is
+  // never tested while decoding fields.
+  // @tparam PointerType the type of the pointers of the traced system, either
+  //     event::UIntValue or event::ULongValue.
+  template <class PointerType>
+  bool DecodeFields(Decoder* decoder,
+                    const FieldProjection* projection,
+                    event::StructValue* fields) const;
+
+  // Adds the fields of the fixed-size prefix to |fields|.
+  // @tparam StructType the type of |fields|, either event::StructValue or
+  //     event::SchemaStructValue.
+  // @param bytes the fixed-size prefix of the payload.
+  template <class StructType>
+  bool DecodePrefix(const char* bytes,
+                    const FieldProjection* projection,
+                    StructType* fields) const;
+
+  template <class PointerType>
+  bool DecodeVariableField(const Field& field,
+                           Decoder* decoder,
+                           event::StructValue* fields) const;
+
+  // Moves |decoder| past a variable-size field without decoding it.
+  template <class PointerType>
+  bool SkipVariableField(const Field& field, Decoder* decoder) const;
+
+  std::vector<Field> fields_;
+
+  // The number of fields which produce a value (i.e. are not padding).
+  size_t value_count_;
+
+  // The fields fully contained in the fixed-size prefix of the payload.
+  size_t prefix_count_;
+  size_t prefix_size_;
+
+  bool is_64_bit_;
+
+  std::unique_ptr<event::StructSchema> schema_;
+
+  DISALLOW_COPY_AND_ASSIGN(PayloadDecoder);
+};
+
+// The layouts of the payloads of the events of a provider, indexed by
+// opcode, version and pointer size.
+class PayloadLayoutTable {
+ public:
+  PayloadLayoutTable();
+
+  // @param category the category of the events of the provider. The type of
+  //     each operation (see event/event_type.h) is registered when its layout
+  //     is added.
+  explicit PayloadLayoutTable(event::Atom category);
+
+  ~PayloadLayoutTable();
+
+  // Adds a layout. The layout must not overlap a layout already added for
+  // the same opcode.
+  // @param versions the versions of the events having this layout.
+  // @param pointer_size the pointer sizes of the events having this layout.
+  // @param operations the opcodes of the events having this layout.
+  // @param fields the fields of the payload.
+  void AddLayout(VersionRange versions,
+                 PointerSize pointer_size,
+                 const std::vector<OperationLayout>& operations,
+                 const std::vector<FieldLayout>& fields);
+
+  // Finds the decoder of a payload.
+  // @param opcode the opcode of the event.
+  // @param version the version of the event definition.
+  // @param is_64_bit indicates whether the event was generated on a 64-bit OS.
+  // @param operation receives the name of the operation, if it has one.
+  // @returns the decoder of the payload, or NULL if no layout applies.
+  const PayloadDecoder* Find(unsigned char opcode,
+                             unsigned char version,
+                             bool is_64_bit,
+                             std::string* operation) const;
+
+  // Same as above, with the operation given as the type of the event. An
+  // unnamed operation has the type of the category with an empty operation.
+  const PayloadDecoder* Find(unsigned char opcode,
+                             unsigned char version,
+                             bool is_64_bit,
+                             event::EventType* type) const;
+
+ private:
+  struct Entry {
+    unsigned char opcode;
+    bool is_64_bit;
+    VersionRange versions;
+    // The type of the event; its operation is empty if it has no name.
+    event::EventType type;
+    // The decoder of version v is at |first_decoder + v - min_version| in
+    // |decoders_by_version_|.
+    size_t first_decoder;
+  };
+
+  const Entry* FindEntry(unsigned char opcode,
+                         unsigned char version,
+                         bool is_64_bit) const;
+
+  static bool EntryLess(const Entry& left, const Entry& right);
+
+  event::Atom category_;
+
+  // Entries sorted by opcode and pointer size.
+  std::vector<Entry> entries_;
+
+  std::vector<const PayloadDecoder*> decoders_by_version_;
+  std::vector<std::unique_ptr<PayloadDecoder> > decoders_;
+
+  DISALLOW_COPY_AND_ASSIGN(PayloadLayoutTable);
+};
+
+}  // namespace etw
+}  // namespace parser
+
+#endif  // PARSER_ETW_ETW_PAYLOAD_LAYOUT_H_
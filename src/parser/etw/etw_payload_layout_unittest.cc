@@ -0,0 +1,396 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_payload_layout.h"
+
+#include <memory>
+
+#include "event/packed_array_value.h"
+#include "event/string_view_value.h"
+#include "event/value_arena.h"
+#include "gtest/gtest.h"
+#include "parser/event_filter.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+using event::PackedArrayValue;
+using event::StructValue;
+using event::UCharValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::UShortValue;
+using event::Value;
+using event::WStringValue;
+
+const unsigned char kReadOpcode = 10;
+const unsigned char kWriteOpcode = 11;
+const unsigned char kNameOpcode = 12;
+
+// Builds a table with a fixed layout and a layout with a string.
+void AddLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kReadOpcode, "Read" }, { kWriteOpcode, "Write" } },
+      { { "Offset", kFieldULong },
+        { "Irp", kFieldPointer },
+        { "ThreadId", kFieldUInt, Version(3) },
+        { NULL, kFieldPadding, 4, Version(3), k64BitOnly } });
+  table->AddLayout(Version(2), k64BitOnly,
+      { { kNameOpcode, "Name" } },
+      { { "Size", kFieldUShort },
+        { "Flags", kFieldUCharArray, 2 },
+        { "Name", kFieldW16String },
+        { "Count", kFieldUInt },
+        { "Stack", kFieldULongTrailingArray } });
+}
+
+}  // namespace
+
+TEST(PayloadLayoutTest, Find) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  std::string operation;
+  EXPECT_TRUE(table.Find(kReadOpcode, 2, false, &operation) != NULL);
+  EXPECT_EQ("Read", operation);
+  EXPECT_TRUE(table.Find(kWriteOpcode, 3, true, &operation) != NULL);
+  EXPECT_EQ("Write", operation);
+
+  // Unknown opcode, version or pointer size.
+  operation.clear();
+  EXPECT_TRUE(table.Find(kReadOpcode + 10, 2, false, &operation) == NULL);
+  EXPECT_TRUE(table.Find(kReadOpcode, 1, false, &operation) == NULL);
+  EXPECT_TRUE(table.Find(kReadOpcode, 4, true, &operation) == NULL);
+  EXPECT_TRUE(table.Find(kNameOpcode, 2, false, &operation) == NULL);
+  EXPECT_TRUE(operation.empty());
+
+  event::EventType type;
+  EXPECT_TRUE(table.Find(kWriteOpcode, 2, false, &type) != NULL);
+  EXPECT_EQ(event::Atom::Intern("Write"), type.operation());
+}
+
+TEST(PayloadLayoutTest, FindEventType) {
+  const event::Atom kCategory = event::Atom::Intern("PayloadLayoutTest");
+  PayloadLayoutTable table(kCategory);
+  AddLayouts(&table);
+
+  event::EventType read_type;
+  event::EventType write_type;
+  EXPECT_TRUE(table.Find(kReadOpcode, 2, false, &read_type) != NULL);
+  EXPECT_TRUE(table.Find(kWriteOpcode, 3, true, &write_type) != NULL);
+  EXPECT_NE(read_type, write_type);
+  EXPECT_EQ(event::EventType::Register(kCategory,
+                                       event::Atom::Intern("Read")),
+            read_type);
+  EXPECT_EQ(kCategory, write_type.category());
+  EXPECT_EQ(event::Atom::Intern("Write"), write_type.operation());
+
+  // The type does not depend on the version or the pointer size.
+  event::EventType other_type;
+  EXPECT_TRUE(table.Find(kReadOpcode, 3, true, &other_type) != NULL);
+  EXPECT_EQ(read_type, other_type);
+}
+
+TEST(PayloadLayoutTest, FindUnnamedOperation) {
+  PayloadLayoutTable table;
+  table.AddLayout(AllVersions(), kAnyPointerSize, { { 80, NULL } }, {});
+
+  std::string operation("unchanged");
+  EXPECT_TRUE(table.Find(80, 0, false, &operation) != NULL);
+  EXPECT_TRUE(table.Find(80, 255, true, &operation) != NULL);
+  EXPECT_EQ("unchanged", operation);
+
+  event::EventType type;
+  EXPECT_TRUE(table.Find(80, 0, false, &type) != NULL);
+  EXPECT_EQ(event::Atom(), type.operation());
+}
+
+TEST(PayloadLayoutTest, VersionsShareDecoders) {
+  PayloadLayoutTable table;
+  table.AddLayout(Versions(0, 2), kAnyPointerSize, { { 1, "Op" } },
+      { { "A", kFieldUInt },
+        { "B", kFieldUInt, SinceVersion(2) } });
+
+  std::string operation;
+  const PayloadDecoder* v0 = table.Find(1, 0, false, &operation);
+  const PayloadDecoder* v1 = table.Find(1, 1, false, &operation);
+  const PayloadDecoder* v2 = table.Find(1, 2, false, &operation);
+  EXPECT_TRUE(v0 != NULL);
+  EXPECT_EQ(v0, v1);
+  EXPECT_NE(v1, v2);
+  EXPECT_EQ(4U, v1->prefix_size());
+  EXPECT_EQ(8U, v2->prefix_size());
+
+  // The fields don't depend on the pointer size.
+  EXPECT_EQ(8U, table.Find(1, 2, true, &operation)->prefix_size());
+}
+
+TEST(PayloadLayoutTest, DecodeFixedLayout) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,  // Offset
+      0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,  // Irp
+      0x21, 0x22, 0x23, 0x24,                          // ThreadId
+      0x00, 0x00, 0x00, 0x00 };                        // Padding
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kReadOpcode, 3, true, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+  ASSERT_TRUE(payload_decoder->schema() != NULL);
+  EXPECT_EQ(sizeof(kPayload), payload_decoder->prefix_size());
+
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  std::unique_ptr<StructValue> fields(payload_decoder->CreateFields(NULL, NULL));
+  EXPECT_TRUE(fields->schema() == payload_decoder->schema());
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, NULL, fields.get()));
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  StructValue expected;
+  expected.AddField<ULongValue>("Offset", 0x0807060504030201ULL);
+  expected.AddField<ULongValue>("Irp", 0x1817161514131211ULL);
+  expected.AddField<UIntValue>("ThreadId", 0x24232221U);
+  EXPECT_TRUE(expected.Equals(fields.get()));
+}
+
+TEST(PayloadLayoutTest, DecodePointerSize) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,  // Offset
+      0x11, 0x12, 0x13, 0x14 };                        // Irp
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kWriteOpcode, 2, false, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  std::unique_ptr<StructValue> fields(payload_decoder->CreateFields(NULL, NULL));
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, NULL, fields.get()));
+
+  StructValue expected;
+  expected.AddField<ULongValue>("Offset", 0x0807060504030201ULL);
+  expected.AddField<UIntValue>("Irp", 0x14131211U);
+  EXPECT_TRUE(expected.Equals(fields.get()));
+}
+
+TEST(PayloadLayoutTest, DecodeTruncated) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+      0x11, 0x12, 0x13 };
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kWriteOpcode, 2, false, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  std::unique_ptr<StructValue> fields(payload_decoder->CreateFields(NULL, NULL));
+  EXPECT_FALSE(payload_decoder->Decode(&decoder, NULL, fields.get()));
+  EXPECT_EQ(sizeof(kPayload), decoder.RemainingBytes());
+}
+
+TEST(PayloadLayoutTest, DecodeVariableFields) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x34, 0x12,                                      // Size
+      0xAA, 0xBB,                                      // Flags
+      'a', 0, 'b', 0, 0, 0,                            // Name
+      0x01, 0x00, 0x00, 0x00,                          // Count
+      0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Stack
+      0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kNameOpcode, 2, true, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+  EXPECT_EQ("Name", operation);
+  EXPECT_TRUE(payload_decoder->schema() == NULL);
+  EXPECT_EQ(4U, payload_decoder->prefix_size());
+
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  std::unique_ptr<StructValue> fields(payload_decoder->CreateFields(NULL, NULL));
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, NULL, fields.get()));
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  StructValue expected;
+  expected.AddField<UShortValue>("Size", 0x1234);
+  PackedArrayValue<UCharValue>* flags =
+      expected.AddPackedArrayField<UCharValue>("Flags");
+  flags->Append(0xAA);
+  flags->Append(0xBB);
+  expected.AddField<WStringValue>("Name", L"ab");
+  expected.AddField<UIntValue>("Count", 1);
+  PackedArrayValue<ULongValue>* stack =
+      expected.AddPackedArrayField<ULongValue>("Stack");
+  stack->Append(1);
+  stack->Append(2);
+  EXPECT_TRUE(expected.Equals(fields.get()));
+}
+
+TEST(PayloadLayoutTest, DecodeIntoArena) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x34, 0x12, 0xAA, 0xBB, 'a', 0, 0, 0, 0x01, 0x00, 0x00, 0x00 };
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kNameOpcode, 2, true, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+
+  event::ValueArena arena;
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  decoder.set_use_string_views(true);
+  StructValue* fields = payload_decoder->CreateFields(&arena, NULL);
+  EXPECT_EQ(&arena, fields->arena());
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, NULL, fields));
+
+  const Value* name = fields->GetField("Name");
+  ASSERT_TRUE(name != NULL);
+  EXPECT_TRUE(event::W16StringViewValue::InstanceOf(name));
+  std::wstring str;
+  EXPECT_TRUE(name->GetAsWString(&str));
+  EXPECT_EQ(L"a", str);
+
+  // The trailing array is empty.
+  const Value* stack = fields->GetField("Stack");
+  ASSERT_TRUE(stack != NULL);
+  EXPECT_EQ(0U, event::ArrayValue::Cast(stack)->Length());
+}
+
+TEST(PayloadLayoutTest, DecodeNarrowStringView) {
+  PayloadLayoutTable table;
+  table.AddLayout(Version(2), kAnyPointerSize,
+      { { kNameOpcode, "Name" } },
+      { { "Name", kFieldString },
+        { "Count", kFieldUInt } });
+
+  const unsigned char kPayload[] = {
+      'a', 'b', 0, 0x01, 0x00, 0x00, 0x00 };
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kNameOpcode, 2, false, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+
+  // The string points into the payload instead of being copied.
+  event::ValueArena arena;
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  decoder.set_use_string_views(true);
+  StructValue* fields = payload_decoder->CreateFields(&arena, NULL);
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, NULL, fields));
+
+  const Value* name = fields->GetField("Name");
+  ASSERT_TRUE(name != NULL);
+  ASSERT_TRUE(event::StringViewValue::InstanceOf(name));
+  EXPECT_EQ(reinterpret_cast<const char*>(&kPayload[0]),
+            event::StringViewValue::Cast(name)->GetValue().data());
+  std::string str;
+  EXPECT_TRUE(name->GetAsString(&str));
+  EXPECT_EQ("ab", str);
+  uint32_t count = 0;
+  EXPECT_TRUE(fields->GetFieldAsUInteger("Count", &count));
+  EXPECT_EQ(1U, count);
+}
+
+TEST(PayloadLayoutTest, DecodeProjection) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x34, 0x12,                                      // Size
+      0xAA, 0xBB,                                      // Flags
+      'a', 0, 'b', 0, 0, 0,                            // Name
+      0x01, 0x00, 0x00, 0x00,                          // Count
+      0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };  // Stack
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kNameOpcode, 2, true, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+
+  FieldProjection projection({ "Size", "Count" });
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  std::unique_ptr<StructValue> fields(
+      payload_decoder->CreateFields(NULL, &projection));
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, &projection, fields.get()));
+  EXPECT_EQ(0U, decoder.RemainingBytes());
+
+  StructValue expected;
+  expected.AddField<UShortValue>("Size", 0x1234);
+  expected.AddField<UIntValue>("Count", 1);
+  EXPECT_TRUE(expected.Equals(fields.get()));
+}
+
+TEST(PayloadLayoutTest, DecodeFixedLayoutProjection) {
+  PayloadLayoutTable table;
+  AddLayouts(&table);
+
+  const unsigned char kPayload[] = {
+      0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,  // Offset
+      0x11, 0x12, 0x13, 0x14 };                        // Irp
+
+  std::string operation;
+  const PayloadDecoder* payload_decoder =
+      table.Find(kReadOpcode, 2, false, &operation);
+  ASSERT_TRUE(payload_decoder != NULL);
+  ASSERT_TRUE(payload_decoder->schema() != NULL);
+
+  // A projected payload does not use the schema of the layout.
+  FieldProjection projection({ "Irp" });
+  Decoder decoder(reinterpret_cast<const char*>(&kPayload[0]),
+                  sizeof(kPayload));
+  std::unique_ptr<StructValue> fields(
+      payload_decoder->CreateFields(NULL, &projection));
+  EXPECT_TRUE(fields->schema() == NULL);
+  EXPECT_TRUE(payload_decoder->Decode(&decoder, &projection, fields.get()));
+
+  StructValue expected;
+  expected.AddField<UIntValue>("Irp", 0x14131211U);
+  EXPECT_TRUE(expected.Equals(fields.get()));
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -25,39 +25,35 @@
 
 #include "parser/etw/etw_raw_kernel_payload_decoder.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
+#include "base/guid.h"
 #include "base/logging.h"
 #include "event/value.h"
+#include "event/value_arena.h"
 #include "parser/decoder.h"
-#include "parser/etw/etw_raw_payload_decoder_utils.h"
+#include "parser/etw/etw_payload_layout.h"
+#include "parser/event_filter.h"
 
 namespace parser {
 namespace etw {
 
 namespace {
 
-using event::CharValue;
-using event::IntValue;
-using event::LongValue;
-using event::ShortValue;
-using event::StringValue;
 using event::StructValue;
-using event::UCharValue;
-using event::UIntValue;
-using event::ULongValue;
-using event::UShortValue;
-using event::Value;
 
 // Constants for EventTraceEvent events.
-const std::string kEventTraceEventProviderId =
-    "68FDD900-4A3E-11D1-84F4-0000F80464E3";
+const base::Guid kEventTraceEventProviderId = { 0x68FDD900, 0x4A3E, 0x11D1,
+    { 0x84, 0xF4, 0x00, 0x00, 0xF8, 0x04, 0x64, 0xE3 } };
 const unsigned char kEventTraceEventHeaderOpcode = 0;
 const unsigned char kEventTraceEventExtensionOpcode = 5;
 const unsigned char kEventTraceEndExtensionOpcode = 32;
 
 // Constants for Image events.
-const std::string kImageProviderId = "2CB15D1D-5FC1-11D2-ABE1-00A0C911F518";
+const base::Guid kImageProviderId = { 0x2CB15D1D, 0x5FC1, 0x11D2,
+    { 0xAB, 0xE1, 0x00, 0xA0, 0xC9, 0x11, 0xF5, 0x18 } };
 const unsigned char kImageUnloadOpcode = 2;
 const unsigned char kImageDCStartOpcode = 3;
 const unsigned char kImageDCEndOpcode = 4;
@@ -65,7 +61,8 @@ const unsigned char kImageLoadOpcode = 10;
 const unsigned char kImageKernelBaseOpcode = 33;
 
 // Constants for PerfInfo events.
-const std::string kPerfInfoProviderId = "CE1DBFB4-137E-4DA6-87B0-3F59AA102CBC";
+const base::Guid kPerfInfoProviderId = { 0xCE1DBFB4, 0x137E, 0x4DA6,
+    { 0x87, 0xB0, 0x3F, 0x59, 0xAA, 0x10, 0x2C, 0xBC } };
 const unsigned char kPerfInfoMarkOpcode = 34;
 const unsigned char kPerfInfoSampleProfOpcode = 46;
 const unsigned char kPerfInfoPmcCounterProfOpcode = 47;
@@ -98,7 +95,8 @@ const unsigned char kPerfInfoWdfPassiveISROpcode = 97;
 const unsigned char kPerfInfoWdfDPCOpcode = 98;
 
 // Constants for Thread events.
-const std::string kThreadProviderId = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+const base::Guid kThreadProviderId = { 0x3D6FA8D1, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
 const unsigned char kThreadStartOpcode = 1;
 const unsigned char kThreadEndOpcode = 2;
 const unsigned char kThreadDCStartOpcode = 3;
@@ -116,7 +114,8 @@ const unsigned char kThreadAutoBoostClearFloorOpcode = 67;
 const unsigned char kThreadAutoBoostEntryExhaustionOpcode = 68;
 
 // Constants for Process events.
-const std::string kProcessProviderId = "3D6FA8D0-FE05-11D0-9DDA-00C04FD7BA7C";
+const base::Guid kProcessProviderId = { 0x3D6FA8D0, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
 const unsigned char kProcessStartOpcode = 1;
 const unsigned char kProcessEndOpcode = 2;
 const unsigned char kProcessDCStartOpcode = 3;
@@ -127,7 +126,8 @@ const unsigned char kProcessPerfCtrRundownOpcode = 33;
 const unsigned char kProcessDefunctOpcode = 39;
 
 // Constants for Tcplp events.
-const std::string kTcplpProviderId = "9A280AC0-C8E0-11D1-84E2-00C04FB998A2";
+const base::Guid kTcplpProviderId = { 0x9A280AC0, 0xC8E0, 0x11D1,
+    { 0x84, 0xE2, 0x00, 0xC0, 0x4F, 0xB9, 0x98, 0xA2 } };
 const unsigned char kTcplpSendIPV4Opcode = 10;
 const unsigned char kTcplpRecvIPV4Opcode = 11;
 const unsigned char kTcplpConnectIPV4Opcode = 12;
@@ -143,7 +143,8 @@ const unsigned char kTcplpPartACKIPV4Opcode = 21;
 const unsigned char kTcplpDupACKIPV4Opcode = 22;
 
 // Constants for Registry events.
-const std::string kRegistryProviderId = "AE53722E-C863-11D2-8659-00C04FA321A1";
+const base::Guid kRegistryProviderId = { 0xAE53722E, 0xC863, 0x11D2,
+    { 0x86, 0x59, 0x00, 0xC0, 0x4F, 0xA3, 0x21, 0xA1 } };
 const unsigned char kRegistryCreateOpcode = 10;
 const unsigned char kRegistryOpenOpcode = 11;
 const unsigned char kRegistryDeleteOpcode = 12;
@@ -177,7 +178,8 @@ const unsigned char kRegistryHiveDirtyOpcode = 40;
 const unsigned char kRegistryChangeNotifyOpcode = 48;
 
 // Constants for FileIO events.
-const std::string kFileIOProviderId = "90CBDC39-4A3E-11D1-84F4-0000F80464E3";
+const base::Guid kFileIOProviderId = { 0x90CBDC39, 0x4A3E, 0x11D1,
+    { 0x84, 0xF4, 0x00, 0x00, 0xF8, 0x04, 0x64, 0xE3 } };
 const unsigned char kFileIOFileCreateOpcode = 32;
 const unsigned char kFileIOFileDeleteOpcode = 35;
 const unsigned char kFileIOFileRundownOpcode = 36;
@@ -200,7 +202,8 @@ const unsigned char kFileIODletePathOpcode = 79;
 const unsigned char kFileIORenamePathOpcode = 80;
 
 // Constants for DiskIO events.
-const std::string kDiskIOProviderId = "3D6FA8D4-FE05-11D0-9DDA-00C04FD7BA7C";
+const base::Guid kDiskIOProviderId = { 0x3D6FA8D4, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
 const unsigned char kDiskIOReadOpcode = 10;
 const unsigned char kDiskIOWriteOpcode = 11;
 const unsigned char kDiskIOReadInitOpcode = 12;
@@ -209,11 +212,13 @@ const unsigned char kDiskIOFlushBuffersOpcode = 14;
 const unsigned char kDiskIOFlushInitOpcode = 15;
 
 // Constants for StackWalk events.
-const std::string kStackWalkProviderId = "DEF2FE46-7BD6-4B80-BD94-F57FE20D0CE3";
+const base::Guid kStackWalkProviderId = { 0xDEF2FE46, 0x7BD6, 0x4B80,
+    { 0xBD, 0x94, 0xF5, 0x7F, 0xE2, 0x0D, 0x0C, 0xE3 } };
 const unsigned char kStackWalkStackOpcode = 32;
 
 // Constants for PageFault events.
-const std::string kPageFaultProviderId = "3D6FA8D3-FE05-11D0-9DDA-00C04FD7BA7C";
+const base::Guid kPageFaultProviderId = { 0x3D6FA8D3, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
 const unsigned char kPageFaultTransitionFaultOpcode = 10;
 const unsigned char kPageFaultDemandZeroFaultOpcode = 11;
 const unsigned char kPageFaultCopyOnWriteOpcode = 12;
@@ -240,2315 +245,830 @@ const unsigned char kPageFaultUnknown112Opcode = 112;
 const unsigned char kPageFaultVirtualAllocDCStartOpcode = 128;
 const unsigned char kPageFaultVirtualAllocDCEndpcode = 129;
 
-bool DecodeEventTraceHeaderPayload(Decoder* decoder,
-                                   unsigned char version,
-                                   unsigned char opcode,
-                                   bool is_64_bit,
-                                   std::string* operation,
-                                   StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kEventTraceEventHeaderOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "Header";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("BufferSize", decoder, fields) ||
-      !Decode<UIntValue>("Version", decoder, fields) ||
-      !Decode<UIntValue>("ProviderVersion", decoder, fields) ||
-      !Decode<UIntValue>("NumberOfProcessors", decoder, fields) ||
-      !Decode<ULongValue>("EndTime", decoder, fields) ||
-      !Decode<UIntValue>("TimerResolution", decoder, fields) ||
-      !Decode<UIntValue>("MaxFileSize", decoder, fields) ||
-      !Decode<UIntValue>("LogFileMode", decoder, fields) ||
-      !Decode<UIntValue>("BuffersWritten", decoder, fields) ||
-      !Decode<UIntValue>("StartBuffers", decoder, fields) ||
-      !Decode<UIntValue>("PointerSize", decoder, fields) ||
-      !Decode<UIntValue>("EventsLost", decoder, fields) ||
-      !Decode<UIntValue>("CPUSpeed", decoder, fields) ||
-      !DecodeUInteger("LoggerName", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("LogFileName", is_64_bit, decoder, fields) ||
-      !DecodeTimeZoneInformation("TimeZoneInformation", decoder, fields) ||
-      !Decode<UIntValue>("Padding", decoder, fields) ||
-      !Decode<ULongValue>("BootTime", decoder, fields) ||
-      !Decode<ULongValue>("PerfFreq", decoder, fields) ||
-      !Decode<ULongValue>("StartTime", decoder, fields) ||
-      !Decode<UIntValue>("ReservedFlags", decoder, fields) ||
-      !Decode<UIntValue>("BuffersLost", decoder, fields) ||
-      !DecodeW16String("SessionNameString", decoder, fields) ||
-      !DecodeW16String("LogFileNameString", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeEventTraceExtensionPayload(Decoder* decoder,
-                                      unsigned char version,
-                                      unsigned char opcode,
-                                      bool /* is_64_bit */,
-                                      std::string* operation,
-                                      StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kEventTraceEventExtensionOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version > 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "Extension";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("GroupMask1", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask2", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask3", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask4", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask5", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask6", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask7", decoder, fields) ||
-      !Decode<UIntValue>("GroupMask8", decoder, fields)) {
-    return false;
-  }
-
-  if (version == 2) {
-    if (!Decode<UIntValue>("KernelEventVersion", decoder, fields))
-      return false;
-  }
-
-  return true;
-}
-
-bool DecodeEventTracePayload(Decoder* decoder,
-                             unsigned char version,
-                             unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
-                             StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kEventTraceEventHeaderOpcode:
-      return DecodeEventTraceHeaderPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-    case kEventTraceEventExtensionOpcode:
-      return DecodeEventTraceExtensionPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-    default:
-      return false;
-  }
-}
-
-bool DecodeImagePayload(Decoder* decoder,
-                        unsigned char version,
-                        unsigned char opcode,
-                        bool is_64_bit,
-                        std::string* operation,
-                        StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version > 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kImageLoadOpcode:
-      // Image load event. Generated when a DLL or executable file is loaded.
-      *operation = "Load";
-      break;
-    case kImageUnloadOpcode:
-      // Image unload event. Generated when a DLL or executable file is
-      // unloaded.
-      *operation = "Unload";
-      break;
-    case kImageDCStartOpcode:
-      // Data collection start event. Enumerates all loaded images at the
-      // beginning of the trace.
-      *operation = "DCStart";
-      break;
-    case kImageDCEndOpcode:
-      // Data collection end event. Enumerates all loaded images at the end
-      // of the trace.
-      *operation = "DCEnd";
-      break;
-    case kImageKernelBaseOpcode:
-      // Kernel load address event.
-      *operation = "KernelBase";
-      break;
-    default:
-      return false;
-  }
-
-  // Decode the payload.
-  if (!DecodeUInteger("BaseAddress", is_64_bit, decoder, fields))
-    return false;
-
-  if (opcode == kImageKernelBaseOpcode)
-    return true;
-
-  if (version == 0) {
-    if (!Decode<UIntValue>("ModuleSize", decoder, fields))
-      return false;
-  } else {
-    if (!DecodeUInteger("ModuleSize", is_64_bit, decoder, fields))
-      return false;
-  }
-
-  if (version >= 1 &&
-      !Decode<UIntValue>("ProcessId", decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 2 && (
-      !Decode<UIntValue>("ImageCheckSum", decoder, fields) ||
-      !Decode<UIntValue>("TimeDateStamp", decoder, fields))) {
-    return false;
-  }
-
-  if (version >= 3) {
-    if (!Decode<UCharValue>("SignatureLevel", decoder, fields) ||
-        !Decode<UCharValue>("SignatureType", decoder, fields) ||
-        !Decode<UShortValue>("Reserved0", decoder, fields)) {
-      return false;
-    }
-  } else if (version >= 2) {
-    if (!Decode<UIntValue>("Reserved0", decoder, fields))
-      return false;
-  }
-
-  if (version >= 2 && (
-      !DecodeUInteger("DefaultBase", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("Reserved1", decoder, fields) ||
-      !Decode<UIntValue>("Reserved2", decoder, fields) ||
-      !Decode<UIntValue>("Reserved3", decoder, fields) ||
-      !Decode<UIntValue>("Reserved4", decoder, fields))) {
-    return false;
-  }
-
-  if (!DecodeW16String("ImageFileName", decoder, fields))
-    return false;
-
-  return true;
-}
-
-bool DecodePerfInfoCollectionPayload(Decoder* decoder,
-                                     unsigned char version,
-                                     unsigned char opcode,
-                                     bool /* is_64_bit */,
-                                     std::string* operation,
-                                     StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kPerfInfoCollectionSetIntervalOpcode:
-      *operation = "SetInterval";
-      break;
-
-    case kPerfInfoCollectionStartOpcode:
-      *operation = "CollectionStart";
-      break;
-
-    case kPerfInfoCollectionEndOpcode:
-      *operation = "CollectionEnd";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("Source", decoder, fields) ||
-      !Decode<UIntValue>("NewInterval", decoder, fields) ||
-      !Decode<UIntValue>("OldInterval", decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 3 &&
-      !DecodeW16String("SourceName", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodePerfInfoCollectionSecondPayload(Decoder* decoder,
-                                           unsigned char version,
-                                           unsigned char opcode,
-                                           bool /* is_64_bit */,
-                                           std::string* operation,
-                                           StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kPerfInfoCollectionStartSecondOpcode:
-      *operation = "CollectionStart";
-      break;
-
-    case kPerfInfoCollectionEndSecondOpcode:
-      *operation = "CollectionEnd";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("SpinLockSpinThreshold", decoder, fields) ||
-      !Decode<UIntValue>("SpinLockContentionSampleRate", decoder, fields) ||
-      !Decode<UIntValue>("SpinLockAcquireSampleRate", decoder, fields) ||
-      !Decode<UIntValue>("SpinLockHoldThreshold", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodePerfInfoISRPayload(Decoder* decoder,
-                              unsigned char version,
-                              unsigned char opcode,
-                              bool is_64_bit,
-                              std::string* operation,
-                              StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kPerfInfoISRMSIOpcode:
-      *operation = "ISR-MSI";
-      break;
-
-    case kPerfInfoISROpcode:
-      *operation = "ISR";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("InitialTime", decoder, fields) ||
-      !DecodeUInteger("Routine", is_64_bit, decoder, fields) ||
-      !Decode<UCharValue>("ReturnValue", decoder, fields) ||
-      !Decode<UShortValue>("Vector", decoder, fields) ||
-      !Decode<UCharValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  if (opcode == kPerfInfoISRMSIOpcode &&
-      !Decode<UIntValue>("MessageNumber", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodePerfInfoDPCPayload(Decoder* decoder,
-                              unsigned char version,
-                              unsigned char opcode,
-                              bool is_64_bit,
-                              std::string* operation,
-                              StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kPerfInfoThreadedDPCOpcode:
-      *operation = "ThreadedDPC";
-      break;
-
-    case kPerfInfoDPCOpcode:
-      *operation = "DPC";
-      break;
-
-    case kPerfInfoTimerDPCOpcode:
-      *operation = "TimerDPC";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("InitialTime", decoder, fields) ||
-      !DecodeUInteger("Routine", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodePerfInfoSysClEnterPayload(Decoder* decoder,
-                                     unsigned char version,
-                                     unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
-                                     StructValue* fields) {
-  DCHECK(opcode == kPerfInfoSysClEnterOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "SysClEnter";
-
-  // Decode the payload.
-  if (!DecodeUInteger("SysCallAddress", is_64_bit, decoder, fields))
-    return false;
-
-  return true;
-}
-
-bool DecodePerfInfoSysClExitPayload(Decoder* decoder,
-                                    unsigned char version,
-                                    unsigned char opcode,
-                                    bool /* is_64_bit */,
-                                    std::string* operation,
-                                    StructValue* fields) {
-  DCHECK(opcode == kPerfInfoSysClExitOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "SysClExit";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("SysCallNtStatus", decoder, fields))
-    return false;
-
-  return true;
-}
-
-bool DecodePerfInfoSampleProfPayload(Decoder* decoder,
-                                     unsigned char version,
-                                     unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
-                                     StructValue* fields) {
-  DCHECK(opcode == kPerfInfoSampleProfOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "SampleProf";
-
-  // Decode the payload.
-  if (!DecodeUInteger("InstructionPointer", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("ThreadId", decoder, fields) ||
-      !Decode<UShortValue>("Count", decoder, fields) ||
-      !Decode<UShortValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodePerfInfoDebuggerEnabledPayload(Decoder* decoder,
-                                          unsigned char version,
-                                          unsigned char opcode,
-                                          bool /* is_64_bit */,
-                                          std::string* operation,
-                                          StructValue* fields) {
-  DCHECK(opcode == kPerfInfoDebuggerEnabledOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "DebuggerEnabled";
-
-  return true;
-}
-
-bool DecodePerfInfoPayload(Decoder* decoder,
-                           unsigned char version,
-                           unsigned char opcode,
-                           bool is_64_bit,
-                           std::string* operation,
-                           StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kPerfInfoCollectionSetIntervalOpcode:
-    case kPerfInfoCollectionStartOpcode:
-    case kPerfInfoCollectionEndOpcode:
-      return DecodePerfInfoCollectionPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoCollectionStartSecondOpcode:
-    case kPerfInfoCollectionEndSecondOpcode:
-      return DecodePerfInfoCollectionSecondPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoISROpcode:
-    case kPerfInfoISRMSIOpcode:
-      return DecodePerfInfoISRPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoThreadedDPCOpcode:
-    case kPerfInfoDPCOpcode:
-    case kPerfInfoTimerDPCOpcode:
-      return DecodePerfInfoDPCPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoSysClEnterOpcode:
-      return DecodePerfInfoSysClEnterPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoSysClExitOpcode:
-      return DecodePerfInfoSysClExitPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoSampleProfOpcode:
-      return DecodePerfInfoSampleProfPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPerfInfoUnknown80Opcode:
-    case kPerfInfoUnknown81Opcode:
-    case kPerfInfoUnknown82Opcode:
-    case kPerfInfoUnknown83Opcode:
-    case kPerfInfoUnknown84Opcode:
-    case kPerfInfoUnknown85Opcode:
-      // TODO(fdoray): Decode these events.
-      return true;
-
-    case kPerfInfoDebuggerEnabledOpcode:
-      return DecodePerfInfoDebuggerEnabledPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
-}
-
-bool DecodeThreadAutoBoostPayload(Decoder* decoder,
-                                  unsigned char version,
-                                  unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
-                                  StructValue* fields) {
-  DCHECK(is_64_bit);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event ThreadAutoBoost unsupported in 32 bit.";
-    return false;
-  }
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kThreadAutoBoostEntryExhaustionOpcode:
-      *operation = "AutoBoostEntryExhaustion";
-      break;
-
-    case kThreadAutoBoostClearFloorOpcode:
-      *operation = "AutoBoostClearFloor";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("LockAddress", decoder, fields) ||
-      !Decode<UIntValue>("ThreadId", decoder, fields)) {
-    return false;
-  }
-
-  if (opcode == kThreadAutoBoostEntryExhaustionOpcode &&
-      !decoder->Skip(4)) {
-    return false;
-  }
-
-  if (opcode == kThreadAutoBoostClearFloorOpcode && (
-      !Decode<UShortValue>("BoostBitmap", decoder, fields) ||
-      !Decode<UShortValue>("Reserved", decoder, fields))) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadAutoBoostSetFloorPayload(Decoder* decoder,
-                                          unsigned char version,
-                                          unsigned char opcode,
-                                          bool is_64_bit,
-                                          std::string* operation,
-                                          StructValue* fields) {
-  DCHECK(opcode == kThreadAutoBoostSetFloorOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event AutoBoostSetFloor unsupported in 32 bit.";
-    return false;
-  }
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "AutoBoostSetFloor";
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("Lock", decoder, fields) ||
-      !Decode<UIntValue>("ThreadId", decoder, fields) ||
-      !Decode<UCharValue>("NewCpuPriorityFloor", decoder, fields) ||
-      !Decode<UCharValue>("OldCpuPriority", decoder, fields) ||
-      !Decode<UCharValue>("IoPriorities", decoder, fields) ||
-      !Decode<UCharValue>("BoostFlags", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadSetPriorityPayload(Decoder* decoder,
-                                    unsigned char version,
-                                    unsigned char opcode,
-                                    bool is_64_bit,
-                                    std::string* operation,
-                                    StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event ThreadSetPriority unsupported in 32 bit.";
-    return false;
-  }
-
-  if (version != 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kThreadSetPriorityOpcode:
-      *operation = "SetPriority";
-      break;
-
-    case kThreadSetIoPriorityOpcode:
-      *operation = "SetIoPriority";
-      break;
-
-    case kThreadSetBasePriorityOpcode:
-      *operation = "SetBasePriority";
-      break;
-
-    case kThreadSetPagePriorityOpcode:
-      *operation = "SetPagePriority";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("ThreadId", decoder, fields) ||
-      !Decode<UCharValue>("OldPriority", decoder, fields) ||
-      !Decode<UCharValue>("NewPriority", decoder, fields) ||
-      !Decode<UShortValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadCSwitchPayload(Decoder* decoder,
-                                unsigned char version,
-                                unsigned char opcode,
-                                bool /* is_64_bit */,
-                                std::string* operation,
-                                StructValue* fields) {
-  DCHECK(opcode == kThreadCSwitchOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "CSwitch";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("NewThreadId", decoder, fields) ||
-      !Decode<UIntValue>("OldThreadId", decoder, fields) ||
-      !Decode<CharValue>("NewThreadPriority", decoder, fields) ||
-      !Decode<CharValue>("OldThreadPriority", decoder, fields) ||
-      !Decode<UCharValue>("PreviousCState", decoder, fields) ||
-      !Decode<CharValue>("SpareByte", decoder, fields) ||
-      !Decode<CharValue>("OldThreadWaitReason", decoder, fields) ||
-      !Decode<CharValue>("OldThreadWaitMode", decoder, fields) ||
-      !Decode<CharValue>("OldThreadState", decoder, fields) ||
-      !Decode<CharValue>("OldThreadWaitIdealProcessor", decoder, fields) ||
-      !Decode<UIntValue>("NewThreadWaitTime", decoder, fields) ||
-      !Decode<UIntValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadCompCSPayload(Decoder* decoder,
-                               unsigned char version,
-                               unsigned char opcode,
-                               bool /* is_64_bit */,
-                               std::string* operation,
-                               StructValue* fields) {
-  DCHECK(opcode == kThreadCompCSOpcode);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "CompCS";
-
-  // This payload is a compressed version of the CSwitch event.
-  // TODO(bergeret): Determine a way to decode this event.
-  LOG(ERROR) << "The CompCS Thread event is currently unsupported.";
-  return false;
-}
-
-bool DecodeThreadReadyThreadPayload(Decoder* decoder,
-                                    unsigned char version,
-                                    unsigned char opcode,
-                                    bool /* is_64_bit */,
-                                    std::string* operation,
-                                    StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kThreadReadyThreadOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "ReadyThread";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("TThreadId", decoder, fields) ||
-      !Decode<CharValue>("AdjustReason", decoder, fields) ||
-      !Decode<CharValue>("AdjustIncrement", decoder, fields) ||
-      !Decode<CharValue>("Flag", decoder, fields) ||
-      !Decode<CharValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadSpinLockPayload(Decoder* decoder,
-                                unsigned char version,
-                                unsigned char opcode,
-                                bool is_64_bit,
-                                std::string* operation,
-                                StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kThreadSpinLockOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event ThreadSpinLock unsupported in 32 bit.";
-    return false;
-  }
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "SpinLock";
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("SpinLockAddress", decoder, fields) ||
-      !Decode<ULongValue>("CallerAddress", decoder, fields) ||
-      !Decode<ULongValue>("AcquireTime", decoder, fields) ||
-      !Decode<ULongValue>("ReleaseTime", decoder, fields) ||
-      !Decode<UIntValue>("WaitTimeInCycles", decoder, fields) ||
-      !Decode<UIntValue>("SpinCount", decoder, fields) ||
-      !Decode<UIntValue>("ThreadId", decoder, fields) ||
-      !Decode<UIntValue>("InterruptCount", decoder, fields) ||
-      !Decode<UCharValue>("Irql", decoder, fields) ||
-      !Decode<UCharValue>("AcquireDepth", decoder, fields) ||
-      !Decode<UCharValue>("Flag", decoder, fields) ||
-      !DecodeArray<UCharValue>("Reserved", 5, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadStartEndPayload(Decoder* decoder,
-                                 unsigned char version,
-                                 unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
-                                 StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  // Set the operation name.
-  switch (opcode) {
-    case kThreadDCStartOpcode:
-      *operation = "DCStart";
-      break;
-
-    case kThreadStartOpcode:
-      *operation = "Start";
-      break;
-
-    case kThreadDCEndOpcode:
-      *operation = "DCEnd";
-      break;
-
-    case kThreadEndOpcode:
-      *operation = "End";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("ProcessId", decoder, fields) ||
-      !Decode<UIntValue>("TThreadId", decoder, fields)) {
-    return false;
-  }
-
-  if (version == 1) {
-    if ((opcode == kThreadStartOpcode || opcode == kThreadDCStartOpcode) && (
-        !DecodeUInteger("StackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Win32StartAddr", is_64_bit, decoder, fields) ||
-        // This field is a signed char, but is padded to an integer 32-bit.
-        !Decode<CharValue>("WaitMode", decoder, fields) ||
-        !decoder->Skip(3))) {
-      return false;
-    }
-  } else if (version == 2) {
-    if (!DecodeUInteger("StackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Win32StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("TebBase", is_64_bit, decoder, fields) ||
-        !Decode<UIntValue>("SubProcessTag", decoder, fields)) {
-      return false;
-    }
-  } else if (version == 3) {
-    if (!DecodeUInteger("StackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Affinity", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Win32StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("TebBase", is_64_bit, decoder, fields) ||
-        !Decode<UIntValue>("SubProcessTag", decoder, fields) ||
-        !Decode<UCharValue>("BasePriority", decoder, fields) ||
-        !Decode<UCharValue>("PagePriority", decoder, fields) ||
-        !Decode<UCharValue>("IoPriority", decoder, fields) ||
-        !Decode<UCharValue>("ThreadFlags", decoder, fields)) {
-      return false;
-    }
-  } else {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeThreadPayload(Decoder* decoder,
-                         unsigned char version,
-                         unsigned char opcode,
-                         bool is_64_bit,
-                         std::string* operation,
-                         StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kThreadCSwitchOpcode:
-      return DecodeThreadCSwitchPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadCompCSOpcode:
-      return DecodeThreadCompCSPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadReadyThreadOpcode:
-      return DecodeThreadReadyThreadPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadSpinLockOpcode:
-      return DecodeThreadSpinLockPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadDCStartOpcode:
-    case kThreadStartOpcode:
-    case kThreadDCEndOpcode:
-    case kThreadEndOpcode:
-      return DecodeThreadStartEndPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadAutoBoostClearFloorOpcode:
-    case kThreadAutoBoostEntryExhaustionOpcode:
-      return DecodeThreadAutoBoostPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadAutoBoostSetFloorOpcode:
-      return DecodeThreadAutoBoostSetFloorPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kThreadSetPriorityOpcode:
-    case kThreadSetIoPriorityOpcode:
-    case kThreadSetBasePriorityOpcode:
-    case kThreadSetPagePriorityOpcode:
-      return DecodeThreadSetPriorityPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
-}
-
-bool DecodeProcessStartEndDefunctPayload(Decoder* decoder,
-                                         unsigned char version,
-                                         unsigned char opcode,
-                                         bool is_64_bit,
-                                         std::string* operation,
-                                         StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (opcode == kProcessDefunctOpcode) {
-    if (version < 2 || version > 5)
-      return false;
-  } else {
-    if (version > 4)
-      return false;
-  }
-
-  // Set the operation name.
-  switch (opcode) {
-    case kProcessDCStartOpcode:
-      *operation = "DCStart";
-      break;
-
-    case kProcessStartOpcode:
-      *operation = "Start";
-      break;
-
-    case kProcessDCEndOpcode:
-      *operation = "DCEnd";
-      break;
-
-    case kProcessEndOpcode:
-      *operation = "End";
-      break;
-
-    case kProcessDefunctOpcode:
-      *operation = "Defunct";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED() macro.
-      return false;
-  }
-
-  // Decode the payload.
-  if (version == 1 &&
-      !DecodeUInteger("PageDirectoryBase", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 2 &&
-      !DecodeUInteger("UniqueProcessKey", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  if (!Decode<UIntValue>("ProcessId", decoder, fields) ||
-      !Decode<UIntValue>("ParentId", decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 1 && (
-      !Decode<UIntValue>("SessionId", decoder, fields) ||
-      !Decode<IntValue>("ExitStatus", decoder, fields))) {
-    return false;
-  }
-
-  if (version >= 3 &&
-      !DecodeUInteger("DirectoryTableBase", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 4 &&
-      !Decode<UIntValue>("Flags", decoder, fields)) {
-    return false;
-  }
-
-  if (!DecodeSID("UserSID", is_64_bit, decoder, fields))
-    return false;
-
-  if (version >= 1 &&
-      !Decode<StringValue>("ImageFileName", decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 2 &&
-      !DecodeW16String("CommandLine", decoder, fields)) {
-    return false;
-  }
-
-  if (version >= 4 && (
-      !DecodeW16String("PackageFullName", decoder, fields) ||
-      !DecodeW16String("ApplicationId", decoder, fields))) {
-    return false;
-  }
-
-  if (version >= 5 &&
-      !Decode<ULongValue>("ExitTime", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeProcessTerminatePayload(Decoder* decoder,
-                                   unsigned char version,
-                                   unsigned char opcode,
-                                   bool is_64_bit,
-                                   std::string* operation,
-                                   StructValue* fields) {
-  DCHECK(opcode == kProcessTerminateOpcode);
-  DCHECK(is_64_bit);
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "Terminate";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("ProcessId", decoder, fields))
-    return false;
-
-  return true;
-}
-
-bool DecodeProcessPerfCtrPayload(Decoder* decoder,
-                                 unsigned char version,
-                                 unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
-                                 StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kProcessPerfCtrOpcode:
-      *operation = "PerfCtr";
-      break;
-
-    case kProcessPerfCtrRundownOpcode:
-      *operation = "PerfCtrRundown";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED();
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("ProcessId", decoder, fields) ||
-      !Decode<UIntValue>("PageFaultCount", decoder, fields) ||
-      !Decode<UIntValue>("HandleCount", decoder, fields) ||
-      !Decode<UIntValue>("Reserved", decoder, fields) ||
-      !DecodeUInteger("PeakVirtualSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PeakWorkingSetSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PeakPagefileUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("QuotaPeakPagedPoolUsage", is_64_bit,  decoder, fields) ||
-      !DecodeUInteger("QuotaPeakNonPagedPoolUsage", is_64_bit, decoder,
-                      fields) ||
-      !DecodeUInteger("VirtualSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("WorkingSetSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PagefileUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("QuotaPagedPoolUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("QuotaNonPagedPoolUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PrivatePageCount", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeProcessPayload(Decoder* decoder,
-                          unsigned char version,
-                          unsigned char opcode,
-                          bool is_64_bit,
-                          std::string* operation,
-                          StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kProcessDCStartOpcode:
-    case kProcessStartOpcode:
-    case kProcessDefunctOpcode:
-    case kProcessDCEndOpcode:
-    case kProcessEndOpcode:
-      return DecodeProcessStartEndDefunctPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kProcessTerminateOpcode:
-      return DecodeProcessTerminatePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kProcessPerfCtrOpcode:
-    case kProcessPerfCtrRundownOpcode:
-      return DecodeProcessPerfCtrPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
-}
-
-bool DecodeTcplpGroup1IPV4Payload(Decoder* decoder,
-                                  unsigned char version,
-                                  unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
-                                  StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kTcplpRecvIPV4Opcode:
-      *operation = "RecvIPV4";
-      break;
-
-    case kTcplpDisconnectIPV4Opcode:
-      *operation = "DisconnectIPV4";
-      break;
-
-    case kTcplpRetransmitIPV4Opcode:
-      *operation = "RetransmitIPV4";
-      break;
-
-    case kTcplpReconnectIPV4Opcode:
-      *operation = "ReconnectIPV4";
-      break;
-
-    case kTcplpTCPCopyIPV4Opcode:
-      *operation = "TCPCopyIPV4";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED();
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("PID", decoder, fields) ||
-      !Decode<UIntValue>("size", decoder, fields) ||
-      !Decode<UIntValue>("daddr", decoder, fields) ||
-      !Decode<UIntValue>("saddr", decoder, fields) ||
-      !Decode<UShortValue>("dport", decoder, fields) ||
-      !Decode<UShortValue>("sport", decoder, fields) ||
-      !Decode<UIntValue>("seqnum", decoder, fields) ||
-      !DecodeUInteger("connid", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-
-bool DecodeTcplpGroup2IPV4Payload(Decoder* decoder,
-                                  unsigned char version,
-                                  unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
-                                  StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kTcplpConnectIPV4Opcode:
-      *operation = "ConnectIPV4";
-      break;
-    case kTcplpAcceptIPV4Opcode:
-      *operation = "AcceptIPV4";
-      break;
-    default:
-      // TODO(fdoray): NOTREACHED();
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("PID", decoder, fields) ||
-      !Decode<UIntValue>("size", decoder, fields) ||
-      !Decode<UIntValue>("daddr", decoder, fields) ||
-      !Decode<UIntValue>("saddr", decoder, fields) ||
-      !Decode<UShortValue>("dport", decoder, fields) ||
-      !Decode<UShortValue>("sport", decoder, fields) ||
-      !Decode<UShortValue>("mss", decoder, fields) ||
-      !Decode<UShortValue>("sackopt", decoder, fields) ||
-      !Decode<UShortValue>("tsopt", decoder, fields) ||
-      !Decode<UShortValue>("wsopt", decoder, fields) ||
-      !Decode<UIntValue>("rcvwin", decoder, fields) ||
-      !Decode<ShortValue>("rcvwinscale", decoder, fields) ||
-      !Decode<ShortValue>("sndwinscale", decoder, fields) ||
-      !Decode<UIntValue>("seqnum", decoder, fields) ||
-      !DecodeUInteger("connid", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeTcplpSendIPV4Payload(Decoder* decoder,
-                                unsigned char version,
-                                unsigned char opcode,
-                                bool is_64_bit,
-                                std::string* operation,
-                                StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kTcplpSendIPV4Opcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "SendIPV4";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("PID", decoder, fields) ||
-      !Decode<UIntValue>("size", decoder, fields) ||
-      !Decode<UIntValue>("daddr", decoder, fields) ||
-      !Decode<UIntValue>("saddr", decoder, fields) ||
-      !Decode<UShortValue>("dport", decoder, fields) ||
-      !Decode<UShortValue>("sport", decoder, fields) ||
-      !Decode<UIntValue>("startime", decoder, fields) ||
-      !Decode<UIntValue>("endtime", decoder, fields) ||
-      !Decode<UIntValue>("seqnum", decoder, fields) ||
-      !DecodeUInteger("connid", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeTcplpPayload(Decoder* decoder,
-                        unsigned char version,
-                        unsigned char opcode,
-                        bool is_64_bit,
-                        std::string* operation,
-                        StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kTcplpRecvIPV4Opcode:
-    case kTcplpDisconnectIPV4Opcode:
-    case kTcplpRetransmitIPV4Opcode:
-    case kTcplpReconnectIPV4Opcode:
-    case kTcplpTCPCopyIPV4Opcode:
-      return DecodeTcplpGroup1IPV4Payload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kTcplpConnectIPV4Opcode:
-    case kTcplpAcceptIPV4Opcode:
-      return DecodeTcplpGroup2IPV4Payload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kTcplpSendIPV4Opcode:
-      return DecodeTcplpSendIPV4Payload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
-}
-
-bool DecodeRegistryGenericPayload(Decoder* decoder,
-                                  unsigned char version,
-                                  unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
-                                  StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version < 1 || version > 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kRegistryCreateOpcode:
-      *operation = "Create";
-      break;
-
-    case kRegistryOpenOpcode:
-      *operation = "Open";
-      break;
-
-    case kRegistryDeleteOpcode:
-      *operation = "Delete";
-      break;
-
-    case kRegistryQueryOpcode:
-      *operation = "Query";
-      break;
-
-    case kRegistrySetValueOpcode:
-      *operation = "SetValue";
-      break;
-
-    case kRegistryDeleteValueOpcode:
-      *operation = "DeleteValue";
-      break;
-
-    case kRegistryQueryValueOpcode:
-      *operation = "QueryValue";
-      break;
-
-    case kRegistryEnumerateKeyOpcode:
-      *operation = "EnumerateKey";
-      break;
-
-    case kRegistryEnumerateValueKeyOpcode:
-      *operation = "EnumerateValueKey";
-      break;
-
-    case kRegistryQueryMultipleValueOpcode:
-      *operation = "QueryMultipleValue";
-      break;
-
-    case kRegistrySetInformationOpcode:
-      *operation = "SetInformation";
-      break;
-
-    case kRegistryFlushOpcode:
-      *operation = "Flush";
-      break;
-
-    case kRegistryKCBCreateOpcode:
-      *operation = "KCBCreate";
-      break;
-
-    case kRegistryKCBDeleteOpcode:
-      *operation = "KCBDelete";
-      break;
-
-    case kRegistryKCBRundownBeginOpcode:
-      *operation = "KCBRundownBegin";
-      break;
-
-    case kRegistryKCBRundownEndOpcode:
-      *operation = "KCBRundownEnd";
-      break;
-
-    case kRegistryVirtualizeOpcode:
-      *operation = "Virtualize";
-      break;
-
-    case kRegistryCloseOpcode:
-      *operation = "Close";
-      break;
-
-    case kRegistrySetSecurityOpcode:
-      *operation = "SetSecurity";
-      break;
-
-    case kRegistryQuerySecurityOpcode:
-      *operation = "QuerySecurity";
-      break;
-
-    default:
-      // TODO(fdoray): NOTREACHED();
-      return false;
-  }
-
-  // Decode the payload.
-  if (version == 1) {
-    if (!Decode<UIntValue>("Status", decoder, fields) ||
-        !DecodeUInteger("KeyHandle", is_64_bit, decoder, fields) ||
-        !Decode<LongValue>("ElapsedTime", decoder, fields) ||
-        !Decode<UIntValue>("Index", decoder, fields) ||
-        !DecodeW16String("KeyName", decoder, fields)) {
-      return false;
-    }
-  } else {
-    if (!Decode<LongValue>("InitialTime", decoder, fields) ||
-        !Decode<UIntValue>("Status", decoder, fields) ||
-        !Decode<UIntValue>("Index", decoder, fields) ||
-        !DecodeUInteger("KeyHandle", is_64_bit, decoder, fields) ||
-        !DecodeW16String("KeyName", decoder, fields)) {
-      return false;
-    }
-  }
-
-  return true;
-}
-
-bool DecodeRegistryCountersPayload(Decoder* decoder,
-                                   unsigned char version,
-                                   unsigned char opcode,
-                                   bool /* is_64_bit */,
-                                   std::string* operation,
-                                   StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kRegistryCountersOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "Counters";
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("Counter1", decoder, fields) ||
-      !Decode<ULongValue>("Counter2", decoder, fields) ||
-      !Decode<ULongValue>("Counter3", decoder, fields) ||
-      !Decode<ULongValue>("Counter4", decoder, fields) ||
-      !Decode<ULongValue>("Counter5", decoder, fields) ||
-      !Decode<ULongValue>("Counter6", decoder, fields) ||
-      !Decode<ULongValue>("Counter7", decoder, fields) ||
-      !Decode<ULongValue>("Counter8", decoder, fields) ||
-      !Decode<ULongValue>("Counter9", decoder, fields) ||
-      !Decode<ULongValue>("Counter10", decoder, fields) ||
-      !Decode<ULongValue>("Counter11", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeRegistryConfigPayload(Decoder* decoder,
-                                 unsigned char version,
-                                 unsigned char opcode,
-                                 bool /* is_64_bit */,
-                                 std::string* operation,
-                                 StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kRegistryConfigOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "Config";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("CurrentControlSet", decoder, fields))
-    return false;
-
-  return true;
-}
-
-bool DecodeRegistryPayload(Decoder* decoder,
-                           unsigned char version,
-                           unsigned char opcode,
-                           bool is_64_bit,
-                           std::string* operation,
-                           StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kRegistryCreateOpcode:
-    case kRegistryOpenOpcode:
-    case kRegistryDeleteOpcode:
-    case kRegistryQueryOpcode:
-    case kRegistrySetValueOpcode:
-    case kRegistryDeleteValueOpcode:
-    case kRegistryQueryValueOpcode:
-    case kRegistryEnumerateKeyOpcode:
-    case kRegistryEnumerateValueKeyOpcode:
-    case kRegistryQueryMultipleValueOpcode:
-    case kRegistrySetInformationOpcode:
-    case kRegistryFlushOpcode:
-    case kRegistryKCBCreateOpcode:
-    case kRegistryKCBDeleteOpcode:
-    case kRegistryKCBRundownBeginOpcode:
-    case kRegistryKCBRundownEndOpcode:
-    case kRegistryVirtualizeOpcode:
-    case kRegistryCloseOpcode:
-    case kRegistrySetSecurityOpcode:
-    case kRegistryQuerySecurityOpcode:
-      return DecodeRegistryGenericPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kRegistryCountersOpcode:
-      return DecodeRegistryCountersPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kRegistryConfigOpcode:
-      return DecodeRegistryConfigPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
-}
-
-bool DecodeFileIOFileNamePayload(Decoder* decoder,
-                                 unsigned char version,
-                                 unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
-                                 StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kFileIOFileCreateOpcode:
-      *operation = "FileCreate";
-      break;
-    case kFileIOFileDeleteOpcode:
-      *operation = "FileDelete";
-      break;
-    case kFileIOFileRundownOpcode:
-      *operation = "FileRundown";
-      break;
-    default:
-      return false;
-  }
-
-  // Decode the payload.
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeW16String("FileName", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeFileIOCreatePayload(Decoder* decoder,
-                               unsigned char version,
-                               unsigned char opcode,
-                               bool is_64_bit,
-                               std::string* operation,
-                               StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kFileIOCreateOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  *operation = "Create";
-
-  // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
-    return false;
-
-  if (version == 2 && (
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields))) {
-    return false;
-  }
-
-  if (version == 3 && (
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("TTID", decoder, fields))) {
-    return false;
-  }
-
-  if (!Decode<UIntValue>("CreateOptions", decoder, fields) ||
-      !Decode<UIntValue>("FileAttributes", decoder, fields) ||
-      !Decode<UIntValue>("ShareAccess", decoder, fields) ||
-      !DecodeW16String("OpenPath", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeFileIOSimpleOpPayload(Decoder* decoder,
-                                 unsigned char version,
-                                 unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
-                                 StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kFileIOCleanupOpcode:
-      *operation = "Cleanup";
-      break;
-    case kFileIOCloseOpcode:
-      *operation = "Close";
-      break;
-    case kFileIOFlushOpcode:
-      *operation = "Flush";
-      break;
-    default:
-      return false;
-  }
-
-  // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
-    return false;
-
-  if (version == 2 && (
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields))) {
-    return false;
-  }
-
-  if (version == 3 && (
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("TTID", decoder, fields))) {
-    return false;
-  }
-
-  return true;
+void AddEventTraceLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kEventTraceEventHeaderOpcode, "Header" } },
+      { { "BufferSize", kFieldUInt },
+        { "Version", kFieldUInt },
+        { "ProviderVersion", kFieldUInt },
+        { "NumberOfProcessors", kFieldUInt },
+        { "EndTime", kFieldULong },
+        { "TimerResolution", kFieldUInt },
+        { "MaxFileSize", kFieldUInt },
+        { "LogFileMode", kFieldUInt },
+        { "BuffersWritten", kFieldUInt },
+        { "StartBuffers", kFieldUInt },
+        { "PointerSize", kFieldUInt },
+        { "EventsLost", kFieldUInt },
+        { "CPUSpeed", kFieldUInt },
+        { "LoggerName", kFieldPointer },
+        { "LogFileName", kFieldPointer },
+        { "TimeZoneInformation", kFieldTimeZoneInformation },
+        { "Padding", kFieldUInt },
+        { "BootTime", kFieldULong },
+        { "PerfFreq", kFieldULong },
+        { "StartTime", kFieldULong },
+        { "ReservedFlags", kFieldUInt },
+        { "BuffersLost", kFieldUInt },
+        { "SessionNameString", kFieldW16String },
+        { "LogFileNameString", kFieldW16String } });
+
+  table->AddLayout(Versions(0, 2), kAnyPointerSize,
+      { { kEventTraceEventExtensionOpcode, "Extension" } },
+      { { "GroupMask1", kFieldUInt },
+        { "GroupMask2", kFieldUInt },
+        { "GroupMask3", kFieldUInt },
+        { "GroupMask4", kFieldUInt },
+        { "GroupMask5", kFieldUInt },
+        { "GroupMask6", kFieldUInt },
+        { "GroupMask7", kFieldUInt },
+        { "GroupMask8", kFieldUInt },
+        { "KernelEventVersion", kFieldUInt, Version(2) } });
 }
 
-bool DecodeFileIOReadWritePayload(Decoder* decoder,
-                                  unsigned char version,
-                                  unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
-                                  StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kFileIOReadOpcode:
-      *operation = "Read";
-      break;
-    case kFileIOWriteOpcode:
-      *operation = "Write";
-      break;
-    default:
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("Offset", decoder, fields) ||
-      !DecodeUInteger("IrpPtr", is_64_bit, decoder, fields)) {
-    return false;
-  }
-  
-  if (version == 2 &&
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields)) {
-    return false;
-  }
-  
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields)) {
-    return false;
-  }
-  
-  if (version == 3 &&
-      !Decode<UIntValue>("TTID", decoder, fields)) {
-    return false;
-  }
-  
-  if (!Decode<UIntValue>("IoSize", decoder, fields) ||
-      !Decode<UIntValue>("IoFlags", decoder, fields)) {
-    return false;
-  }
-
-  // Padding at the end of 64 bit events.
-  if (is_64_bit && version == 3 && !decoder->Skip(4))
-    return false;
-
-  return true;
+void AddImageLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Versions(0, 3), kAnyPointerSize,
+      { { kImageLoadOpcode, "Load" },
+        { kImageUnloadOpcode, "Unload" },
+        { kImageDCStartOpcode, "DCStart" },
+        { kImageDCEndOpcode, "DCEnd" } },
+      { { "BaseAddress", kFieldPointer },
+        { "ModuleSize", kFieldUInt, Version(0) },
+        { "ModuleSize", kFieldPointer, SinceVersion(1) },
+        { "ProcessId", kFieldUInt, SinceVersion(1) },
+        { "ImageCheckSum", kFieldUInt, SinceVersion(2) },
+        { "TimeDateStamp", kFieldUInt, SinceVersion(2) },
+        { "Reserved0", kFieldUInt, Version(2) },
+        { "SignatureLevel", kFieldUChar, SinceVersion(3) },
+        { "SignatureType", kFieldUChar, SinceVersion(3) },
+        { "Reserved0", kFieldUShort, SinceVersion(3) },
+        { "DefaultBase", kFieldPointer, SinceVersion(2) },
+        { "Reserved1", kFieldUInt, SinceVersion(2) },
+        { "Reserved2", kFieldUInt, SinceVersion(2) },
+        { "Reserved3", kFieldUInt, SinceVersion(2) },
+        { "Reserved4", kFieldUInt, SinceVersion(2) },
+        { "ImageFileName", kFieldW16String } });
+
+  table->AddLayout(Versions(0, 3), kAnyPointerSize,
+      { { kImageKernelBaseOpcode, "KernelBase" } },
+      { { "BaseAddress", kFieldPointer } });
 }
 
-bool DecodeFileIOPathPayload(Decoder* decoder,
-                             unsigned char version,
-                             unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
-                             StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
+void AddPerfInfoLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoSampleProfOpcode, "SampleProf" } },
+      { { "InstructionPointer", kFieldPointer },
+        { "ThreadId", kFieldUInt },
+        { "Count", kFieldUShort },
+        { "Reserved", kFieldUShort } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoSysClEnterOpcode, "SysClEnter" } },
+      { { "SysCallAddress", kFieldPointer } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoSysClExitOpcode, "SysClExit" } },
+      { { "SysCallNtStatus", kFieldUInt } });
+
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kPerfInfoCollectionSetIntervalOpcode, "SetInterval" },
+        { kPerfInfoCollectionStartOpcode, "CollectionStart" },
+        { kPerfInfoCollectionEndOpcode, "CollectionEnd" } },
+      { { "Source", kFieldUInt },
+        { "NewInterval", kFieldUInt },
+        { "OldInterval", kFieldUInt },
+        { "SourceName", kFieldW16String, SinceVersion(3) } });
+
+  table->AddLayout(Version(3), kAnyPointerSize,
+      { { kPerfInfoCollectionStartSecondOpcode, "CollectionStart" },
+        { kPerfInfoCollectionEndSecondOpcode, "CollectionEnd" } },
+      { { "SpinLockSpinThreshold", kFieldUInt },
+        { "SpinLockContentionSampleRate", kFieldUInt },
+        { "SpinLockAcquireSampleRate", kFieldUInt },
+        { "SpinLockHoldThreshold", kFieldUInt } });
+
+  const std::vector<FieldLayout> kISRFields = {
+    { "InitialTime", kFieldULong },
+    { "Routine", kFieldPointer },
+    { "ReturnValue", kFieldUChar },
+    { "Vector", kFieldUShort },
+    { "Reserved", kFieldUChar } };
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoISROpcode, "ISR" } },
+      kISRFields);
+
+  std::vector<FieldLayout> isr_msi_fields(kISRFields);
+  isr_msi_fields.push_back(FieldLayout("MessageNumber", kFieldUInt));
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoISRMSIOpcode, "ISR-MSI" } },
+      isr_msi_fields);
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoThreadedDPCOpcode, "ThreadedDPC" },
+        { kPerfInfoDPCOpcode, "DPC" },
+        { kPerfInfoTimerDPCOpcode, "TimerDPC" } },
+      { { "InitialTime", kFieldULong },
+        { "Routine", kFieldPointer } });
+
+  // TODO(fdoray): Decode these events.
+  table->AddLayout(AllVersions(), kAnyPointerSize,
+      { { kPerfInfoUnknown80Opcode, NULL },
+        { kPerfInfoUnknown81Opcode, NULL },
+        { kPerfInfoUnknown82Opcode, NULL },
+        { kPerfInfoUnknown83Opcode, NULL },
+        { kPerfInfoUnknown84Opcode, NULL },
+        { kPerfInfoUnknown85Opcode, NULL } },
+      {});
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPerfInfoDebuggerEnabledOpcode, "DebuggerEnabled" } },
+      {});
+}
 
-  if (!is_64_bit || version != 3)
-    return false;
+void AddThreadLayouts(PayloadLayoutTable* table) {
+  const std::vector<FieldLayout> kStartEndFields = {
+    { "ProcessId", kFieldUInt },
+    { "TThreadId", kFieldUInt },
+    { "StackBase", kFieldPointer },
+    { "StackLimit", kFieldPointer },
+    { "UserStackBase", kFieldPointer },
+    { "UserStackLimit", kFieldPointer },
+    { "StartAddr", kFieldPointer, Versions(1, 2) },
+    { "Affinity", kFieldPointer, SinceVersion(3) },
+    { "Win32StartAddr", kFieldPointer },
+    { "TebBase", kFieldPointer, SinceVersion(2) },
+    { "SubProcessTag", kFieldUInt, SinceVersion(2) },
+    { "BasePriority", kFieldUChar, SinceVersion(3) },
+    { "PagePriority", kFieldUChar, SinceVersion(3) },
+    { "IoPriority", kFieldUChar, SinceVersion(3) },
+    { "ThreadFlags", kFieldUChar, SinceVersion(3) },
+    // This field is a signed char, but is padded to an integer 32-bit.
+    { "WaitMode", kFieldChar, Version(1) },
+    { NULL, kFieldPadding, 3, Version(1) } };
+  table->AddLayout(Versions(1, 3), kAnyPointerSize,
+      { { kThreadStartOpcode, "Start" },
+        { kThreadDCStartOpcode, "DCStart" } },
+      kStartEndFields);
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kThreadEndOpcode, "End" },
+        { kThreadDCEndOpcode, "DCEnd" } },
+      kStartEndFields);
+  table->AddLayout(Version(1), kAnyPointerSize,
+      { { kThreadEndOpcode, "End" },
+        { kThreadDCEndOpcode, "DCEnd" } },
+      { { "ProcessId", kFieldUInt },
+        { "TThreadId", kFieldUInt } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kThreadCSwitchOpcode, "CSwitch" } },
+      { { "NewThreadId", kFieldUInt },
+        { "OldThreadId", kFieldUInt },
+        { "NewThreadPriority", kFieldChar },
+        { "OldThreadPriority", kFieldChar },
+        { "PreviousCState", kFieldUChar },
+        { "SpareByte", kFieldChar },
+        { "OldThreadWaitReason", kFieldChar },
+        { "OldThreadWaitMode", kFieldChar },
+        { "OldThreadState", kFieldChar },
+        { "OldThreadWaitIdealProcessor", kFieldChar },
+        { "NewThreadWaitTime", kFieldUInt },
+        { "Reserved", kFieldUInt } });
+
+  // The CompCS payload is a compressed version of the CSwitch payload.
+  // TODO(bergeret): Determine a way to decode this event.
 
-  // Set the operation name.
-  switch (opcode) {
-    case kFileIODletePathOpcode:
-      *operation = "DeletePath";
-      break;
-    case kFileIORenamePathOpcode:
-      *operation = "RenamePath";
-      break;
-    default:
-      return false;
-  }
+  table->AddLayout(Version(2), k64BitOnly,
+      { { kThreadSpinLockOpcode, "SpinLock" } },
+      { { "SpinLockAddress", kFieldULong },
+        { "CallerAddress", kFieldULong },
+        { "AcquireTime", kFieldULong },
+        { "ReleaseTime", kFieldULong },
+        { "WaitTimeInCycles", kFieldUInt },
+        { "SpinCount", kFieldUInt },
+        { "ThreadId", kFieldUInt },
+        { "InterruptCount", kFieldUInt },
+        { "Irql", kFieldUChar },
+        { "AcquireDepth", kFieldUChar },
+        { "Flag", kFieldUChar },
+        { "Reserved", kFieldUCharArray, 5 } });
+
+  table->AddLayout(Version(3), k64BitOnly,
+      { { kThreadSetPriorityOpcode, "SetPriority" },
+        { kThreadSetIoPriorityOpcode, "SetIoPriority" },
+        { kThreadSetBasePriorityOpcode, "SetBasePriority" },
+        { kThreadSetPagePriorityOpcode, "SetPagePriority" } },
+      { { "ThreadId", kFieldUInt },
+        { "OldPriority", kFieldUChar },
+        { "NewPriority", kFieldUChar },
+        { "Reserved", kFieldUShort } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kThreadReadyThreadOpcode, "ReadyThread" } },
+      { { "TThreadId", kFieldUInt },
+        { "AdjustReason", kFieldChar },
+        { "AdjustIncrement", kFieldChar },
+        { "Flag", kFieldChar },
+        { "Reserved", kFieldChar } });
+
+  table->AddLayout(Version(2), k64BitOnly,
+      { { kThreadAutoBoostSetFloorOpcode, "AutoBoostSetFloor" } },
+      { { "Lock", kFieldULong },
+        { "ThreadId", kFieldUInt },
+        { "NewCpuPriorityFloor", kFieldUChar },
+        { "OldCpuPriority", kFieldUChar },
+        { "IoPriorities", kFieldUChar },
+        { "BoostFlags", kFieldUChar } });
+
+  table->AddLayout(Version(2), k64BitOnly,
+      { { kThreadAutoBoostClearFloorOpcode, "AutoBoostClearFloor" } },
+      { { "LockAddress", kFieldULong },
+        { "ThreadId", kFieldUInt },
+        { "BoostBitmap", kFieldUShort },
+        { "Reserved", kFieldUShort } });
+
+  table->AddLayout(Version(2), k64BitOnly,
+      { { kThreadAutoBoostEntryExhaustionOpcode,
+          "AutoBoostEntryExhaustion" } },
+      { { "LockAddress", kFieldULong },
+        { "ThreadId", kFieldUInt },
+        { NULL, kFieldPadding, 4 } });
+}
 
-  // Decode the payload.
-  if (!Decode<ULongValue>("IrpPtr", decoder, fields) ||
-      !Decode<ULongValue>("FileObject", decoder, fields) ||
-      !Decode<ULongValue>("FileKey", decoder, fields) ||
-      !Decode<ULongValue>("ExtraInfo", decoder, fields) ||
-      !Decode<UIntValue>("TTID", decoder, fields) ||
-      !Decode<UIntValue>("InfoClass", decoder, fields) ||
-      !DecodeW16String("FileName", decoder, fields)) {
-    return false;
-  }
+void AddProcessLayouts(PayloadLayoutTable* table) {
+  const std::vector<FieldLayout> kStartEndFields = {
+    { "PageDirectoryBase", kFieldPointer, Version(1) },
+    { "UniqueProcessKey", kFieldPointer, SinceVersion(2) },
+    { "ProcessId", kFieldUInt },
+    { "ParentId", kFieldUInt },
+    { "SessionId", kFieldUInt, SinceVersion(1) },
+    { "ExitStatus", kFieldInt, SinceVersion(1) },
+    { "DirectoryTableBase", kFieldPointer, SinceVersion(3) },
+    { "Flags", kFieldUInt, SinceVersion(4) },
+    { "UserSID", kFieldSID },
+    { "ImageFileName", kFieldString, SinceVersion(1) },
+    { "CommandLine", kFieldW16String, SinceVersion(2) },
+    { "PackageFullName", kFieldW16String, SinceVersion(4) },
+    { "ApplicationId", kFieldW16String, SinceVersion(4) },
+    { "ExitTime", kFieldULong, SinceVersion(5) } };
+  table->AddLayout(Versions(0, 4), kAnyPointerSize,
+      { { kProcessStartOpcode, "Start" },
+        { kProcessEndOpcode, "End" },
+        { kProcessDCStartOpcode, "DCStart" },
+        { kProcessDCEndOpcode, "DCEnd" } },
+      kStartEndFields);
+  table->AddLayout(Versions(2, 5), kAnyPointerSize,
+      { { kProcessDefunctOpcode, "Defunct" } },
+      kStartEndFields);
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kProcessTerminateOpcode, "Terminate" } },
+      { { "ProcessId", kFieldUInt } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kProcessPerfCtrOpcode, "PerfCtr" },
+        { kProcessPerfCtrRundownOpcode, "PerfCtrRundown" } },
+      { { "ProcessId", kFieldUInt },
+        { "PageFaultCount", kFieldUInt },
+        { "HandleCount", kFieldUInt },
+        { "Reserved", kFieldUInt },
+        { "PeakVirtualSize", kFieldPointer },
+        { "PeakWorkingSetSize", kFieldPointer },
+        { "PeakPagefileUsage", kFieldPointer },
+        { "QuotaPeakPagedPoolUsage", kFieldPointer },
+        { "QuotaPeakNonPagedPoolUsage", kFieldPointer },
+        { "VirtualSize", kFieldPointer },
+        { "WorkingSetSize", kFieldPointer },
+        { "PagefileUsage", kFieldPointer },
+        { "QuotaPagedPoolUsage", kFieldPointer },
+        { "QuotaNonPagedPoolUsage", kFieldPointer },
+        { "PrivatePageCount", kFieldPointer } });
+}
 
-  return true;
+void AddTcplpLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kTcplpSendIPV4Opcode, "SendIPV4" } },
+      { { "PID", kFieldUInt },
+        { "size", kFieldUInt },
+        { "daddr", kFieldUInt },
+        { "saddr", kFieldUInt },
+        { "dport", kFieldUShort },
+        { "sport", kFieldUShort },
+        { "startime", kFieldUInt },
+        { "endtime", kFieldUInt },
+        { "seqnum", kFieldUInt },
+        { "connid", kFieldPointer } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kTcplpRecvIPV4Opcode, "RecvIPV4" },
+        { kTcplpDisconnectIPV4Opcode, "DisconnectIPV4" },
+        { kTcplpRetransmitIPV4Opcode, "RetransmitIPV4" },
+        { kTcplpReconnectIPV4Opcode, "ReconnectIPV4" },
+        { kTcplpTCPCopyIPV4Opcode, "TCPCopyIPV4" } },
+      { { "PID", kFieldUInt },
+        { "size", kFieldUInt },
+        { "daddr", kFieldUInt },
+        { "saddr", kFieldUInt },
+        { "dport", kFieldUShort },
+        { "sport", kFieldUShort },
+        { "seqnum", kFieldUInt },
+        { "connid", kFieldPointer } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kTcplpConnectIPV4Opcode, "ConnectIPV4" },
+        { kTcplpAcceptIPV4Opcode, "AcceptIPV4" } },
+      { { "PID", kFieldUInt },
+        { "size", kFieldUInt },
+        { "daddr", kFieldUInt },
+        { "saddr", kFieldUInt },
+        { "dport", kFieldUShort },
+        { "sport", kFieldUShort },
+        { "mss", kFieldUShort },
+        { "sackopt", kFieldUShort },
+        { "tsopt", kFieldUShort },
+        { "wsopt", kFieldUShort },
+        { "rcvwin", kFieldUInt },
+        { "rcvwinscale", kFieldShort },
+        { "sndwinscale", kFieldShort },
+        { "seqnum", kFieldUInt },
+        { "connid", kFieldPointer } });
 }
 
-bool DecodeFileIOInfoPayload(Decoder* decoder,
-                             unsigned char version,
-                             unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
-                             StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
+void AddRegistryLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Versions(1, 2), kAnyPointerSize,
+      { { kRegistryCreateOpcode, "Create" },
+        { kRegistryOpenOpcode, "Open" },
+        { kRegistryDeleteOpcode, "Delete" },
+        { kRegistryQueryOpcode, "Query" },
+        { kRegistrySetValueOpcode, "SetValue" },
+        { kRegistryDeleteValueOpcode, "DeleteValue" },
+        { kRegistryQueryValueOpcode, "QueryValue" },
+        { kRegistryEnumerateKeyOpcode, "EnumerateKey" },
+        { kRegistryEnumerateValueKeyOpcode, "EnumerateValueKey" },
+        { kRegistryQueryMultipleValueOpcode, "QueryMultipleValue" },
+        { kRegistrySetInformationOpcode, "SetInformation" },
+        { kRegistryFlushOpcode, "Flush" },
+        { kRegistryKCBCreateOpcode, "KCBCreate" },
+        { kRegistryKCBDeleteOpcode, "KCBDelete" },
+        { kRegistryKCBRundownBeginOpcode, "KCBRundownBegin" },
+        { kRegistryKCBRundownEndOpcode, "KCBRundownEnd" },
+        { kRegistryVirtualizeOpcode, "Virtualize" },
+        { kRegistryCloseOpcode, "Close" },
+        { kRegistrySetSecurityOpcode, "SetSecurity" },
+        { kRegistryQuerySecurityOpcode, "QuerySecurity" } },
+      { { "InitialTime", kFieldLong, Version(2) },
+        { "Status", kFieldUInt },
+        { "KeyHandle", kFieldPointer, Version(1) },
+        { "ElapsedTime", kFieldLong, Version(1) },
+        { "Index", kFieldUInt },
+        { "KeyHandle", kFieldPointer, Version(2) },
+        { "KeyName", kFieldW16String } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kRegistryCountersOpcode, "Counters" } },
+      { { "Counter1", kFieldULong },
+        { "Counter2", kFieldULong },
+        { "Counter3", kFieldULong },
+        { "Counter4", kFieldULong },
+        { "Counter5", kFieldULong },
+        { "Counter6", kFieldULong },
+        { "Counter7", kFieldULong },
+        { "Counter8", kFieldULong },
+        { "Counter9", kFieldULong },
+        { "Counter10", kFieldULong },
+        { "Counter11", kFieldULong } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kRegistryConfigOpcode, "Config" } },
+      { { "CurrentControlSet", kFieldUInt } });
+}
 
-  if (version < 2 && version > 3)
-    return false;
+void AddFileIOLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kFileIOFileCreateOpcode, "FileCreate" },
+        { kFileIOFileDeleteOpcode, "FileDelete" },
+        { kFileIOFileRundownOpcode, "FileRundown" } },
+      { { "FileObject", kFieldPointer },
+        { "FileName", kFieldW16String } });
+
+  // In version 2, the thread id is pointer-sized and precedes the file
+  // object. In version 3, it is a 32-bit integer following the file key.
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kFileIOCreateOpcode, "Create" } },
+      { { "IrpPtr", kFieldPointer },
+        { "TTID", kFieldPointer, Version(2) },
+        { "FileObject", kFieldPointer },
+        { "TTID", kFieldUInt, Version(3) },
+        { "CreateOptions", kFieldUInt },
+        { "FileAttributes", kFieldUInt },
+        { "ShareAccess", kFieldUInt },
+        { "OpenPath", kFieldW16String } });
+
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kFileIOCleanupOpcode, "Cleanup" },
+        { kFileIOCloseOpcode, "Close" },
+        { kFileIOFlushOpcode, "Flush" } },
+      { { "IrpPtr", kFieldPointer },
+        { "TTID", kFieldPointer, Version(2) },
+        { "FileObject", kFieldPointer },
+        { "FileKey", kFieldPointer },
+        { "TTID", kFieldUInt, Version(3) } });
+
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kFileIOReadOpcode, "Read" },
+        { kFileIOWriteOpcode, "Write" } },
+      { { "Offset", kFieldULong },
+        { "IrpPtr", kFieldPointer },
+        { "TTID", kFieldPointer, Version(2) },
+        { "FileObject", kFieldPointer },
+        { "FileKey", kFieldPointer },
+        { "TTID", kFieldUInt, Version(3) },
+        { "IoSize", kFieldUInt },
+        { "IoFlags", kFieldUInt },
+        // Padding at the end of 64 bit events.
+        { NULL, kFieldPadding, 4, Version(3), k64BitOnly } });
+
+  table->AddLayout(Version(3), k64BitOnly,
+      { { kFileIODletePathOpcode, "DeletePath" },
+        { kFileIORenamePathOpcode, "RenamePath" } },
+      { { "IrpPtr", kFieldULong },
+        { "FileObject", kFieldULong },
+        { "FileKey", kFieldULong },
+        { "ExtraInfo", kFieldULong },
+        { "TTID", kFieldUInt },
+        { "InfoClass", kFieldUInt },
+        { "FileName", kFieldW16String } });
+
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kFileIOSetInfoOpcode, "SetInfo" },
+        { kFileIODeleteOpcode, "Delete" },
+        { kFileIORenameOpcode, "Rename" },
+        { kFileIOQueryInfoOpcode, "QueryInfo" },
+        { kFileIOFSControlOpcode, "FSControl" } },
+      { { "IrpPtr", kFieldPointer },
+        { "TTID", kFieldPointer, Version(2) },
+        { "FileObject", kFieldPointer },
+        { "FileKey", kFieldPointer },
+        { "ExtraInfo", kFieldPointer },
+        { "TTID", kFieldUInt, Version(3) },
+        { "InfoClass", kFieldUInt } });
+
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kFileIODirEnumOpcode, "DirEnum" },
+        { kFileIODirNotifyOpcode, "DirNotify" } },
+      { { "IrpPtr", kFieldPointer },
+        { "TTID", kFieldPointer, Version(2) },
+        { "FileObject", kFieldPointer },
+        { "FileKey", kFieldPointer },
+        { "TTID", kFieldUInt, Version(3) },
+        { "Length", kFieldUInt },
+        { "InfoClass", kFieldUInt },
+        { "FileIndex", kFieldUInt },
+        { "FileName", kFieldW16String } });
+
+  table->AddLayout(Versions(2, 3), kAnyPointerSize,
+      { { kFileIOOperationEndOpcode, "OperationEnd" } },
+      { { "IrpPtr", kFieldPointer },
+        { "ExtraInfo", kFieldPointer },
+        { "NtStatus", kFieldUInt } });
+}
 
-  // Set the operation name.
-  switch (opcode) {
-    case kFileIOSetInfoOpcode:
-      *operation = "SetInfo";
-      break;
-    case kFileIODeleteOpcode:
-      *operation = "Delete";
-      break;
-    case kFileIORenameOpcode:
-      *operation = "Rename";
-      break;
-    case kFileIOQueryInfoOpcode:
-      *operation = "QueryInfo";
-      break;
-    case kFileIOFSControlOpcode:
-      *operation = "FSControl";
-      break;
-    default:
-      return false;
-  }
+void AddDiskIOLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Versions(2, 3), k64BitOnly,
+      { { kDiskIOReadOpcode, "Read" },
+        { kDiskIOWriteOpcode, "Write" } },
+      { { "DiskNumber", kFieldUInt },
+        { "IrpFlags", kFieldUInt },
+        { "TransferSize", kFieldUInt },
+        { "Reserved", kFieldUInt },
+        { "ByteOffset", kFieldULong },
+        { "FileObject", kFieldULong },
+        { "Irp", kFieldULong },
+        { "HighResResponseTime", kFieldULong },
+        { "IssuingThreadId", kFieldUInt, Version(3) } });
+
+  table->AddLayout(Versions(2, 3), k64BitOnly,
+      { { kDiskIOReadInitOpcode, "ReadInit" },
+        { kDiskIOWriteInitOpcode, "WriteInit" },
+        { kDiskIOFlushInitOpcode, "FlushInit" } },
+      { { "Irp", kFieldULong },
+        { "IssuingThreadId", kFieldUInt, Version(3) } });
+
+  table->AddLayout(Versions(2, 3), k64BitOnly,
+      { { kDiskIOFlushBuffersOpcode, "FlushBuffers" } },
+      { { "DiskNumber", kFieldUInt },
+        { "IrpFlags", kFieldUInt },
+        { "HighResResponseTime", kFieldULong },
+        { "Irp", kFieldULong },
+        { "IssuingThreadId", kFieldUInt, Version(3) } });
+}
 
-  // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
-    return false;
-  
-  if (version == 2 &&
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields)) {
-    return false;
-  }
-  
+void AddStackWalkLayouts(PayloadLayoutTable* table) {
+  // The number of stack pointers is deduced from the event size.
+  table->AddLayout(Version(2), k64BitOnly,
+      { { kStackWalkStackOpcode, "Stack" } },
+      { { "EventTimeStamp", kFieldULong },
+        { "StackProcess", kFieldUInt },
+        { "StackThread", kFieldUInt },
+        { "Stack", kFieldULongTrailingArray } });
+}
 
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("ExtraInfo", is_64_bit, decoder, fields)) {
-    return false;
-  }
-  
-  if (version == 3 &&
-      !Decode<UIntValue>("TTID", decoder, fields)) {
-    return false;
-  }
-  
-  if (!Decode<UIntValue>("InfoClass", decoder, fields))
-    return false;
+void AddPageFaultLayouts(PayloadLayoutTable* table) {
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPageFaultTransitionFaultOpcode, "TransitionFault" },
+        { kPageFaultDemandZeroFaultOpcode, "DemandZeroFault" },
+        { kPageFaultCopyOnWriteOpcode, "CopyOnWrite" },
+        { kPageFaultGuardPageFaultOpcode, "GuardPageFault" },
+        { kPageFaultHardPageFaultOpcode, "HardPageFault" },
+        { kPageFaultAccessViolationOpcode, "AccessViolation" } },
+      { { "VirtualAddress", kFieldPointer },
+        { "ProgramCounter", kFieldPointer } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPageFaultHardFaultOpcode, "HardFault" } },
+      { { "InitialTime", kFieldULong },
+        { "ReadOffset", kFieldULong },
+        { "VirtualAddress", kFieldPointer },
+        { "FileObject", kFieldPointer },
+        { "TThreadId", kFieldUInt },
+        { "ByteCount", kFieldUInt } });
+
+  table->AddLayout(Version(2), kAnyPointerSize,
+      { { kPageFaultVirtualAllocOpcode, "VirtualAlloc" },
+        { kPageFaultVirtualFreeOpcode, "VirtualFree" } },
+      { { "BaseAddress", kFieldPointer },
+        { "RegionSize", kFieldPointer },
+        { "ProcessId", kFieldUInt },
+        { "Flags", kFieldUInt } });
+}
 
-  return true;
+// Describes how to decode the payloads of a provider.
+struct ProviderDecoder {
+  const base::Guid* provider_id;
+  const char* category;
+  // Severity of the message logged when a payload cannot be decoded.
+  base::LogSeverity error_severity;
+  const PayloadLayoutTable* layouts;
+};
+
+// Dispatch table of the supported providers, sorted by binary GUID so that
+// a provider is found with a binary search instead of string comparisons.
+class ProviderDecoderTable {
+ public:
+  ProviderDecoderTable() {
+    AddEventTraceLayouts(AddProvider(
+        kEventTraceEventProviderId, "EventTraceEvent", base::LOG_WARNING));
+    AddImageLayouts(AddProvider(kImageProviderId, "Image", base::LOG_ERROR));
+    // TODO(etienneb): Complete the decoding of PerfInfo and Thread payloads.
+    AddPerfInfoLayouts(AddProvider(
+        kPerfInfoProviderId, "PerfInfo", base::LOG_WARNING));
+    AddThreadLayouts(AddProvider(
+        kThreadProviderId, "Thread", base::LOG_WARNING));
+    AddProcessLayouts(AddProvider(
+        kProcessProviderId, "Process", base::LOG_WARNING));
+    AddTcplpLayouts(AddProvider(
+        kTcplpProviderId, "Tcplp", base::LOG_WARNING));
+    AddRegistryLayouts(AddProvider(
+        kRegistryProviderId, "Registry", base::LOG_WARNING));
+    AddFileIOLayouts(AddProvider(
+        kFileIOProviderId, "FileIO", base::LOG_WARNING));
+    AddDiskIOLayouts(AddProvider(
+        kDiskIOProviderId, "DiskIO", base::LOG_WARNING));
+    AddStackWalkLayouts(AddProvider(
+        kStackWalkProviderId, "StackWalk", base::LOG_WARNING));
+    AddPageFaultLayouts(AddProvider(
+        kPageFaultProviderId, "PageFault", base::LOG_WARNING));
+    std::sort(decoders_.begin(), decoders_.end(), &Less);
+  }
+
+  const ProviderDecoder* Find(const base::Guid& provider_id) const {
+    ProviderDecoder key = { &provider_id, NULL, base::LOG_INFO, NULL };
+    std::vector<ProviderDecoder>::const_iterator it =
+        std::lower_bound(decoders_.begin(), decoders_.end(), key, &Less);
+    if (it == decoders_.end() || *it->provider_id != provider_id)
+      return NULL;
+    return &*it;
+  }
+
+ private:
+  PayloadLayoutTable* AddProvider(const base::Guid& provider_id,
+                                  const char* category,
+                                  base::LogSeverity error_severity) {
+    layouts_.push_back(std::unique_ptr<PayloadLayoutTable>(
+        new PayloadLayoutTable(event::Atom::Intern(category))));
+    ProviderDecoder decoder = { &provider_id, category, error_severity,
+                                layouts_.back().get() };
+    decoders_.push_back(decoder);
+    return layouts_.back().get();
+  }
+
+  static bool Less(const ProviderDecoder& left,
+                   const ProviderDecoder& right) {
+    return *left.provider_id < *right.provider_id;
+  }
+
+  std::vector<ProviderDecoder> decoders_;
+  std::vector<std::unique_ptr<PayloadLayoutTable> > layouts_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProviderDecoderTable);
+};
+
+const ProviderDecoder* FindProviderDecoder(const base::Guid& provider_id) {
+  static const ProviderDecoderTable table;
+  return table.Find(provider_id);
 }
 
-bool DecodeFileIODirPayload(Decoder* decoder,
-                            unsigned char version,
-                            unsigned char opcode,
-                            bool is_64_bit,
-                            std::string* operation,
-                            StructValue* fields) {
+// Decodes a payload into a structure created with |arena|, or on the heap
+// when |arena| is NULL. Only the fields of |projection| are decoded, unless it
+// is NULL. |operation| and |category| may be NULL.
+bool DecodePayload(const base::Guid& provider_id,
+                   unsigned char version,
+                   unsigned char opcode,
+                   bool is_64_bit,
+                   Decoder* decoder,
+                   event::ValueArena* arena,
+                   const FieldProjection* projection,
+                   std::string* operation,
+                   std::string* category,
+                   StructValue** fields) {
   DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (version < 2 || version > 3)
+  // Dispatch event by provider (GUID).
+  const ProviderDecoder* provider = FindProviderDecoder(provider_id);
+  if (provider == NULL) {
+    // Unsupported event.
     return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kFileIODirEnumOpcode:
-      *operation = "DirEnum";
-      break;
-    case kFileIODirNotifyOpcode:
-      *operation = "DirNotify";
-      break;
-    default:
-      return false;
   }
 
-  // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
-    return false;
-  
-  if (version == 2 &&
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields)) {
-    return false;
+  event::EventType type;
+  const PayloadDecoder* payload_decoder =
+      provider->layouts->Find(opcode, version, is_64_bit, &type);
+  std::unique_ptr<StructValue> heap_fields;
+  StructValue* decoded = NULL;
+  if (payload_decoder != NULL) {
+    decoded = payload_decoder->CreateFields(arena, projection);
+    if (arena == NULL)
+      heap_fields.reset(decoded);
   }
 
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields)) {
+  if (payload_decoder == NULL ||
+      !payload_decoder->Decode(decoder, projection, decoded)) {
+    base::LogMessage(provider->error_severity, __FILE__, __LINE__).stream()
+        << "Error while decoding " << provider->category << " payload.";
     return false;
   }
 
-  if (version == 3 &&
-      !Decode<UIntValue>("TTID", decoder, fields)) {
-    return false;
-  }
-  
-  if (!Decode<UIntValue>("Length", decoder, fields) ||
-      !Decode<UIntValue>("InfoClass", decoder, fields) ||
-      !Decode<UIntValue>("FileIndex", decoder, fields) ||
-      !DecodeW16String("FileName", decoder, fields)) {
+  // Make sure that all the payload has been decoded.
+  if (decoder->RemainingBytes() != 0)
     return false;
-  }
 
+  // The names are only copied for the callers which request them.
+  if (operation != NULL && type.operation() != event::Atom())
+    *operation = type.operation().str();
+  if (category != NULL)
+    *category = provider->category;
+  heap_fields.release();
+  *fields = decoded;
   return true;
 }
 
-bool DecodeFileIOOperationEndPayload(Decoder* decoder,
-                                     unsigned char version,
-                                     unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
-                                     StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kFileIOOperationEndOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
+}  // namespace
 
-  if (version < 2 || version > 3)
-    return false;
+bool DecodeRawETWKernelPayload(const base::Guid& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               std::string* operation,
+                               std::string* category,
+                               std::unique_ptr<event::Value>* decoded_payload) {
+  DCHECK(payload != NULL || payload_size == 0);  // note: payload can be NULL.
+  DCHECK(decoded_payload != NULL);
 
-  // Set the operation name.
-  *operation = "OperationEnd";
+  // Create the byte decoder for the encoded payload.
+  Decoder decoder(payload, payload_size);
 
-  // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("ExtraInfo", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("NtStatus", decoder, fields)) {
+  StructValue* fields = NULL;
+  if (!DecodePayload(provider_id, version, opcode, is_64_bit, &decoder, NULL,
+                     NULL, operation, category, &fields)) {
     return false;
   }
 
+  // Successful decoding of this event.
+  decoded_payload->reset(fields);
   return true;
 }
 
-bool DecodeFileIOPayload(Decoder* decoder,
-                         unsigned char version,
-                         unsigned char opcode,
-                         bool is_64_bit,
-                         std::string* operation,
-                         StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kFileIOFileCreateOpcode:
-    case kFileIOFileDeleteOpcode:
-    case kFileIOFileRundownOpcode:
-      return DecodeFileIOFileNamePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIOCreateOpcode:
-      return DecodeFileIOCreatePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIOCleanupOpcode:
-    case kFileIOCloseOpcode:
-    case kFileIOFlushOpcode:
-      return DecodeFileIOSimpleOpPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIOReadOpcode:
-    case kFileIOWriteOpcode:
-      return DecodeFileIOReadWritePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIODletePathOpcode:
-    case kFileIORenamePathOpcode:
-      return DecodeFileIOPathPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIOSetInfoOpcode:
-    case kFileIODeleteOpcode:
-    case kFileIORenameOpcode:
-    case kFileIOQueryInfoOpcode:
-    case kFileIOFSControlOpcode:
-      return DecodeFileIOInfoPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIODirEnumOpcode:
-    case kFileIODirNotifyOpcode:
-      return DecodeFileIODirPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kFileIOOperationEndOpcode:
-      return DecodeFileIOOperationEndPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
+bool DecodeRawETWKernelPayload(const base::Guid& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               event::ValueArena* arena,
+                               std::string* operation,
+                               std::string* category,
+                               const event::Value** decoded_payload) {
+  return DecodeRawETWKernelPayload(provider_id, version, opcode, is_64_bit,
+                                   payload, payload_size, arena, NULL,
+                                   operation, category, decoded_payload);
 }
 
-bool DecodeDiskIOReadWritePayload(Decoder* decoder,
-                                  unsigned char version,
-                                  unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
-                                  StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit || version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kDiskIOReadOpcode:
-      *operation = "Read";
-      break;
-    case kDiskIOWriteOpcode:
-      *operation = "Write";
-      break;
-    default:
-      return false;
-  }
+bool DecodeRawETWKernelPayload(const base::Guid& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               event::ValueArena* arena,
+                               const FieldProjection* projection,
+                               std::string* operation,
+                               std::string* category,
+                               const event::Value** decoded_payload) {
+  DCHECK(payload != NULL || payload_size == 0);  // note: payload can be NULL.
+  DCHECK(arena != NULL);
+  DCHECK(decoded_payload != NULL);
 
-  // Decode the payload.
-  if (!Decode<UIntValue>("DiskNumber", decoder, fields) ||
-      !Decode<UIntValue>("IrpFlags", decoder, fields) ||
-      !Decode<UIntValue>("TransferSize", decoder, fields) ||
-      !Decode<UIntValue>("Reserved", decoder, fields) ||
-      !Decode<ULongValue>("ByteOffset", decoder, fields) ||
-      !Decode<ULongValue>("FileObject", decoder, fields) ||
-      !Decode<ULongValue>("Irp", decoder, fields) ||
-      !Decode<ULongValue>("HighResResponseTime", decoder, fields)) {
-    return false;
-  }
+  // Create the byte decoder for the encoded payload. The decoded fields are
+  // allocated in |arena| and released by the next reset of the arena; they
+  // share the lifetime of |payload|, so strings are not copied.
+  Decoder decoder(payload, payload_size);
+  decoder.set_use_string_views(true);
 
-  if (version == 3 &&
-      !Decode<UIntValue>("IssuingThreadId", decoder, fields)) {
+  StructValue* fields = NULL;
+  if (!DecodePayload(provider_id, version, opcode, is_64_bit, &decoder, arena,
+                     projection, operation, category, &fields)) {
     return false;
   }
 
+  // Successful decoding of this event.
+  *decoded_payload = fields;
   return true;
 }
 
-bool DecodeDiskIOInitPayload(Decoder* decoder,
+bool LookupRawETWKernelEvent(const base::Guid& provider_id,
                              unsigned char version,
                              unsigned char opcode,
                              bool is_64_bit,
                              std::string* operation,
-                             StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit || version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kDiskIOReadInitOpcode:
-      *operation = "ReadInit";
-      break;
-    case kDiskIOWriteInitOpcode:
-      *operation = "WriteInit";
-      break;
-    case kDiskIOFlushInitOpcode:
-      *operation = "FlushInit";
-      break;
-    default:
-      return false;
-  }
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("Irp", decoder, fields))
-    return false;
-
-  if (version == 3 &&
-      !Decode<UIntValue>("IssuingThreadId", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeDiskIOFlushBuffersPayload(Decoder* decoder,
-                                     unsigned char version,
-                                     unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
-                                     StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kDiskIOFlushBuffersOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (!is_64_bit || version < 2 || version > 3)
-    return false;
-
-  // Set the operation name.
-  *operation = "FlushBuffers";
-
-  // Decode the payload.
-  if (!Decode<UIntValue>("DiskNumber", decoder, fields) ||
-      !Decode<UIntValue>("IrpFlags", decoder, fields) ||
-      !Decode<ULongValue>("HighResResponseTime", decoder, fields) ||
-      !Decode<ULongValue>("Irp", decoder, fields)) {
-    return false;
-  }
-
-  if (version == 3 &&
-      !Decode<UIntValue>("IssuingThreadId", decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodeDiskIOPayload(Decoder* decoder,
-                         unsigned char version,
-                         unsigned char opcode,
-                         bool is_64_bit,
-                         std::string* operation,
-                         StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kDiskIOReadOpcode:
-    case kDiskIOWriteOpcode:
-      return DecodeDiskIOReadWritePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kDiskIOReadInitOpcode:
-    case kDiskIOWriteInitOpcode:
-    case kDiskIOFlushInitOpcode:
-      return DecodeDiskIOInitPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kDiskIOFlushBuffersOpcode:
-      return DecodeDiskIOFlushBuffersPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
-  }
-}
-
-bool DecodeStackWalkPayload(Decoder* decoder,
-                            unsigned char version,
-                            unsigned char opcode,
-                            bool is_64_bit,
-                            std::string* operation,
-                            StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2 || opcode != kStackWalkStackOpcode || !is_64_bit)
-    return false;
-
-  // Set the operation name.
-  *operation = "Stack";
-
-  // Deduce the number of stack pointers from the event size.
-  size_t num_stack_pointers = (decoder->RemainingBytes() - sizeof(int64_t) -
-                               2 * sizeof(uint32_t)) / sizeof(uint64_t);
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("EventTimeStamp", decoder, fields) ||
-      !Decode<UIntValue>("StackProcess", decoder, fields) ||
-      !Decode<UIntValue>("StackThread", decoder, fields) ||
-      !DecodeArray<ULongValue>("Stack", num_stack_pointers, decoder, fields)) {
-    return false;
-  }
-
-  return true;
-}
-
-bool DecodePageFaultCommonPageFaultPayload(Decoder* decoder,
-                                           unsigned char version,
-                                           unsigned char opcode,
-                                           bool is_64_bit,
-                                           std::string* operation,
-                                           StructValue* fields) {
-  DCHECK(decoder != NULL);
+                             std::string* category) {
   DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kPageFaultTransitionFaultOpcode:
-      *operation = "TransitionFault";
-      break;
-    case kPageFaultDemandZeroFaultOpcode:
-      *operation = "DemandZeroFault";
-      break;
-    case kPageFaultCopyOnWriteOpcode:
-      *operation = "CopyOnWrite";
-      break;
-    case kPageFaultGuardPageFaultOpcode:
-      *operation = "GuardPageFault";
-      break;
-    case kPageFaultHardPageFaultOpcode:
-      *operation = "HardPageFault";
-      break;
-    case kPageFaultAccessViolationOpcode:
-      *operation = "AccessViolation";
-      break;
-    default:
-      return false;
-  }
+  DCHECK(category != NULL);
 
-  // Decode the payload.
-  if (!DecodeUInteger("VirtualAddress", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("ProgramCounter", is_64_bit, decoder, fields)) {
+  const ProviderDecoder* provider = FindProviderDecoder(provider_id);
+  if (provider == NULL ||
+      provider->layouts->Find(opcode, version, is_64_bit, operation) == NULL) {
     return false;
   }
 
+  *category = provider->category;
   return true;
 }
 
-bool DecodePageFaultHardPageFaultPayload(Decoder* decoder,
-                                         unsigned char version,
-                                         unsigned char opcode,
-                                         bool is_64_bit,
-                                         std::string* operation,
-                                         StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(opcode == kPageFaultHardFaultOpcode);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  *operation = "HardFault";
-
-  // Decode the payload.
-  if (!Decode<ULongValue>("InitialTime", decoder, fields) ||
-      !Decode<ULongValue>("ReadOffset", decoder, fields) ||
-      !DecodeUInteger("VirtualAddress", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("TThreadId", decoder, fields) ||
-      !Decode<UIntValue>("ByteCount", decoder, fields)) {
-    return false;
-  }
+bool LookupRawETWKernelEvent(const base::Guid& provider_id,
+                             unsigned char version,
+                             unsigned char opcode,
+                             bool is_64_bit,
+                             event::EventType* type) {
+  DCHECK(type != NULL);
 
-  return true;
+  const ProviderDecoder* provider = FindProviderDecoder(provider_id);
+  return provider != NULL &&
+         provider->layouts->Find(opcode, version, is_64_bit, type) != NULL;
 }
 
-bool DecodePageFaultVirtualAllocFreePayload(Decoder* decoder,
-                                            unsigned char version,
-                                            unsigned char opcode,
-                                            bool is_64_bit,
-                                            std::string* operation,
-                                            StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  if (version != 2)
-    return false;
-
-  // Set the operation name.
-  switch (opcode) {
-    case kPageFaultVirtualAllocOpcode:
-      *operation = "VirtualAlloc";
-      break;
-    case kPageFaultVirtualFreeOpcode:
-      *operation = "VirtualFree";
-      break;
-    default:
-      return false;
-  }
-
-  // Decode the payload.
-  if (!DecodeUInteger("BaseAddress", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("RegionSize", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("ProcessId", decoder, fields) ||
-      !Decode<UIntValue>("Flags", decoder, fields)) {
-    return false;
-  }
-
-  return true;
+LazyRawETWKernelPayload::LazyRawETWKernelPayload(
+    const base::Guid& provider_id,
+    unsigned char version,
+    unsigned char opcode,
+    bool is_64_bit,
+    const char* payload,
+    size_t payload_size,
+    event::ValueArena* arena,
+    const FieldProjection* projection)
+    : provider_id_(provider_id),
+      version_(version),
+      opcode_(opcode),
+      is_64_bit_(is_64_bit),
+      payload_(payload),
+      payload_size_(payload_size),
+      arena_(arena),
+      projection_(projection) {
+  DCHECK(payload != NULL || payload_size == 0);  // note: payload can be NULL.
+  DCHECK(arena != NULL);
 }
 
-bool DecodePageFaultPayload(Decoder* decoder,
-                            unsigned char version,
-                            unsigned char opcode,
-                            bool is_64_bit,
-                            std::string* operation,
-                            StructValue* fields) {
-  DCHECK(decoder != NULL);
-  DCHECK(operation != NULL);
-  DCHECK(fields != NULL);
-
-  switch (opcode) {
-    case kPageFaultTransitionFaultOpcode:
-    case kPageFaultDemandZeroFaultOpcode:
-    case kPageFaultCopyOnWriteOpcode:
-    case kPageFaultGuardPageFaultOpcode:
-    case kPageFaultHardPageFaultOpcode:
-    case kPageFaultAccessViolationOpcode:
-      return DecodePageFaultCommonPageFaultPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPageFaultHardFaultOpcode:
-      return DecodePageFaultHardPageFaultPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    case kPageFaultVirtualAllocOpcode:
-    case kPageFaultVirtualFreeOpcode:
-      return DecodePageFaultVirtualAllocFreePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
-
-    default:
-      return false;
+const event::Value* LazyRawETWKernelPayload::Decode() const {
+  const event::Value* decoded_payload = NULL;
+  if (!DecodeRawETWKernelPayload(provider_id_, version_, opcode_, is_64_bit_,
+                                 payload_, payload_size_, arena_, projection_,
+                                 NULL, NULL, &decoded_payload)) {
+    return NULL;
   }
+  return decoded_payload;
 }
 
-}  // namespace
-
 bool DecodeRawETWKernelPayload(const std::string& provider_id,
                                unsigned char version,
                                unsigned char opcode,
@@ -2558,118 +1078,30 @@ bool DecodeRawETWKernelPayload(const std::string& provider_id,
                                std::string* operation,
                                std::string* category,
                                std::unique_ptr<event::Value>* decoded_payload) {
-  DCHECK(payload != NULL || payload_size == 0);  // note: payload can be NULL.
-  DCHECK(operation != NULL);
-  DCHECK(category != NULL);
-  DCHECK(decoded_payload != NULL);
-
-  // Create the byte decoder for the encoded payload.
-  Decoder decoder(payload, payload_size);
-  std::unique_ptr<StructValue> fields(new StructValue);
-
-  // Dispatch event by provider (GUID).
-  if (provider_id == kEventTraceEventProviderId) {
-    if (DecodeEventTracePayload(&decoder, version, opcode, is_64_bit,
-                                operation, fields.get())) {
-      *category = "EventTraceEvent";
-    } else {
-      LOG(WARNING) << "Error while decoding EventTraceEvent payload.";
-      return false;
-    }
-  } else if (provider_id == kImageProviderId) {
-    if (DecodeImagePayload(&decoder, version, opcode, is_64_bit,
-                           operation, fields.get())) {
-      *category = "Image";
-    } else {
-      LOG(ERROR) << "Error while decoding Image payload.";
-      return false;
-    }
-  } else if (provider_id == kPerfInfoProviderId) {
-    if (DecodePerfInfoPayload(&decoder, version, opcode, is_64_bit,
-                              operation, fields.get())) {
-      *category = "PerfInfo";
-    } else {
-      // TODO(etienneb): Complete the decoding of these payload.
-      LOG(WARNING) << "Error while decoding PerfInfo payload.";
-      return false;
-    }
-  } else if (provider_id == kThreadProviderId) {
-    if (DecodeThreadPayload(&decoder, version, opcode, is_64_bit,
-                            operation, fields.get())) {
-      *category = "Thread";
-    } else {
-      // TODO(etienneb): Complete the decoding of these payload.
-      LOG(WARNING) << "Error while decoding Thread payload.";
-      return false;
-    }
-  } else if (provider_id == kProcessProviderId) {
-    if (DecodeProcessPayload(&decoder, version, opcode, is_64_bit,
-                             operation, fields.get())) {
-      *category = "Process";
-    } else {
-      LOG(WARNING) << "Error while decoding Process payload.";
-      return false;
-    }
-  } else if (provider_id == kTcplpProviderId) {
-    if (DecodeTcplpPayload(&decoder, version, opcode, is_64_bit,
-                           operation, fields.get())) {
-      *category = "Tcplp";
-    } else {
-      LOG(WARNING) << "Error while decoding Tcplp payload.";
-      return false;
-    }
-  } else if (provider_id == kRegistryProviderId) {
-    if (DecodeRegistryPayload(&decoder, version, opcode, is_64_bit,
-                              operation, fields.get())) {
-      *category = "Registry";
-    } else {
-      LOG(WARNING) << "Error while decoding Registry payload.";
-      return false;
-    }
-  } else if (provider_id == kFileIOProviderId) {
-    if (DecodeFileIOPayload(&decoder, version, opcode, is_64_bit,
-                            operation, fields.get())) {
-      *category = "FileIO";
-    } else {
-      LOG(WARNING) << "Error while decoding FileIO payload.";
-      return false;
-    }
-  } else if (provider_id == kDiskIOProviderId) {
-    if (DecodeDiskIOPayload(&decoder, version, opcode, is_64_bit,
-                            operation, fields.get())) {
-      *category = "DiskIO";
-    } else {
-      LOG(WARNING) << "Error while decoding DiskIO payload.";
-      return false;
-    }
-  } else if (provider_id == kStackWalkProviderId) {
-    if (DecodeStackWalkPayload(&decoder, version, opcode, is_64_bit,
-                               operation, fields.get())) {
-      *category = "StackWalk";
-    } else {
-      LOG(WARNING) << "Error while decoding StackWalk payload.";
-      return false;
-    }
-  } else if (provider_id == kPageFaultProviderId) {
-    if (DecodePageFaultPayload(&decoder, version, opcode, is_64_bit,
-                               operation, fields.get())) {
-      *category = "PageFault";
-    } else {
-      LOG(WARNING) << "Error while decoding PageFault payload.";
-      return false;
-    }
-  } else {
-    // Unsupported event.
+  base::Guid guid;
+  if (!base::StringToGuid(provider_id, &guid))
     return false;
-  }
+  return DecodeRawETWKernelPayload(guid, version, opcode, is_64_bit, payload,
+                                   payload_size, operation, category,
+                                   decoded_payload);
+}
 
-  // Make sure that all the payload has been decoded.
-  if (decoder.RemainingBytes() != 0)
+bool DecodeRawETWKernelPayload(const std::string& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               event::ValueArena* arena,
+                               std::string* operation,
+                               std::string* category,
+                               const event::Value** decoded_payload) {
+  base::Guid guid;
+  if (!base::StringToGuid(provider_id, &guid))
     return false;
-
-  // Successful decoding of this event.
-  *decoded_payload = std::move(fields);
-  return true;
+  return DecodeRawETWKernelPayload(guid, version, opcode, is_64_bit, payload,
+                                   payload_size, arena, operation, category,
+                                   decoded_payload);
 }
 
 }  // namespace etw
@@ -29,12 +29,22 @@
 #include <memory>
 #include <string>
 
+#include "base/base.h"
+#include "base/guid.h"
+#include "event/event.h"
+#include "event/event_type.h"
+
 // Forward declaration.
 namespace event {
 class Value;
+class ValueArena;
 }
 
 namespace parser {
+
+// Forward declaration.
+class FieldProjection;
+
 namespace etw {
 
 // Decodes the raw payload of an ETW kernel event without relying on external
@@ -50,6 +60,125 @@ namespace etw {
 // @param category the name of the category of this event.
 // @param decoded_payload the decoded payload.
 // @returns true if the payload has been decoded successfully, false otherwise.
+bool DecodeRawETWKernelPayload(const base::Guid& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               std::string* operation,
+                               std::string* category,
+                               std::unique_ptr<event::Value>* decoded_payload);
+
+// Decodes the raw payload of an ETW kernel event into values allocated from
+// |arena|. This avoids one heap allocation per decoded field; the decoded
+// payload stays valid until |arena| is reset or destroyed. Strings are decoded
+// as views into |payload| (see string_view_value.h), which must stay alive as
+// long as the decoded payload is used.
+// @param provider_id the GUID of the provider of the event.
+// @param version the version of the event definition.
+// @param opcode the opcode of the event.
+// @param is_64_bit indicates whether the event was generated on a 64-bit OS.
+// @param payload the raw payload to decode.
+// @param payload_size the size of the raw payload, in bytes.
+// @param arena the arena used to allocate the decoded values.
+// @param operation the name associated with the opcode of this event.
+// @param category the name of the category of this event.
+// @param decoded_payload receives the decoded payload, owned by |arena|.
+// @returns true if the payload has been decoded successfully, false otherwise.
+bool DecodeRawETWKernelPayload(const base::Guid& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               event::ValueArena* arena,
+                               std::string* operation,
+                               std::string* category,
+                               const event::Value** decoded_payload);
+
+// Same as the function above, decoding only the fields of |projection|. The
+// other fields of the payload are skipped. |operation| and |category| may be
+// NULL when the caller gets them from LookupRawETWKernelEvent().
+// @param projection the fields to decode, or NULL to decode all of them.
+bool DecodeRawETWKernelPayload(const base::Guid& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               event::ValueArena* arena,
+                               const FieldProjection* projection,
+                               std::string* operation,
+                               std::string* category,
+                               const event::Value** decoded_payload);
+
+// Finds the operation and the category of an ETW kernel event without decoding
+// its payload.
+// @param provider_id the GUID of the provider of the event.
+// @param version the version of the event definition.
+// @param opcode the opcode of the event.
+// @param is_64_bit indicates whether the event was generated on a 64-bit OS.
+// @param operation the name associated with the opcode of this event.
+// @param category the name of the category of this event.
+// @returns true if the payload of the event can be decoded, false otherwise.
+bool LookupRawETWKernelEvent(const base::Guid& provider_id,
+                             unsigned char version,
+                             unsigned char opcode,
+                             bool is_64_bit,
+                             std::string* operation,
+                             std::string* category);
+
+// Same as above, with the category and the operation given as the type of
+// the event (see event/event_type.h). Types are registered when the decoding
+// tables are built, so this neither allocates nor copies names.
+bool LookupRawETWKernelEvent(const base::Guid& provider_id,
+                             unsigned char version,
+                             unsigned char opcode,
+                             bool is_64_bit,
+                             event::EventType* type);
+
+// The raw payload of an ETW kernel event, decoded into an arena by
+// DecodeRawETWKernelPayload() the first time it is accessed.
+class LazyRawETWKernelPayload : public event::LazyPayload {
+ public:
+  // @param provider_id the GUID of the provider of the event.
+  // @param version the version of the event definition.
+  // @param opcode the opcode of the event.
+  // @param is_64_bit indicates whether the event was generated on a 64-bit OS.
+  // @param payload the raw payload to decode, must outlive this object.
+  // @param payload_size the size of the raw payload, in bytes.
+  // @param arena the arena used to allocate the decoded values.
+  // @param projection the fields to decode, or NULL to decode all of them.
+  LazyRawETWKernelPayload(const base::Guid& provider_id,
+                          unsigned char version,
+                          unsigned char opcode,
+                          bool is_64_bit,
+                          const char* payload,
+                          size_t payload_size,
+                          event::ValueArena* arena,
+                          const FieldProjection* projection);
+
+  // @returns the decoded payload, owned by the arena, or nullptr if the
+  //     payload can't be decoded.
+  const event::Value* Decode() const override;
+
+ private:
+  base::Guid provider_id_;
+  unsigned char version_;
+  unsigned char opcode_;
+  bool is_64_bit_;
+  const char* payload_;
+  size_t payload_size_;
+  event::ValueArena* arena_;
+  const FieldProjection* projection_;
+
+  DISALLOW_COPY_AND_ASSIGN(LazyRawETWKernelPayload);
+};
+
+// Same as the functions above, with the GUID of the provider given as a
+// string of the form "2CB15D1D-5FC1-11D2-ABE1-00A0C911F518". The string is
+// parsed on every call; prefer the binary GUID on hot paths.
 bool DecodeRawETWKernelPayload(const std::string& provider_id,
                                unsigned char version,
                                unsigned char opcode,
@@ -60,6 +189,17 @@ bool DecodeRawETWKernelPayload(const std::string& provider_id,
                                std::string* category,
                                std::unique_ptr<event::Value>* decoded_payload);
 
+bool DecodeRawETWKernelPayload(const std::string& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               event::ValueArena* arena,
+                               std::string* operation,
+                               std::string* category,
+                               const event::Value** decoded_payload);
+
 }  // namespace etw
 }  // namespace parser
 
@@ -25,12 +25,18 @@
 
 #include "parser/etw/etw_raw_kernel_payload_decoder.h"
 
+#include <chrono>
+#include <iostream>
 #include <memory>
 
+#include "base/guid.h"
 #include "base/logging.h"
+#include "event/string_view_value.h"
 #include "event/utils.h"
 #include "event/value.h"
+#include "event/value_arena.h"
 #include "gtest/gtest.h"
+#include "parser/event_filter.h"
 
 namespace parser {
 namespace etw {
@@ -2371,6 +2377,54 @@ TEST(EtwRawDecoderTest, EventTraceHeaderV2) {
   EXPECT_TRUE(expected->Equals(fields.get()));
 }
 
+TEST(EtwRawDecoderTest, EventTraceHeaderV2Arena) {
+  std::string operation;
+  std::string category;
+  std::unique_ptr<Value> expected;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(kEventTraceEventProviderId,
+          kVersion2, kEventTraceEventHeaderOpcode, k64bit,
+          reinterpret_cast<const char*>(&kEventTraceEventHeaderPayloadV2[0]),
+          sizeof(kEventTraceEventHeaderPayloadV2),
+          &operation, &category, &expected));
+
+  event::ValueArena arena;
+  std::string arena_operation;
+  std::string arena_category;
+  const Value* fields = nullptr;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(kEventTraceEventProviderId,
+          kVersion2, kEventTraceEventHeaderOpcode, k64bit,
+          reinterpret_cast<const char*>(&kEventTraceEventHeaderPayloadV2[0]),
+          sizeof(kEventTraceEventHeaderPayloadV2),
+          &arena, &arena_operation, &arena_category, &fields));
+
+  EXPECT_EQ(category, arena_category);
+  EXPECT_EQ(operation, arena_operation);
+  ASSERT_TRUE(fields != nullptr);
+  EXPECT_LT(0U, arena.BytesUsed());
+
+  // Strings are views into the payload, with the same content.
+  const Value* session_name = fields->GetField("SessionNameString");
+  ASSERT_TRUE(session_name != nullptr);
+  EXPECT_TRUE(event::W16StringViewValue::InstanceOf(session_name));
+  std::wstring expected_session_name;
+  std::wstring session_name_copy;
+  EXPECT_TRUE(expected->GetFieldAsWString("SessionNameString",
+                                          &expected_session_name));
+  EXPECT_TRUE(session_name->GetAsWString(&session_name_copy));
+  EXPECT_EQ(expected_session_name, session_name_copy);
+
+  std::string expected_str;
+  std::string fields_str;
+  EXPECT_TRUE(event::ToString(expected.get(), &expected_str));
+  EXPECT_TRUE(event::ToString(fields, &fields_str));
+  EXPECT_EQ(expected_str, fields_str);
+
+  arena.Reset();
+  EXPECT_EQ(0U, arena.BytesUsed());
+}
+
 TEST(EtwRawDecoderTest, EventTraceHeader32bitsV2) {
   std::string operation;
   std::string category;
@@ -4333,6 +4387,132 @@ TEST(EtwRawDecoderTest, ThreadCSwitchV2) {
   EXPECT_TRUE(expected->Equals(fields.get()));
 }
 
+TEST(EtwRawDecoderTest, LookupEvent) {
+  base::Guid provider_id;
+  ASSERT_TRUE(base::StringToGuid(kThreadProviderId, &provider_id));
+
+  std::string operation;
+  std::string category;
+  EXPECT_TRUE(LookupRawETWKernelEvent(provider_id, kVersion2,
+                                      kThreadCSwitchOpcode, k64bit,
+                                      &operation, &category));
+  EXPECT_EQ("Thread", category);
+  EXPECT_EQ("CSwitch", operation);
+
+  event::EventType type;
+  EXPECT_TRUE(LookupRawETWKernelEvent(provider_id, kVersion2,
+                                      kThreadCSwitchOpcode, k64bit, &type));
+  EXPECT_EQ(event::Atom::Intern("Thread"), type.category());
+  EXPECT_EQ(event::Atom::Intern("CSwitch"), type.operation());
+
+  // The type does not depend on the pointer size.
+  event::EventType type_32_bit;
+  EXPECT_TRUE(LookupRawETWKernelEvent(provider_id, kVersion2,
+                                      kThreadCSwitchOpcode, k32bit,
+                                      &type_32_bit));
+  EXPECT_EQ(type, type_32_bit);
+
+  const base::Guid kUnknownGuid = { 0x3D6FA8D2, 0xFE05, 0x11D0,
+      { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+  EXPECT_FALSE(LookupRawETWKernelEvent(kUnknownGuid, kVersion2,
+                                       kThreadCSwitchOpcode, k64bit,
+                                       &operation, &category));
+  EXPECT_FALSE(LookupRawETWKernelEvent(provider_id, 99,
+                                       kThreadCSwitchOpcode, k64bit,
+                                       &operation, &category));
+}
+
+TEST(EtwRawDecoderTest, ThreadCSwitchV2Lazy) {
+  base::Guid provider_id;
+  ASSERT_TRUE(base::StringToGuid(kThreadProviderId, &provider_id));
+
+  std::string operation;
+  std::string category;
+  std::unique_ptr<Value> expected;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(provider_id,
+          kVersion2, kThreadCSwitchOpcode, k64bit,
+          reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+          sizeof(kThreadCSwitchPayloadV2),
+          &operation, &category, &expected));
+
+  event::ValueArena arena;
+  LazyRawETWKernelPayload lazy_payload(
+      provider_id, kVersion2, kThreadCSwitchOpcode, k64bit,
+      reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+      sizeof(kThreadCSwitchPayloadV2), &arena, NULL);
+  EXPECT_EQ(0U, arena.BytesUsed());
+
+  const Value* fields = lazy_payload.Decode();
+  ASSERT_TRUE(fields != nullptr);
+  EXPECT_TRUE(expected->Equals(fields));
+
+  // A truncated payload can't be decoded.
+  LazyRawETWKernelPayload truncated_payload(
+      provider_id, kVersion2, kThreadCSwitchOpcode, k64bit,
+      reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+      sizeof(kThreadCSwitchPayloadV2) - 1, &arena, NULL);
+  EXPECT_TRUE(truncated_payload.Decode() == nullptr);
+}
+
+TEST(EtwRawDecoderTest, ThreadCSwitchV2Projection) {
+  base::Guid provider_id;
+  ASSERT_TRUE(base::StringToGuid(kThreadProviderId, &provider_id));
+
+  FieldProjection projection({ "NewThreadId", "OldThreadState" });
+  event::ValueArena arena;
+  std::string operation;
+  std::string category;
+  const Value* fields = nullptr;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(provider_id,
+          kVersion2, kThreadCSwitchOpcode, k64bit,
+          reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+          sizeof(kThreadCSwitchPayloadV2),
+          &arena, &projection, &operation, &category, &fields));
+
+  std::unique_ptr<StructValue> expected(new StructValue());
+  expected->AddField<UIntValue>("NewThreadId", 2252U);
+  expected->AddField<CharValue>("OldThreadState", 2);
+
+  EXPECT_STREQ("Thread", category.c_str());
+  EXPECT_STREQ("CSwitch", operation.c_str());
+  EXPECT_TRUE(expected->Equals(fields));
+}
+
+TEST(EtwRawDecoderTest, ThreadCSwitchV2FixedLayout) {
+  event::ValueArena arena;
+  std::string operation;
+  std::string category;
+  const Value* fields = nullptr;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(kThreadProviderId,
+          kVersion2, kThreadCSwitchOpcode, k64bit,
+          reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+          sizeof(kThreadCSwitchPayloadV2),
+          &arena, &operation, &category, &fields));
+
+  // CSwitch payloads have a fixed layout and are decoded with a schema.
+  ASSERT_TRUE(fields != nullptr);
+  ASSERT_TRUE(StructValue::InstanceOf(fields));
+  EXPECT_TRUE(StructValue::Cast(fields)->schema() != nullptr);
+
+  uint32_t new_thread_id = 0;
+  EXPECT_TRUE(fields->GetFieldAsUInteger("NewThreadId", &new_thread_id));
+  EXPECT_EQ(2252U, new_thread_id);
+
+  EXPECT_STREQ("Thread", category.c_str());
+  EXPECT_STREQ("CSwitch", operation.c_str());
+
+  // A truncated payload is rejected.
+  EXPECT_FALSE(
+      DecodeRawETWKernelPayload(kThreadProviderId,
+          kVersion2, kThreadCSwitchOpcode, k64bit,
+          reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+          sizeof(kThreadCSwitchPayloadV2) - 1,
+          &arena, &operation, &category, &fields));
+}
+
 TEST(EtwRawDecoderTest, ThreadSpinLockV2) {
   std::string operation;
   std::string category;
@@ -7039,5 +7219,124 @@ TEST(EtwRawDecoderTest, PageFaultVirtualFreeV2) {
   EXPECT_TRUE(expected->Equals(fields.get()));
 }
 
+TEST(EtwRawDecoderTest, BinaryProviderId) {
+  // 3D6FA8D3-FE05-11D0-9DDA-00C04FD7BA7C, the PageFault provider.
+  const base::Guid kPageFaultGuid = { 0x3D6FA8D3, 0xFE05, 0x11D0,
+      { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+
+  std::string operation;
+  std::string category;
+  std::unique_ptr<Value> fields;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(kPageFaultGuid,
+          kVersion2, kPageFaultVirtualFreeOpcode, k64bit,
+          reinterpret_cast<const char*>(&kPageFaultVirtualFreePayloadV2[0]),
+          sizeof(kPageFaultVirtualFreePayloadV2),
+          &operation, &category, &fields));
+
+  std::string expected_operation;
+  std::string expected_category;
+  std::unique_ptr<Value> expected;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(kPageFaultProviderId,
+          kVersion2, kPageFaultVirtualFreeOpcode, k64bit,
+          reinterpret_cast<const char*>(&kPageFaultVirtualFreePayloadV2[0]),
+          sizeof(kPageFaultVirtualFreePayloadV2),
+          &expected_operation, &expected_category, &expected));
+
+  EXPECT_EQ(expected_category, category);
+  EXPECT_EQ(expected_operation, operation);
+  EXPECT_TRUE(expected->Equals(fields.get()));
+}
+
+TEST(EtwRawDecoderTest, UnknownProviderId) {
+  const base::Guid kUnknownGuid = { 0x3D6FA8D2, 0xFE05, 0x11D0,
+      { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+
+  std::string operation;
+  std::string category;
+  std::unique_ptr<Value> fields;
+  EXPECT_FALSE(
+      DecodeRawETWKernelPayload(kUnknownGuid,
+          kVersion2, kPageFaultVirtualFreeOpcode, k64bit,
+          reinterpret_cast<const char*>(&kPageFaultVirtualFreePayloadV2[0]),
+          sizeof(kPageFaultVirtualFreePayloadV2),
+          &operation, &category, &fields));
+  EXPECT_FALSE(
+      DecodeRawETWKernelPayload("not a guid",
+          kVersion2, kPageFaultVirtualFreeOpcode, k64bit,
+          reinterpret_cast<const char*>(&kPageFaultVirtualFreePayloadV2[0]),
+          sizeof(kPageFaultVirtualFreePayloadV2),
+          &operation, &category, &fields));
+  EXPECT_TRUE(fields.get() == NULL);
+}
+
+// Compares the decoding of 32-bit and 64-bit payloads. Run with
+// --gtest_also_run_disabled_tests.
+TEST(EtwRawDecoderTest, DISABLED_Benchmark) {
+  const size_t kIterations = 1000 * 1000;
+
+  struct Fixture {
+    const char* name;
+    const std::string* provider_id;
+    unsigned char opcode;
+    const unsigned char* payload_32_bit;
+    size_t payload_32_bit_size;
+    const unsigned char* payload_64_bit;
+    size_t payload_64_bit_size;
+  };
+
+  // StackWalk payloads are only decoded on 64-bit systems.
+  const Fixture kFixtures[] = {
+      { "CSwitch", &kThreadProviderId, kThreadCSwitchOpcode,
+        kThreadCSwitchPayload32bitsV2, sizeof(kThreadCSwitchPayload32bitsV2),
+        kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2) },
+      { "FileIO Create", &kFileIOProviderId, kFileIOCreateOpcode,
+        kFileIOCreatePayload32bitsV2, sizeof(kFileIOCreatePayload32bitsV2),
+        kFileIOCreatePayloadV2, sizeof(kFileIOCreatePayloadV2) },
+      { "StackWalk", &kStackWalkProviderId, kStackWalkStackOpcode,
+        NULL, 0,
+        kStackWalkStackPayloadV2, sizeof(kStackWalkStackPayloadV2) },
+  };
+
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::milliseconds ms;
+
+  event::ValueArena arena;
+  std::string operation;
+  std::string category;
+  const Value* fields = NULL;
+
+  for (const Fixture& fixture : kFixtures) {
+    base::Guid provider_id;
+    ASSERT_TRUE(base::StringToGuid(*fixture.provider_id, &provider_id));
+
+    Clock::duration times[2] = {};
+    for (int is_64_bit = 0; is_64_bit < 2; ++is_64_bit) {
+      const char* payload = reinterpret_cast<const char*>(
+          is_64_bit ? fixture.payload_64_bit : fixture.payload_32_bit);
+      if (payload == NULL)
+        continue;
+      size_t payload_size = is_64_bit ? fixture.payload_64_bit_size
+                                      : fixture.payload_32_bit_size;
+
+      Clock::time_point start = Clock::now();
+      for (size_t i = 0; i < kIterations; ++i) {
+        arena.Reset();
+        ASSERT_TRUE(DecodeRawETWKernelPayload(provider_id, kVersion2,
+            fixture.opcode, is_64_bit != 0, payload, payload_size, &arena,
+            &operation, &category, &fields));
+      }
+      times[is_64_bit] = Clock::now() - start;
+    }
+
+    std::cout << fixture.name << ": 32-bit "
+              << std::chrono::duration_cast<ms>(times[0]).count()
+              << " ms, 64-bit "
+              << std::chrono::duration_cast<ms>(times[1]).count()
+              << " ms" << std::endl;
+  }
+}
+
 }  // namespace etw
 }  // namespace parser
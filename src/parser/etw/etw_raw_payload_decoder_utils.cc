@@ -25,20 +25,30 @@
 
 #include "parser/etw/etw_raw_payload_decoder_utils.h"
 
+#include "event/string_view_value.h"
+
 namespace parser {
 namespace etw {
 
 namespace {
 
 using event::IntValue;
+using event::SchemaStructValue;
 using event::UCharValue;
 using event::UIntValue;
 using event::ULongValue;
 using event::ShortValue;
 using event::StructValue;
+using event::W16StringViewValue;
 using event::WStringValue;
 using event::Value;
 
+template<class T>
+bool DecodeSchemaField(Decoder* decoder, SchemaStructValue* fields) {
+  typename T::ScalarType decoded = typename T::ScalarType();
+  return decoder->DecodeScalar<T>(&decoded) && fields->Append<T>(decoded);
+}
+
 }  // namespace
 
 bool DecodeUInteger(const std::string& name,
@@ -56,10 +66,15 @@ bool DecodeW16String(const std::string& name,
   DCHECK(decoder != NULL);
   DCHECK(fields != NULL);
 
-  std::unique_ptr<WStringValue> decoded(decoder->DecodeW16String());
+  if (decoder->use_string_views()) {
+    base::Span<const char> view;
+    return decoder->DecodeW16StringView(&view) &&
+           fields->AddField<W16StringViewValue>(name, view);
+  }
 
-  if (decoded.get() == NULL ||
-      !fields->AddField(name, std::move(decoded))) {
+  std::wstring decoded;
+  if (!decoder->DecodeW16String(&decoded) ||
+      !fields->AddField<WStringValue>(name, decoded)) {
     return false;
   }
 
@@ -73,10 +88,15 @@ bool DecodeFixedW16String(const std::string& name,
   DCHECK(decoder != NULL);
   DCHECK(fields != NULL);
 
-  std::unique_ptr<WStringValue> decoded(decoder->DecodeFixedW16String(length));
+  if (decoder->use_string_views()) {
+    base::Span<const char> view;
+    return decoder->DecodeFixedW16StringView(length, &view) &&
+           fields->AddField<W16StringViewValue>(name, view);
+  }
 
-  if (decoded.get() == NULL ||
-      !fields->AddField(name, std::move(decoded))) {
+  std::wstring decoded;
+  if (!decoder->DecodeFixedW16String(length, &decoded) ||
+      !fields->AddField<WStringValue>(name, decoded)) {
     return false;
   }
 
@@ -87,58 +107,31 @@ bool DecodeSID(const std::string& name,
                bool is_64_bit,
                Decoder* decoder,
                StructValue* fields) {
-  // Check the minimal SID length to avoid out-of-bound accesses.
-  if (decoder->RemainingBytes() < 3 * 8)
-    return false;
-
-  // Decode the TOKEN_USER structure.
-  std::unique_ptr<StructValue> sid(new StructValue);
-  if (!DecodeUInteger("PSid", is_64_bit, decoder, sid.get()) ||
-      !Decode<UIntValue>("Attributes", decoder, sid.get())) {
-    return false;
-  }
-
-  // Skip padding.
-  if (is_64_bit) {
-    std::unique_ptr<UIntValue> padding(decoder->Decode<UIntValue>());
-    if (padding.get() == NULL)
-      return false;
-  }
-
-  // Decode the SID structure.
-  unsigned char revision = decoder->Lookup(0);
-  unsigned char subAuthorityCount = decoder->Lookup(1);
-  const int kSID_REVISION = 1;
-  const int kSID_MAX_SUB_AUTHORITIES = 15;
-  DCHECK_EQ(revision, kSID_REVISION);
-  DCHECK_LE(subAuthorityCount, kSID_MAX_SUB_AUTHORITIES);
-
-  unsigned int length = 4 * subAuthorityCount + 8;
-  if (!DecodeArray<UCharValue>("Sid", length, decoder, sid.get()))
-    return false;
-
-  // Returns a struct containing all decoded fields.
-  return fields->AddField(name, std::move(sid));
+  if (is_64_bit)
+    return DecodeSID<ULongValue>(name, decoder, fields);
+  return DecodeSID<UIntValue>(name, decoder, fields);
 }
 
 bool DecodeSystemTime(const std::string& name,
                       Decoder* decoder,
                       StructValue* fields) {
   // Decode the SystemTime structure.
-  std::unique_ptr<StructValue> system_time(new StructValue);
-  if (!Decode<ShortValue>("wYear", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wMonth", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wDayOfWeek", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wDay", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wHour", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wMinute", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wSecond", decoder, system_time.get()) ||
-      !Decode<ShortValue>("wMilliseconds", decoder, system_time.get())) {
+  StructValue* system_time = fields->AddStructField(name);
+  if (system_time != NULL)
+    system_time->Reserve(8);
+  if (system_time == NULL ||
+      !Decode<ShortValue>("wYear", decoder, system_time) ||
+      !Decode<ShortValue>("wMonth", decoder, system_time) ||
+      !Decode<ShortValue>("wDayOfWeek", decoder, system_time) ||
+      !Decode<ShortValue>("wDay", decoder, system_time) ||
+      !Decode<ShortValue>("wHour", decoder, system_time) ||
+      !Decode<ShortValue>("wMinute", decoder, system_time) ||
+      !Decode<ShortValue>("wSecond", decoder, system_time) ||
+      !Decode<ShortValue>("wMilliseconds", decoder, system_time)) {
     return false;
   }
 
-  // Returns a struct containing all decoded fields.
-  return fields->AddField(name, std::move(system_time));
+  return true;
 }
 
 bool DecodeTimeZoneInformation(const std::string& name,
@@ -146,19 +139,72 @@ bool DecodeTimeZoneInformation(const std::string& name,
                                StructValue* fields) {
 
   // Decode the TimeZone structure.
-  std::unique_ptr<StructValue> timezone(new StructValue);
-  if (!Decode<IntValue>("Bias", decoder, timezone.get()) ||
-      !DecodeFixedW16String("StandardName", 32, decoder, timezone.get()) ||
-      !DecodeSystemTime("StandardDate", decoder, timezone.get()) ||
-      !Decode<IntValue>("StandardBias", decoder, timezone.get()) ||
-      !DecodeFixedW16String("DaylightName", 32, decoder, timezone.get()) ||
-      !DecodeSystemTime("DaylightDate",  decoder, timezone.get()) ||
-      !Decode<IntValue>("DaylightBias", decoder, timezone.get())) {
+  StructValue* timezone = fields->AddStructField(name);
+  if (timezone != NULL)
+    timezone->Reserve(7);
+  if (timezone == NULL ||
+      !Decode<IntValue>("Bias", decoder, timezone) ||
+      !DecodeFixedW16String("StandardName", 32, decoder, timezone) ||
+      !DecodeSystemTime("StandardDate", decoder, timezone) ||
+      !Decode<IntValue>("StandardBias", decoder, timezone) ||
+      !DecodeFixedW16String("DaylightName", 32, decoder, timezone) ||
+      !DecodeSystemTime("DaylightDate",  decoder, timezone) ||
+      !Decode<IntValue>("DaylightBias", decoder, timezone)) {
     return false;
   }
 
-  // Returns a struct containing all decoded fields.
-  return fields->AddField(name, std::move(timezone));
+  return true;
+}
+
+bool DecodeSchemaStruct(Decoder* decoder, SchemaStructValue* fields) {
+  DCHECK(decoder != NULL);
+  DCHECK(fields != NULL);
+
+  const event::StructSchema* schema = fields->schema();
+  for (size_t i = 0; i < schema->FieldCount(); ++i) {
+    bool decoded = false;
+    switch (schema->field(i).type) {
+      case event::VALUE_BOOL:
+        decoded = DecodeSchemaField<event::BoolValue>(decoder, fields);
+        break;
+      case event::VALUE_CHAR:
+        decoded = DecodeSchemaField<event::CharValue>(decoder, fields);
+        break;
+      case event::VALUE_UCHAR:
+        decoded = DecodeSchemaField<event::UCharValue>(decoder, fields);
+        break;
+      case event::VALUE_SHORT:
+        decoded = DecodeSchemaField<event::ShortValue>(decoder, fields);
+        break;
+      case event::VALUE_USHORT:
+        decoded = DecodeSchemaField<event::UShortValue>(decoder, fields);
+        break;
+      case event::VALUE_INT:
+        decoded = DecodeSchemaField<event::IntValue>(decoder, fields);
+        break;
+      case event::VALUE_UINT:
+        decoded = DecodeSchemaField<event::UIntValue>(decoder, fields);
+        break;
+      case event::VALUE_LONG:
+        decoded = DecodeSchemaField<event::LongValue>(decoder, fields);
+        break;
+      case event::VALUE_ULONG:
+        decoded = DecodeSchemaField<event::ULongValue>(decoder, fields);
+        break;
+      case event::VALUE_FLOAT:
+        decoded = DecodeSchemaField<event::FloatValue>(decoder, fields);
+        break;
+      case event::VALUE_DOUBLE:
+        decoded = DecodeSchemaField<event::DoubleValue>(decoder, fields);
+        break;
+      default:
+        LOG(ERROR) << "Unsupported type in schema.";
+    }
+    if (!decoded)
+      return false;
+  }
+
+  return true;
 }
 
 }  // namespace etw
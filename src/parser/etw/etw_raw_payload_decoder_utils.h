@@ -29,6 +29,8 @@
 #include <string>
 
 #include "base/logging.h"
+#include "event/packed_array_value.h"
+#include "event/struct_schema.h"
 #include "event/value.h"
 #include "parser/decoder.h"
 
@@ -47,10 +49,9 @@ bool Decode(const std::string& name, Decoder* decoder,
   DCHECK(decoder != NULL);
   DCHECK(fields != NULL);
 
-  std::unique_ptr<event::Value> decoded(decoder->Decode<T>());
-
-  if (decoded.get() == NULL ||
-      !fields->AddField(name, std::move(decoded))) {
+  typename T::ScalarType decoded = typename T::ScalarType();
+  if (!decoder->DecodeScalar<T>(&decoded) ||
+      !fields->AddField<T>(name, decoded)) {
     return false;
   }
 
@@ -72,12 +73,9 @@ bool DecodeArray(const std::string& name,
   DCHECK(decoder != NULL);
   DCHECK(fields != NULL);
 
-  std::unique_ptr<event::ArrayValue> decoded(decoder->DecodeArray<T>(length));
-
-  if (decoded.get() == NULL ||
-      !fields->AddField(name, std::move(decoded))) {
+  event::PackedArrayValue<T>* decoded = fields->AddPackedArrayField<T>(name);
+  if (decoded == NULL || !decoder->DecodeArray<T>(length, decoded))
     return false;
-  }
 
   return true;
 }
@@ -95,6 +93,7 @@ bool DecodeUInteger(const std::string& name,
                     event::StructValue* fields);
 
 // Decode a string of 16-bit char and add it as a field into |fields|.
+// The field is a W16StringViewValue when |decoder| uses string views.
 // @param name the name of the field to be added.
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
@@ -104,6 +103,7 @@ bool DecodeW16String(const std::string& name,
                      event::StructValue* fields);
 
 // Decode a string of 16-bit char and add it as a field into |fields|.
+// The field is a W16StringViewValue when |decoder| uses string views.
 // @param name the name of the field to be added.
 // @param length the length of the array holding the string.
 // @param decoder the decoder processing the payload.
@@ -114,6 +114,47 @@ bool DecodeFixedW16String(const std::string& name,
                           Decoder* decoder,
                           event::StructValue* fields);
 
+// Decode a SID (Secure ID) structure.
+// @tparam PointerType the type of the pointers of the traced system, either
+//     event::UIntValue or event::ULongValue.
+// @param name the name of the field to be added.
+// @param decoder the decoder processing the payload.
+// @param fields the structure to receive the field.
+// @returns true on sucess, false otherwise.
+template <class PointerType>
+bool DecodeSID(const std::string& name,
+               Decoder* decoder,
+               event::StructValue* fields) {
+  DCHECK(decoder != NULL);
+  DCHECK(fields != NULL);
+
+  // Check the minimal SID length to avoid out-of-bound accesses.
+  if (decoder->RemainingBytes() < 3 * 8)
+    return false;
+
+  // Decode the TOKEN_USER structure. The attributes are padded to the size
+  // of a pointer.
+  event::StructValue* sid = fields->AddStructField(name);
+  if (sid == NULL ||
+      !Decode<PointerType>("PSid", decoder, sid) ||
+      !Decode<event::UIntValue>("Attributes", decoder, sid) ||
+      !decoder->Skip(sizeof(typename PointerType::ScalarType) -
+                     sizeof(uint32_t))) {
+    return false;
+  }
+
+  // Decode the SID structure.
+  unsigned char revision = decoder->Lookup(0);
+  unsigned char subAuthorityCount = decoder->Lookup(1);
+  const int kSID_REVISION = 1;
+  const int kSID_MAX_SUB_AUTHORITIES = 15;
+  DCHECK_EQ(revision, kSID_REVISION);
+  DCHECK_LE(subAuthorityCount, kSID_MAX_SUB_AUTHORITIES);
+
+  unsigned int length = 4 * subAuthorityCount + 8;
+  return DecodeArray<event::UCharValue>("Sid", length, decoder, sid);
+}
+
 // Decode a SID (Secure ID) structure.
 // @param name the name of the field to be added.
 // @param is_64_bit the flag to enable decoding of 64-bit integer.
@@ -143,6 +184,12 @@ bool DecodeTimeZoneInformation(const std::string& name,
                                Decoder* decoder,
                                event::StructValue* fields);
 
+// Decode every field of the schema of |fields|, in order.
+// @param decoder the decoder processing the payload.
+// @param fields the structure to receive the fields.
+// @returns true on sucess, false otherwise.
+bool DecodeSchemaStruct(Decoder* decoder, event::SchemaStructValue* fields);
+
 }  // namespace etw
 }  // namespace parser
 
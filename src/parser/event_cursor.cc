@@ -0,0 +1,123 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/event_cursor.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "parser/parser.h"
+
+namespace parser {
+
+EventCursor::EventCursor(size_t queue_size)
+    : merger_(new EventMerger(queue_size)),
+      started_(false),
+      exhausted_(false) {
+}
+
+EventCursor::~EventCursor() {
+  // Stop the parsers before they lose their filter.
+  merger_.reset();
+  std::vector<ParserImpl*>::iterator parser = sources_.begin();
+  for (; parser != sources_.end(); ++parser)
+    (*parser)->set_filter(NULL);
+}
+
+void EventCursor::AddSource(ParserImpl* parser) {
+  DCHECK(!started_);
+  sources_.push_back(parser);
+}
+
+void EventCursor::SetFilter(const EventFilter& filter) {
+  DCHECK(!started_);
+  filter_ = filter;
+}
+
+const event::Event* EventCursor::Next() {
+  current_.clear();
+  if (Peek() == nullptr)
+    return nullptr;
+  current_.push_back(std::move(next_));
+  return current_.back().get();
+}
+
+const event::Event* EventCursor::Peek() {
+  if (exhausted_)
+    return nullptr;
+  if (!started_)
+    Start();
+  if (next_.get() == nullptr)
+    next_ = merger_->Pop();
+  return next_.get();
+}
+
+bool EventCursor::SeekToTimestamp(event::Timestamp timestamp) {
+  current_.clear();
+
+  // The filter rejects every event after its time range.
+  if (timestamp > filter_.end_time()) {
+    next_.reset();
+    exhausted_ = true;
+    return false;
+  }
+
+  // Before the parsers start, let them skip the events without decoding them.
+  if (!started_) {
+    filter_.SetTimeRange(std::max(timestamp, filter_.begin_time()),
+                         filter_.end_time());
+  }
+
+  const event::Event* event = Peek();
+  while (event != nullptr && event->timestamp() < timestamp) {
+    next_.reset();
+    event = Peek();
+  }
+  return event != nullptr;
+}
+
+size_t EventCursor::NextN(base::Span<const event::Event*> events) {
+  current_.clear();
+  size_t count = 0;
+  for (; count < events.size() && Peek() != nullptr; ++count) {
+    events[count] = next_.get();
+    current_.push_back(std::move(next_));
+  }
+  return count;
+}
+
+void EventCursor::Start() {
+  DCHECK(!started_);
+  started_ = true;
+
+  std::vector<ParserImpl*>::iterator parser = sources_.begin();
+  for (; parser != sources_.end(); ++parser) {
+    (*parser)->set_filter(&filter_);
+    merger_->AddSource(*parser);
+  }
+  merger_->Start();
+}
+
+}  // namespace parser
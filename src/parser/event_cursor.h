@@ -0,0 +1,124 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An EventCursor reads the events of one or several parsers on demand,
+// in timestamp order, instead of receiving them through a callback. The
+// parsers run on producer threads (see event_merger.h) which are started by
+// the first read. Destroying the cursor stops them, so a consumer may stop
+// reading at any point.
+//
+// Usage example:
+//   std::unique_ptr<EventCursor> cursor = parser.CreateCursor();
+//   cursor->SeekToTimestamp(start);
+//   while (const event::Event* event = cursor->Next()) {
+//     if (++count == 1000)
+//       break;
+//   }
+
+#ifndef PARSER_EVENT_CURSOR_H_
+#define PARSER_EVENT_CURSOR_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/base.h"
+#include "base/span.h"
+#include "event/event.h"
+#include "parser/event_filter.h"
+#include "parser/event_merger.h"
+
+namespace parser {
+
+// Forward declaration.
+class ParserImpl;
+
+class EventCursor {
+ public:
+  // @param queue_size the maximum number of events queued per parser.
+  explicit EventCursor(size_t queue_size);
+
+  ~EventCursor();
+
+  // Adds a parser to read. Must be called before the first read.
+  // @param parser the parser, owned by the caller. Must outlive the cursor.
+  void AddSource(ParserImpl* parser);
+
+  // Sets the filter applied by the parsers. Must be called before the first
+  // read.
+  // @param filter the filter to apply to the events.
+  void SetFilter(const EventFilter& filter);
+
+  // Returns the next event and moves past it.
+  // @returns the next event, or nullptr at the end of the traces. The event is
+  //     valid until the next call to Next(), NextN() or SeekToTimestamp().
+  const event::Event* Next();
+
+  // Returns the next event without moving past it.
+  // @returns the next event, or nullptr at the end of the traces. The event is
+  //     valid until the call to Next() which returns it, and then as long as
+  //     an event returned by Next().
+  const event::Event* Peek();
+
+  // Moves past the events which occurred before |timestamp|. Before the first
+  // read, the events are rejected by the parsers, before being decoded. A
+  // timestamp after the end of the time range of the filter exhausts the
+  // cursor without reading the traces.
+  // @param timestamp the timestamp to reach.
+  // @returns true if an event at or after |timestamp| exists, false at the end
+  //     of the traces.
+  bool SeekToTimestamp(event::Timestamp timestamp);
+
+  // Returns a batch of events and moves past them.
+  // @param events receives the next events, up to its size.
+  // @returns the number of events written in |events|; less than the size of
+  //     |events| only at the end of the traces. The events are valid until the
+  //     next call to Next(), NextN() or SeekToTimestamp().
+  size_t NextN(base::Span<const event::Event*> events);
+
+ private:
+  // Starts the parsers, on the first read.
+  void Start();
+
+  std::vector<ParserImpl*> sources_;
+  EventFilter filter_;
+  std::unique_ptr<EventMerger> merger_;
+  bool started_;
+
+  // Indicates that no event is left to read, whether the traces are read or
+  // not.
+  bool exhausted_;
+
+  // The event returned by Peek(), not read yet by Next().
+  std::unique_ptr<event::Event> next_;
+
+  // The events returned by the last call to Next() or NextN().
+  std::vector<std::unique_ptr<event::Event> > current_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventCursor);
+};
+
+}  // namespace parser
+
+#endif  // PARSER_EVENT_CURSOR_H_
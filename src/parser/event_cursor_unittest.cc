@@ -0,0 +1,225 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/event_cursor.h"
+
+#include <atomic>
+#include <vector>
+
+#include "event/event_header.h"
+#include "gtest/gtest.h"
+#include "parser/parser.h"
+
+namespace parser {
+
+namespace {
+
+// Produces events at the given timestamps until it is cancelled. The process
+// id of each event is the id of the parser.
+class FakeParser : public ParserImpl {
+ public:
+  FakeParser(base::Pid id, const std::vector<event::Timestamp>& timestamps)
+      : id_(id), timestamps_(timestamps), produced_(0) {
+  }
+
+  bool AddTraceFile(const std::wstring& path) override { return false; }
+
+  void Parse(const EventCallback& callback) override {
+    event::EventHeader header;
+    header.process_id = id_;
+    for (size_t i = 0; i < timestamps_.size() && !cancelled(); ++i) {
+      if (filter() != NULL &&
+          !filter()->Accepts(base::Guid(), 0, id_, 0, timestamps_[i])) {
+        continue;
+      }
+      event::Event event(timestamps_[i], header,
+                         static_cast<const event::Value*>(NULL));
+      callback(event);
+      ++produced_;
+    }
+  }
+
+  // Returns the number of events sent to the callback.
+  size_t produced() const { return produced_; }
+
+ private:
+  base::Pid id_;
+  std::vector<event::Timestamp> timestamps_;
+  std::atomic<size_t> produced_;
+};
+
+std::vector<event::Timestamp> Range(event::Timestamp begin,
+                                    event::Timestamp end) {
+  std::vector<event::Timestamp> timestamps;
+  for (event::Timestamp ts = begin; ts < end; ++ts)
+    timestamps.push_back(ts);
+  return timestamps;
+}
+
+}  // namespace
+
+TEST(EventCursorTest, NextAndPeek) {
+  FakeParser first(1, { 10, 30 });
+  FakeParser second(2, { 20 });
+
+  EventCursor cursor(EventMerger::kDefaultQueueSize);
+  cursor.AddSource(&first);
+  cursor.AddSource(&second);
+
+  const event::Event* peeked = cursor.Peek();
+  ASSERT_TRUE(peeked != nullptr);
+  EXPECT_EQ(10U, peeked->timestamp());
+  EXPECT_EQ(peeked, cursor.Peek());
+
+  const event::Event* event = cursor.Next();
+  EXPECT_EQ(peeked, event);
+
+  // The event returned by Next() stays valid while the next one is peeked.
+  const event::Event* next = cursor.Peek();
+  ASSERT_TRUE(next != nullptr);
+  EXPECT_EQ(20U, next->timestamp());
+  EXPECT_EQ(10U, event->timestamp());
+
+  EXPECT_EQ(next, cursor.Next());
+  event = cursor.Next();
+  ASSERT_TRUE(event != nullptr);
+  EXPECT_EQ(30U, event->timestamp());
+  EXPECT_EQ(1U, event->event_header().process_id);
+
+  EXPECT_EQ(nullptr, cursor.Peek());
+  EXPECT_EQ(nullptr, cursor.Next());
+}
+
+TEST(EventCursorTest, SeekToTimestamp) {
+  FakeParser first(1, Range(0, 100));
+  FakeParser second(2, Range(50, 150));
+
+  EventCursor cursor(4);
+  cursor.AddSource(&first);
+  cursor.AddSource(&second);
+
+  // Before the first read, the parsers filter the skipped events.
+  EXPECT_TRUE(cursor.SeekToTimestamp(90));
+  const event::Event* event = cursor.Next();
+  ASSERT_TRUE(event != nullptr);
+  EXPECT_EQ(90U, event->timestamp());
+
+  // After the first read, the cursor skips the events.
+  EXPECT_TRUE(cursor.SeekToTimestamp(120));
+  event = cursor.Next();
+  ASSERT_TRUE(event != nullptr);
+  EXPECT_EQ(120U, event->timestamp());
+  EXPECT_EQ(2U, event->event_header().process_id);
+
+  EXPECT_FALSE(cursor.SeekToTimestamp(1000));
+  EXPECT_EQ(nullptr, cursor.Next());
+}
+
+TEST(EventCursorTest, SeekPastTimeRange) {
+  FakeParser first(1, Range(0, 100));
+  FakeParser second(2, Range(50, 150));
+
+  EventCursor cursor(4);
+  cursor.AddSource(&first);
+  cursor.AddSource(&second);
+  EventFilter filter;
+  filter.SetTimeRange(10, 120);
+  cursor.SetFilter(filter);
+
+  // Seeking past the end of the time range exhausts the cursor without
+  // starting the parsers.
+  EXPECT_FALSE(cursor.SeekToTimestamp(121));
+  EXPECT_EQ(nullptr, cursor.Peek());
+  EXPECT_EQ(nullptr, cursor.Next());
+  EXPECT_EQ(0U, first.produced());
+  EXPECT_EQ(0U, second.produced());
+}
+
+TEST(EventCursorTest, SeekPastTimeRangeAfterRead) {
+  FakeParser first(1, Range(0, 100));
+
+  EventCursor cursor(4);
+  cursor.AddSource(&first);
+  EventFilter filter;
+  filter.SetTimeRange(10, 50);
+  cursor.SetFilter(filter);
+
+  const event::Event* event = cursor.Next();
+  ASSERT_TRUE(event != nullptr);
+  EXPECT_EQ(10U, event->timestamp());
+
+  EXPECT_FALSE(cursor.SeekToTimestamp(51));
+  EXPECT_EQ(nullptr, cursor.Next());
+}
+
+TEST(EventCursorTest, NextN) {
+  FakeParser first(1, { 1, 3, 5 });
+  FakeParser second(2, { 2, 4 });
+
+  EventCursor cursor(EventMerger::kDefaultQueueSize);
+  cursor.AddSource(&first);
+  cursor.AddSource(&second);
+
+  const event::Event* events[3] = {};
+  base::Span<const event::Event*> batch(events, 3);
+  ASSERT_EQ(3U, cursor.NextN(batch));
+  EXPECT_EQ(1U, events[0]->timestamp());
+  EXPECT_EQ(2U, events[1]->timestamp());
+  EXPECT_EQ(3U, events[2]->timestamp());
+
+  ASSERT_EQ(2U, cursor.NextN(batch));
+  EXPECT_EQ(4U, events[0]->timestamp());
+  EXPECT_EQ(5U, events[1]->timestamp());
+
+  EXPECT_EQ(0U, cursor.NextN(batch));
+}
+
+TEST(EventCursorTest, StopEarly) {
+  const size_t kEventCount = 1000000;
+  FakeParser parser(1, Range(0, kEventCount));
+
+  {
+    EventCursor cursor(16);
+    cursor.AddSource(&parser);
+    ASSERT_TRUE(cursor.Next() != nullptr);
+  }
+
+  // Destroying the cursor cancels the parser.
+  EXPECT_LT(parser.produced(), kEventCount);
+}
+
+TEST(EventCursorTest, CreateFromParser) {
+  std::unique_ptr<FakeParser> impl(new FakeParser(1, { 5, 6, 7 }));
+  Parser parser;
+  parser.RegisterParser(std::move(impl));
+
+  std::unique_ptr<EventCursor> cursor = parser.CreateCursor();
+  EXPECT_TRUE(cursor->SeekToTimestamp(6));
+  const event::Event* event = cursor->Next();
+  ASSERT_TRUE(event != nullptr);
+  EXPECT_EQ(6U, event->timestamp());
+}
+
+}  // namespace parser
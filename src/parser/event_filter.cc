@@ -0,0 +1,106 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/event_filter.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace parser {
+
+FieldProjection::FieldProjection(const std::vector<std::string>& fields) {
+  for (const std::string& field : fields)
+    fields_.push_back(event::Atom::Intern(field));
+  std::sort(fields_.begin(), fields_.end());
+}
+
+bool FieldProjection::Contains(event::Atom name) const {
+  return std::binary_search(fields_.begin(), fields_.end(), name);
+}
+
+EventFilter::EventFilter()
+    : begin_(0),
+      end_(std::numeric_limits<event::Timestamp>::max()) {
+}
+
+void EventFilter::AllowProvider(const base::Guid& provider_id) {
+  providers_[provider_id].set();
+}
+
+void EventFilter::AllowOpcode(const base::Guid& provider_id,
+                              unsigned char opcode) {
+  providers_[provider_id].set(opcode);
+}
+
+void EventFilter::AllowProcess(base::Pid pid) {
+  processes_.insert(pid);
+}
+
+void EventFilter::AllowThread(base::Tid tid) {
+  threads_.insert(tid);
+}
+
+void EventFilter::SetTimeRange(event::Timestamp begin, event::Timestamp end) {
+  begin_ = begin;
+  end_ = end;
+}
+
+void EventFilter::ProjectFields(const base::Guid& provider_id,
+                                unsigned char opcode,
+                                const std::vector<std::string>& fields) {
+  projections_[EventType(provider_id, opcode)] = FieldProjection(fields);
+}
+
+bool EventFilter::Accepts(const base::Guid& provider_id,
+                          unsigned char opcode,
+                          base::Pid pid,
+                          base::Tid tid,
+                          event::Timestamp timestamp) const {
+  if (timestamp < begin_ || timestamp > end_)
+    return false;
+  if (!processes_.empty() && processes_.find(pid) == processes_.end())
+    return false;
+  if (!threads_.empty() && threads_.find(tid) == threads_.end())
+    return false;
+
+  if (providers_.empty())
+    return true;
+  std::map<base::Guid, OpcodeSet>::const_iterator provider =
+      providers_.find(provider_id);
+  return provider != providers_.end() && provider->second.test(opcode);
+}
+
+const FieldProjection* EventFilter::GetProjection(
+    const base::Guid& provider_id, unsigned char opcode) const {
+  if (projections_.empty())
+    return NULL;
+  std::map<EventType, FieldProjection>::const_iterator projection =
+      projections_.find(EventType(provider_id, opcode));
+  if (projection == projections_.end())
+    return NULL;
+  return &projection->second;
+}
+
+}  // namespace parser
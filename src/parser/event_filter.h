@@ -0,0 +1,164 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An EventFilter selects the events that a parser sends to its callback. The
+// filter is checked against the raw header of each event before its payload
+// is decoded, so rejected events cost no decoding and no allocation.
+//
+// An empty filter accepts every event. Each added criterion restricts the
+// accepted events:
+//
+//   parser::EventFilter filter;
+//   filter.AllowOpcode(kThreadProviderId, kCSwitchOpcode);
+//   filter.AllowProvider(kStackWalkProviderId);
+//   filter.AllowProcess(1234);
+//   filter.ProjectFields(kThreadProviderId, kCSwitchOpcode,
+//                        { "NewThreadId", "OldThreadId" });
+//   parser.SetFilter(filter);
+
+#ifndef PARSER_EVENT_FILTER_H_
+#define PARSER_EVENT_FILTER_H_
+
+#include <bitset>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/guid.h"
+#include "base/types.h"
+#include "event/atom.h"
+#include "event/event.h"
+
+namespace parser {
+
+// A set of payload fields to decode. The other fields of the payload are
+// skipped by the decoders.
+class FieldProjection {
+ public:
+  FieldProjection() { }
+
+  // @param fields the names of the fields to decode.
+  explicit FieldProjection(const std::vector<std::string>& fields);
+
+  // @param name the name of a field.
+  // @returns true if the field |name| must be decoded, false otherwise.
+  bool Contains(event::Atom name) const;
+
+  // @returns the number of fields to decode.
+  size_t size() const { return fields_.size(); }
+
+ private:
+  // Sorted atoms of the fields to decode.
+  std::vector<event::Atom> fields_;
+};
+
+// Selects the events to decode from their raw header.
+class EventFilter {
+ public:
+  EventFilter();
+
+  // Accepts every event of a provider. Once a provider or an opcode is
+  // allowed, the events of the other providers are rejected.
+  // @param provider_id the GUID of the provider.
+  void AllowProvider(const base::Guid& provider_id);
+
+  // Accepts the events of a provider with a given opcode. Once a provider or
+  // an opcode is allowed, the events of the other providers are rejected.
+  // @param provider_id the GUID of the provider.
+  // @param opcode the opcode of the events.
+  void AllowOpcode(const base::Guid& provider_id, unsigned char opcode);
+
+  // Accepts the events of a process. Once a process is allowed, the events of
+  // the other processes are rejected.
+  // @param pid the id of the process.
+  void AllowProcess(base::Pid pid);
+
+  // Accepts the events of a thread. Once a thread is allowed, the events of
+  // the other threads are rejected.
+  // @param tid the id of the thread.
+  void AllowThread(base::Tid tid);
+
+  // Rejects the events outside of a time range.
+  // @param begin the first accepted timestamp.
+  // @param end the last accepted timestamp.
+  void SetTimeRange(event::Timestamp begin, event::Timestamp end);
+
+  // @returns the first and the last accepted timestamps.
+  // @{
+  event::Timestamp begin_time() const { return begin_; }
+  event::Timestamp end_time() const { return end_; }
+  // @}
+
+  // Restricts the decoded payload fields of the events of a provider with a
+  // given opcode. This does not change the accepted events.
+  // @param provider_id the GUID of the provider.
+  // @param opcode the opcode of the events.
+  // @param fields the names of the fields to decode.
+  void ProjectFields(const base::Guid& provider_id,
+                     unsigned char opcode,
+                     const std::vector<std::string>& fields);
+
+  // Checks the raw header of an event against the filter.
+  // @param provider_id the GUID of the provider of the event.
+  // @param opcode the opcode of the event.
+  // @param pid the id of the process which emitted the event.
+  // @param tid the id of the thread which emitted the event.
+  // @param timestamp the timestamp of the event.
+  // @returns true if the event must be decoded, false otherwise.
+  bool Accepts(const base::Guid& provider_id,
+               unsigned char opcode,
+               base::Pid pid,
+               base::Tid tid,
+               event::Timestamp timestamp) const;
+
+  // @param provider_id the GUID of the provider of the event.
+  // @param opcode the opcode of the event.
+  // @returns the fields to decode from the payload of the event, or NULL to
+  //     decode all of them.
+  const FieldProjection* GetProjection(const base::Guid& provider_id,
+                                       unsigned char opcode) const;
+
+ private:
+  typedef std::bitset<256> OpcodeSet;
+  typedef std::pair<base::Guid, unsigned char> EventType;
+
+  // Allowed opcodes by provider. Empty to accept every provider.
+  std::map<base::Guid, OpcodeSet> providers_;
+
+  // Allowed processes and threads. Empty to accept every process or thread.
+  std::set<base::Pid> processes_;
+  std::set<base::Tid> threads_;
+
+  event::Timestamp begin_;
+  event::Timestamp end_;
+
+  std::map<EventType, FieldProjection> projections_;
+};
+
+}  // namespace parser
+
+#endif  // PARSER_EVENT_FILTER_H_
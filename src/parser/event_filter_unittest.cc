@@ -0,0 +1,112 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/event_filter.h"
+
+#include "gtest/gtest.h"
+
+namespace parser {
+
+namespace {
+
+using event::Atom;
+
+const base::Guid kThreadProviderId = { 0x3D6FA8D1, 0xFE05, 0x11D0,
+    { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+const base::Guid kStackWalkProviderId = { 0xDEF2FE46, 0x7BD6, 0x4B80,
+    { 0xBD, 0x94, 0xF5, 0x7F, 0xE2, 0x0D, 0x0C, 0xE3 } };
+const base::Guid kImageProviderId = { 0x2CB15D1D, 0x5FC1, 0x11D2,
+    { 0xAB, 0xE1, 0x00, 0xA0, 0xC9, 0x11, 0xF5, 0x18 } };
+
+const unsigned char kCSwitchOpcode = 36;
+const unsigned char kReadyThreadOpcode = 50;
+const unsigned char kStackOpcode = 32;
+
+}  // namespace
+
+TEST(EventFilterTest, EmptyFilterAcceptsEverything) {
+  EventFilter filter;
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 1, 2, 0));
+  EXPECT_TRUE(filter.Accepts(kImageProviderId, 0, 3, 4, 1000));
+  EXPECT_TRUE(filter.GetProjection(kThreadProviderId, kCSwitchOpcode) == NULL);
+}
+
+TEST(EventFilterTest, Providers) {
+  EventFilter filter;
+  filter.AllowOpcode(kThreadProviderId, kCSwitchOpcode);
+  filter.AllowProvider(kStackWalkProviderId);
+
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 1, 2, 0));
+  EXPECT_FALSE(filter.Accepts(kThreadProviderId, kReadyThreadOpcode, 1, 2, 0));
+  EXPECT_TRUE(filter.Accepts(kStackWalkProviderId, kStackOpcode, 1, 2, 0));
+  EXPECT_TRUE(filter.Accepts(kStackWalkProviderId, 255, 1, 2, 0));
+  EXPECT_FALSE(filter.Accepts(kImageProviderId, kStackOpcode, 1, 2, 0));
+}
+
+TEST(EventFilterTest, ProcessesAndThreads) {
+  EventFilter filter;
+  filter.AllowProcess(10);
+  filter.AllowProcess(11);
+
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 10, 1, 0));
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 11, 2, 0));
+  EXPECT_FALSE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 12, 1, 0));
+
+  filter.AllowThread(1);
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 10, 1, 0));
+  EXPECT_FALSE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 11, 2, 0));
+}
+
+TEST(EventFilterTest, TimeRange) {
+  EventFilter filter;
+  filter.SetTimeRange(100, 200);
+
+  EXPECT_FALSE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 1, 2, 99));
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 1, 2, 100));
+  EXPECT_TRUE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 1, 2, 200));
+  EXPECT_FALSE(filter.Accepts(kThreadProviderId, kCSwitchOpcode, 1, 2, 201));
+}
+
+TEST(EventFilterTest, Projection) {
+  EventFilter filter;
+  filter.ProjectFields(kThreadProviderId, kCSwitchOpcode,
+                       { "OldThreadId", "NewThreadId" });
+
+  // A projection does not change the accepted events.
+  EXPECT_TRUE(filter.Accepts(kImageProviderId, 0, 1, 2, 0));
+
+  EXPECT_TRUE(filter.GetProjection(kThreadProviderId, kReadyThreadOpcode) ==
+              NULL);
+  EXPECT_TRUE(filter.GetProjection(kImageProviderId, kCSwitchOpcode) == NULL);
+
+  const FieldProjection* projection =
+      filter.GetProjection(kThreadProviderId, kCSwitchOpcode);
+  ASSERT_TRUE(projection != NULL);
+  EXPECT_TRUE(projection->Contains(Atom::Intern("NewThreadId")));
+  EXPECT_TRUE(projection->Contains(Atom::Intern("OldThreadId")));
+  EXPECT_FALSE(projection->Contains(Atom::Intern("WaitTime")));
+}
+
+}  // namespace parser
@@ -0,0 +1,253 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/event_merger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "base/logging.h"
+#include "base/spsc_ring.h"
+#include "event/utils.h"
+#include "event/value_arena.h"
+#include "parser/parser.h"
+
+namespace parser {
+
+namespace {
+
+// Value of |last_source_| when no source must be read again.
+const size_t kNoSource = static_cast<size_t>(-1);
+
+// Number of times a thread yields while it waits for a ring before it starts
+// sleeping. Short waits stay cheap; long waits do not burn a core.
+const int kMaxYields = 128;
+
+// Sleep duration of a thread waiting for a ring, in microseconds.
+const int kWaitSleepMicroseconds = 50;
+
+// Size of the arenas holding the copies of the queued events. The copies of
+// consecutive events share an arena, which is released with the last of them.
+const size_t kArenaSize = 64 * 1024;
+
+// A new arena is started when the current one has less free space, so that
+// the copy of an event rarely spills into a second block.
+const size_t kArenaHeadroom = 8 * 1024;
+
+// Waits for the other side of a ring, with an increasing backoff.
+class Backoff {
+ public:
+  Backoff() : yields_(0) { }
+
+  void Wait() {
+    if (yields_ < kMaxYields) {
+      ++yields_;
+      std::this_thread::yield();
+      return;
+    }
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(kWaitSleepMicroseconds));
+  }
+
+ private:
+  int yields_;
+};
+
+}  // namespace
+
+// A parser running on its own thread, and the ring of the events it has
+// produced and the consumer has not read yet. The parser thread is the only
+// producer of the ring and the consumer thread its only consumer.
+class EventMerger::Source {
+ public:
+  Source(ParserImpl* parser, size_t queue_size)
+      : parser_(parser),
+        ring_(queue_size),
+        done_(false),
+        cancelled_(false) {
+    DCHECK(parser != NULL);
+    DCHECK_GT(queue_size, 0U);
+  }
+
+  ~Source() {
+    Cancel();
+    if (thread_.joinable())
+      thread_.join();
+  }
+
+  // Starts parsing on a new thread.
+  void Start() {
+    parser_->set_cancelled(false);
+    thread_ = std::thread(&Source::Run, this);
+  }
+
+  // Returns the next event of the parser. Waits until an event is available.
+  // @returns the next event, or nullptr when the parser is done.
+  std::unique_ptr<event::Event> Pop() {
+    std::unique_ptr<event::Event> event;
+    Backoff backoff;
+    while (!ring_.TryPop(&event)) {
+      // The producer pushes its last event before it sets |done_|: check the
+      // ring again once |done_| is seen.
+      if (done_.load(std::memory_order_acquire)) {
+        ring_.TryPop(&event);
+        break;
+      }
+      backoff.Wait();
+    }
+    return event;
+  }
+
+  // Stops queuing events and asks the parser to return early. The events it
+  // produces until then are discarded.
+  void Cancel() {
+    cancelled_.store(true, std::memory_order_release);
+    parser_->set_cancelled(true);
+  }
+
+ private:
+  // Runs the parser, on the thread of the source.
+  void Run() {
+    parser_->Parse([this](const event::Event& event) {
+      // The event only lives until the callback returns: queue a copy.
+      if (cancelled_.load(std::memory_order_acquire))
+        return;
+      if (arena_.get() == NULL ||
+          arena_->BytesUsed() > kArenaSize - kArenaHeadroom) {
+        arena_ = std::make_shared<event::ValueArena>(kArenaSize);
+      }
+      Push(event::CopyEvent(event, arena_));
+    });
+    arena_.reset();
+    done_.store(true, std::memory_order_release);
+  }
+
+  // Queues an event. Waits while the ring is full, which applies
+  // backpressure to the parser when the consumer is slower.
+  void Push(std::unique_ptr<event::Event> event) {
+    Backoff backoff;
+    while (!ring_.TryPush(std::move(event))) {
+      if (cancelled_.load(std::memory_order_acquire))
+        return;
+      backoff.Wait();
+    }
+  }
+
+  ParserImpl* parser_;
+  std::thread thread_;
+
+  // The arena holding the copies of the last events, used by the parser
+  // thread only.
+  std::shared_ptr<event::ValueArena> arena_;
+
+  base::SpscRing<std::unique_ptr<event::Event> > ring_;
+
+  // Set by the producer when the parser is done.
+  std::atomic<bool> done_;
+
+  // Set by the consumer to stop the producer.
+  std::atomic<bool> cancelled_;
+
+  DISALLOW_COPY_AND_ASSIGN(Source);
+};
+
+bool EventMerger::HeadEventGreater::operator()(const HeadEvent& left,
+                                               const HeadEvent& right) const {
+  if (left.event->timestamp() != right.event->timestamp())
+    return left.event->timestamp() > right.event->timestamp();
+  return left.source > right.source;
+}
+
+EventMerger::EventMerger(size_t queue_size)
+    : queue_size_(queue_size),
+      last_source_(kNoSource),
+      started_(false) {
+}
+
+EventMerger::~EventMerger() {
+  // Destroying a source cancels it and waits for its thread.
+  sources_.clear();
+}
+
+void EventMerger::AddSource(ParserImpl* parser) {
+  DCHECK(!started_);
+  sources_.push_back(
+      std::unique_ptr<Source>(new Source(parser, queue_size_)));
+}
+
+void EventMerger::Start() {
+  DCHECK(!started_);
+  started_ = true;
+
+  for (size_t i = 0; i < sources_.size(); ++i)
+    sources_[i]->Start();
+
+  // The first event of every source is needed before the oldest one is known.
+  heap_.reserve(sources_.size());
+  for (size_t i = 0; i < sources_.size(); ++i)
+    ReadSource(i);
+}
+
+const event::Event* EventMerger::Next() {
+  current_ = Pop();
+  return current_.get();
+}
+
+std::unique_ptr<event::Event> EventMerger::Pop() {
+  DCHECK(started_);
+
+  // Replace the event returned by the previous call with the next event of
+  // the same source.
+  if (last_source_ != kNoSource) {
+    ReadSource(last_source_);
+    last_source_ = kNoSource;
+  }
+
+  if (heap_.empty())
+    return std::unique_ptr<event::Event>();
+
+  std::pop_heap(heap_.begin(), heap_.end(), HeadEventGreater());
+  std::unique_ptr<event::Event> event = std::move(heap_.back().event);
+  last_source_ = heap_.back().source;
+  heap_.pop_back();
+  return event;
+}
+
+void EventMerger::ReadSource(size_t source) {
+  DCHECK_LT(source, sources_.size());
+
+  HeadEvent head;
+  head.event = sources_[source]->Pop();
+  if (head.event.get() == NULL)
+    return;
+  head.source = source;
+  heap_.push_back(std::move(head));
+  std::push_heap(heap_.begin(), heap_.end(), HeadEventGreater());
+}
+
+}  // namespace parser
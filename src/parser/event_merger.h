@@ -0,0 +1,136 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An EventMerger parses several traces concurrently and returns their events
+// in global timestamp order. Each source (a ParserImpl) runs on its own thread
+// and pushes copies of its events into a lock-free single-producer
+// single-consumer ring (see base/spsc_ring.h). The consumer keeps the head of
+// each ring in a min-heap and pops the oldest event. A producer waits when its
+// ring is full, so the memory used is bounded by the size of the rings, not by
+// the size of the traces, and decoding overlaps with the consumer.
+//
+// The merger is not free: an event received by a source only lives until its
+// callback returns, so the source copies it (see event::CopyEvent()). The
+// copies of consecutive events share an arena, which costs a few heap
+// allocations per arena instead of one per value, and string views and
+// structures with a schema keep their compact form. However, a lazy payload
+// is decoded on the source thread, even if the consumer never reads it, and
+// every value is written twice. A single source which runs on the thread of
+// the consumer does not need a merger (see Parser::Parse()).
+//
+// Each source must produce its events in timestamp order.
+//
+// Usage example:
+//   EventMerger merger(EventMerger::kDefaultQueueSize);
+//   merger.AddSource(first_parser);
+//   merger.AddSource(second_parser);
+//   merger.Start();
+//   while (const event::Event* event = merger.Next())
+//     ...
+
+#ifndef PARSER_EVENT_MERGER_H_
+#define PARSER_EVENT_MERGER_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/base.h"
+#include "event/event.h"
+
+namespace parser {
+
+// Forward declaration.
+class ParserImpl;
+
+class EventMerger {
+ public:
+  // The default number of events queued per source.
+  static const size_t kDefaultQueueSize = 1024;
+
+  // @param queue_size the maximum number of events queued per source. It is
+  //     rounded up to a power of two.
+  explicit EventMerger(size_t queue_size);
+
+  // Cancels the sources which are still running (see
+  // ParserImpl::set_cancelled()) and waits for their threads.
+  ~EventMerger();
+
+  // Adds a source of events. Must be called before Start().
+  // @param parser the source, owned by the caller. Must outlive the merger.
+  void AddSource(ParserImpl* parser);
+
+  // Starts the thread of each source.
+  void Start();
+
+  // Returns the next event in timestamp order. Blocks until each source has
+  // produced an event or is done.
+  // @returns the next event, or nullptr when all sources are done. The event
+  //     is valid until the next call to Next() or Pop().
+  const event::Event* Next();
+
+  // Same as Next(), giving the ownership of the event to the caller.
+  // @returns the next event, or nullptr when all sources are done.
+  std::unique_ptr<event::Event> Pop();
+
+ private:
+  class Source;
+
+  // An event at the head of a source.
+  struct HeadEvent {
+    std::unique_ptr<event::Event> event;
+    size_t source;
+  };
+
+  // Orders the heap by timestamp, the oldest first. Events with the same
+  // timestamp are returned in the order of their sources.
+  struct HeadEventGreater {
+    bool operator()(const HeadEvent& left, const HeadEvent& right) const;
+  };
+
+  // Pushes the next event of |source| on the heap, unless it is done.
+  // @param source the index of the source to read.
+  void ReadSource(size_t source);
+
+  size_t queue_size_;
+  std::vector<std::unique_ptr<Source> > sources_;
+
+  // The head of each source which is not done.
+  std::vector<HeadEvent> heap_;
+
+  // The event returned by the last call to Next().
+  std::unique_ptr<event::Event> current_;
+
+  // The source of the last returned event. It is read again on the next call,
+  // so that the consumer handles the event while the source decodes.
+  size_t last_source_;
+
+  bool started_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventMerger);
+};
+
+}  // namespace parser
+
+#endif  // PARSER_EVENT_MERGER_H_
@@ -0,0 +1,125 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/event_merger.h"
+
+#include <vector>
+
+#include "event/event_header.h"
+#include "gtest/gtest.h"
+#include "parser/parser.h"
+
+namespace parser {
+
+namespace {
+
+// Produces events at the given timestamps. The process id of each event is
+// the id of the parser.
+class FakeParser : public ParserImpl {
+ public:
+  FakeParser(base::Pid id, const std::vector<event::Timestamp>& timestamps)
+      : id_(id), timestamps_(timestamps) {
+  }
+
+  bool AddTraceFile(const std::wstring& path) override { return false; }
+
+  void Parse(const EventCallback& callback) override {
+    event::EventHeader header;
+    header.process_id = id_;
+    for (size_t i = 0; i < timestamps_.size(); ++i) {
+      event::Event event(timestamps_[i], header,
+                         static_cast<const event::Value*>(NULL));
+      callback(event);
+    }
+  }
+
+ private:
+  base::Pid id_;
+  std::vector<event::Timestamp> timestamps_;
+};
+
+}  // namespace
+
+TEST(EventMergerTest, MergeInTimestampOrder) {
+  FakeParser first(1, { 10, 20, 30, 40 });
+  FakeParser second(2, { 5, 25, 26, 27, 50, 60 });
+  FakeParser third(3, { 20, 45 });
+
+  // A small queue makes the producers wait for the consumer.
+  EventMerger merger(2);
+  merger.AddSource(&first);
+  merger.AddSource(&second);
+  merger.AddSource(&third);
+  merger.Start();
+
+  std::vector<event::Timestamp> timestamps;
+  std::vector<base::Pid> sources;
+  while (const event::Event* event = merger.Next()) {
+    timestamps.push_back(event->timestamp());
+    sources.push_back(event->event_header().process_id);
+  }
+
+  const std::vector<event::Timestamp> kExpectedTimestamps = {
+      5, 10, 20, 20, 25, 26, 27, 30, 40, 45, 50, 60 };
+  const std::vector<base::Pid> kExpectedSources = {
+      2, 1, 1, 3, 2, 2, 2, 1, 1, 3, 2, 2 };
+  EXPECT_EQ(kExpectedTimestamps, timestamps);
+  EXPECT_EQ(kExpectedSources, sources);
+
+  // All sources are done.
+  EXPECT_EQ(nullptr, merger.Next());
+}
+
+TEST(EventMergerTest, EmptySources) {
+  FakeParser empty(1, std::vector<event::Timestamp>());
+  FakeParser single(2, { 42 });
+
+  EventMerger merger(EventMerger::kDefaultQueueSize);
+  merger.AddSource(&empty);
+  merger.AddSource(&single);
+  merger.Start();
+
+  const event::Event* event = merger.Next();
+  ASSERT_TRUE(event != nullptr);
+  EXPECT_EQ(42U, event->timestamp());
+  EXPECT_EQ(nullptr, merger.Next());
+}
+
+TEST(EventMergerTest, StopBeforeTheEnd) {
+  std::vector<event::Timestamp> timestamps;
+  for (event::Timestamp ts = 0; ts < 1000; ++ts)
+    timestamps.push_back(ts);
+  FakeParser first(1, timestamps);
+  FakeParser second(2, timestamps);
+
+  // Destroying the merger releases the producers blocked on a full queue.
+  EventMerger merger(4);
+  merger.AddSource(&first);
+  merger.AddSource(&second);
+  merger.Start();
+  ASSERT_TRUE(merger.Next() != nullptr);
+}
+
+}  // namespace parser
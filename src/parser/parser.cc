@@ -26,35 +26,97 @@
 #include "parser/parser.h"
 
 #include "base/logging.h"
+#include "parser/event_merger.h"
 
 namespace parser {
 
+Parser::Parser() : queue_size_(EventMerger::kDefaultQueueSize) {
+}
+
 Parser::~Parser() {
   for (ParserList::iterator it = parsers_.begin(); it != parsers_.end(); ++it)
     delete *it;
+  for (ParserList::iterator it = instances_.begin(); it != instances_.end();
+       ++it) {
+    delete *it;
+  }
 }
 
 void Parser::RegisterParser(std::unique_ptr<ParserImpl> parser) {
+  // A parser which creates an instance per trace file never parses itself.
+  if (!parser->ParsesEachFileSeparately())
+    sources_.push_back(parser.get());
   parsers_.push_back(parser.release());
 }
 
 bool Parser::AddTraceFile(const std::wstring& path) {
   ParserList::iterator parser = parsers_.begin();
   for (; parser != parsers_.end(); ++parser) {
-    if ((*parser)->AddTraceFile(path))
+    if (!(*parser)->ParsesEachFileSeparately()) {
+      if ((*parser)->AddTraceFile(path))
+        return true;
+      continue;
+    }
+
+    std::unique_ptr<ParserImpl> instance = (*parser)->NewInstance();
+    DCHECK(instance.get() != NULL);
+    if (instance->AddTraceFile(path)) {
+      sources_.push_back(instance.get());
+      instances_.push_back(instance.release());
       return true;
+    }
   }
   return false;
 }
 
+void Parser::SetFilter(const EventFilter& filter) {
+  filter_ = filter;
+}
+
+void Parser::SetTimeRange(event::Timestamp begin, event::Timestamp end) {
+  DCHECK_LT(begin, end);
+  filter_.SetTimeRange(begin, end - 1);
+}
+
+void Parser::SetQueueSize(size_t queue_size) {
+  queue_size_ = queue_size;
+}
+
+size_t Parser::GetQueueSize() const {
+  if (queue_size_ == 0)
+    return EventMerger::kDefaultQueueSize;
+  return queue_size_;
+}
+
 void Parser::Parse(const EventCallback& callback) {
-  // TODO(etienneb): This is a patch, there is no event ordering.
-  //     We should start thread for each active parser.
-  //     The parser class should manage and merge events in order.
-  ParserList::iterator parser = parsers_.begin();
-  for (; parser != parsers_.end(); ++parser) {
-    (*parser)->Parse(callback);
+  // The events of a single source are already ordered: without a queue, they
+  // are sent to the callback without being copied.
+  if (sources_.size() == 1 && queue_size_ == 0) {
+    sources_.front()->set_filter(&filter_);
+    sources_.front()->Parse(callback);
+    return;
   }
+
+  EventMerger merger(GetQueueSize());
+  ParserList::iterator parser = sources_.begin();
+  for (; parser != sources_.end(); ++parser) {
+    (*parser)->set_filter(&filter_);
+    merger.AddSource(*parser);
+  }
+  merger.Start();
+
+  while (const event::Event* event = merger.Next())
+    callback(*event);
+}
+
+std::unique_ptr<EventCursor> Parser::CreateCursor() {
+  std::unique_ptr<EventCursor> cursor(
+      new EventCursor(GetQueueSize()));
+  cursor->SetFilter(filter_);
+  ParserList::iterator parser = sources_.begin();
+  for (; parser != sources_.end(); ++parser)
+    cursor->AddSource(*parser);
+  return cursor;
 }
 
 }  // namespace parser
@@ -35,6 +35,9 @@
 //     4) Call the Parse() method,
 //     5) Receive the decoded events through the callback.
 //
+// Alternatively, the events may be read on demand through an EventCursor
+// returned by CreateCursor() (see event_cursor.h).
+//
 // The parser is intented to be used like that:
 //
 //   parser::Parser parser;
@@ -42,16 +45,31 @@
 //   if (!parser.AddTraceFile("trace.dummy")
 //     return false;
 //   parser.Parse(&Callback);
+//
+// An EventFilter (see event_filter.h) may be set before parsing to skip the
+// decoding of unneeded events.
+//
+// Each parser runs on its own thread and the callback receives the events of
+// all traces in timestamp order (see event_merger.h), so that decoding
+// overlaps with the callback; the events are copied from the parser threads
+// to the callback. Implementations which support it parse each trace file in
+// a separate instance, so multiple trace files of the same format are merged
+// too. Other implementations order the events of their trace files
+// themselves.
 
 #ifndef PARSER_PARSER_H_
 #define PARSER_PARSER_H_
 
+#include <atomic>
 #include <functional>
 #include <list>
+#include <memory>
 #include <string>
 
 #include "base/base.h"
 #include "event/event.h"
+#include "parser/event_cursor.h"
+#include "parser/event_filter.h"
 
 namespace parser {
 
@@ -67,7 +85,7 @@ class Parser {
   typedef std::function<void(const event::Event& value)> EventCallback;
 
   // Constructor.
-  Parser() { }
+  Parser();
 
   // Destructor.
   ~Parser();
@@ -81,14 +99,58 @@ class Parser {
   // @returns true if the trace can be handled by this parser, false otherwise.
   bool AddTraceFile(const std::wstring& path);
 
+  // Sets the filter selecting the events sent to the callback by Parse().
+  // @param filter the filter to apply to the events.
+  void SetFilter(const EventFilter& filter);
+
+  // Restricts the events sent by Parse() to a time range. It replaces the
+  // time range of the filter. Parsers with an index of their traces (e.g.
+  // etw::EtlFileParser) only read the parts of the traces in this range.
+  // @param begin the first timestamp of the range.
+  // @param end the timestamp following the range, greater than |begin|.
+  void SetTimeRange(event::Timestamp begin, event::Timestamp end);
+
+  // Sets the maximum number of events queued by each parser thread before it
+  // waits for the callback. The default is EventMerger::kDefaultQueueSize.
+  // With 0, a single parser runs on the calling thread and sends its events
+  // to the callback without copying them, and several parsers use
+  // EventMerger::kDefaultQueueSize.
+  // @param queue_size the number of events queued per parser.
+  void SetQueueSize(size_t queue_size);
+
   // Parses the trace files added with AddTraceFile() and sends the resulting
-  // events to the provided callback.
+  // events to the provided callback, in timestamp order.
   // @param callback a callback that will receive the decoded events.
   void Parse(const EventCallback& callback);
 
+  // Creates a cursor reading the events of the trace files added with
+  // AddTraceFile(), in timestamp order. The filter and the queue size are
+  // the ones set on this parser. Only one cursor, or one call to Parse(), may
+  // read the traces.
+  // @returns the cursor, which must not outlive this parser.
+  std::unique_ptr<EventCursor> CreateCursor();
+
  private:
+  // @returns the number of events queued per parser thread.
+  size_t GetQueueSize() const;
+
+  // The registered parsers.
   ParserList parsers_;
 
+  // The instances created for each trace file by the parsers which support
+  // it (see ParserImpl::NewInstance()).
+  ParserList instances_;
+
+  // The parsers which run when Parse() is called: the registered parsers
+  // which parse their trace files themselves, and the instances.
+  ParserList sources_;
+
+  EventFilter filter_;
+
+  // The number of events queued per parser, or 0 to run a single parser on
+  // the calling thread.
+  size_t queue_size_;
+
   DISALLOW_COPY_AND_ASSIGN(Parser);
 };
 
@@ -96,7 +158,8 @@ class Parser {
 class ParserImpl {
  public:
   typedef Parser::EventCallback EventCallback;
-  
+
+  ParserImpl() : filter_(NULL), cancelled_(false) { }
   virtual ~ParserImpl() { }
 
   // Adds a trace file to the list of traces to parse.
@@ -105,9 +168,50 @@ class ParserImpl {
   virtual bool AddTraceFile(const std::wstring& path) = 0;
 
   // Parses the trace files added with AddTraceFile() and sends the resulting
-  // events to the provided callback.
+  // events to the provided callback, in timestamp order.
   // @param callback a callback that will receive the decoded events.
   virtual void Parse(const EventCallback& callback) = 0;
+
+  // Indicates whether each trace file is parsed by its own instance (see
+  // NewInstance()). Parser checks it when the parser is registered.
+  // @returns true if NewInstance() is implemented, false if this
+  //     implementation parses all its trace files itself.
+  virtual bool ParsesEachFileSeparately() const { return false; }
+
+  // Creates a parser of the same kind, without trace files. Parser adds each
+  // trace file to a new instance, so that the files are parsed concurrently.
+  // Only called when ParsesEachFileSeparately() is true.
+  // @returns the new parser.
+  virtual std::unique_ptr<ParserImpl> NewInstance() const {
+    return std::unique_ptr<ParserImpl>();
+  }
+
+  // Sets the filter to apply to the events. Implementations check it against
+  // the raw header of each event, before decoding its payload.
+  // @param filter the filter, owned by the caller. Must outlive Parse().
+  void set_filter(const EventFilter* filter) { filter_ = filter; }
+
+  // Asks Parse() to return as soon as possible, e.g. when the consumer of the
+  // events stops early. May be called from another thread. Implementations
+  // check cancelled() regularly; the events sent after the cancellation are
+  // ignored.
+  // @param cancelled whether Parse() must return early.
+  void set_cancelled(bool cancelled) {
+    cancelled_.store(cancelled, std::memory_order_relaxed);
+  }
+
+ protected:
+  // @returns the filter to apply to the events, or NULL to accept them all.
+  const EventFilter* filter() const { return filter_; }
+
+  // @returns true if Parse() must return as soon as possible.
+  bool cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const EventFilter* filter_;
+  std::atomic<bool> cancelled_;
 };
 
 }  // namespace parser
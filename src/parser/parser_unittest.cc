@@ -25,6 +25,11 @@
 
 #include "parser/parser.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include "base/bind_object.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -48,6 +53,91 @@ class MockObserver {
   MOCK_METHOD1(Receive, void(const event::Event& event));
 };
 
+// Records the filter set when Parse() is called.
+class FilterRecordingParser : public parser::ParserImpl {
+ public:
+  FilterRecordingParser() : parse_filter_(NULL) { }
+
+  bool AddTraceFile(const std::wstring& path) override { return true; }
+  void Parse(const EventCallback& callback) override {
+    parse_filter_ = filter();
+  }
+
+  const parser::EventFilter* parse_filter() const { return parse_filter_; }
+
+ private:
+  const parser::EventFilter* parse_filter_;
+};
+
+// Parses each trace file in its own instance. The events of a trace file
+// named with N characters are at timestamps N and N + 2.
+class InstanceParser : public parser::ParserImpl {
+ public:
+  bool AddTraceFile(const std::wstring& path) override {
+    if (!path_.empty())
+      return false;
+    path_ = path;
+    return true;
+  }
+
+  void Parse(const EventCallback& callback) override {
+    event::EventHeader header;
+    event::Event first(path_.size(), header,
+                       static_cast<const event::Value*>(NULL));
+    callback(first);
+    event::Event second(path_.size() + 2, header,
+                        static_cast<const event::Value*>(NULL));
+    callback(second);
+  }
+
+  bool ParsesEachFileSeparately() const override { return true; }
+
+  std::unique_ptr<parser::ParserImpl> NewInstance() const override {
+    return std::unique_ptr<parser::ParserImpl>(new InstanceParser());
+  }
+
+ private:
+  std::wstring path_;
+};
+
+// Sends an event, then records that it decodes a second event.
+class DecodingParser : public parser::ParserImpl {
+ public:
+  DecodingParser() : decoding_second_event_(false) { }
+
+  bool AddTraceFile(const std::wstring& path) override { return true; }
+
+  void Parse(const EventCallback& callback) override {
+    event::EventHeader header;
+    event::Event first(1, header, static_cast<const event::Value*>(NULL));
+    callback(first);
+
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      decoding_second_event_ = true;
+      decoding_changed_.notify_one();
+    }
+
+    event::Event second(2, header, static_cast<const event::Value*>(NULL));
+    callback(second);
+  }
+
+  // Waits until the parser decodes its second event. When the parser runs on
+  // the thread of the callback, it never does.
+  // @returns true if the parser decodes its second event.
+  bool WaitForSecondEvent() {
+    std::unique_lock<std::mutex> lock(lock_);
+    return decoding_changed_.wait_for(
+        lock, std::chrono::seconds(10),
+        [this] { return decoding_second_event_; });
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable decoding_changed_;
+  bool decoding_second_event_;
+};
+
 }  // namespace
 
 TEST(ParserTest, AddTraceFileWithoutParser) {
@@ -72,7 +162,96 @@ TEST(ParserTest, Parse) {
   parser.RegisterParser(std::move(impl));
   EXPECT_TRUE(parser.AddTraceFile(filename));
 
+  // Without a queue, the callback is passed to the parser.
+  parser.SetQueueSize(0);
   parser.Parse(callback);
 }
 
+TEST(ParserTest, ParseWithFilter) {
+  const base::Guid kProviderId = { 0x3D6FA8D1, 0xFE05, 0x11D0,
+      { 0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C } };
+
+  parser::Parser parser;
+  std::unique_ptr<FilterRecordingParser> impl(new FilterRecordingParser());
+  FilterRecordingParser* impl_ptr = impl.get();
+  parser.RegisterParser(std::move(impl));
+
+  parser::EventFilter filter;
+  filter.AllowProcess(42);
+  parser.SetFilter(filter);
+  parser.Parse([](const event::Event& event) { });
+
+  const parser::EventFilter* parse_filter = impl_ptr->parse_filter();
+  ASSERT_TRUE(parse_filter != NULL);
+  EXPECT_TRUE(parse_filter->Accepts(kProviderId, 0, 42, 0, 0));
+  EXPECT_FALSE(parse_filter->Accepts(kProviderId, 0, 43, 0, 0));
+}
+
+TEST(ParserTest, ParseWithTimeRange) {
+  parser::Parser parser;
+  std::unique_ptr<FilterRecordingParser> impl(new FilterRecordingParser());
+  FilterRecordingParser* impl_ptr = impl.get();
+  parser.RegisterParser(std::move(impl));
+
+  parser.SetTimeRange(100, 200);
+  parser.Parse([](const event::Event& event) { });
+
+  const parser::EventFilter* parse_filter = impl_ptr->parse_filter();
+  ASSERT_TRUE(parse_filter != NULL);
+  EXPECT_EQ(100U, parse_filter->begin_time());
+  EXPECT_EQ(199U, parse_filter->end_time());
+}
+
+TEST(ParserTest, ParseMergesTraceFiles) {
+  parser::Parser parser;
+  parser.RegisterParser(
+      std::unique_ptr<parser::ParserImpl>(new InstanceParser()));
+  EXPECT_TRUE(parser.AddTraceFile(L"a"));
+  EXPECT_TRUE(parser.AddTraceFile(L"bb"));
+
+  std::vector<event::Timestamp> timestamps;
+  parser.Parse([&timestamps](const event::Event& event) {
+    timestamps.push_back(event.timestamp());
+  });
+
+  const std::vector<event::Timestamp> kExpectedTimestamps = { 1, 2, 3, 4 };
+  EXPECT_EQ(kExpectedTimestamps, timestamps);
+}
+
+TEST(ParserTest, ParseOnParserThread) {
+  parser::Parser parser;
+  parser.RegisterParser(
+      std::unique_ptr<parser::ParserImpl>(new InstanceParser()));
+  EXPECT_TRUE(parser.AddTraceFile(L"abc"));
+  parser.SetQueueSize(1);
+
+  std::vector<event::Timestamp> timestamps;
+  parser.Parse([&timestamps](const event::Event& event) {
+    timestamps.push_back(event.timestamp());
+  });
+
+  const std::vector<event::Timestamp> kExpectedTimestamps = { 3, 5 };
+  EXPECT_EQ(kExpectedTimestamps, timestamps);
+}
+
+TEST(ParserTest, ParseOverlapsDecoding) {
+  parser::Parser parser;
+  std::unique_ptr<DecodingParser> impl(new DecodingParser());
+  DecodingParser* impl_ptr = impl.get();
+  parser.RegisterParser(std::move(impl));
+  EXPECT_TRUE(parser.AddTraceFile(L"dummy"));
+
+  // By default, a single parser runs on its own thread: it decodes its
+  // second event while the callback handles the first one.
+  std::vector<event::Timestamp> timestamps;
+  parser.Parse([impl_ptr, &timestamps](const event::Event& event) {
+    if (event.timestamp() == 1)
+      EXPECT_TRUE(impl_ptr->WaitForSecondEvent());
+    timestamps.push_back(event.timestamp());
+  });
+
+  const std::vector<event::Timestamp> kExpectedTimestamps = { 1, 2 };
+  EXPECT_EQ(kExpectedTimestamps, timestamps);
+}
+
 }  // namespace parser
@@ -0,0 +1,444 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_format.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+// Size of the header of a perf.data file.
+const size_t kFileHeaderSize = 104;
+
+// Offsets of the fields of the header of a perf.data file.
+const size_t kMagicOffset = 0;
+const size_t kHeaderSizeOffset = 8;
+const size_t kAttrSizeOffset = 16;
+const size_t kAttrsOffset = 24;
+const size_t kDataOffset = 40;
+
+// Offsets of the fields of a perf_event_attr.
+const size_t kAttrTypeOffset = 0;
+const size_t kAttrConfigOffset = 8;
+const size_t kAttrSampleTypeOffset = 24;
+const size_t kAttrReadFormatOffset = 32;
+const size_t kAttrFlagsOffset = 40;
+const size_t kAttrMinSize = 48;
+
+// The sample_id_all bit of the flags of a perf_event_attr.
+const uint64_t kAttrFlagSampleIdAll = 1ULL << 18;
+
+// Size of the header of a record.
+const size_t kRecordHeaderSize = 8;
+
+// Offsets of the fields of the records of the kernel.
+const size_t kMmapFilenameOffset = 32;
+const size_t kMmap2ProtOffset = 56;
+const size_t kMmap2FilenameOffset = 64;
+const size_t kCommNameOffset = 8;
+const size_t kTaskSize = 24;
+const size_t kSwitchCpuWideSize = 8;
+
+// The protection flag of executable mappings (PROT_EXEC).
+const uint32_t kProtExec = 0x4;
+
+// Reads a little-endian value which may be unaligned.
+template<typename T>
+T ReadAt(const char* data, size_t offset) {
+  T value;
+  ::memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+// Reads the content of a record, field by field.
+class RecordReader {
+ public:
+  RecordReader(const char* data, size_t size)
+      : data_(data), size_(size), offset_(0) {
+  }
+
+  template<typename T>
+  bool Read(T* value) {
+    if (size_ - offset_ < sizeof(T))
+      return false;
+    ::memcpy(value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool Skip(uint64_t size) {
+    if (size_ - offset_ < size)
+      return false;
+    offset_ += static_cast<size_t>(size);
+    return true;
+  }
+
+  const char* current() const { return data_ + offset_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_;
+};
+
+// Reads a null-terminated string, padded to 8 bytes, at the end of the fields
+// of a record.
+bool ReadString(const char* body, size_t body_size, size_t offset,
+                std::string* value) {
+  if (offset >= body_size)
+    return false;
+  const char* begin = body + offset;
+  const char* end = static_cast<const char*>(
+      ::memchr(begin, '\0', body_size - offset));
+  if (end == NULL)
+    return false;
+  value->assign(begin, end);
+  return true;
+}
+
+bool ReadSection(const char* data, size_t offset, PerfFileSection* section) {
+  section->offset = ReadAt<uint64_t>(data, offset);
+  section->size = ReadAt<uint64_t>(data, offset + sizeof(uint64_t));
+  return true;
+}
+
+bool IsInFile(const PerfFileSection& section, size_t size) {
+  return section.offset <= size && section.size <= size - section.offset;
+}
+
+// Skips the counter values of a sample (see PERF_SAMPLE_READ).
+bool SkipReadValues(uint64_t read_format, RecordReader* reader) {
+  uint64_t value_size = sizeof(uint64_t);
+  if ((read_format & kPerfFormatId) != 0)
+    value_size += sizeof(uint64_t);
+  if ((read_format & kPerfFormatLost) != 0)
+    value_size += sizeof(uint64_t);
+
+  uint64_t times_size = 0;
+  if ((read_format & kPerfFormatTotalTimeEnabled) != 0)
+    times_size += sizeof(uint64_t);
+  if ((read_format & kPerfFormatTotalTimeRunning) != 0)
+    times_size += sizeof(uint64_t);
+
+  if ((read_format & kPerfFormatGroup) == 0)
+    return reader->Skip(value_size + times_size);
+
+  uint64_t nr = 0;
+  if (!reader->Read(&nr) || !reader->Skip(times_size))
+    return false;
+  for (uint64_t i = 0; i < nr; ++i) {
+    if (!reader->Skip(value_size))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ReadPerfFileHeader(const char* data, size_t size,
+                        PerfFileHeader* header) {
+  DCHECK(data != NULL);
+  DCHECK(header != NULL);
+
+  if (size < kFileHeaderSize ||
+      ReadAt<uint64_t>(data, kMagicOffset) != kPerfFileMagic ||
+      ReadAt<uint64_t>(data, kHeaderSizeOffset) < kFileHeaderSize) {
+    return false;
+  }
+
+  header->attr_size = ReadAt<uint64_t>(data, kAttrSizeOffset);
+  ReadSection(data, kAttrsOffset, &header->attrs);
+  ReadSection(data, kDataOffset, &header->data);
+  return header->attr_size >= kAttrMinSize + sizeof(PerfFileSection) &&
+         IsInFile(header->attrs, size) &&
+         IsInFile(header->data, size);
+}
+
+bool ReadPerfEventAttrs(const char* data,
+                        size_t size,
+                        const PerfFileHeader& header,
+                        std::vector<PerfEventAttr>* attrs) {
+  DCHECK(data != NULL);
+  DCHECK(attrs != NULL);
+
+  if (header.attrs.size % header.attr_size != 0)
+    return false;
+
+  for (uint64_t offset = header.attrs.offset;
+       offset < header.attrs.offset + header.attrs.size;
+       offset += header.attr_size) {
+    const char* attr_data = data + offset;
+    PerfEventAttr attr;
+    attr.type = ReadAt<uint32_t>(attr_data, kAttrTypeOffset);
+    attr.config = ReadAt<uint64_t>(attr_data, kAttrConfigOffset);
+    attr.sample_type = ReadAt<uint64_t>(attr_data, kAttrSampleTypeOffset);
+    attr.read_format = ReadAt<uint64_t>(attr_data, kAttrReadFormatOffset);
+    attr.sample_id_all =
+        (ReadAt<uint64_t>(attr_data, kAttrFlagsOffset) &
+         kAttrFlagSampleIdAll) != 0;
+
+    // The section of the ids of the attribute follows it.
+    PerfFileSection ids;
+    ReadSection(attr_data, header.attr_size - sizeof(PerfFileSection), &ids);
+    if (!IsInFile(ids, size) || ids.size % sizeof(uint64_t) != 0)
+      return false;
+    for (uint64_t i = 0; i < ids.size; i += sizeof(uint64_t))
+      attr.ids.push_back(ReadAt<uint64_t>(data, ids.offset + i));
+
+    attrs->push_back(attr);
+  }
+  return true;
+}
+
+bool ReadPerfRecord(const char* data,
+                    size_t end,
+                    size_t* offset,
+                    PerfRecordHeader* header,
+                    const char** body,
+                    size_t* body_size) {
+  DCHECK(data != NULL);
+  DCHECK(offset != NULL);
+  DCHECK(header != NULL);
+
+  if (*offset >= end || end - *offset < kRecordHeaderSize)
+    return false;
+
+  header->type = ReadAt<uint32_t>(data, *offset);
+  header->misc = ReadAt<uint16_t>(data, *offset + 4);
+  header->size = ReadAt<uint16_t>(data, *offset + 6);
+  if (header->size < kRecordHeaderSize || header->size > end - *offset) {
+    LOG(WARNING) << "Corrupted perf record.";
+    return false;
+  }
+
+  *body = data + *offset + kRecordHeaderSize;
+  *body_size = header->size - kRecordHeaderSize;
+  *offset += header->size;
+  return true;
+}
+
+bool ReadPerfRecordIdentifier(uint32_t type,
+                              const char* body,
+                              size_t body_size,
+                              uint64_t* id) {
+  if (body_size < sizeof(uint64_t))
+    return false;
+  // The identifier is the first field of a sample and the last field of the
+  // sample id of the other records.
+  if (type == kPerfRecordSample)
+    *id = ReadAt<uint64_t>(body, 0);
+  else
+    *id = ReadAt<uint64_t>(body, body_size - sizeof(uint64_t));
+  return true;
+}
+
+bool ReadPerfSample(const char* body,
+                    size_t body_size,
+                    const PerfEventAttr& attr,
+                    PerfSample* sample) {
+  DCHECK(sample != NULL);
+  ::memset(sample, 0, sizeof(*sample));
+
+  // The fields are in the order of struct perf_event's PERF_RECORD_SAMPLE.
+  RecordReader reader(body, body_size);
+  uint64_t type = attr.sample_type;
+  uint64_t unused = 0;
+  uint32_t reserved = 0;
+  if (((type & kPerfSampleIdentifier) != 0 && !reader.Read(&sample->id)) ||
+      ((type & kPerfSampleIp) != 0 && !reader.Read(&sample->ip)) ||
+      ((type & kPerfSampleTid) != 0 &&
+       (!reader.Read(&sample->pid) || !reader.Read(&sample->tid))) ||
+      ((type & kPerfSampleTime) != 0 && !reader.Read(&sample->time)) ||
+      ((type & kPerfSampleAddr) != 0 && !reader.Read(&unused)) ||
+      ((type & kPerfSampleId) != 0 && !reader.Read(&sample->id)) ||
+      ((type & kPerfSampleStreamId) != 0 && !reader.Read(&unused)) ||
+      ((type & kPerfSampleCpu) != 0 &&
+       (!reader.Read(&sample->cpu) || !reader.Read(&reserved))) ||
+      ((type & kPerfSamplePeriod) != 0 && !reader.Read(&sample->period)) ||
+      ((type & kPerfSampleRead) != 0 &&
+       !SkipReadValues(attr.read_format, &reader))) {
+    return false;
+  }
+
+  // The fields after the callchain are not read.
+  if ((type & kPerfSampleCallchain) != 0) {
+    uint64_t nr = 0;
+    if (!reader.Read(&nr) || nr > body_size / sizeof(uint64_t))
+      return false;
+    sample->callchain = reader.current();
+    sample->callchain_size = nr;
+    if (!reader.Skip(nr * sizeof(uint64_t)))
+      return false;
+  }
+  return true;
+}
+
+bool ReadPerfSampleId(const char* body,
+                      size_t body_size,
+                      const PerfEventAttr& attr,
+                      PerfSample* sample) {
+  DCHECK(sample != NULL);
+  ::memset(sample, 0, sizeof(*sample));
+  if (!attr.sample_id_all)
+    return false;
+
+  uint64_t type = attr.sample_type;
+  size_t size = 0;
+  const uint64_t kIdFields[] = {
+    kPerfSampleTid, kPerfSampleTime, kPerfSampleId, kPerfSampleStreamId,
+    kPerfSampleCpu, kPerfSampleIdentifier };
+  for (size_t i = 0; i < sizeof(kIdFields) / sizeof(kIdFields[0]); ++i) {
+    if ((type & kIdFields[i]) != 0)
+      size += sizeof(uint64_t);
+  }
+  if (size > body_size)
+    return false;
+
+  // The sample id is at the end of the record.
+  RecordReader reader(body + body_size - size, size);
+  uint64_t unused = 0;
+  uint32_t reserved = 0;
+  return ((type & kPerfSampleTid) == 0 ||
+          (reader.Read(&sample->pid) && reader.Read(&sample->tid))) &&
+         ((type & kPerfSampleTime) == 0 || reader.Read(&sample->time)) &&
+         ((type & kPerfSampleId) == 0 || reader.Read(&sample->id)) &&
+         ((type & kPerfSampleStreamId) == 0 || reader.Read(&unused)) &&
+         ((type & kPerfSampleCpu) == 0 ||
+          (reader.Read(&sample->cpu) && reader.Read(&reserved))) &&
+         ((type & kPerfSampleIdentifier) == 0 || reader.Read(&sample->id));
+}
+
+bool ReadPerfMmap(const PerfRecordHeader& header,
+                  const char* body,
+                  size_t body_size,
+                  PerfMmap* record) {
+  DCHECK(record != NULL);
+  if (header.type != kPerfRecordMmap && header.type != kPerfRecordMmap2)
+    return false;
+
+  size_t filename_offset = kMmapFilenameOffset;
+  record->executable = (header.misc & kPerfRecordMiscMmapData) == 0;
+  if (header.type == kPerfRecordMmap2) {
+    if (body_size < kMmap2FilenameOffset)
+      return false;
+    // The device and inode fields, or the build id which may replace them,
+    // are not read.
+    filename_offset = kMmap2FilenameOffset;
+    if ((ReadAt<uint32_t>(body, kMmap2ProtOffset) & kProtExec) == 0)
+      record->executable = false;
+  }
+  if (!ReadString(body, body_size, filename_offset, &record->filename))
+    return false;
+
+  record->pid = ReadAt<uint32_t>(body, 0);
+  record->tid = ReadAt<uint32_t>(body, 4);
+  record->address = ReadAt<uint64_t>(body, 8);
+  record->length = ReadAt<uint64_t>(body, 16);
+  record->page_offset = ReadAt<uint64_t>(body, 24);
+  return true;
+}
+
+bool ReadPerfComm(const PerfRecordHeader& header,
+                  const char* body,
+                  size_t body_size,
+                  PerfComm* record) {
+  DCHECK(record != NULL);
+  if (header.type != kPerfRecordComm ||
+      !ReadString(body, body_size, kCommNameOffset, &record->comm)) {
+    return false;
+  }
+  record->pid = ReadAt<uint32_t>(body, 0);
+  record->tid = ReadAt<uint32_t>(body, 4);
+  return true;
+}
+
+bool ReadPerfTask(const PerfRecordHeader& header,
+                  const char* body,
+                  size_t body_size,
+                  PerfTask* record) {
+  DCHECK(record != NULL);
+  if ((header.type != kPerfRecordFork && header.type != kPerfRecordExit) ||
+      body_size < kTaskSize) {
+    return false;
+  }
+  record->pid = ReadAt<uint32_t>(body, 0);
+  record->ppid = ReadAt<uint32_t>(body, 4);
+  record->tid = ReadAt<uint32_t>(body, 8);
+  record->ptid = ReadAt<uint32_t>(body, 12);
+  record->time = ReadAt<uint64_t>(body, 16);
+  return true;
+}
+
+bool ReadPerfRecordThread(const PerfRecordHeader& header,
+                          const char* body,
+                          size_t body_size,
+                          uint32_t* pid,
+                          uint32_t* tid) {
+  DCHECK(pid != NULL);
+  DCHECK(tid != NULL);
+  switch (header.type) {
+    case kPerfRecordMmap:
+    case kPerfRecordMmap2:
+    case kPerfRecordComm:
+      if (body_size < 8)
+        return false;
+      *pid = ReadAt<uint32_t>(body, 0);
+      *tid = ReadAt<uint32_t>(body, 4);
+      return true;
+    case kPerfRecordFork:
+    case kPerfRecordExit:
+      if (body_size < kTaskSize)
+        return false;
+      *pid = ReadAt<uint32_t>(body, 0);
+      *tid = ReadAt<uint32_t>(body, 8);
+      return true;
+  }
+  return false;
+}
+
+bool ReadPerfSwitch(const PerfRecordHeader& header,
+                    const char* body,
+                    size_t body_size,
+                    PerfSwitch* record) {
+  DCHECK(record != NULL);
+  record->out = (header.misc & kPerfRecordMiscSwitchOut) != 0;
+  record->next_prev_pid = 0;
+  record->next_prev_tid = 0;
+  if (header.type == kPerfRecordSwitch)
+    return true;
+  if (header.type != kPerfRecordSwitchCpuWide || body_size < kSwitchCpuWideSize)
+    return false;
+  record->next_prev_pid = ReadAt<uint32_t>(body, 0);
+  record->next_prev_tid = ReadAt<uint32_t>(body, 4);
+  return true;
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -0,0 +1,302 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Portable readers for the perf.data files written by the Linux perf tool.
+//
+// A perf.data file starts with a header locating two sections:
+//   - the attributes of the recorded events (struct perf_event_attr), each
+//     followed by the section holding the ids of its event streams.
+//   - the data section: a sequence of records, each starting with a
+//     perf_event_header which gives its type and its size.
+//
+// Records are written as the per-processor ring buffers of the kernel are
+// flushed; they are not in timestamp order across processors. Samples hold
+// the fields selected by the sample_type of their attribute. When
+// sample_id_all is set, the other kernel records end with a subset of these
+// fields (the sample id), which gives their timestamp.
+
+#ifndef PARSER_PERF_PERF_DATA_FORMAT_H_
+#define PARSER_PERF_PERF_DATA_FORMAT_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace parser {
+namespace perf {
+
+// Magic number of perf.data files: "PERFILE2".
+const uint64_t kPerfFileMagic = 0x32454C4946524550ULL;
+
+// Types of records (see enum perf_event_type).
+const uint32_t kPerfRecordMmap = 1;
+const uint32_t kPerfRecordLost = 2;
+const uint32_t kPerfRecordComm = 3;
+const uint32_t kPerfRecordExit = 4;
+const uint32_t kPerfRecordFork = 7;
+const uint32_t kPerfRecordSample = 9;
+const uint32_t kPerfRecordMmap2 = 10;
+const uint32_t kPerfRecordSwitch = 14;
+const uint32_t kPerfRecordSwitchCpuWide = 15;
+
+// Records of the perf tool, which are not logged by the kernel, have types
+// from this value.
+const uint32_t kPerfRecordUserTypeStart = 64;
+
+// Flags of the misc field of a record header. Their meaning depends on the
+// type of the record.
+const uint16_t kPerfRecordMiscMmapData = 0x2000;
+const uint16_t kPerfRecordMiscCommExec = 0x2000;
+const uint16_t kPerfRecordMiscSwitchOut = 0x2000;
+
+// Fields of the samples (see enum perf_event_sample_format).
+const uint64_t kPerfSampleIp = 1ULL << 0;
+const uint64_t kPerfSampleTid = 1ULL << 1;
+const uint64_t kPerfSampleTime = 1ULL << 2;
+const uint64_t kPerfSampleAddr = 1ULL << 3;
+const uint64_t kPerfSampleRead = 1ULL << 4;
+const uint64_t kPerfSampleCallchain = 1ULL << 5;
+const uint64_t kPerfSampleId = 1ULL << 6;
+const uint64_t kPerfSampleCpu = 1ULL << 7;
+const uint64_t kPerfSamplePeriod = 1ULL << 8;
+const uint64_t kPerfSampleStreamId = 1ULL << 9;
+const uint64_t kPerfSampleIdentifier = 1ULL << 16;
+
+// Fields of the counter values in samples (see enum perf_event_read_format).
+const uint64_t kPerfFormatTotalTimeEnabled = 1ULL << 0;
+const uint64_t kPerfFormatTotalTimeRunning = 1ULL << 1;
+const uint64_t kPerfFormatId = 1ULL << 2;
+const uint64_t kPerfFormatGroup = 1ULL << 3;
+const uint64_t kPerfFormatLost = 1ULL << 4;
+
+// Callchain entries from this value mark a context (kernel, user...) instead
+// of an instruction pointer.
+const uint64_t kPerfContextMax = static_cast<uint64_t>(-4095);
+
+// A section of a perf.data file.
+struct PerfFileSection {
+  uint64_t offset;
+  uint64_t size;
+};
+
+// The fields of the header of a perf.data file used to read it.
+struct PerfFileHeader {
+  // The size of an entry of the attributes section.
+  uint64_t attr_size;
+  PerfFileSection attrs;
+  PerfFileSection data;
+};
+
+// The fields of a perf_event_attr used to read the records.
+struct PerfEventAttr {
+  uint32_t type;
+  uint64_t config;
+  // The kPerfSample* fields of the samples.
+  uint64_t sample_type;
+  // The kPerfFormat* fields of the counter values in samples.
+  uint64_t read_format;
+  // Indicates whether the records other than samples end with a sample id.
+  bool sample_id_all;
+  // The ids of the event streams of this attribute.
+  std::vector<uint64_t> ids;
+};
+
+// The header of a record.
+struct PerfRecordHeader {
+  uint32_t type;
+  uint16_t misc;
+  uint16_t size;
+};
+
+// The fields of a sample, or of the sample id of another record. Only the
+// fields selected by the sample type are set; the others are 0.
+struct PerfSample {
+  uint64_t ip;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t time;
+  uint64_t id;
+  uint32_t cpu;
+  uint64_t period;
+  // The instruction pointers of the callchain of a sample, including context
+  // markers (see kPerfContextMax). The entries may be unaligned.
+  const char* callchain;
+  uint64_t callchain_size;
+};
+
+// The fields of a mmap or mmap2 record.
+struct PerfMmap {
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t address;
+  uint64_t length;
+  uint64_t page_offset;
+  // Indicates whether the mapping is executable. Data mappings are only
+  // recorded with "perf record -d".
+  bool executable;
+  std::string filename;
+};
+
+// The fields of a comm record.
+struct PerfComm {
+  uint32_t pid;
+  uint32_t tid;
+  std::string comm;
+};
+
+// The fields of a fork or exit record.
+struct PerfTask {
+  uint32_t pid;
+  uint32_t ppid;
+  uint32_t tid;
+  uint32_t ptid;
+  uint64_t time;
+};
+
+// The fields of a switch or switch_cpu_wide record.
+struct PerfSwitch {
+  // Indicates whether the thread is switched out, rather than in.
+  bool out;
+  // The thread switched in or out in its place. Only set for
+  // switch_cpu_wide records.
+  uint32_t next_prev_pid;
+  uint32_t next_prev_tid;
+};
+
+// Reads the header of a perf.data file.
+// @param data the content of the file.
+// @param size the size of the file.
+// @param header receives the header.
+// @returns true if the header is valid and its sections are in the file,
+//     false otherwise.
+bool ReadPerfFileHeader(const char* data, size_t size, PerfFileHeader* header);
+
+// Reads the attributes of the events of a perf.data file.
+// @param data the content of the file.
+// @param size the size of the file.
+// @param header the header of the file.
+// @param attrs receives the attributes.
+// @returns true if the attributes are valid, false otherwise.
+bool ReadPerfEventAttrs(const char* data,
+                        size_t size,
+                        const PerfFileHeader& header,
+                        std::vector<PerfEventAttr>* attrs);
+
+// Reads a record of the data section.
+// @param data the content of the file.
+// @param end the offset of the end of the data section.
+// @param offset the offset of the record to read. Receives the offset of the
+//     next record.
+// @param header receives the header of the record.
+// @param body receives the content of the record, after its header.
+// @param body_size receives the size of the content of the record.
+// @returns true if a record is read, false at the end of the data section or
+//     when the record is corrupted.
+bool ReadPerfRecord(const char* data,
+                    size_t end,
+                    size_t* offset,
+                    PerfRecordHeader* header,
+                    const char** body,
+                    size_t* body_size);
+
+// Reads the id of the attribute of a record, when the samples have the
+// kPerfSampleIdentifier field.
+// @param type the type of the record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param id receives the id of the event stream of the record.
+// @returns true if the id is read, false otherwise.
+bool ReadPerfRecordIdentifier(uint32_t type,
+                              const char* body,
+                              size_t body_size,
+                              uint64_t* id);
+
+// Reads the fields of a sample record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param attr the attribute of the record.
+// @param sample receives the fields of the sample.
+// @returns true if the sample is valid, false otherwise.
+bool ReadPerfSample(const char* body,
+                    size_t body_size,
+                    const PerfEventAttr& attr,
+                    PerfSample* sample);
+
+// Reads the sample id at the end of a record other than a sample.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param attr the attribute of the record.
+// @param sample receives the fields of the sample id.
+// @returns true if the record has a valid sample id, false otherwise.
+bool ReadPerfSampleId(const char* body,
+                      size_t body_size,
+                      const PerfEventAttr& attr,
+                      PerfSample* sample);
+
+// Reads the fields of the records of the kernel. The sample id at the end of
+// the record, if any, is ignored.
+// @param header the header of the record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param record receives the fields of the record.
+// @returns true if the record is valid, false otherwise.
+// @{
+bool ReadPerfMmap(const PerfRecordHeader& header,
+                  const char* body,
+                  size_t body_size,
+                  PerfMmap* record);
+bool ReadPerfComm(const PerfRecordHeader& header,
+                  const char* body,
+                  size_t body_size,
+                  PerfComm* record);
+bool ReadPerfTask(const PerfRecordHeader& header,
+                  const char* body,
+                  size_t body_size,
+                  PerfTask* record);
+bool ReadPerfSwitch(const PerfRecordHeader& header,
+                    const char* body,
+                    size_t body_size,
+                    PerfSwitch* record);
+// @}
+
+// Reads the process and the thread of a mmap, mmap2, comm, fork or exit
+// record, without reading its other fields.
+// @param header the header of the record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param pid receives the process of the record.
+// @param tid receives the thread of the record.
+// @returns true if the record has a process and a thread, false otherwise.
+bool ReadPerfRecordThread(const PerfRecordHeader& header,
+                          const char* body,
+                          size_t body_size,
+                          uint32_t* pid,
+                          uint32_t* tid);
+
+}  // namespace perf
+}  // namespace parser
+
+#endif  // PARSER_PERF_PERF_DATA_FORMAT_H_
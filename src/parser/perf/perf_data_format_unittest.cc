@@ -0,0 +1,466 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_format.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+// Writes the content of a perf.data file, or of a record.
+class DataWriter {
+ public:
+  template<typename T>
+  void Append(T value) {
+    size_t offset = data_.size();
+    data_.resize(offset + sizeof(value));
+    memcpy(&data_[offset], &value, sizeof(value));
+  }
+
+  template<typename T>
+  void Write(size_t offset, T value) {
+    if (data_.size() < offset + sizeof(value))
+      data_.resize(offset + sizeof(value));
+    memcpy(&data_[offset], &value, sizeof(value));
+  }
+
+  // Appends a null-terminated string, padded to 8 bytes.
+  void AppendString(const std::string& value) {
+    data_.insert(data_.end(), value.begin(), value.end());
+    data_.push_back(0);
+    while (data_.size() % 8 != 0)
+      data_.push_back(0);
+  }
+
+  const char* data() const { return &data_[0]; }
+  size_t size() const { return data_.size(); }
+
+ private:
+  std::vector<char> data_;
+};
+
+const size_t kAttrStructSize = 64;
+const size_t kAttrSize = kAttrStructSize + sizeof(PerfFileSection);
+const uint64_t kSampleIdAllFlag = 1ULL << 18;
+
+// Writes a perf.data file with two attributes, each with one id, and a data
+// section of |data_size| bytes.
+void WriteFile(size_t data_size, DataWriter* writer) {
+  const size_t kAttrsOffset = 104;
+  const size_t kIdsOffset = kAttrsOffset + 2 * kAttrSize;
+  const size_t kDataOffset = kIdsOffset + 2 * sizeof(uint64_t);
+
+  writer->Append<uint64_t>(kPerfFileMagic);
+  writer->Append<uint64_t>(104);
+  writer->Append<uint64_t>(kAttrSize);
+  writer->Append<uint64_t>(kAttrsOffset);
+  writer->Append<uint64_t>(2 * kAttrSize);
+  writer->Append<uint64_t>(kDataOffset);
+  writer->Append<uint64_t>(data_size);
+
+  for (size_t i = 0; i < 2; ++i) {
+    size_t attr = kAttrsOffset + i * kAttrSize;
+    writer->Write<uint32_t>(attr, 1);
+    writer->Write<uint64_t>(attr + 8, i);
+    writer->Write<uint64_t>(attr + 24,
+                            kPerfSampleIdentifier | kPerfSampleTime);
+    writer->Write<uint64_t>(attr + 32, kPerfFormatId);
+    writer->Write<uint64_t>(attr + 40, i == 0 ? kSampleIdAllFlag : 0);
+    writer->Write<uint64_t>(attr + kAttrStructSize,
+                            kIdsOffset + i * sizeof(uint64_t));
+    writer->Write<uint64_t>(attr + kAttrStructSize + 8, sizeof(uint64_t));
+    writer->Write<uint64_t>(kIdsOffset + i * sizeof(uint64_t), 100 + i);
+  }
+  writer->Write<char>(kDataOffset + data_size - 1, 0);
+}
+
+}  // namespace
+
+TEST(PerfDataFormatTest, ReadFileHeader) {
+  DataWriter writer;
+  WriteFile(16, &writer);
+
+  PerfFileHeader header;
+  ASSERT_TRUE(ReadPerfFileHeader(writer.data(), writer.size(), &header));
+  EXPECT_EQ(kAttrSize, header.attr_size);
+  EXPECT_EQ(104U, header.attrs.offset);
+  EXPECT_EQ(2 * kAttrSize, header.attrs.size);
+  EXPECT_EQ(writer.size() - 16, header.data.offset);
+  EXPECT_EQ(16U, header.data.size);
+
+  // The file is truncated.
+  EXPECT_FALSE(ReadPerfFileHeader(writer.data(), writer.size() - 1,
+                                  &header));
+  EXPECT_FALSE(ReadPerfFileHeader(writer.data(), 100, &header));
+
+  // The magic number is invalid.
+  writer.Write<uint64_t>(0, 0x1234);
+  EXPECT_FALSE(ReadPerfFileHeader(writer.data(), writer.size(), &header));
+}
+
+TEST(PerfDataFormatTest, ReadEventAttrs) {
+  DataWriter writer;
+  WriteFile(16, &writer);
+
+  PerfFileHeader header;
+  ASSERT_TRUE(ReadPerfFileHeader(writer.data(), writer.size(), &header));
+  std::vector<PerfEventAttr> attrs;
+  ASSERT_TRUE(ReadPerfEventAttrs(writer.data(), writer.size(), header,
+                                 &attrs));
+  ASSERT_EQ(2U, attrs.size());
+
+  EXPECT_EQ(1U, attrs[0].type);
+  EXPECT_EQ(0U, attrs[0].config);
+  EXPECT_EQ(kPerfSampleIdentifier | kPerfSampleTime, attrs[0].sample_type);
+  EXPECT_EQ(kPerfFormatId, attrs[0].read_format);
+  EXPECT_TRUE(attrs[0].sample_id_all);
+  ASSERT_EQ(1U, attrs[0].ids.size());
+  EXPECT_EQ(100U, attrs[0].ids[0]);
+
+  EXPECT_EQ(1U, attrs[1].config);
+  EXPECT_FALSE(attrs[1].sample_id_all);
+  ASSERT_EQ(1U, attrs[1].ids.size());
+  EXPECT_EQ(101U, attrs[1].ids[0]);
+
+  // The ids of an attribute are outside the file.
+  writer.Write<uint64_t>(104 + kAttrStructSize, writer.size());
+  attrs.clear();
+  EXPECT_FALSE(ReadPerfEventAttrs(writer.data(), writer.size(), header,
+                                  &attrs));
+}
+
+TEST(PerfDataFormatTest, ReadRecord) {
+  DataWriter writer;
+  writer.Append<uint32_t>(kPerfRecordComm);
+  writer.Append<uint16_t>(0);
+  writer.Append<uint16_t>(16);
+  writer.Append<uint64_t>(42);
+  writer.Append<uint32_t>(kPerfRecordLost);
+  writer.Append<uint16_t>(kPerfRecordMiscMmapData);
+  writer.Append<uint16_t>(8);
+
+  size_t offset = 0;
+  PerfRecordHeader header;
+  const char* body = NULL;
+  size_t body_size = 0;
+  ASSERT_TRUE(ReadPerfRecord(writer.data(), writer.size(), &offset, &header,
+                             &body, &body_size));
+  EXPECT_EQ(kPerfRecordComm, header.type);
+  EXPECT_EQ(0U, header.misc);
+  EXPECT_EQ(16U, header.size);
+  EXPECT_EQ(writer.data() + 8, body);
+  EXPECT_EQ(8U, body_size);
+  EXPECT_EQ(16U, offset);
+
+  ASSERT_TRUE(ReadPerfRecord(writer.data(), writer.size(), &offset, &header,
+                             &body, &body_size));
+  EXPECT_EQ(kPerfRecordLost, header.type);
+  EXPECT_EQ(kPerfRecordMiscMmapData, header.misc);
+  EXPECT_EQ(0U, body_size);
+  EXPECT_EQ(24U, offset);
+
+  EXPECT_FALSE(ReadPerfRecord(writer.data(), writer.size(), &offset, &header,
+                              &body, &body_size));
+
+  // The first record does not fit in the data section.
+  offset = 0;
+  EXPECT_FALSE(ReadPerfRecord(writer.data(), 12, &offset, &header, &body,
+                              &body_size));
+
+  // A record is smaller than its header.
+  writer.Write<uint16_t>(6, 4);
+  EXPECT_FALSE(ReadPerfRecord(writer.data(), writer.size(), &offset,
+                              &header, &body, &body_size));
+}
+
+TEST(PerfDataFormatTest, ReadRecordIdentifier) {
+  DataWriter writer;
+  writer.Append<uint64_t>(1);
+  writer.Append<uint64_t>(2);
+  writer.Append<uint64_t>(3);
+
+  uint64_t id = 0;
+  ASSERT_TRUE(ReadPerfRecordIdentifier(kPerfRecordSample, writer.data(),
+                                       writer.size(), &id));
+  EXPECT_EQ(1U, id);
+  ASSERT_TRUE(ReadPerfRecordIdentifier(kPerfRecordMmap, writer.data(),
+                                       writer.size(), &id));
+  EXPECT_EQ(3U, id);
+  EXPECT_FALSE(ReadPerfRecordIdentifier(kPerfRecordMmap, writer.data(), 4,
+                                        &id));
+}
+
+TEST(PerfDataFormatTest, ReadSample) {
+  PerfEventAttr attr;
+  attr.sample_type = kPerfSampleIdentifier | kPerfSampleIp | kPerfSampleTid |
+                     kPerfSampleTime | kPerfSampleAddr | kPerfSampleCpu |
+                     kPerfSamplePeriod | kPerfSampleRead |
+                     kPerfSampleCallchain;
+  attr.read_format = kPerfFormatGroup | kPerfFormatId |
+                     kPerfFormatTotalTimeEnabled;
+  attr.sample_id_all = true;
+
+  DataWriter writer;
+  writer.Append<uint64_t>(7);  // Identifier.
+  writer.Append<uint64_t>(0x401000);  // Ip.
+  writer.Append<uint32_t>(10);  // Pid.
+  writer.Append<uint32_t>(11);  // Tid.
+  writer.Append<uint64_t>(5000);  // Time.
+  writer.Append<uint64_t>(0x1234);  // Addr.
+  writer.Append<uint32_t>(3);  // Cpu.
+  writer.Append<uint32_t>(0);
+  writer.Append<uint64_t>(100);  // Period.
+  writer.Append<uint64_t>(2);  // Read: 2 values with their id.
+  writer.Append<uint64_t>(999);
+  writer.Append<uint64_t>(1);
+  writer.Append<uint64_t>(7);
+  writer.Append<uint64_t>(2);
+  writer.Append<uint64_t>(8);
+  writer.Append<uint64_t>(2);  // Callchain.
+  writer.Append<uint64_t>(kPerfContextMax);
+  writer.Append<uint64_t>(0x401000);
+
+  PerfSample sample;
+  ASSERT_TRUE(ReadPerfSample(writer.data(), writer.size(), attr, &sample));
+  EXPECT_EQ(7U, sample.id);
+  EXPECT_EQ(0x401000U, sample.ip);
+  EXPECT_EQ(10U, sample.pid);
+  EXPECT_EQ(11U, sample.tid);
+  EXPECT_EQ(5000U, sample.time);
+  EXPECT_EQ(3U, sample.cpu);
+  EXPECT_EQ(100U, sample.period);
+  ASSERT_EQ(2U, sample.callchain_size);
+  EXPECT_EQ(writer.data() + writer.size() - 16, sample.callchain);
+
+  // The callchain is truncated.
+  EXPECT_FALSE(ReadPerfSample(writer.data(), writer.size() - 8, attr,
+                              &sample));
+
+  // Only the selected fields are read.
+  attr.sample_type = kPerfSampleTid | kPerfSampleTime;
+  ASSERT_TRUE(ReadPerfSample(writer.data() + 16, 16, attr, &sample));
+  EXPECT_EQ(10U, sample.pid);
+  EXPECT_EQ(11U, sample.tid);
+  EXPECT_EQ(5000U, sample.time);
+  EXPECT_EQ(0U, sample.ip);
+  EXPECT_EQ(0U, sample.callchain_size);
+}
+
+TEST(PerfDataFormatTest, ReadSampleId) {
+  PerfEventAttr attr;
+  attr.sample_type = kPerfSampleIp | kPerfSampleTid | kPerfSampleTime |
+                     kPerfSampleCpu | kPerfSampleIdentifier;
+  attr.read_format = 0;
+  attr.sample_id_all = true;
+
+  DataWriter writer;
+  writer.Append<uint64_t>(0xFFFF);  // Fields of the record.
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(11);
+  writer.Append<uint64_t>(5000);
+  writer.Append<uint32_t>(3);
+  writer.Append<uint32_t>(0);
+  writer.Append<uint64_t>(7);
+
+  PerfSample sample;
+  ASSERT_TRUE(ReadPerfSampleId(writer.data(), writer.size(), attr, &sample));
+  EXPECT_EQ(10U, sample.pid);
+  EXPECT_EQ(11U, sample.tid);
+  EXPECT_EQ(5000U, sample.time);
+  EXPECT_EQ(3U, sample.cpu);
+  EXPECT_EQ(7U, sample.id);
+  EXPECT_EQ(0U, sample.ip);
+
+  EXPECT_FALSE(ReadPerfSampleId(writer.data(), 16, attr, &sample));
+  attr.sample_id_all = false;
+  EXPECT_FALSE(ReadPerfSampleId(writer.data(), writer.size(), attr,
+                                &sample));
+}
+
+TEST(PerfDataFormatTest, ReadMmap) {
+  DataWriter writer;
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(11);
+  writer.Append<uint64_t>(0x400000);
+  writer.Append<uint64_t>(0x1000);
+  writer.Append<uint64_t>(0x200);
+  writer.AppendString("/usr/bin/app");
+
+  PerfRecordHeader header = { kPerfRecordMmap, 0, 0 };
+  PerfMmap mmap;
+  ASSERT_TRUE(ReadPerfMmap(header, writer.data(), writer.size(), &mmap));
+  EXPECT_EQ(10U, mmap.pid);
+  EXPECT_EQ(11U, mmap.tid);
+  EXPECT_EQ(0x400000U, mmap.address);
+  EXPECT_EQ(0x1000U, mmap.length);
+  EXPECT_EQ(0x200U, mmap.page_offset);
+  EXPECT_TRUE(mmap.executable);
+  EXPECT_EQ("/usr/bin/app", mmap.filename);
+
+  header.misc = kPerfRecordMiscMmapData;
+  ASSERT_TRUE(ReadPerfMmap(header, writer.data(), writer.size(), &mmap));
+  EXPECT_FALSE(mmap.executable);
+
+  // The filename is not terminated.
+  EXPECT_FALSE(ReadPerfMmap(header, writer.data(), 40, &mmap));
+
+  header.type = kPerfRecordComm;
+  EXPECT_FALSE(ReadPerfMmap(header, writer.data(), writer.size(), &mmap));
+}
+
+TEST(PerfDataFormatTest, ReadMmap2) {
+  DataWriter writer;
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(11);
+  writer.Append<uint64_t>(0x400000);
+  writer.Append<uint64_t>(0x1000);
+  writer.Append<uint64_t>(0);
+  writer.Append<uint32_t>(8);  // Device.
+  writer.Append<uint32_t>(1);
+  writer.Append<uint64_t>(1234);  // Inode.
+  writer.Append<uint64_t>(0);
+  writer.Append<uint32_t>(5);  // PROT_READ | PROT_EXEC.
+  writer.Append<uint32_t>(2);
+  writer.AppendString("libc.so");
+
+  PerfRecordHeader header = { kPerfRecordMmap2, 0, 0 };
+  PerfMmap mmap;
+  ASSERT_TRUE(ReadPerfMmap(header, writer.data(), writer.size(), &mmap));
+  EXPECT_EQ(10U, mmap.pid);
+  EXPECT_EQ(0x400000U, mmap.address);
+  EXPECT_TRUE(mmap.executable);
+  EXPECT_EQ("libc.so", mmap.filename);
+
+  // The mapping is not executable.
+  writer.Write<uint32_t>(56, 1);
+  ASSERT_TRUE(ReadPerfMmap(header, writer.data(), writer.size(), &mmap));
+  EXPECT_FALSE(mmap.executable);
+
+  EXPECT_FALSE(ReadPerfMmap(header, writer.data(), 60, &mmap));
+}
+
+TEST(PerfDataFormatTest, ReadComm) {
+  DataWriter writer;
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(11);
+  writer.AppendString("worker");
+
+  PerfRecordHeader header = { kPerfRecordComm, 0, 0 };
+  PerfComm comm;
+  ASSERT_TRUE(ReadPerfComm(header, writer.data(), writer.size(), &comm));
+  EXPECT_EQ(10U, comm.pid);
+  EXPECT_EQ(11U, comm.tid);
+  EXPECT_EQ("worker", comm.comm);
+
+  EXPECT_FALSE(ReadPerfComm(header, writer.data(), 8, &comm));
+}
+
+TEST(PerfDataFormatTest, ReadTask) {
+  DataWriter writer;
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(1);
+  writer.Append<uint32_t>(11);
+  writer.Append<uint32_t>(10);
+  writer.Append<uint64_t>(5000);
+
+  PerfRecordHeader header = { kPerfRecordFork, 0, 0 };
+  PerfTask task;
+  ASSERT_TRUE(ReadPerfTask(header, writer.data(), writer.size(), &task));
+  EXPECT_EQ(10U, task.pid);
+  EXPECT_EQ(1U, task.ppid);
+  EXPECT_EQ(11U, task.tid);
+  EXPECT_EQ(10U, task.ptid);
+  EXPECT_EQ(5000U, task.time);
+
+  header.type = kPerfRecordExit;
+  EXPECT_TRUE(ReadPerfTask(header, writer.data(), writer.size(), &task));
+  EXPECT_FALSE(ReadPerfTask(header, writer.data(), 16, &task));
+}
+
+TEST(PerfDataFormatTest, ReadRecordThread) {
+  DataWriter writer;
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(1);
+  writer.Append<uint32_t>(11);
+  writer.Append<uint32_t>(10);
+  writer.Append<uint64_t>(5000);
+
+  // Fork and exit records have the parent between the process and the
+  // thread.
+  PerfRecordHeader header = { kPerfRecordFork, 0, 0 };
+  uint32_t pid = 0;
+  uint32_t tid = 0;
+  ASSERT_TRUE(ReadPerfRecordThread(header, writer.data(), writer.size(),
+                                   &pid, &tid));
+  EXPECT_EQ(10U, pid);
+  EXPECT_EQ(11U, tid);
+  EXPECT_FALSE(ReadPerfRecordThread(header, writer.data(), 16, &pid, &tid));
+
+  // The other records start with the process and the thread.
+  header.type = kPerfRecordComm;
+  ASSERT_TRUE(ReadPerfRecordThread(header, writer.data(), writer.size(),
+                                   &pid, &tid));
+  EXPECT_EQ(10U, pid);
+  EXPECT_EQ(1U, tid);
+  header.type = kPerfRecordMmap2;
+  EXPECT_TRUE(ReadPerfRecordThread(header, writer.data(), 8, &pid, &tid));
+  EXPECT_FALSE(ReadPerfRecordThread(header, writer.data(), 4, &pid, &tid));
+
+  header.type = kPerfRecordSample;
+  EXPECT_FALSE(ReadPerfRecordThread(header, writer.data(), writer.size(),
+                                    &pid, &tid));
+}
+
+TEST(PerfDataFormatTest, ReadSwitch) {
+  DataWriter writer;
+  writer.Append<uint32_t>(10);
+  writer.Append<uint32_t>(11);
+
+  PerfRecordHeader header = { kPerfRecordSwitchCpuWide, 0, 0 };
+  PerfSwitch context_switch;
+  ASSERT_TRUE(ReadPerfSwitch(header, writer.data(), writer.size(),
+                             &context_switch));
+  EXPECT_FALSE(context_switch.out);
+  EXPECT_EQ(10U, context_switch.next_prev_pid);
+  EXPECT_EQ(11U, context_switch.next_prev_tid);
+  EXPECT_FALSE(ReadPerfSwitch(header, writer.data(), 4, &context_switch));
+
+  // Switch records have no field.
+  header.type = kPerfRecordSwitch;
+  header.misc = kPerfRecordMiscSwitchOut;
+  ASSERT_TRUE(ReadPerfSwitch(header, writer.data(), 0, &context_switch));
+  EXPECT_TRUE(context_switch.out);
+  EXPECT_EQ(0U, context_switch.next_prev_tid);
+}
+
+}  // namespace perf
+}  // namespace parser
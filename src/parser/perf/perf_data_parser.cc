@@ -0,0 +1,512 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+#include "base/string_utils.h"
+#include "event/event.h"
+#include "event/packed_array_value.h"
+#include "event/value.h"
+#include "parser/perf/perf_data_format.h"
+
+namespace parser {
+namespace perf {
+
+// {D0F9A644-6DCF-4098-BE97-36E17AB56F28}
+const base::Guid kPerfProviderId = { 0xD0F9A644, 0x6DCF, 0x4098,
+    { 0xBE, 0x97, 0x36, 0xE1, 0x7A, 0xB5, 0x6F, 0x28 } };
+
+namespace {
+
+using event::Atom;
+using event::Event;
+using event::EventType;
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::UShortValue;
+using event::Value;
+using event::WStringValue;
+
+// The types of the events, named as the equivalent ETW kernel events.
+const EventType kSampleProfType = EventType::Register(
+    Atom::Intern("PerfInfo"), Atom::Intern("SampleProf"));
+const EventType kStackType = EventType::Register(
+    Atom::Intern("StackWalk"), Atom::Intern("Stack"));
+const EventType kImageLoadType = EventType::Register(
+    Atom::Intern("Image"), Atom::Intern("Load"));
+const EventType kThreadSetNameType = EventType::Register(
+    Atom::Intern("Thread"), Atom::Intern("SetName"));
+const EventType kThreadStartType = EventType::Register(
+    Atom::Intern("Thread"), Atom::Intern("Start"));
+const EventType kThreadEndType = EventType::Register(
+    Atom::Intern("Thread"), Atom::Intern("End"));
+const EventType kThreadCSwitchType = EventType::Register(
+    Atom::Intern("Thread"), Atom::Intern("CSwitch"));
+const EventType kProcessStartType = EventType::Register(
+    Atom::Intern("Process"), Atom::Intern("Start"));
+const EventType kProcessEndType = EventType::Register(
+    Atom::Intern("Process"), Atom::Intern("End"));
+
+// The fields of the payloads.
+const Atom kBaseAddressField = Atom::Intern("BaseAddress");
+const Atom kCountField = Atom::Intern("Count");
+const Atom kEventTimeStampField = Atom::Intern("EventTimeStamp");
+const Atom kImageCheckSumField = Atom::Intern("ImageCheckSum");
+const Atom kImageFileNameField = Atom::Intern("ImageFileName");
+const Atom kInstructionPointerField = Atom::Intern("InstructionPointer");
+const Atom kModuleSizeField = Atom::Intern("ModuleSize");
+const Atom kNewThreadIdField = Atom::Intern("NewThreadId");
+const Atom kOldThreadIdField = Atom::Intern("OldThreadId");
+const Atom kParentIdField = Atom::Intern("ParentId");
+const Atom kPeriodField = Atom::Intern("Period");
+const Atom kProcessIdField = Atom::Intern("ProcessId");
+const Atom kStackField = Atom::Intern("Stack");
+const Atom kStackProcessField = Atom::Intern("StackProcess");
+const Atom kStackThreadField = Atom::Intern("StackThread");
+const Atom kThreadIdField = Atom::Intern("ThreadId");
+const Atom kThreadNameField = Atom::Intern("ThreadName");
+const Atom kTimeDateStampField = Atom::Intern("TimeDateStamp");
+const Atom kTThreadIdField = Atom::Intern("TThreadId");
+
+// The number of fields of the payloads of the records, at most (Image Load),
+// and of the stack events. They are reserved when a payload is created.
+const size_t kMaxRecordFields = 6;
+const size_t kStackFields = 4;
+
+// A record of the data section, with its timestamp.
+struct RecordLocation {
+  uint64_t time;
+  size_t offset;
+
+  bool operator<(const RecordLocation& other) const {
+    return time < other.time;
+  }
+};
+
+// Finds the attribute of the records.
+class AttrTable {
+ public:
+  AttrTable() : attrs_(NULL), use_identifier_(false) {
+  }
+
+  // @param attrs the attributes of the trace. Must outlive the table.
+  // @returns true if the attribute of each record can be found, false
+  //     otherwise.
+  bool Init(const std::vector<PerfEventAttr>* attrs) {
+    attrs_ = attrs;
+    if (attrs->empty())
+      return false;
+
+    // When all the attributes have the same layout, any of them can be used.
+    const PerfEventAttr& first = attrs->front();
+    bool same_layout = true;
+    bool have_identifier = true;
+    for (size_t i = 0; i < attrs->size(); ++i) {
+      const PerfEventAttr& attr = (*attrs)[i];
+      if (attr.sample_id_all != first.sample_id_all)
+        return false;
+      if (attr.sample_type != first.sample_type ||
+          attr.read_format != first.read_format) {
+        same_layout = false;
+      }
+      if ((attr.sample_type & kPerfSampleIdentifier) == 0)
+        have_identifier = false;
+    }
+    if (same_layout)
+      return true;
+    if (!have_identifier)
+      return false;
+
+    // Otherwise, the records give the id of their event stream.
+    use_identifier_ = true;
+    for (size_t i = 0; i < attrs->size(); ++i) {
+      std::vector<uint64_t>::const_iterator id = (*attrs)[i].ids.begin();
+      for (; id != (*attrs)[i].ids.end(); ++id)
+        attr_by_id_[*id] = i;
+    }
+    return true;
+  }
+
+  // @param header the header of a record.
+  // @param body the content of the record.
+  // @param body_size the size of the content of the record.
+  // @returns the attribute of the record, or NULL if it is unknown.
+  const PerfEventAttr* Find(const PerfRecordHeader& header,
+                            const char* body,
+                            size_t body_size) const {
+    if (!use_identifier_)
+      return &attrs_->front();
+    // The records other than samples have no id without sample_id_all; their
+    // fields do not depend on their attribute.
+    if (header.type != kPerfRecordSample && !attrs_->front().sample_id_all)
+      return &attrs_->front();
+
+    uint64_t id = 0;
+    if (!ReadPerfRecordIdentifier(header.type, body, body_size, &id))
+      return NULL;
+    std::map<uint64_t, size_t>::const_iterator look = attr_by_id_.find(id);
+    if (look == attr_by_id_.end())
+      return NULL;
+    return &(*attrs_)[look->second];
+  }
+
+ private:
+  const std::vector<PerfEventAttr>* attrs_;
+
+  // Indicates whether the attributes are found by the id of the records.
+  bool use_identifier_;
+  std::map<uint64_t, size_t> attr_by_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(AttrTable);
+};
+
+// Reads the sample, or the sample id, of a record.
+// @param header the header of the record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param attr the attribute of the record.
+// @param sample receives the fields of the sample. They are 0 when the record
+//     has no sample id.
+// @returns false if the record is a corrupted sample, true otherwise.
+bool ReadRecordSample(const PerfRecordHeader& header,
+                      const char* body,
+                      size_t body_size,
+                      const PerfEventAttr& attr,
+                      PerfSample* sample) {
+  if (header.type == kPerfRecordSample)
+    return ReadPerfSample(body, body_size, attr, sample);
+  ReadPerfSampleId(body, body_size, attr, sample);
+  return true;
+}
+
+// Reads the timestamp of a record.
+// @param header the header of the record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param attr the attribute of the record.
+// @param time receives the timestamp of the record.
+// @returns true if the record has a timestamp, false otherwise.
+bool ReadRecordTime(const PerfRecordHeader& header,
+                    const char* body,
+                    size_t body_size,
+                    const PerfEventAttr& attr,
+                    uint64_t* time) {
+  PerfSample sample;
+  if ((attr.sample_type & kPerfSampleTime) != 0 &&
+      (header.type == kPerfRecordSample || attr.sample_id_all)) {
+    if (!ReadRecordSample(header, body, body_size, attr, &sample))
+      return false;
+    *time = sample.time;
+    return true;
+  }
+
+  // Fork and exit records have their own timestamp.
+  PerfTask task;
+  if (ReadPerfTask(header, body, body_size, &task)) {
+    *time = task.time;
+    return true;
+  }
+  return false;
+}
+
+// Converts a record of the kernel into an event.
+// @param header the header of the record.
+// @param body the content of the record.
+// @param body_size the size of the content of the record.
+// @param attr the attribute of the record.
+// @param sample the sample, or the sample id, of the record.
+// @param arena the arena holding the payload.
+// @param event_header receives the header of the event.
+// @param payload receives the payload of the event.
+// @returns true if the record is converted, false if it must be skipped.
+bool ConvertRecord(const PerfRecordHeader& header,
+                   const char* body,
+                   size_t body_size,
+                   const PerfEventAttr& attr,
+                   const PerfSample& sample,
+                   event::ValueArena* arena,
+                   event::EventHeader* event_header,
+                   const Value** payload) {
+  event_header->process_id = sample.pid;
+  event_header->thread_id = sample.tid;
+  event_header->processor_number = static_cast<uint8_t>(sample.cpu);
+  event_header->flags = header.misc;
+
+  StructValue* fields = arena->New<StructValue>(arena);
+  fields->Reserve(kMaxRecordFields);
+  *payload = fields;
+
+  switch (header.type) {
+    case kPerfRecordSample: {
+      event_header->type = kSampleProfType;
+      fields->AddField<ULongValue>(kInstructionPointerField, sample.ip);
+      fields->AddField<UIntValue>(kThreadIdField, sample.tid);
+      fields->AddField<UShortValue>(kCountField, 1);
+      if ((attr.sample_type & kPerfSamplePeriod) != 0)
+        fields->AddField<ULongValue>(kPeriodField, sample.period);
+      return true;
+    }
+
+    case kPerfRecordMmap:
+    case kPerfRecordMmap2: {
+      PerfMmap mmap;
+      if (!ReadPerfMmap(header, body, body_size, &mmap) || !mmap.executable)
+        return false;
+      event_header->type = kImageLoadType;
+      event_header->process_id = mmap.pid;
+      event_header->thread_id = mmap.tid;
+      fields->AddField<ULongValue>(kBaseAddressField, mmap.address);
+      fields->AddField<ULongValue>(kModuleSizeField, mmap.length);
+      fields->AddField<UIntValue>(kProcessIdField, mmap.pid);
+      fields->AddField<UIntValue>(kImageCheckSumField, 0);
+      fields->AddField<UIntValue>(kTimeDateStampField, 0);
+      fields->AddField<WStringValue>(
+          kImageFileNameField, base::StringToWString(mmap.filename));
+      return true;
+    }
+
+    case kPerfRecordComm: {
+      PerfComm comm;
+      if (!ReadPerfComm(header, body, body_size, &comm))
+        return false;
+      event_header->type = kThreadSetNameType;
+      event_header->process_id = comm.pid;
+      event_header->thread_id = comm.tid;
+      fields->AddField<UIntValue>(kProcessIdField, comm.pid);
+      fields->AddField<UIntValue>(kThreadIdField, comm.tid);
+      fields->AddField<WStringValue>(
+          kThreadNameField, base::StringToWString(comm.comm));
+      return true;
+    }
+
+    case kPerfRecordFork:
+    case kPerfRecordExit: {
+      PerfTask task;
+      if (!ReadPerfTask(header, body, body_size, &task))
+        return false;
+      event_header->process_id = task.pid;
+      event_header->thread_id = task.tid;
+      fields->AddField<UIntValue>(kProcessIdField, task.pid);
+      // The main thread of a process has the id of the process.
+      if (task.pid == task.tid) {
+        event_header->type = header.type == kPerfRecordFork ?
+            kProcessStartType : kProcessEndType;
+        fields->AddField<UIntValue>(kParentIdField, task.ppid);
+      } else {
+        event_header->type = header.type == kPerfRecordFork ?
+            kThreadStartType : kThreadEndType;
+        fields->AddField<UIntValue>(kTThreadIdField, task.tid);
+      }
+      return true;
+    }
+
+    case kPerfRecordSwitch:
+    case kPerfRecordSwitchCpuWide: {
+      // A thread switched out is followed by the thread switched in, which
+      // gives the complete context switch.
+      PerfSwitch context_switch;
+      if (!ReadPerfSwitch(header, body, body_size, &context_switch) ||
+          context_switch.out) {
+        return false;
+      }
+      event_header->type = kThreadCSwitchType;
+      fields->AddField<UIntValue>(kNewThreadIdField, sample.tid);
+      fields->AddField<UIntValue>(kOldThreadIdField,
+                                  context_switch.next_prev_tid);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Converts the callchain of a sample into the payload of a stack event.
+// @param sample the sample.
+// @param time the timestamp of the sample.
+// @param arena the arena holding the payload.
+// @returns the payload, or NULL if the callchain has no instruction pointer.
+const Value* ConvertCallchain(const PerfSample& sample,
+                              uint64_t time,
+                              event::ValueArena* arena) {
+  StructValue* fields = arena->New<StructValue>(arena);
+  fields->Reserve(kStackFields);
+  fields->AddField<ULongValue>(kEventTimeStampField, time);
+  fields->AddField<UIntValue>(kStackProcessField, sample.pid);
+  fields->AddField<UIntValue>(kStackThreadField, sample.tid);
+  event::PackedArrayValue<ULongValue>* stack =
+      fields->AddPackedArrayField<ULongValue>(kStackField);
+  stack->Reserve(sample.callchain_size);
+
+  // The context markers are not instruction pointers.
+  for (uint64_t i = 0; i < sample.callchain_size; ++i) {
+    uint64_t ip = 0;
+    ::memcpy(&ip, sample.callchain + i * sizeof(ip), sizeof(ip));
+    if (ip < kPerfContextMax)
+      stack->Append(ip);
+  }
+  if (stack->Length() == 0)
+    return NULL;
+  return fields;
+}
+
+}  // namespace
+
+PerfDataParser::PerfDataParser() : converted_records_(0) {
+}
+
+bool PerfDataParser::AddTraceFile(const std::wstring& path) {
+  if (!path_.empty())
+    return false;
+  if (!base::WStringEndsWith(path, L".data"))
+    return false;
+  path_ = path;
+  return true;
+}
+
+std::unique_ptr<parser::ParserImpl> PerfDataParser::NewInstance() const {
+  return std::unique_ptr<parser::ParserImpl>(new PerfDataParser());
+}
+
+void PerfDataParser::Parse(const EventCallback& callback) {
+  converted_records_ = 0;
+  if (path_.empty())
+    return;
+
+  base::MemoryMappedFile file;
+  if (!file.Open(path_)) {
+    LOG(ERROR) << "Cannot open the trace file "
+               << base::WStringToString(path_) << ".";
+    return;
+  }
+
+  PerfFileHeader file_header;
+  std::vector<PerfEventAttr> attrs;
+  AttrTable attr_table;
+  if (file.data() == NULL ||
+      !ReadPerfFileHeader(file.data(), file.size(), &file_header) ||
+      !ReadPerfEventAttrs(file.data(), file.size(), file_header, &attrs)) {
+    LOG(ERROR) << "Invalid perf.data file.";
+    return;
+  }
+  if (!attr_table.Init(&attrs)) {
+    LOG(ERROR) << "The events of the perf.data file have different layouts "
+               << "without the identifier sample field.";
+    return;
+  }
+
+  // The records are flushed processor by processor: sort them by timestamp.
+  // A record without a timestamp keeps the timestamp of the previous record.
+  size_t end = static_cast<size_t>(
+      file_header.data.offset + file_header.data.size);
+  size_t offset = static_cast<size_t>(file_header.data.offset);
+  std::vector<RecordLocation> records;
+  uint64_t time = 0;
+  PerfRecordHeader header;
+  const char* body = NULL;
+  size_t body_size = 0;
+  for (;;) {
+    size_t record_offset = offset;
+    if (!ReadPerfRecord(file.data(), end, &offset, &header, &body, &body_size))
+      break;
+    if (header.type >= kPerfRecordUserTypeStart)
+      continue;
+    const PerfEventAttr* attr = attr_table.Find(header, body, body_size);
+    if (attr == NULL)
+      continue;
+    ReadRecordTime(header, body, body_size, *attr, &time);
+    RecordLocation location = { time, record_offset };
+    records.push_back(location);
+  }
+  std::stable_sort(records.begin(), records.end());
+
+  // Skip the records before the time range of the filter.
+  const EventFilter* filter = this->filter();
+  std::vector<RecordLocation>::const_iterator record = records.begin();
+  if (filter != NULL) {
+    RecordLocation begin = { filter->begin_time(), 0 };
+    record = std::lower_bound(records.begin(), records.end(), begin);
+  }
+
+  for (; record != records.end() && !cancelled(); ++record) {
+    if (filter != NULL && record->time > filter->end_time())
+      break;
+
+    offset = record->offset;
+    ReadPerfRecord(file.data(), end, &offset, &header, &body, &body_size);
+    const PerfEventAttr* attr = attr_table.Find(header, body, body_size);
+    DCHECK(attr != NULL);
+    PerfSample sample;
+    if (!ReadRecordSample(header, body, body_size, *attr, &sample))
+      continue;
+
+    // Check the filter before the payload is built. The records about a
+    // process or a thread have their own ids, which the events keep.
+    if (filter != NULL) {
+      uint32_t pid = sample.pid;
+      uint32_t tid = sample.tid;
+      ReadPerfRecordThread(header, body, body_size, &pid, &tid);
+      if (!filter->Accepts(kPerfProviderId,
+                           static_cast<unsigned char>(header.type),
+                           pid, tid, record->time)) {
+        continue;
+      }
+    }
+
+    event::EventHeader event_header;
+    const Value* payload = NULL;
+    ++converted_records_;
+    if (!ConvertRecord(header, body, body_size, *attr, sample, &arena_,
+                       &event_header, &payload)) {
+      arena_.Reset();
+      continue;
+    }
+
+    {
+      Event event(record->time, event_header, payload);
+      callback(event);
+    }
+
+    // The stack of a sample follows it, as with ETW.
+    if (sample.callchain_size != 0) {
+      payload = ConvertCallchain(sample, record->time, &arena_);
+      if (payload != NULL) {
+        event_header.type = kStackType;
+        Event event(record->time, event_header, payload);
+        callback(event);
+      }
+    }
+    arena_.Reset();
+  }
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -0,0 +1,108 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A portable parser of the perf.data files written by "perf record" on Linux.
+// The file is mapped into memory and its records are read directly (see
+// perf_data_format.h).
+//
+// The kernel records are converted into events with the categories and the
+// operations of the equivalent ETW kernel events, so that the same consumers
+// can process traces of both systems:
+//   - samples: PerfInfo/SampleProf, followed by StackWalk/Stack when the
+//     sample has a callchain.
+//   - executable mappings: Image/Load.
+//   - comm records: Thread/SetName.
+//   - fork and exit records: Process/Start and Process/End for the main
+//     thread of a process, Thread/Start and Thread/End otherwise.
+//   - context switches: Thread/CSwitch, when a thread is switched in.
+// The other records are skipped.
+//
+// The timestamps of the events are those of the perf clock, in nanoseconds.
+// The records of the processors are sent in timestamp order.
+
+#ifndef PARSER_PERF_PERF_DATA_PARSER_H_
+#define PARSER_PERF_PERF_DATA_PARSER_H_
+
+#include <memory>
+#include <string>
+
+#include "base/base.h"
+#include "base/guid.h"
+#include "event/value_arena.h"
+#include "parser/parser.h"
+
+namespace parser {
+namespace perf {
+
+// The provider id of the events of perf.data files, to use with EventFilter.
+// The opcode of an event is the type of its record (e.g. kPerfRecordSample).
+extern const base::Guid kPerfProviderId;
+
+// Generate Event objects from perf.data files, on any platform.
+class PerfDataParser : public parser::ParserImpl {
+ public:
+  typedef parser::ParserImpl::EventCallback EventCallback;
+
+  PerfDataParser();
+
+  // Adds a trace file to parse. Each instance parses a single trace file.
+  // @param path path to the trace file.
+  // @returns true if the trace is a .data file, false otherwise.
+  bool AddTraceFile(const std::wstring& path) override;
+
+  // Parses the trace file added with AddTraceFile() and sends the resulting
+  // events to the provided callback. The field projections of the filter
+  // are not applied.
+  // @param callback a callback that will receive the decoded events.
+  void Parse(const EventCallback& callback) override;
+
+  // Each trace file is parsed by its own instance.
+  bool ParsesEachFileSeparately() const override { return true; }
+
+  // Creates a new parser.
+  std::unique_ptr<parser::ParserImpl> NewInstance() const override;
+
+  // Returns the number of records converted into events by the last call to
+  // Parse(). The records rejected by the filter are not converted.
+  size_t converted_records() const { return converted_records_; }
+
+ private:
+  // The trace file to parse.
+  std::wstring path_;
+
+  // Arena holding the values of the event being processed. It is reset after
+  // each record is converted.
+  event::ValueArena arena_;
+
+  // The number of records converted by Parse().
+  size_t converted_records_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfDataParser);
+};
+
+}  // namespace perf
+}  // namespace parser
+
+#endif  // PARSER_PERF_PERF_DATA_PARSER_H_
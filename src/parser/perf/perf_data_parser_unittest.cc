@@ -0,0 +1,247 @@
+// Copyright (c) 2015 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_parser.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/string_utils.h"
+#include "event/event.h"
+#include "event/utils.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/event_filter.h"
+#include "parser/perf/perf_data_format.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+// The sample trace is generated by test/data/perf/generate_samples.py.
+const char kSampleTrace[] = "sample.perf.data";
+
+std::wstring GetSamplePath(const char* name) {
+  return base::StringToWString(
+      std::string(LIBTRACE_TEST_DATA_DIR) + "/perf/" + name);
+}
+
+// Keeps a copy of the events received from a parser.
+class EventRecorder {
+ public:
+  void Receive(const event::Event& event) {
+    events_.push_back(event::CopyEvent(event));
+  }
+
+  const std::vector<std::unique_ptr<event::Event>>& events() const {
+    return events_;
+  }
+
+ private:
+  std::vector<std::unique_ptr<event::Event>> events_;
+};
+
+// Parses the sample trace with the provided filter.
+void ParseSample(const EventFilter* filter, EventRecorder* recorder) {
+  parser::Parser parser;
+  parser.RegisterParser(
+      std::unique_ptr<parser::ParserImpl>(new PerfDataParser()));
+  if (filter != NULL)
+    parser.SetFilter(*filter);
+  ASSERT_TRUE(parser.AddTraceFile(GetSamplePath(kSampleTrace)));
+  parser.Parse([recorder](const event::Event& event) {
+    recorder->Receive(event);
+  });
+}
+
+uint32_t GetUInteger(const event::Event& event, const char* name) {
+  uint32_t value = 0;
+  EXPECT_TRUE(event.payload()->GetFieldAsUInteger(name, &value));
+  return value;
+}
+
+uint64_t GetULong(const event::Event& event, const char* name) {
+  uint64_t value = 0;
+  EXPECT_TRUE(event.payload()->GetFieldAsULong(name, &value));
+  return value;
+}
+
+std::string GetTypeName(const event::Event& event) {
+  return event.event_header().type.category().str() + "/" +
+         event.event_header().type.operation().str();
+}
+
+}  // namespace
+
+TEST(PerfDataParserTest, AddTraceFile) {
+  PerfDataParser parser;
+  EXPECT_FALSE(parser.AddTraceFile(L"dummy.etl"));
+  EXPECT_TRUE(parser.AddTraceFile(L"perf.data"));
+  // An instance parses a single trace file.
+  EXPECT_FALSE(parser.AddTraceFile(L"other.data"));
+}
+
+TEST(PerfDataParserTest, ParseMissingFile) {
+  EventRecorder recorder;
+  PerfDataParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(L"do_not_exist.data"));
+  parser.Parse([&recorder](const event::Event& event) {
+    recorder.Receive(event);
+  });
+  EXPECT_TRUE(recorder.events().empty());
+}
+
+TEST(PerfDataParserTest, Parse) {
+  EventRecorder recorder;
+  ParseSample(NULL, &recorder);
+  const std::vector<std::unique_ptr<event::Event>>& events =
+      recorder.events();
+  ASSERT_EQ(10U, events.size());
+
+  // The records of the processors are merged in timestamp order. The lost
+  // records, the data mappings and the threads switched out are skipped.
+  const uint64_t kTimestamps[] = {
+      1000, 1100, 1200, 1250, 1300, 1500, 1500, 1600, 1800, 1900 };
+  const uint8_t kProcessors[] = { 0, 0, 1, 1, 1, 0, 0, 0, 1, 1 };
+  const char* kTypes[] = {
+      "Thread/SetName", "Image/Load", "Thread/Start", "Process/Start",
+      "PerfInfo/SampleProf", "PerfInfo/SampleProf", "StackWalk/Stack",
+      "Thread/CSwitch", "Thread/End", "Process/End" };
+  for (size_t i = 0; i < events.size(); ++i) {
+    const event::Event& event = *events[i];
+    EXPECT_EQ(kTimestamps[i], event.timestamp());
+    EXPECT_EQ(kProcessors[i], event.event_header().processor_number);
+    EXPECT_EQ(kTypes[i], GetTypeName(event));
+    ASSERT_TRUE(event.payload() != NULL);
+  }
+
+  std::wstring name;
+  EXPECT_EQ(100U, GetUInteger(*events[0], "ThreadId"));
+  EXPECT_TRUE(events[0]->payload()->GetFieldAsWString("ThreadName", &name));
+  EXPECT_EQ(L"main", name);
+
+  EXPECT_EQ(0x400000U, GetULong(*events[1], "BaseAddress"));
+  EXPECT_EQ(0x10000U, GetULong(*events[1], "ModuleSize"));
+  EXPECT_EQ(100U, GetUInteger(*events[1], "ProcessId"));
+  EXPECT_TRUE(events[1]->payload()->GetFieldAsWString("ImageFileName",
+                                                      &name));
+  EXPECT_EQ(L"/usr/bin/app", name);
+
+  EXPECT_EQ(100U, events[2]->event_header().process_id);
+  EXPECT_EQ(101U, events[2]->event_header().thread_id);
+  EXPECT_EQ(101U, GetUInteger(*events[2], "TThreadId"));
+  EXPECT_EQ(200U, GetUInteger(*events[3], "ProcessId"));
+  EXPECT_EQ(100U, GetUInteger(*events[3], "ParentId"));
+
+  EXPECT_EQ(200U, events[4]->event_header().thread_id);
+  EXPECT_EQ(0x7F0000001000U, GetULong(*events[4], "InstructionPointer"));
+  EXPECT_EQ(200U, GetUInteger(*events[4], "ThreadId"));
+  EXPECT_EQ(10000U, GetULong(*events[4], "Period"));
+  EXPECT_EQ(0x401234U, GetULong(*events[5], "InstructionPointer"));
+
+  // The context markers of the callchain are skipped.
+  EXPECT_EQ(1500U, GetULong(*events[6], "EventTimeStamp"));
+  EXPECT_EQ(100U, GetUInteger(*events[6], "StackThread"));
+  const event::ArrayValue* stack = NULL;
+  ASSERT_TRUE(events[6]->payload()->GetFieldAs<event::ArrayValue>(
+      "Stack", &stack));
+  ASSERT_EQ(2U, stack->Length());
+  uint64_t address = 0;
+  EXPECT_TRUE(stack->GetElementAsULong(0, &address));
+  EXPECT_EQ(0x401234U, address);
+  EXPECT_TRUE(stack->GetElementAsULong(1, &address));
+  EXPECT_EQ(0x400100U, address);
+
+  EXPECT_EQ(100U, GetUInteger(*events[7], "NewThreadId"));
+  EXPECT_EQ(201U, GetUInteger(*events[7], "OldThreadId"));
+  EXPECT_EQ(101U, GetUInteger(*events[8], "TThreadId"));
+  EXPECT_EQ(200U, GetUInteger(*events[9], "ProcessId"));
+}
+
+TEST(PerfDataParserTest, ParseWithFilter) {
+  EventFilter filter;
+  filter.AllowOpcode(kPerfProviderId,
+                     static_cast<unsigned char>(kPerfRecordSample));
+  filter.AllowOpcode(kPerfProviderId,
+                     static_cast<unsigned char>(kPerfRecordExit));
+  filter.SetTimeRange(1300, 1800);
+
+  EventRecorder recorder;
+  ParseSample(&filter, &recorder);
+  const std::vector<std::unique_ptr<event::Event>>& events =
+      recorder.events();
+  ASSERT_EQ(4U, events.size());
+  EXPECT_EQ(1300U, events[0]->timestamp());
+  EXPECT_EQ("PerfInfo/SampleProf", GetTypeName(*events[0]));
+  EXPECT_EQ(1500U, events[1]->timestamp());
+  EXPECT_EQ("PerfInfo/SampleProf", GetTypeName(*events[1]));
+  EXPECT_EQ("StackWalk/Stack", GetTypeName(*events[2]));
+  EXPECT_EQ(1800U, events[3]->timestamp());
+  EXPECT_EQ("Thread/End", GetTypeName(*events[3]));
+}
+
+TEST(PerfDataParserTest, FilterBeforeConversion) {
+  PerfDataParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(GetSamplePath(kSampleTrace)));
+  EventRecorder recorder;
+  PerfDataParser::EventCallback callback = [&recorder](const event::Event& event) {
+    recorder.Receive(event);
+  };
+
+  // Without a filter, every record is converted, including the ones which
+  // are not sent to the callback. Stacks come with their sample.
+  parser.Parse(callback);
+  size_t record_events = 0;
+  for (const std::unique_ptr<event::Event>& event : recorder.events()) {
+    if (event->event_header().type.operation().str() != "Stack")
+      ++record_events;
+  }
+  EXPECT_LT(record_events, parser.converted_records());
+  size_t previous_events = recorder.events().size();
+
+  // The records rejected by the filter are never converted: no payload is
+  // allocated for them.
+  EventFilter filter;
+  filter.AllowProcess(12345);
+  parser.set_filter(&filter);
+  parser.Parse(callback);
+  EXPECT_EQ(0U, parser.converted_records());
+  EXPECT_EQ(previous_events, recorder.events().size());
+
+  // The records of an accepted opcode are the only ones converted.
+  EventFilter exit_filter;
+  exit_filter.AllowOpcode(kPerfProviderId,
+                          static_cast<unsigned char>(kPerfRecordExit));
+  parser.set_filter(&exit_filter);
+  parser.Parse(callback);
+  EXPECT_EQ(recorder.events().size() - previous_events,
+            parser.converted_records());
+  parser.set_filter(NULL);
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -27,67 +27,119 @@
 
 #include <vector>
 
+#include "event/atom.h"
+#include "event/event_type.h"
+#include "event/packed_array_value.h"
 #include "event/value.h"
 
 namespace state {
 
 namespace {
 
+using event::Atom;
+using event::EventType;
+
 // Image events.
-const char kImageCategory[] = "Image";
-const char kImageLoadOperation[] = "Load";
-const char kImageDCStartOperation[] = "DCStart";
-const char kImageUnloadOperation[] = "Unload";
-const char kImageKernelBase[] = "KernelBase";
+const Atom kImageCategory = Atom::Intern("Image");
+const Atom kImageLoadOperation = Atom::Intern("Load");
+const Atom kImageDCStartOperation = Atom::Intern("DCStart");
+const Atom kImageUnloadOperation = Atom::Intern("Unload");
+const Atom kModuleSizeField = Atom::Intern("ModuleSize");
+const Atom kImageCheckSumField = Atom::Intern("ImageCheckSum");
+const Atom kTimeDateStampField = Atom::Intern("TimeDateStamp");
+const Atom kImageFileNameField = Atom::Intern("ImageFileName");
+const Atom kBaseAddressField = Atom::Intern("BaseAddress");
 
 // Stackwalk events.
-const char kStackWalkCategory[] = "StackWalk";
-const char kStackOperation[] = "Stack";
+const Atom kStackWalkCategory = Atom::Intern("StackWalk");
+const Atom kStackOperation = Atom::Intern("Stack");
+const Atom kEventTimeStampField = Atom::Intern("EventTimeStamp");
+const Atom kStackProcessField = Atom::Intern("StackProcess");
+const Atom kStackThreadField = Atom::Intern("StackThread");
+const Atom kStackField = Atom::Intern("Stack");
+
+// Symbolizes the addresses of a stack.
+// @tparam GetAddress a callable with the signature
+//     bool(size_t index, base::Address* address).
+// @param symbols the resolver of the symbols.
+// @param pid the process of the stack.
+// @param length the number of addresses of the stack.
+// @param get_address reads the address at an index of the stack.
+// @param symbolized_stack receives the names of the resolved symbols.
+// @returns true if every address could be read, false otherwise.
+template <class GetAddress>
+bool SymbolizeStack(symbols::SymbolsResolver* symbols,
+                    base::Pid pid,
+                    size_t length,
+                    const GetAddress& get_address,
+                    std::vector<std::wstring>* symbolized_stack) {
+  for (size_t i = 0; i < length; ++i) {
+    base::Address address = 0;
+    if (!get_address(i, &address))
+      return false;
+
+    symbols::Symbol symbol;
+    if (symbols->ResolveSymbol(pid, address, &symbol))
+      symbolized_stack->push_back(symbol.name());
+  }
+  return true;
+}
 
 }  // namespace
 
-CurrentState::CurrentState() {
+CurrentState::CurrentState()
+    : module_size_field_(kModuleSizeField),
+      image_checksum_field_(kImageCheckSumField),
+      time_date_stamp_field_(kTimeDateStampField),
+      image_file_name_field_(kImageFileNameField),
+      base_address_field_(kBaseAddressField),
+      event_timestamp_field_(kEventTimeStampField),
+      stack_process_field_(kStackProcessField),
+      stack_thread_field_(kStackThreadField),
+      stack_field_(kStackField) {
+  // TODO: Handle the Image/KernelBase events.
+  AddHandler(EventType::Register(kImageCategory, kImageLoadOperation),
+             &CurrentState::OnImageLoad);
+  AddHandler(EventType::Register(kImageCategory, kImageDCStartOperation),
+             &CurrentState::OnImageLoad);
+  AddHandler(EventType::Register(kImageCategory, kImageUnloadOperation),
+             &CurrentState::OnImageUnload);
+  AddHandler(EventType::Register(kStackWalkCategory, kStackOperation),
+             &CurrentState::OnStackWalk);
 }
 
 CurrentState::~CurrentState() {
 }
 
 void CurrentState::OnEvent(const event::Event& event) {
-  std::string category;
-  std::string operation;
-
-  if (!event.header()->GetFieldAsString(event::kCategoryFieldName, &category) ||
-      !event.header()->GetFieldAsString(
-          event::kOperationFieldName, &operation)) {
+  // Dispatch on the numeric type of the event.
+  EventType::Id id = event.event_header().type.id();
+  if (id >= handlers_.size() || handlers_[id] == NULL)
     return;
-  }
+  (this->*handlers_[id])(event);
+}
 
-  if (category == kImageCategory) {
-    if (operation == kImageLoadOperation ||
-        operation == kImageDCStartOperation) {
-      OnImageLoad(event);
-    } else if (operation == kImageUnloadOperation) {
-      OnImageUnload(event);
-    }
-    else if (operation == kImageKernelBase) {
-      // TODO.
-    }
-  } else if (category == kStackWalkCategory && operation == kStackOperation) {
-    OnStackWalk(event);
-  }
+void CurrentState::AddHandler(EventType type, EventHandler handler) {
+  if (type.id() >= handlers_.size())
+    handlers_.resize(type.id() + 1, NULL);
+  handlers_[type.id()] = handler;
 }
 
 void CurrentState::OnImageLoad(const event::Event& event) {
   symbols::Image image;
   base::Address base_address = 0;
-  base::Pid pid = 0;
+  base::Pid pid = event.event_header().process_id;
 
-  if (!event.payload()->GetFieldAsUInteger("ModuleSize", &image.size) ||
-      !event.payload()->GetFieldAsUInteger("ImageCheckSum", &image.checksum) ||
-      !event.payload()->GetFieldAsUInteger("TimeDateStamp", &image.timestamp) ||
-      !event.payload()->GetFieldAsWString("ImageFileName", &image.filename) ||
-      !event.payload()->GetFieldAsULong("BaseAddress", &base_address) ||
-      !event.header()->GetFieldAsULong(event::kProcessIdFieldName, &pid)) {
+  const event::Value* payload = event.payload();
+  if (payload == nullptr) {
+    LOG(WARNING) << "Undecodable Image Load event.";
+    return;
+  }
+  if (!module_size_field_.GetFieldAsUInteger(payload, &image.size) ||
+      !image_checksum_field_.GetFieldAsUInteger(payload, &image.checksum) ||
+      !time_date_stamp_field_.GetFieldAsUInteger(payload, &image.timestamp) ||
+      !image_file_name_field_.GetFieldAsWString(payload, &image.filename) ||
+      !base_address_field_.GetFieldAsULong(payload, &base_address)) {
     LOG(WARNING) << "Incomplete Image Load event.";
     return;
   }
@@ -97,10 +149,14 @@ void CurrentState::OnImageLoad(const event::Event& event) {
 
 void CurrentState::OnImageUnload(const event::Event& event) {
   base::Address base_address = 0;
-  base::Pid pid = 0;
+  base::Pid pid = event.event_header().process_id;
 
-  if (!event.payload()->GetFieldAsULong("BaseAddress", &base_address) ||
-      !event.header()->GetFieldAsULong(event::kProcessIdFieldName, &pid)) {
+  const event::Value* payload = event.payload();
+  if (payload == nullptr) {
+    LOG(WARNING) << "Undecodable Image Unload event.";
+    return;
+  }
+  if (!base_address_field_.GetFieldAsULong(payload, &base_address)) {
     LOG(WARNING) << "Incomplete Image Unload event.";
     return;
   }
@@ -114,27 +170,44 @@ void CurrentState::OnStackWalk(const event::Event& event) {
   base::Tid tid = 0;
   const event::ArrayValue* stack = nullptr;
 
-  if (!event.payload()->GetFieldAsULong("EventTimeStamp", &event_ts) ||
-      !event.payload()->GetFieldAsULong("StackProcess", &pid) ||
-      !event.payload()->GetFieldAsULong("StackThread", &tid) ||
-      !event.payload()->GetFieldAs<event::ArrayValue>("Stack", &stack)) {
+  const event::Value* payload = event.payload();
+  if (payload == nullptr) {
+    LOG(WARNING) << "Undecodable StackWalk event.";
+    return;
+  }
+  if (!event_timestamp_field_.GetFieldAsULong(payload, &event_ts) ||
+      !stack_process_field_.GetFieldAsULong(payload, &pid) ||
+      !stack_thread_field_.GetFieldAsULong(payload, &tid) ||
+      !stack_field_.GetFieldAs<event::ArrayValue>(payload, &stack)) {
     LOG(WARNING) << "Incomplete StackWalk event.";
     return;
   }
 
-  // Symbolize the stack.
+  // Symbolize the stack. Stacks decoded as packed arrays are read without
+  // going through a Value per frame.
   std::vector<std::wstring> symbolized_stack;
-  for (const event::Value* address_value : *stack) {
-    base::Address address = 0;
-    if (!address_value->GetAsULong(&address)) {
-      LOG(WARNING) << "Invalid stack format in StackWalk event.";
-      return;
-    }
-
-    symbols::Symbol symbol;
-    if (symbols_.ResolveSymbol(pid, address, &symbol))
-      symbolized_stack.push_back(symbol.name());
+  bool symbolized = false;
+  typedef event::PackedArrayValue<event::ULongValue> PackedStack;
+  if (PackedStack::InstanceOf(stack)) {
+    const PackedStack* packed_stack = PackedStack::Cast(stack);
+    symbolized = SymbolizeStack(
+        &symbols_, pid, packed_stack->Length(),
+        [packed_stack](size_t index, base::Address* address) {
+          *address = packed_stack->elements()[index];
+          return true;
+        },
+        &symbolized_stack);
+  } else {
+    symbolized = SymbolizeStack(
+        &symbols_, pid, stack->Length(),
+        [stack](size_t index, base::Address* address) {
+          return stack->GetElementAsULong(index, address);
+        },
+        &symbolized_stack);
   }
+
+  if (!symbolized)
+    LOG(WARNING) << "Invalid stack format in StackWalk event.";
 }
 
 }  // namespace state
@@ -26,8 +26,12 @@
 #ifndef STATE_CURRENT_STATE_H_
 #define STATE_CURRENT_STATE_H_
 
+#include <vector>
+
 #include "base/base.h"
 #include "event/event.h"
+#include "event/event_type.h"
+#include "event/field_accessor.h"
 #include "symbols/symbols_resolver.h"
 
 namespace state {
@@ -43,11 +47,35 @@ class CurrentState {
   void OnEvent(const event::Event& event);
 
  private:
+  typedef void (CurrentState::*EventHandler)(const event::Event& event);
+
+  // Registers the handler of the events of type |type|.
+  // @param type the type of the handled events.
+  // @param handler the method called for these events.
+  void AddHandler(event::EventType type, EventHandler handler);
+
   // Called when different kinds of events are read.
   void OnImageLoad(const event::Event& event);
   void OnImageUnload(const event::Event& event);
   void OnStackWalk(const event::Event& event);
 
+  // Accessors to the payload fields.
+  // @{
+  event::FieldAccessor module_size_field_;
+  event::FieldAccessor image_checksum_field_;
+  event::FieldAccessor time_date_stamp_field_;
+  event::FieldAccessor image_file_name_field_;
+  event::FieldAccessor base_address_field_;
+  event::FieldAccessor event_timestamp_field_;
+  event::FieldAccessor stack_process_field_;
+  event::FieldAccessor stack_thread_field_;
+  event::FieldAccessor stack_field_;
+  // @}
+
+  // Handlers of the events, indexed by event type id. NULL for the types
+  // which are not handled.
+  std::vector<EventHandler> handlers_;
+
   // Symbols resolver.
   symbols::SymbolsResolver symbols_;
 
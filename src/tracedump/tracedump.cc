@@ -23,11 +23,13 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include <iostream>
+#include <stdio.h>
+#include <functional>
 #include <memory>
+#include <string>
 
 #include "base/logging.h"
-#include "event/utils.h"
+#include "event/fast_event_formatter.h"
 #include "parser/parser.h"
 #include "parser/etw/etw_parser.h"
 
@@ -35,14 +37,28 @@ namespace {
 
 using event::Event;
 
-void ReceiveEvent(const Event& event) {
-  std::string output;
-  if (!event::ToString(event, &output)) {
+// The formatted events are written to stdout in blocks of this size.
+const size_t kOutputBufferSize = 1 << 20;
+
+// Writes the content of |output| to stdout and clears it.
+void FlushOutput(std::string* output) {
+  fwrite(output->data(), 1, output->size(), stdout);
+  output->clear();
+}
+
+// Appends the textual representation of |event| to |output|, which is
+// flushed when it reaches kOutputBufferSize.
+void ReceiveEvent(const event::FastEventFormatter* formatter,
+                  std::string* output,
+                  const Event& event) {
+  if (!formatter->AppendEvent(event, output)) {
     LOG(INFO) << "Cannot serialize event.";
     return;
   }
+  output->push_back('\n');
 
-  std::cout << output << std::endl;
+  if (output->size() >= kOutputBufferSize)
+    FlushOutput(output);
 }
 
 }  // namespace
@@ -60,7 +76,14 @@ int wmain(int argc, wchar_t* argv[], wchar_t* /*envp */ []) {
     }
   }
 
-  parser.Parse(&ReceiveEvent);
+  // Formatter and output buffer reused across events.
+  event::FastEventFormatter formatter;
+  std::string output;
+  output.reserve(2 * kOutputBufferSize);
+
+  parser.Parse(std::bind(&ReceiveEvent, &formatter, &output,
+                         std::placeholders::_1));
+  FlushOutput(&output);
 
   return 0;
 }
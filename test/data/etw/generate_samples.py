@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# Copyright (c) 2015 The LibTrace Authors.
+# All rights reserved.
+#
+# Use of this source code is governed by the license found in the 'licence'
+# file at the root of the repository.
+#
+# Writes the sample .etl files used by the unittests of the portable ETL
+# parser (see src/parser/etw/etl_file_parser_unittest.cc). The samples follow
+# the layout of the buffers written by the NT Kernel Logger: 64-bit headers,
+# one buffer per processor, events aligned on 8 bytes.
+#
+# kernel_sample.etl holds:
+#   CPU 0, buffer 0: EventTrace Header (raw timestamp 1000),
+#                    Thread CSwitch (1100), PerfInfo SampleProf (1300).
+#   CPU 1, buffer 1: Thread CSwitch (1050), an event of a group without a
+#                    known provider (1150), Thread CSwitch (1200).
+#   CPU 0, buffer 2: Thread CSwitch (1400).
+#   CPU 1, buffer 3: no event.
+#
+# kernel_many_buffers.etl holds a buffer with the EventTrace Header, then 4
+# processors of 40 buffers each, with 8 Thread CSwitch events per buffer. The buffers of processor 3 are at the end
+# of the file, far from the buffers of the other processors with the same
+# timestamps.
+#
+# Usage: generate_samples.py <output directory>
+
+import os
+import struct
+import sys
+
+BUFFER_SIZE = 1024
+SMALL_BUFFER_SIZE = 512
+BUFFER_HEADER_SIZE = 72
+
+SYSTEM64_HEADER = 2
+COMPACT64_HEADER = 4
+PERFINFO64_HEADER = 17
+HEADER_FLAGS = 0xC0
+
+EVENT_TRACE_GROUP = 0x00
+THREAD_GROUP = 0x05
+CONFIG_GROUP = 0x0B
+PERFINFO_GROUP = 0x0F
+
+START_TIME = 130000000000000000
+PERF_FREQ = 10000000
+
+
+def align(data, alignment=8):
+    padding = (alignment - len(data) % alignment) % alignment
+    return data + b'\0' * padding
+
+
+def system_header(group, opcode, version, tid, pid, timestamp, payload):
+    size = 32 + len(payload)
+    return align(struct.pack('<HBBHBBIIQII', version, SYSTEM64_HEADER,
+                             HEADER_FLAGS, size, opcode, group, tid, pid,
+                             timestamp, 0, 0) + payload)
+
+
+def compact_header(group, opcode, version, tid, pid, timestamp, payload):
+    size = 24 + len(payload)
+    return align(struct.pack('<HBBHBBIIQ', version, COMPACT64_HEADER,
+                             HEADER_FLAGS, size, opcode, group, tid, pid,
+                             timestamp) + payload)
+
+
+def perfinfo_header(group, opcode, version, timestamp, payload):
+    size = 16 + len(payload)
+    return align(struct.pack('<HBBHBBQ', version, PERFINFO64_HEADER,
+                             HEADER_FLAGS, size, opcode, group, timestamp) +
+                 payload)
+
+
+def w16string(value):
+    return value.encode('utf-16-le') + b'\0\0'
+
+
+def logfile_header_payload(buffer_size, processors):
+    payload = struct.pack('<IIIIQIIIIIIII', buffer_size, 0x0A000105, 0,
+                          processors,
+                          0, 156001, 0, 0x10001, 4, 0, 8, 0, 2000)
+    payload += struct.pack('<QQ', 0, 0)  # LoggerName, LogFileName.
+    payload += b'\0' * 172  # TimeZoneInformation.
+    payload += struct.pack('<I', 0)  # Padding.
+    payload += struct.pack('<QQQII', 0, PERF_FREQ, START_TIME, 1, 0)
+    payload += w16string('NT Kernel Logger')
+    payload += w16string('kernel_sample.etl')
+    return payload
+
+
+def cswitch_payload(new_tid, old_tid):
+    return struct.pack('<IIbbBbbbbbII', new_tid, old_tid, 8, 9, 0, 0, 6, 1,
+                       5, 0, 42, 0)
+
+
+def sample_prof_payload(instruction_pointer, tid):
+    return struct.pack('<QIHH', instruction_pointer, tid, 1, 0)
+
+
+def buffer(processor, records, buffer_size=BUFFER_SIZE):
+    events = b''.join(records)
+    end_offset = BUFFER_HEADER_SIZE + len(events)
+    assert end_offset <= buffer_size
+    header = struct.pack('<IIIiQqQBBHIIHH16s', buffer_size, end_offset,
+                         end_offset, 0, 0, 0, 0, processor, 0, 0, 0,
+                         end_offset, 0, 0, b'')
+    assert len(header) == BUFFER_HEADER_SIZE
+    data = header + events
+    return data + b'\xff' * (buffer_size - len(data))
+
+
+def kernel_sample():
+    return b''.join([
+        buffer(0, [
+            system_header(EVENT_TRACE_GROUP, 0, 2, 0, 0, 1000,
+                          logfile_header_payload(BUFFER_SIZE, 2)),
+            compact_header(THREAD_GROUP, 36, 2, 0, 0, 1100,
+                           cswitch_payload(100, 0)),
+            perfinfo_header(PERFINFO_GROUP, 46, 2, 1300,
+                            sample_prof_payload(0x7FF612340000, 100)),
+        ]),
+        buffer(1, [
+            compact_header(THREAD_GROUP, 36, 2, 0, 0, 1050,
+                           cswitch_payload(200, 0)),
+            system_header(CONFIG_GROUP, 10, 2, 0, 0, 1150, b'\0' * 8),
+            compact_header(THREAD_GROUP, 36, 2, 0, 0, 1200,
+                           cswitch_payload(0, 200)),
+        ]),
+        buffer(0, [
+            compact_header(THREAD_GROUP, 36, 2, 0, 0, 1400,
+                           cswitch_payload(0, 100)),
+        ]),
+        buffer(1, []),
+    ])
+
+
+def kernel_many_buffers():
+    processors = 4
+    buffers_per_processor = 40
+    events_per_buffer = 8
+    buffers = [[] for _ in range(processors)]
+    for processor in range(processors):
+        for index in range(buffers_per_processor):
+            records = []
+            for event in range(events_per_buffer):
+                timestamp = (2000 + index * 1000 + event * 100 +
+                             processor * 10)
+                records.append(compact_header(
+                    THREAD_GROUP, 36, 2, 0, 0, timestamp,
+                    cswitch_payload(processor, index * 100 + event)))
+            buffers[processor].append(
+                buffer(processor, records, SMALL_BUFFER_SIZE))
+
+    # The header event fills the first buffer of processor 0. Interleave the
+    # buffers of processors 0 to 2, then append the buffers of processor 3.
+    data = [buffer(0, [system_header(
+        EVENT_TRACE_GROUP, 0, 2, 0, 0, 1000,
+        logfile_header_payload(SMALL_BUFFER_SIZE, processors))],
+        SMALL_BUFFER_SIZE)]
+    for index in range(buffers_per_processor):
+        for processor in range(processors - 1):
+            data.append(buffers[processor][index])
+    data.extend(buffers[processors - 1])
+    return b''.join(data)
+
+
+def main():
+    directory = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(
+        os.path.abspath(__file__))
+    with open(os.path.join(directory, 'kernel_sample.etl'), 'wb') as output:
+        output.write(kernel_sample())
+    with open(os.path.join(directory, 'kernel_many_buffers.etl'),
+              'wb') as output:
+        output.write(kernel_many_buffers())
+
+
+if __name__ == '__main__':
+    main()
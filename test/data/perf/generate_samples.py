@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+# Copyright (c) 2015 The LibTrace Authors.
+# All rights reserved.
+#
+# Use of this source code is governed by the license found in the 'licence'
+# file at the root of the repository.
+#
+# Writes the sample perf.data file used by the unittests of the perf.data
+# parser (see src/parser/perf/perf_data_parser_unittest.cc). The sample has a
+# single event attribute: samples have the IP, TID, TIME, CPU, PERIOD and
+# CALLCHAIN fields, and the other records end with a sample id.
+#
+# sample.perf.data holds, in file order:
+#   CPU 0: COMM of thread 100 (time 1000), executable MMAP2 of process 100
+#          (1100), SAMPLE of thread 100 with a callchain (1500), LOST (1550),
+#          SWITCH_CPU_WIDE switching in thread 100 in place of thread 201
+#          (1600).
+#   FINISHED_ROUND, written by the perf tool.
+#   CPU 1: FORK of thread 101 in process 100 (1200), FORK of process 200
+#          (1250), SAMPLE of thread 200 without callchain (1300), data MMAP
+#          (1400), SWITCH out of thread 200 (1700), EXIT of thread 101 (1800),
+#          EXIT of process 200 (1900).
+#
+# Usage: generate_samples.py <output directory>
+
+import os
+import struct
+import sys
+
+PERF_MAGIC = b'PERFILE2'
+FILE_HEADER_SIZE = 104
+ATTR_STRUCT_SIZE = 112
+ATTR_SIZE = ATTR_STRUCT_SIZE + 16
+
+RECORD_MMAP = 1
+RECORD_LOST = 2
+RECORD_COMM = 3
+RECORD_EXIT = 4
+RECORD_FORK = 7
+RECORD_SAMPLE = 9
+RECORD_MMAP2 = 10
+RECORD_SWITCH = 14
+RECORD_SWITCH_CPU_WIDE = 15
+RECORD_FINISHED_ROUND = 68
+
+MISC_USER = 2
+MISC_MMAP_DATA = 0x2000
+MISC_SWITCH_OUT = 0x2000
+
+SAMPLE_IP = 1 << 0
+SAMPLE_TID = 1 << 1
+SAMPLE_TIME = 1 << 2
+SAMPLE_CALLCHAIN = 1 << 5
+SAMPLE_CPU = 1 << 7
+SAMPLE_PERIOD = 1 << 8
+SAMPLE_TYPE = (SAMPLE_IP | SAMPLE_TID | SAMPLE_TIME | SAMPLE_CALLCHAIN |
+               SAMPLE_CPU | SAMPLE_PERIOD)
+
+ATTR_FLAG_MMAP = 1 << 8
+ATTR_FLAG_COMM = 1 << 9
+ATTR_FLAG_TASK = 1 << 13
+ATTR_FLAG_SAMPLE_ID_ALL = 1 << 18
+ATTR_FLAG_MMAP2 = 1 << 23
+ATTR_FLAG_CONTEXT_SWITCH = 1 << 26
+ATTR_FLAGS = (ATTR_FLAG_MMAP | ATTR_FLAG_COMM | ATTR_FLAG_TASK |
+              ATTR_FLAG_SAMPLE_ID_ALL | ATTR_FLAG_MMAP2 |
+              ATTR_FLAG_CONTEXT_SWITCH)
+
+PERF_CONTEXT_USER = (1 << 64) - 512
+PROT_READ = 1
+PROT_EXEC = 4
+SAMPLE_PERIOD_VALUE = 10000
+STREAM_ID = 42
+
+
+def align(data, alignment=8):
+    padding = (alignment - len(data) % alignment) % alignment
+    return data + b'\0' * padding
+
+
+def record(record_type, misc, body):
+    return struct.pack('<IHH', record_type, misc, 8 + len(body)) + body
+
+
+def string(value):
+    return align(value.encode('utf-8') + b'\0')
+
+
+def sample_id(pid, tid, time, cpu):
+    return struct.pack('<IIQII', pid, tid, time, cpu, 0)
+
+
+def comm(pid, tid, name, time, cpu):
+    return record(RECORD_COMM, 0, struct.pack('<II', pid, tid) +
+                  string(name) + sample_id(pid, tid, time, cpu))
+
+
+def mmap(pid, tid, address, length, filename, time, cpu):
+    return record(RECORD_MMAP, MISC_MMAP_DATA,
+                  struct.pack('<IIQQQ', pid, tid, address, length, 0) +
+                  string(filename) + sample_id(pid, tid, time, cpu))
+
+
+def mmap2(pid, tid, address, length, prot, filename, time, cpu):
+    return record(RECORD_MMAP2, 0,
+                  struct.pack('<IIQQQIIQQII', pid, tid, address, length, 0,
+                              8, 1, 1234, 0, prot, 2) +
+                  string(filename) + sample_id(pid, tid, time, cpu))
+
+
+def task(record_type, pid, ppid, tid, ptid, time, cpu):
+    return record(record_type, 0,
+                  struct.pack('<IIIIQ', pid, ppid, tid, ptid, time) +
+                  sample_id(ppid, ptid, time, cpu))
+
+
+def sample(ip, pid, tid, time, cpu, callchain):
+    return record(RECORD_SAMPLE, MISC_USER,
+                  struct.pack('<QIIQIIQQ', ip, pid, tid, time, cpu, 0,
+                              SAMPLE_PERIOD_VALUE, len(callchain)) +
+                  b''.join(struct.pack('<Q', entry) for entry in callchain))
+
+
+def lost(count, pid, tid, time, cpu):
+    return record(RECORD_LOST, 0, struct.pack('<QQ', STREAM_ID, count) +
+                  sample_id(pid, tid, time, cpu))
+
+
+def switch_out(pid, tid, time, cpu):
+    return record(RECORD_SWITCH, MISC_SWITCH_OUT,
+                  sample_id(pid, tid, time, cpu))
+
+
+def switch_cpu_wide_in(pid, tid, prev_pid, prev_tid, time, cpu):
+    return record(RECORD_SWITCH_CPU_WIDE, 0,
+                  struct.pack('<II', prev_pid, prev_tid) +
+                  sample_id(pid, tid, time, cpu))
+
+
+def finished_round():
+    return record(RECORD_FINISHED_ROUND, 0, b'')
+
+
+def attr():
+    data = bytearray(ATTR_STRUCT_SIZE)
+    struct.pack_into('<IIQQQQQ', data, 0, 0, ATTR_STRUCT_SIZE, 0,
+                     SAMPLE_PERIOD_VALUE, SAMPLE_TYPE, 0, ATTR_FLAGS)
+    return bytes(data)
+
+
+def sample_perf_data():
+    records = b''.join([
+        comm(100, 100, 'main', 1000, 0),
+        mmap2(100, 100, 0x400000, 0x10000, PROT_READ | PROT_EXEC,
+              '/usr/bin/app', 1100, 0),
+        sample(0x401234, 100, 100, 1500, 0,
+               [PERF_CONTEXT_USER, 0x401234, 0x400100]),
+        lost(3, 100, 100, 1550, 0),
+        switch_cpu_wide_in(100, 100, 200, 201, 1600, 0),
+        finished_round(),
+        task(RECORD_FORK, 100, 100, 101, 100, 1200, 1),
+        task(RECORD_FORK, 200, 100, 200, 100, 1250, 1),
+        sample(0x7f0000001000, 200, 200, 1300, 1, []),
+        mmap(200, 200, 0x7f0000100000, 0x1000, '/tmp/data', 1400, 1),
+        switch_out(200, 200, 1700, 1),
+        task(RECORD_EXIT, 100, 100, 101, 101, 1800, 1),
+        task(RECORD_EXIT, 200, 100, 200, 200, 1900, 1),
+    ])
+
+    attrs_offset = FILE_HEADER_SIZE
+    ids_offset = attrs_offset + ATTR_SIZE
+    data_offset = ids_offset + 8
+    header = (PERF_MAGIC +
+              struct.pack('<QQQQQQQQ', FILE_HEADER_SIZE, ATTR_SIZE,
+                          attrs_offset, ATTR_SIZE, data_offset,
+                          len(records), 0, 0) +
+              b'\0' * 32)
+    attrs = attr() + struct.pack('<QQ', ids_offset, 8)
+    return header + attrs + struct.pack('<Q', STREAM_ID) + records
+
+
+def main():
+    directory = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(
+        os.path.abspath(__file__))
+    with open(os.path.join(directory, 'sample.perf.data'), 'wb') as output:
+        output.write(sample_perf_data())
+
+
+if __name__ == '__main__':
+    main()